@@ -51,7 +51,8 @@ function(build_arrow)
   if(WITH_RADOSGW_ARROW_FLIGHT)
     message("building arrow flight; make sure grpc-plugins is installed on the system")
     list(APPEND arrow_CMAKE_ARGS
-      -DARROW_FLIGHT=ON -DARROW_WITH_RE2=OFF)
+      -DARROW_FLIGHT=ON -DARROW_WITH_RE2=OFF
+      -DARROW_CSV=ON) # csv objects are served as record batches too
     find_package(gRPC REQUIRED)
     find_package(Protobuf REQUIRED)
     find_package(c-ares 1.13.0 QUIET REQUIRED)
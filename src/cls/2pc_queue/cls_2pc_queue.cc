@@ -580,16 +580,23 @@ static int cls_2pc_queue_list_entries(cls_method_context_t hctx, bufferlist *in,
   return 0;
 }
 
+// count in bulk listings, which only decode the entry headers
 static int cls_2pc_queue_count_entries(cls_method_context_t hctx, cls_queue_list_op& op, cls_queue_head& head,
                                        uint32_t& entries_to_remove)
 {
+  op.bulk = true;
+  entries_to_remove = 0;
   cls_queue_list_ret op_ret;
-  auto ret = queue_list_entries(hctx, op, op_ret, head);
-  if (ret < 0) {
-    return ret;
-  }
+  do {
+    op_ret = cls_queue_list_ret();
+    auto ret = queue_list_entries(hctx, op, op_ret, head);
+    if (ret < 0) {
+      return ret;
+    }
+    entries_to_remove += op_ret.num_entries;
+    op.start_marker = op_ret.next_marker;
+  } while (op_ret.is_truncated && op_ret.num_entries > 0 && op_ret.next_marker != op.end_marker);
 
-  entries_to_remove = op_ret.entries.size();
   return 0;
 }
 
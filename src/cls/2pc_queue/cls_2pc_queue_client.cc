@@ -156,7 +156,9 @@ int cls_2pc_queue_list_entries_result(const bufferlist& bl, std::vector<cls_queu
     return -EIO;
   }
 
-  entries = std::move(ret.entries);
+  if (cls_queue_list_unpack(ret, entries) < 0) {
+    return -EIO;
+  }
   *truncated = ret.is_truncated;
 
   next_marker = std::move(ret.next_marker);
@@ -164,6 +166,17 @@ int cls_2pc_queue_list_entries_result(const bufferlist& bl, std::vector<cls_queu
   return 0;
 }
 
+int cls_2pc_queue_list_entries_result(const bufferlist& bl, cls_queue_list_ret& ret) {
+  auto iter = bl.cbegin();
+  try {
+    decode(ret, iter);
+  } catch (buffer::error& err) {
+    return -EIO;
+  }
+
+  return 0;
+}
+
 #ifndef CLS_CLIENT_HIDE_IOCTX
 int cls_2pc_queue_list_entries(IoCtx& io_ctx,
                                const std::string& queue_name,
@@ -220,6 +233,17 @@ int cls_2pc_queue_list_reservations(IoCtx& io_ctx, const std::string& queue_name
 }
 #endif
 
+void cls_2pc_queue_list_entries_bulk(ObjectReadOperation& op, const std::string& marker, uint32_t max, bufferlist* obl, int* prval) {
+  bufferlist in;
+  cls_queue_list_op list_op;
+  list_op.start_marker = marker;
+  list_op.max = max;
+  list_op.bulk = true;
+  encode(list_op, in);
+
+  op.exec(TPC_QUEUE_CLASS, TPC_QUEUE_LIST_ENTRIES, in, obl, prval);
+}
+
 void cls_2pc_queue_list_reservations(ObjectReadOperation& op, bufferlist* obl, int* prval) {
   bufferlist in;
 
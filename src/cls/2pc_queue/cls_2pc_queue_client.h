@@ -7,6 +7,7 @@
 #include <vector>
 #include "include/rados/librados.hpp"
 #include "cls/queue/cls_queue_types.h"
+#include "cls/queue/cls_queue_ops.h"
 #include "cls/2pc_queue/cls_2pc_queue_types.h"
 
 // initialize the queue with maximum size (bytes)
@@ -76,6 +77,15 @@ void cls_2pc_queue_list_entries(librados::ObjectReadOperation& op, const std::st
 int cls_2pc_queue_list_entries_result(const bufferlist& bl, std::vector<cls_queue_entry>& entries,
                             bool *truncated, std::string& next_marker);
 
+// optionally async bulk listing of entries in the queue. the entries stay in one buffer as stored in the queue
+// after answer is received, call cls_2pc_queue_list_entries_result() to parse the results, and walk the entries
+// with cls_queue_list_iterator. if the entries are consumed right away, the removal of the previous batch may
+// be sent along with the listing of the next one, listing from the marker the removal ends at
+void cls_2pc_queue_list_entries_bulk(librados::ObjectReadOperation& op, const std::string& marker, uint32_t max,
+        bufferlist* obl, int* prval);
+
+int cls_2pc_queue_list_entries_result(const bufferlist& bl, cls_queue_list_ret& ret);
+
 // optionally async listing of all pending reservations in the queue
 // after answer is received, call cls_2pc_queue_list_reservations_result() to parse the results
 void cls_2pc_queue_list_reservations(librados::ObjectReadOperation& op, bufferlist* obl, int* prval);
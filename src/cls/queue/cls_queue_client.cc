@@ -64,7 +64,9 @@ int cls_queue_list_entries_inner(IoCtx& io_ctx, const string& oid, vector<cls_qu
     return -EIO;
   }
 
-  entries = std::move(ret.entries);
+  if (cls_queue_list_unpack(ret, entries) < 0) {
+    return -EIO;
+  }
   *truncated = ret.is_truncated;
 
   next_marker = std::move(ret.next_marker);
@@ -99,6 +101,46 @@ int cls_queue_list_entries(IoCtx& io_ctx, const string& oid, const string& marke
   return cls_queue_list_entries_inner(io_ctx, oid, entries, truncated, next_marker, in, out);
 }
 
+int cls_queue_list_entries_result(const bufferlist& bl, cls_queue_list_ret& ret)
+{
+  auto iter = bl.cbegin();
+  try {
+    decode(ret, iter);
+  } catch (buffer::error& err) {
+    return -EIO;
+  }
+  return 0;
+}
+
+int cls_queue_list_entries_bulk(IoCtx& io_ctx, const string& oid, const string& marker, uint32_t max,
+                                cls_queue_list_ret& ret)
+{
+  bufferlist in, out;
+  cls_queue_list_op op;
+  op.start_marker = marker;
+  op.max = max;
+  op.bulk = true;
+  encode(op, in);
+
+  int r = io_ctx.exec(oid, QUEUE_CLASS, QUEUE_LIST_ENTRIES, in, out);
+  if (r < 0)
+    return r;
+
+  return cls_queue_list_entries_result(out, ret);
+}
+
+void cls_queue_list_entries_bulk(ObjectReadOperation& op, const string& marker, uint32_t max,
+                                 bufferlist* obl, int* prval)
+{
+  bufferlist in;
+  cls_queue_list_op list_op;
+  list_op.start_marker = marker;
+  list_op.max = max;
+  list_op.bulk = true;
+  encode(list_op, in);
+  op.exec(QUEUE_CLASS, QUEUE_LIST_ENTRIES, in, obl, prval);
+}
+
 void cls_queue_remove_entries(ObjectWriteOperation& op, const string& end_marker)
 {
   bufferlist in, out;
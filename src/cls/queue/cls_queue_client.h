@@ -13,6 +13,13 @@ int cls_queue_list_entries(librados::IoCtx& io_ctx, const std::string& oid, cons
                     std::vector<cls_queue_entry>& entries, bool *truncated, std::string& next_marker);
 int cls_queue_list_entries(librados::IoCtx& io_ctx, const std::string& oid, const std::string& marker, const std::string& end_marker,
                            std::vector<cls_queue_entry>& entries, bool *truncated, std::string& next_marker);
+// bulk listing: entries stay in one buffer as stored in the queue, walk them with cls_queue_list_iterator
+int cls_queue_list_entries_bulk(librados::IoCtx& io_ctx, const std::string& oid, const std::string& marker, uint32_t max,
+                                cls_queue_list_ret& ret);
+// optionally async bulk listing, call cls_queue_list_entries_result() to parse the reply
+void cls_queue_list_entries_bulk(librados::ObjectReadOperation& op, const std::string& marker, uint32_t max,
+                                 bufferlist* obl, int* prval);
+int cls_queue_list_entries_result(const bufferlist& bl, cls_queue_list_ret& ret);
 void cls_queue_remove_entries(librados::ObjectWriteOperation& op, const std::string& end_marker);
 
 #endif
@@ -84,30 +84,37 @@ struct cls_queue_list_op {
   uint64_t max{0};
   std::string start_marker;
   std::string end_marker;
+  // ask for a bulk listing, see cls_queue_list_ret
+  bool bulk{false};
 
   cls_queue_list_op() {}
 
   void encode(ceph::buffer::list& bl) const {
-    ENCODE_START(2, 1, bl);
+    ENCODE_START(3, 1, bl);
     encode(max, bl);
     encode(start_marker, bl);
     encode(end_marker, bl);
+    encode(bulk, bl);
     ENCODE_FINISH(bl);
   }
 
   void decode(ceph::buffer::list::const_iterator& bl) {
-    DECODE_START(2, bl);
+    DECODE_START(3, bl);
     decode(max, bl);
     decode(start_marker, bl);
     if (struct_v > 1) {
       decode(end_marker, bl);
     }
+    if (struct_v > 2) {
+      decode(bulk, bl);
+    }
     DECODE_FINISH(bl);
   }
 
   void dump(ceph::Formatter *f) const {
     f->dump_unsigned("max", max);
     f->dump_string("start_marker", start_marker);
+    f->dump_bool("bulk", bulk);
   }
 
   static std::list<cls_queue_list_op> generate_test_instances() {
@@ -116,31 +123,60 @@ struct cls_queue_list_op {
     o.emplace_back();
     o.back().max = 123;
     o.back().start_marker = "foo";
+    o.emplace_back();
+    o.back().max = 123;
+    o.back().end_marker = "bar";
+    o.back().bulk = true;
     return o;
   }
 };
 WRITE_CLASS_ENCODER(cls_queue_list_op)
 
+// a bulk listing leaves entries empty. data then holds the ring bytes of
+// the listed entries as stored, headers included, starting at
+// data_start_marker. if data_wrap_offset is set, the ring wraps around
+// data_wrap_pos bytes into data and continues at data_wrap_offset with the
+// next generation. use cls_queue_list_iterator to walk either kind
 struct cls_queue_list_ret {
   bool is_truncated;
   std::string next_marker;
   std::vector<cls_queue_entry> entries;
+  bool bulk{false};
+  uint64_t num_entries{0};
+  std::string data_start_marker;
+  uint64_t data_wrap_pos{0};
+  uint64_t data_wrap_offset{0};
+  ceph::buffer::list data;
 
   cls_queue_list_ret() {}
 
   void encode(ceph::buffer::list& bl) const {
-    ENCODE_START(1, 1, bl);
+    ENCODE_START(2, 1, bl);
     encode(is_truncated, bl);
     encode(next_marker, bl);
     encode(entries, bl);
+    encode(bulk, bl);
+    encode(num_entries, bl);
+    encode(data_start_marker, bl);
+    encode(data_wrap_pos, bl);
+    encode(data_wrap_offset, bl);
+    encode(data, bl);
     ENCODE_FINISH(bl);
   }
 
   void decode(ceph::buffer::list::const_iterator& bl) {
-    DECODE_START(1, bl);
+    DECODE_START(2, bl);
     decode(is_truncated, bl);
     decode(next_marker, bl);
     decode(entries, bl);
+    if (struct_v > 1) {
+      decode(bulk, bl);
+      decode(num_entries, bl);
+      decode(data_start_marker, bl);
+      decode(data_wrap_pos, bl);
+      decode(data_wrap_offset, bl);
+      decode(data, bl);
+    }
     DECODE_FINISH(bl);
   }
 
@@ -148,6 +184,14 @@ struct cls_queue_list_ret {
     f->dump_bool("is_truncated", is_truncated);
     f->dump_string("next_marker", next_marker);
     encode_json("entries", entries, f);
+    f->dump_bool("bulk", bulk);
+    if (bulk) {
+      f->dump_unsigned("num_entries", num_entries);
+      f->dump_string("data_start_marker", data_start_marker);
+      f->dump_unsigned("data_wrap_pos", data_wrap_pos);
+      f->dump_unsigned("data_wrap_offset", data_wrap_offset);
+      f->dump_unsigned("data_len", data.length());
+    }
   }
 
   static std::list<cls_queue_list_ret> generate_test_instances() {
@@ -159,11 +203,117 @@ struct cls_queue_list_ret {
     o.back().entries.push_back(cls_queue_entry());
     o.back().entries.back().marker = "id";
     o.back().entries.back().data.append(std::string_view("data"));
+    o.emplace_back();
+    o.back().is_truncated = false;
+    o.back().next_marker = "1/1024";
+    o.back().bulk = true;
+    o.back().num_entries = 1;
+    o.back().data_start_marker = "0/2048";
+    o.back().data.append(std::string_view("data"));
     return o;
   }
 };
 WRITE_CLASS_ENCODER(cls_queue_list_ret)
 
+// hands out the entries of a plain or bulk listing one at a time. entries of
+// a bulk listing are sliced out of its data only when they are reached, and
+// share its buffers, so a consumer that stops early never touches the rest
+class cls_queue_list_iterator {
+  const cls_queue_list_ret& ret;
+  std::vector<cls_queue_entry>::const_iterator entry;
+  ceph::buffer::list::const_iterator pos;
+  uint64_t off{0};
+  cls_queue_marker start;
+  int error{0};
+
+public:
+  explicit cls_queue_list_iterator(const cls_queue_list_ret& _ret)
+    : ret(_ret), entry(ret.entries.begin()), pos(ret.data.cbegin()) {
+    if (ret.bulk && ret.data.length() > 0 &&
+        start.from_str(ret.data_start_marker.c_str()) != 0) {
+      error = -EINVAL;
+    }
+  }
+
+  // number of entries in the listing
+  uint64_t size() const {
+    return ret.bulk ? ret.num_entries : ret.entries.size();
+  }
+
+  // marker of the next entry, or the next marker of the listing at its end
+  std::string marker() const {
+    if (!ret.bulk) {
+      return entry == ret.entries.end() ? ret.next_marker : entry->marker;
+    }
+    if (off == ret.data.length()) {
+      return ret.next_marker;
+    }
+    cls_queue_marker m = start;
+    if (ret.data_wrap_offset > 0 && off >= ret.data_wrap_pos) {
+      m.offset = ret.data_wrap_offset + (off - ret.data_wrap_pos);
+      m.gen += 1;
+    } else {
+      m.offset += off;
+    }
+    return m.to_str();
+  }
+
+  // fill in the next entry. return 1 if there was one, 0 at the end of the
+  // listing, and -EINVAL if the data of a bulk listing is malformed
+  int next(cls_queue_entry& e) {
+    if (!ret.bulk) {
+      if (entry == ret.entries.end()) {
+        return 0;
+      }
+      e = *entry++;
+      return 1;
+    }
+    if (error < 0) {
+      return error;
+    }
+    if (off == ret.data.length()) {
+      return 0;
+    }
+    e.marker = marker();
+    e.data.clear();
+    using ceph::decode;
+    try {
+      uint16_t entry_start;
+      decode(entry_start, pos);
+      if (entry_start != QUEUE_ENTRY_START) {
+        error = -EINVAL;
+        return error;
+      }
+      uint64_t data_size;
+      decode(data_size, pos);
+      pos.copy(data_size, e.data);
+    } catch (const ceph::buffer::error&) {
+      error = -EINVAL;
+      return error;
+    }
+    off = pos.get_off();
+    return 1;
+  }
+};
+
+// move the entries of a plain or bulk listing into a vector
+inline int cls_queue_list_unpack(cls_queue_list_ret& ret, std::vector<cls_queue_entry>& entries)
+{
+  if (!ret.bulk) {
+    entries = std::move(ret.entries);
+    return 0;
+  }
+  entries.clear();
+  entries.reserve(std::min<uint64_t>(ret.num_entries, ret.data.length() / QUEUE_ENTRY_OVERHEAD));
+  cls_queue_list_iterator it(ret);
+  cls_queue_entry e;
+  int r;
+  while ((r = it.next(e)) > 0) {
+    entries.push_back(std::move(e));
+  }
+  return r;
+}
+
 struct cls_queue_remove_op {
   std::string end_marker;
 
@@ -260,6 +260,141 @@ int queue_enqueue(cls_method_context_t hctx, cls_queue_enqueue_op& op, cls_queue
   return 0;
 }
 
+/*
+bulk listing hands out the ring bytes from the start marker on as they are
+stored, trimmed to whole entries and to about one large chunk. only the entry
+headers are decoded, to find where the listed entries end; the entries are
+sliced out of the data by the client (see cls_queue_list_iterator). the part
+before the wrap around and the part after it form one stream, as enqueue may
+split an entry, header included, between them.
+*/
+static int queue_list_entries_bulk(cls_method_context_t hctx, const cls_queue_list_op& op, cls_queue_list_ret& op_ret,
+                                   const cls_queue_head& head, cls_queue_marker start,
+                                   uint64_t size_before_wrap, bool wrap_around)
+{
+  const uint64_t size_after_wrap = wrap_around ? head.tail.offset - head.max_head_size : 0;
+  const uint64_t stream_size = size_before_wrap + size_after_wrap;
+
+  op_ret.bulk = true;
+  op_ret.data_start_marker = start.to_str();
+  if (wrap_around) {
+    op_ret.data_wrap_pos = size_before_wrap;
+    op_ret.data_wrap_offset = head.max_head_size;
+  }
+
+  auto marker_at = [&] (uint64_t pos) {
+    if (wrap_around && pos >= size_before_wrap) {
+      return cls_queue_marker{head.max_head_size + (pos - size_before_wrap), start.gen + 1};
+    }
+    return cls_queue_marker{start.offset + pos, start.gen};
+  };
+
+  // append len bytes of the stream, starting at pos, to bl
+  auto read_stream = [&] (uint64_t pos, uint64_t len, bufferlist& bl) {
+    if (pos < size_before_wrap) {
+      const auto size_to_read = std::min(len, size_before_wrap - pos);
+      bufferlist bl_chunk;
+      auto ret = cls_cxx_read(hctx, start.offset + pos, size_to_read, &bl_chunk);
+      if (ret < 0) {
+        return ret;
+      }
+      bl.claim_append(bl_chunk);
+      pos += size_to_read;
+      len -= size_to_read;
+    }
+    if (len > 0) {
+      bufferlist bl_chunk;
+      auto ret = cls_cxx_read(hctx, head.max_head_size + (pos - size_before_wrap), len, &bl_chunk);
+      if (ret < 0) {
+        return ret;
+      }
+      bl.claim_append(bl_chunk);
+    }
+    return 0;
+  };
+
+  bufferlist bl;
+  auto ret = read_stream(0, std::min(stream_size, large_chunk_size), bl);
+  if (ret < 0) {
+    return ret;
+  }
+
+  cls_queue_marker end_marker;
+  const bool has_end_marker = !op.end_marker.empty() && end_marker.from_str(op.end_marker.c_str()) == 0;
+  bool end_marker_reached = false;
+  uint64_t pos = 0;
+  auto it = bl.cbegin();
+  while (pos < stream_size && op_ret.num_entries < op.max) {
+    const auto marker = marker_at(pos);
+    if (has_end_marker && marker.offset == end_marker.offset && marker.gen == end_marker.gen) {
+      end_marker_reached = true;
+      break;
+    }
+    if (bl.length() - pos < QUEUE_ENTRY_OVERHEAD) {
+      if (pos > 0) {
+        break;
+      }
+      CLS_LOG(5, "ERROR: queue_list_entries_bulk: truncated entry header at: %lu", marker.offset);
+      return -EINVAL;
+    }
+    uint16_t entry_start = 0;
+    uint64_t data_size = 0;
+    try {
+      decode(entry_start, it);
+      decode(data_size, it);
+    } catch (const ceph::buffer::error& err) {
+      CLS_LOG(10, "ERROR: queue_list_entries_bulk: failed to decode entry header: %s", err.what());
+      return -EINVAL;
+    }
+    if (entry_start != QUEUE_ENTRY_START) {
+      CLS_LOG(5, "ERROR: queue_list_entries_bulk: invalid entry start %u", entry_start);
+      return -EINVAL;
+    }
+    if (data_size > stream_size - pos - QUEUE_ENTRY_OVERHEAD) {
+      CLS_LOG(5, "ERROR: queue_list_entries_bulk: entry at: %lu runs past the tail", marker.offset);
+      return -EINVAL;
+    }
+    const uint64_t entry_end = pos + QUEUE_ENTRY_OVERHEAD + data_size;
+    if (entry_end > bl.length()) {
+      if (pos > 0) {
+        // left for the next listing
+        break;
+      }
+      // the first entry is larger than a chunk, it is listed whole
+      ret = read_stream(bl.length(), entry_end - bl.length(), bl);
+      if (ret < 0) {
+        return ret;
+      }
+      it = bl.cbegin();
+      it += QUEUE_ENTRY_OVERHEAD;
+    }
+    it += data_size;
+    pos = entry_end;
+    op_ret.num_entries++;
+  }
+
+  op_ret.data.substr_of(bl, 0, pos);
+
+  cls_queue_marker next_marker;
+  if (end_marker_reached) {
+    next_marker = end_marker;
+  } else if (pos == stream_size) {
+    next_marker = head.tail;
+  } else {
+    next_marker = marker_at(pos);
+  }
+  if (next_marker.offset == head.queue_size) {
+    next_marker.offset = head.max_head_size;
+    next_marker.gen += 1;
+  }
+  op_ret.is_truncated = !((next_marker.offset == head.tail.offset) && (next_marker.gen == head.tail.gen));
+  op_ret.next_marker = next_marker.to_str();
+
+  CLS_LOG(10, "INFO: queue_list_entries_bulk(): listed %lu entries in %u bytes, next offset: %s",
+          op_ret.num_entries, op_ret.data.length(), op_ret.next_marker.c_str());
+  return 0;
+}
+
 int queue_list_entries(cls_method_context_t hctx, const cls_queue_list_op& op, cls_queue_list_ret& op_ret, cls_queue_head& head)
 {
   // If queue is empty, return from here
@@ -301,6 +436,10 @@ int queue_list_entries(cls_method_context_t hctx, const cls_queue_list_op& op, c
 
   CLS_LOG(10, "INFO: queue_list_entries(): front is: %s, tail is %s", head.front.to_str().c_str(), head.tail.to_str().c_str());
 
+  if (op.bulk) {
+    return queue_list_entries_bulk(hctx, op, op_ret, head, {start_offset, gen}, contiguous_data_size, wrap_around);
+  }
+
   bool offset_populated = false, entry_start_processed = false;
   uint64_t data_size = 0, num_ops = 0;
   uint16_t entry_start = 0;
@@ -1905,6 +1905,7 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
   }
 
   const uint64_t prev_epoch = olh.get_epoch();
+  rgw_cls_link_olh_ret reply;
 
   // op.olh_epoch is provided (> 0) in the case when a remote epoch is coming in as the result of multisite sync;
   uint64_t candidate_epoch = op.olh_epoch ? op.olh_epoch :
@@ -1964,6 +1965,14 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
     if (removing) {
       olh.update_log(CLS_RGW_OLH_OP_REMOVE_INSTANCE, op.op_tag, op.key, false);
     }
+    {
+      const auto& log = olh.get_entry().pending_log;
+      reply.olh_epoch = olh.get_epoch();
+      reply.removing = removing;
+      reply.own_log = (log.size() == 1 &&
+                       log.begin()->first == olh.get_epoch() &&
+                       log.begin()->second.size() == (removing ? 2u : 1u));
+    }
 
     if (promote) {
       olh.update(op.key, op.delete_marker);
@@ -1998,6 +2007,8 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
     return ret;
   }
 
+  encode(reply, *out);
+
   if (!op.log_op) {
     return write_header_while_logrecord(hctx, header);
   }
@@ -4353,6 +4364,135 @@ int rgw_user_usage_log_trim(cls_method_context_t hctx, bufferlist *in, bufferlis
   return 0;
 }
 
+struct usage_rollup_param
+{
+  const uint64_t period;
+  const bool key_transition;
+  bool found = false;
+  uint64_t last_epoch = 0; // of the last record listed
+};
+
+static int usage_log_rollup_cb(cls_method_context_t hctx, const string& key, rgw_usage_log_entry& entry, void *param)
+{
+  usage_rollup_param *rollup_param = (usage_rollup_param *)param;
+  rollup_param->last_epoch = entry.epoch;
+
+  const string o = entry.payer.empty() ? entry.owner.to_str() : entry.payer.to_str();
+
+  string key_by_time;
+  usage_record_name_by_time(entry.epoch, o, entry.bucket, key_by_time);
+  if (key != key_by_time) {
+    /* an old style by-user key listed among the by-time ones, the record is
+     * handled through its by-time key */
+    return 0;
+  }
+
+  const uint64_t epoch = entry.epoch - entry.epoch % rollup_param->period;
+  if (epoch == entry.epoch) {
+    /* already a rolled up record (or the first record of its period, which
+     * the others get merged into) */
+    return 0;
+  }
+  rollup_param->found = true;
+
+  string key_by_user;
+  usage_record_name_by_user(o, entry.epoch, entry.bucket, key_by_user);
+
+  int ret = cls_cxx_map_remove_key(hctx, key_by_time);
+  if (ret < 0)
+    return ret;
+  ret = cls_cxx_map_remove_key(hctx, key_by_user);
+  if (ret < 0 && ret != -ENOENT)
+    return ret;
+  if (rollup_param->key_transition && o.starts_with('0')) {
+    string key_by_user_old;
+    usage_record_name_by_user_old(o, entry.epoch, entry.bucket, key_by_user_old);
+    (void)cls_cxx_map_remove_key(hctx, key_by_user_old);
+  }
+
+  entry.epoch = epoch;
+  usage_record_name_by_time(epoch, o, entry.bucket, key_by_time);
+  usage_record_name_by_user(o, epoch, entry.bucket, key_by_user);
+
+  bufferlist record_bl;
+  ret = cls_cxx_map_get_val(hctx, key_by_time, &record_bl);
+  if (ret < 0 && ret != -ENOENT) {
+    CLS_LOG(1, "ERROR: usage_log_rollup_cb(): cls_cxx_map_get_val returned %d", ret);
+    return ret;
+  }
+  if (ret >= 0) {
+    rgw_usage_log_entry e;
+    ret = usage_record_decode(record_bl, e);
+    if (ret < 0)
+      return ret;
+    entry.aggregate(e);
+  }
+
+  bufferlist new_record_bl;
+  encode(entry, new_record_bl);
+  ret = cls_cxx_map_set_val(hctx, key_by_time, &new_record_bl);
+  if (ret < 0)
+    return ret;
+  return cls_cxx_map_set_val(hctx, key_by_user, &new_record_bl);
+}
+
+/*
+ * Merge the usage records of [start_epoch, end_epoch) into one record per
+ * user, bucket and period (e.g. a day), stored under the epoch the period
+ * starts at. Reading a range of rolled up records costs a fraction of the
+ * omap keys, at the price of the granularity within each period. Like trim,
+ * each call handles a bounded number of records and returns -ENODATA once
+ * there is nothing left to merge. Otherwise it replies with the epoch the
+ * next call should start from, so that records that are never merged, like
+ * already rolled up ones, aren't listed over and over.
+ */
+int rgw_user_usage_log_rollup(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  CLS_LOG(10, "entered %s", __func__);
+
+  /* only continue if object exists! */
+  int ret = cls_cxx_stat(hctx, NULL, NULL);
+  if (ret < 0)
+    return ret;
+
+  auto in_iter = in->cbegin();
+  rgw_cls_usage_log_rollup_op op;
+
+  try {
+    decode(op, in_iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_user_usage_log_rollup(): failed to decode request\n");
+    return -EINVAL;
+  }
+
+  if (op.period == 0) {
+    return -EINVAL;
+  }
+
+  string iter;
+  bool more;
+  const ConfigProxy& conf = cls_get_config(hctx);
+  usage_rollup_param rollup_param{op.period, conf->rgw_usage_log_key_transition};
+
+  ret = usage_iterate_range(hctx, op.start_epoch, op.end_epoch, "", "", iter, MAX_USAGE_TRIM_ENTRIES, more, usage_log_rollup_cb, (void *)&rollup_param);
+  if (ret < 0)
+    return ret;
+
+  if (!more && !rollup_param.found)
+    return -ENODATA;
+
+  /* the rest of the last epoch listed may still need merging. if nothing
+   * was merged, the whole page was records that never will be, so make
+   * sure the next call starts past the start of this one */
+  rgw_cls_usage_log_rollup_ret reply;
+  reply.next_epoch = rollup_param.last_epoch;
+  if (!rollup_param.found && reply.next_epoch <= op.start_epoch) {
+    reply.next_epoch = op.start_epoch + 1;
+  }
+  encode(reply, *out);
+  return 0;
+}
+
 int rgw_usage_log_clear(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 {
   CLS_LOG(10, "entered %s", __func__);
@@ -5228,6 +5368,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_user_usage_log_add;
   cls_method_handle_t h_rgw_user_usage_log_read;
   cls_method_handle_t h_rgw_user_usage_log_trim;
+  cls_method_handle_t h_rgw_user_usage_log_rollup;
   cls_method_handle_t h_rgw_usage_log_clear;
   cls_method_handle_t h_rgw_gc_set_entry;
   cls_method_handle_t h_rgw_gc_defer_entry;
@@ -5290,6 +5431,7 @@ CLS_INIT(rgw)
   cls_register_cxx_method(h_class, RGW_USER_USAGE_LOG_ADD, CLS_METHOD_RD | CLS_METHOD_WR, rgw_user_usage_log_add, &h_rgw_user_usage_log_add);
   cls_register_cxx_method(h_class, RGW_USER_USAGE_LOG_READ, CLS_METHOD_RD, rgw_user_usage_log_read, &h_rgw_user_usage_log_read);
   cls_register_cxx_method(h_class, RGW_USER_USAGE_LOG_TRIM, CLS_METHOD_RD | CLS_METHOD_WR, rgw_user_usage_log_trim, &h_rgw_user_usage_log_trim);
+  cls_register_cxx_method(h_class, RGW_USER_USAGE_LOG_ROLLUP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_user_usage_log_rollup, &h_rgw_user_usage_log_rollup);
   cls_register_cxx_method(h_class, RGW_USAGE_LOG_CLEAR, CLS_METHOD_WR, rgw_usage_log_clear, &h_rgw_usage_log_clear);
 
   /* garbage collection */
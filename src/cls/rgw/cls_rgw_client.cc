@@ -301,7 +301,8 @@ int cls_rgw_bucket_link_olh(librados::IoCtx& io_ctx, const string& oid,
 void cls_rgw_bucket_link_olh(librados::ObjectWriteOperation& op, const cls_rgw_obj_key& key,
                             const bufferlist& olh_tag, bool delete_marker,
                             const string& op_tag, const rgw_bucket_dir_entry_meta *meta,
-                            uint64_t olh_epoch, ceph::real_time unmod_since, bool high_precision_time, bool log_op, const rgw_zone_set& zones_trace)
+                            uint64_t olh_epoch, ceph::real_time unmod_since, bool high_precision_time, bool log_op, const rgw_zone_set& zones_trace,
+                            bufferlist *reply)
 {
   bufferlist in, out;
   rgw_cls_link_olh_op call;
@@ -318,7 +319,25 @@ void cls_rgw_bucket_link_olh(librados::ObjectWriteOperation& op, const cls_rgw_o
   call.high_precision_time = high_precision_time;
   call.zones_trace = zones_trace;
   encode(call, in);
-  op.exec(RGW_CLASS, RGW_BUCKET_LINK_OLH, in);
+  if (reply) {
+    op.exec(RGW_CLASS, RGW_BUCKET_LINK_OLH, in, reply, nullptr);
+  } else {
+    op.exec(RGW_CLASS, RGW_BUCKET_LINK_OLH, in);
+  }
+}
+
+int cls_rgw_bucket_link_olh_result(const bufferlist& reply, rgw_cls_link_olh_ret& ret)
+{
+  if (reply.length() == 0) {
+    return -ENODATA;
+  }
+  try {
+    auto iter = reply.cbegin();
+    decode(ret, iter);
+  } catch (ceph::buffer::error& err) {
+    return -EIO;
+  }
+  return 0;
 }
 
 int cls_rgw_bucket_unlink_instance(librados::IoCtx& io_ctx, const string& oid,
@@ -598,6 +617,37 @@ void cls_rgw_usage_log_trim(librados::ObjectWriteOperation& op, const string& us
   op.exec(RGW_CLASS, RGW_USER_USAGE_LOG_TRIM, in);
 }
 
+void cls_rgw_usage_log_rollup(librados::ObjectWriteOperation& op, uint64_t start_epoch, uint64_t end_epoch, uint32_t period,
+                              bufferlist* reply)
+{
+  bufferlist in;
+  rgw_cls_usage_log_rollup_op call;
+  call.start_epoch = start_epoch;
+  call.end_epoch = end_epoch;
+  call.period = period;
+  encode(call, in);
+
+  if (reply) {
+    op.exec(RGW_CLASS, RGW_USER_USAGE_LOG_ROLLUP, in, reply, nullptr);
+  } else {
+    op.exec(RGW_CLASS, RGW_USER_USAGE_LOG_ROLLUP, in);
+  }
+}
+
+int cls_rgw_usage_log_rollup_result(const bufferlist& reply, rgw_cls_usage_log_rollup_ret& ret)
+{
+  if (reply.length() == 0) {
+    return -ENODATA;
+  }
+  try {
+    auto iter = reply.cbegin();
+    decode(ret, iter);
+  } catch (ceph::buffer::error& err) {
+    return -EIO;
+  }
+  return 0;
+}
+
 void cls_rgw_usage_log_clear(ObjectWriteOperation& op)
 {
   bufferlist in;
@@ -168,10 +168,15 @@ int cls_rgw_bi_list(librados::IoCtx& io_ctx, const std::string& oid,
                    const std::string& name, const std::string& marker, uint32_t max,
                    std::list<rgw_cls_bi_entry> *entries, bool *is_truncated, bool reshardlog = false);
 
+// when reply is given, the op must be sent with librados::OPERATION_RETURNVEC
+// and the reply decoded with cls_rgw_bucket_link_olh_result()
 void cls_rgw_bucket_link_olh(librados::ObjectWriteOperation& op,
                             const cls_rgw_obj_key& key, const ceph::buffer::list& olh_tag,
                             bool delete_marker, const std::string& op_tag, const rgw_bucket_dir_entry_meta *meta,
-                            uint64_t olh_epoch, ceph::real_time unmod_since, bool high_precision_time, bool log_op, const rgw_zone_set& zones_trace);
+                            uint64_t olh_epoch, ceph::real_time unmod_since, bool high_precision_time, bool log_op, const rgw_zone_set& zones_trace,
+                            ceph::buffer::list *reply = nullptr);
+// returns -ENODATA if the osd did not send a reply
+int cls_rgw_bucket_link_olh_result(const ceph::buffer::list& reply, rgw_cls_link_olh_ret& ret);
 void cls_rgw_bucket_unlink_instance(librados::ObjectWriteOperation& op,
                                    const cls_rgw_obj_key& key, const std::string& op_tag,
                                    const std::string& olh_tag, uint64_t olh_epoch, bool log_op, uint16_t bilog_flags, const rgw_zone_set& zones_trace);
@@ -242,6 +247,13 @@ int cls_rgw_usage_log_read(librados::IoCtx& io_ctx, const std::string& oid, cons
 
 void cls_rgw_usage_log_trim(librados::ObjectWriteOperation& op, const std::string& user, const std::string& bucket, uint64_t start_epoch, uint64_t end_epoch);
 
+/* merges the records of [start_epoch, end_epoch) into one record per user,
+ * bucket and period; returns -ENODATA once there is nothing left to merge */
+void cls_rgw_usage_log_rollup(librados::ObjectWriteOperation& op, uint64_t start_epoch, uint64_t end_epoch, uint32_t period,
+                              ceph::buffer::list* reply = nullptr);
+// decode the reply of a rollup that returned 0; needs OPERATION_RETURNVEC
+int cls_rgw_usage_log_rollup_result(const ceph::buffer::list& reply, rgw_cls_usage_log_rollup_ret& ret);
+
 void cls_rgw_usage_log_clear(librados::ObjectWriteOperation& op);
 void cls_rgw_usage_log_add(librados::ObjectWriteOperation& op, rgw_usage_log_info& info);
 
@@ -217,6 +217,26 @@ void rgw_cls_link_olh_op::dump(Formatter *f) const
   encode_json("zones_trace", zones_trace, f);
 }
 
+list<rgw_cls_link_olh_ret> rgw_cls_link_olh_ret::generate_test_instances()
+{
+  list<rgw_cls_link_olh_ret> o;
+  rgw_cls_link_olh_ret r;
+  r.olh_epoch = 123;
+  r.own_log = true;
+  r.removing = true;
+
+  o.push_back(std::move(r));
+  o.emplace_back();
+  return o;
+}
+
+void rgw_cls_link_olh_ret::dump(Formatter *f) const
+{
+  encode_json("olh_epoch", olh_epoch, f);
+  encode_json("own_log", own_log, f);
+  encode_json("removing", removing, f);
+}
+
 list<rgw_cls_unlink_instance_op> rgw_cls_unlink_instance_op::generate_test_instances()
 {
   list<rgw_cls_unlink_instance_op> o;
@@ -229,6 +229,37 @@ struct rgw_cls_link_olh_op {
 };
 WRITE_CLASS_ENCODER(rgw_cls_link_olh_op)
 
+/* Returned by link_olh (with OPERATION_RETURNVEC) so that, when the olh
+ * log holds nothing but the entries this link added, the caller can
+ * apply them without reading the log back. Must stay within
+ * osd_max_write_op_reply_len. */
+struct rgw_cls_link_olh_ret
+{
+  uint64_t olh_epoch = 0; // epoch of the entries added by this link
+  bool own_log = false; // pending log holds only the entries added by this link
+  bool removing = false; // they include removing the replaced instance
+
+  void encode(ceph::buffer::list& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(olh_epoch, bl);
+    encode(own_log, bl);
+    encode(removing, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(ceph::buffer::list::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(olh_epoch, bl);
+    decode(own_log, bl);
+    decode(removing, bl);
+    DECODE_FINISH(bl);
+  }
+
+  static std::list<rgw_cls_link_olh_ret> generate_test_instances();
+  void dump(ceph::Formatter *f) const;
+};
+WRITE_CLASS_ENCODER(rgw_cls_link_olh_ret)
+
 struct rgw_cls_unlink_instance_op {
   cls_rgw_obj_key key;
   std::string op_tag;
@@ -1041,6 +1072,75 @@ struct rgw_cls_usage_log_trim_op {
 };
 WRITE_CLASS_ENCODER(rgw_cls_usage_log_trim_op)
 
+struct rgw_cls_usage_log_rollup_op {
+  uint64_t start_epoch = 0;
+  uint64_t end_epoch = 0;
+  uint32_t period = 0; // length of the rolled up records, in seconds
+
+  void encode(ceph::buffer::list& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(start_epoch, bl);
+    encode(end_epoch, bl);
+    encode(period, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(ceph::buffer::list::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(start_epoch, bl);
+    decode(end_epoch, bl);
+    decode(period, bl);
+    DECODE_FINISH(bl);
+  }
+
+  void dump(ceph::Formatter *f) const {
+    f->dump_unsigned("start_epoch", start_epoch);
+    f->dump_unsigned("end_epoch", end_epoch);
+    f->dump_unsigned("period", period);
+  }
+
+  static std::list<rgw_cls_usage_log_rollup_op> generate_test_instances() {
+    std::list<rgw_cls_usage_log_rollup_op> ls;
+    rgw_cls_usage_log_rollup_op m;
+    m.start_epoch = 3600;
+    m.end_epoch = 7200;
+    m.period = 86400;
+    ls.push_back(std::move(m));
+    return ls;
+  }
+};
+WRITE_CLASS_ENCODER(rgw_cls_usage_log_rollup_op)
+
+/* Returned by user_usage_log_rollup (with OPERATION_RETURNVEC) while there
+ * are records left: the start_epoch for the next call. */
+struct rgw_cls_usage_log_rollup_ret {
+  uint64_t next_epoch = 0;
+
+  void encode(ceph::buffer::list& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(next_epoch, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(ceph::buffer::list::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(next_epoch, bl);
+    DECODE_FINISH(bl);
+  }
+
+  void dump(ceph::Formatter *f) const {
+    f->dump_unsigned("next_epoch", next_epoch);
+  }
+
+  static std::list<rgw_cls_usage_log_rollup_ret> generate_test_instances() {
+    std::list<rgw_cls_usage_log_rollup_ret> ls;
+    ls.emplace_back();
+    ls.back().next_epoch = 7200;
+    return ls;
+  }
+};
+WRITE_CLASS_ENCODER(rgw_cls_usage_log_rollup_ret)
+
 struct cls_rgw_gc_set_entry_op {
   uint32_t expiration_secs;
   cls_rgw_gc_obj_info info;
@@ -3,7 +3,13 @@
 
 #include <random>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include "FastCDC.h"
+#include "arch/probe.h"
+#include "arch/intel.h"
 
 
 // Unlike FastCDC described in the paper, if we are close to the
@@ -100,6 +106,152 @@ static inline bool _scan(
   return true;
 }
 
+// The fingerprint at any position only depends on the window bytes
+// before it, since older bytes are shifted out.  That lets a
+// contiguous buffer be scanned without carrying fp between regions,
+// and lets several positions be scanned at once.
+static constexpr size_t window_bytes = sizeof(uint64_t)*8;
+
+// Same as _scan(), for a contiguous buffer.  Needs window_bytes of
+// data before pos.
+static bool _scan_contiguous(
+  const unsigned char *data,
+  size_t& pos,
+  size_t max,
+  uint64_t mask, const uint64_t *table)
+{
+  if (pos >= max) {
+    return true;
+  }
+  uint64_t fp = 0;
+  for (const unsigned char *w = data + pos - window_bytes; w < data + pos; ++w) {
+    fp = (fp << 1) ^ table[*w];
+  }
+  for (; pos < max; ++pos) {
+    if ((fp & mask) == mask) {
+      return false;
+    }
+    fp = (fp << 1) ^ table[data[pos]];
+  }
+  return true;
+}
+
+#if defined(__x86_64__)
+// Split [pos, max) into 4 segments and run the gear hash over them in
+// lockstep, one 64-bit lane each.  The first cut of the lowest lane
+// that has one wins, so we can only stop early when lane 0 hits.  The
+// remainder that doesn't divide evenly is scanned by the scalar loop.
+__attribute__((target("avx2")))
+static bool _scan_avx2(
+  const unsigned char *data,
+  size_t& pos,
+  size_t max,
+  uint64_t mask, const uint64_t *table)
+{
+  constexpr unsigned lanes = 4;
+  const size_t n = pos < max ? (max - pos) / lanes : 0;
+  if (n < window_bytes) {
+    return _scan_contiguous(data, pos, max, mask, table);
+  }
+  const unsigned char *s0 = data + pos;
+  const unsigned char *s1 = s0 + n;
+  const unsigned char *s2 = s1 + n;
+  const unsigned char *s3 = s2 + n;
+  const long long *t = reinterpret_cast<const long long*>(table);
+  const __m256i m = _mm256_set1_epi64x(mask);
+
+  // fill each lane's window from the bytes before its segment
+  __m256i fp = _mm256_setzero_si256();
+  for (ptrdiff_t i = -(ptrdiff_t)window_bytes; i < 0; ++i) {
+    __m256i idx = _mm256_set_epi64x(s3[i], s2[i], s1[i], s0[i]);
+    fp = _mm256_xor_si256(_mm256_slli_epi64(fp, 1),
+			  _mm256_i64gather_epi64(t, idx, 8));
+  }
+
+  unsigned found = 0;
+  size_t first[lanes] = {0};
+  for (size_t i = 0; i < n; ++i) {
+    __m256i hit = _mm256_cmpeq_epi64(_mm256_and_si256(fp, m), m);
+    unsigned bits = _mm256_movemask_pd(_mm256_castsi256_pd(hit)) & ~found;
+    if (bits) {
+      for (unsigned l = 0; l < lanes; ++l) {
+	if (bits & (1u << l)) {
+	  first[l] = i;
+	}
+      }
+      found |= bits;
+      if (found & 1) {
+	break;
+      }
+    }
+    __m256i idx = _mm256_set_epi64x(s3[i], s2[i], s1[i], s0[i]);
+    fp = _mm256_xor_si256(_mm256_slli_epi64(fp, 1),
+			  _mm256_i64gather_epi64(t, idx, 8));
+  }
+  if (found) {
+    unsigned l = __builtin_ctz(found);
+    pos += l * n + first[l];
+    return false;
+  }
+  pos += lanes * n;
+  return _scan_contiguous(data, pos, max, mask, table);
+}
+#endif
+
+using scan_contiguous_fn = bool (*)(const unsigned char*, size_t&, size_t,
+				    uint64_t, const uint64_t*);
+
+static scan_contiguous_fn choose_scan_contiguous()
+{
+  ceph_arch_probe();
+#if defined(__x86_64__)
+  if (ceph_arch_intel_avx2) {
+    return _scan_avx2;
+  }
+#endif
+  return _scan_contiguous;
+}
+
+static const scan_contiguous_fn scan_contiguous = choose_scan_contiguous();
+
+void FastCDC::_calc_chunks_contiguous(
+  const unsigned char *data,
+  size_t len,
+  std::vector<std::pair<uint64_t, uint64_t>> *chunks) const
+{
+  size_t pos = 0;
+  while (pos < len) {
+    size_t cstart = pos;
+
+    // are we left with a min-sized (or smaller) chunk?
+    if (len - pos <= (1ul << min_bits)) {
+      chunks->push_back(std::pair<uint64_t,uint64_t>(pos, len - pos));
+      break;
+    }
+
+    // the window before the min chunk size cut point seeds the
+    // fingerprint, so there is nothing to fill here
+    pos += 1 << min_bits;
+    ceph_assert(pos < len);
+
+    // find an end marker
+    if (
+      scan_contiguous(data, pos,
+		      std::min(len, cstart + (1 << (target_bits - TARGET_WINDOW_BITS))),
+		      small_mask, table) &&
+      (TARGET_WINDOW_BITS == 0 ||
+       scan_contiguous(data, pos,
+		       std::min(len, cstart + (1 << (target_bits + TARGET_WINDOW_BITS))),
+		       target_mask, table)) &&
+      scan_contiguous(data, pos,
+		      std::min(len, cstart + (1 << max_bits)),
+		      large_mask, table))
+      ;
+
+    chunks->push_back(std::pair<uint64_t,uint64_t>(cstart, pos - cstart));
+  }
+}
+
 void FastCDC::calc_chunks(
   const bufferlist& bl,
   std::vector<std::pair<uint64_t, uint64_t>> *chunks) const
@@ -107,6 +259,12 @@ void FastCDC::calc_chunks(
   if (bl.length() == 0) {
     return;
   }
+  if (bl.get_num_buffers() == 1) {
+    _calc_chunks_contiguous(
+      reinterpret_cast<const unsigned char*>(bl.front().c_str()),
+      bl.length(), chunks);
+    return;
+  }
   auto p = bl.buffers().begin();
   const char *pp = p->c_str();
   const char *pe = pp + p->length();
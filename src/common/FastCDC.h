@@ -39,6 +39,12 @@ private:
 
   void _setup(int target, int window_bits);
 
+  /// calc_chunks() for a bufferlist with a single buffer
+  void _calc_chunks_contiguous(
+    const unsigned char *data,
+    size_t len,
+    std::vector<std::pair<uint64_t, uint64_t>> *chunks) const;
+
 public:
   FastCDC(int target = 18, int window_bits = 0) {
     _setup(target, window_bits);
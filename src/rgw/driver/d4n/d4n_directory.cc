@@ -1353,6 +1353,107 @@ int BlockDirectory::del(const DoutPrefixProvider* dpp, CacheBlock* block, option
   return 0; 
 }
 
+int BlockDirectory::del(const DoutPrefixProvider* dpp, std::vector<CacheBlock>& blocks, optional_yield y)
+{
+  if (blocks.empty()) {
+    return 0;
+  }
+
+  std::vector<std::string> keys;
+  keys.reserve(blocks.size());
+  for (auto& block : blocks) {
+    keys.push_back(build_index(&block));
+    ldpp_dout(dpp, 10) << "BlockDirectory::" << __func__ << "(): index is: " << keys.back() << dendl;
+  }
+
+  try {
+    boost::system::error_code ec;
+    request req;
+    req.push_range("DEL", keys);
+    response<int> resp;
+    redis_exec_connection_pool(dpp, redis_pool, conn, ec, req, resp, y);
+    if (ec) {
+      ldpp_dout(dpp, 0) << "BlockDirectory::" << __func__ << "() ERROR: " << ec.what() << dendl;
+      return -ec.value();
+    }
+    ldpp_dout(dpp, 10) << "BlockDirectory::" << __func__ << "(): deleted " << std::get<0>(resp).value() << " of " << keys.size() << " keys" << dendl;
+  } catch (std::exception &e) {
+    ldpp_dout(dpp, 0) << "BlockDirectory::" << __func__ << "() ERROR: " << e.what() << dendl;
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+/* Sets (or appends to, for the hosts list) a field of every existing key in KEYS.
+   Running the existence check on the server avoids an EXISTS round trip per block. */
+static const std::string update_field_script = R"(
+local n = 0
+for _, key in ipairs(KEYS) do
+  if redis.call('EXISTS', key) == 1 then
+    local value = ARGV[2]
+    if ARGV[3] == '1' then
+      local hosts = redis.call('HGET', key, ARGV[1])
+      if hosts and hosts ~= '' then
+        value = hosts .. '_' .. value
+      end
+    end
+    redis.call('HSET', key, ARGV[1], value)
+    n = n + 1
+  end
+end
+return n
+)";
+
+int BlockDirectory::update_field(const DoutPrefixProvider* dpp, std::vector<CacheBlock>& blocks, const std::string& field, std::string& value, optional_yield y)
+{
+  if (blocks.empty()) {
+    return 0;
+  }
+
+  if (field == "dirty") {
+    int ret = -1;
+    if ((ret = check_bool(value)) != -EINVAL) {
+      bool val = (ret != 0);
+      value = std::to_string(val);
+    } else {
+      ldpp_dout(dpp, 0) << "BlockDirectory::" << __func__ << "() ERROR: Invalid bool value" << dendl;
+      return -EINVAL;
+    }
+  }
+
+  std::vector<std::string> args;
+  args.reserve(blocks.size() + 5);
+  args.push_back(update_field_script);
+  args.push_back(std::to_string(blocks.size()));
+  for (auto& block : blocks) {
+    args.push_back(build_index(&block));
+  }
+  args.push_back(field);
+  args.push_back(value);
+  args.push_back(field == "hosts" ? "1" : "0");
+
+  try {
+    boost::system::error_code ec;
+    response<int> resp;
+    request req;
+    req.push_range("EVAL", args);
+
+    redis_exec_connection_pool(dpp, redis_pool, conn, ec, req, resp, y);
+
+    if (ec) {
+      ldpp_dout(dpp, 0) << "BlockDirectory::" << __func__ << "() ERROR: " << ec.what() << dendl;
+      return -ec.value();
+    }
+    ldpp_dout(dpp, 20) << "BlockDirectory::" << __func__ << "(): updated " << std::get<0>(resp).value() << " of " << blocks.size() << " blocks" << dendl;
+  } catch (std::exception &e) {
+    ldpp_dout(dpp, 0) << "BlockDirectory::" << __func__ << "() ERROR: " << e.what() << dendl;
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
 int BlockDirectory::update_field(const DoutPrefixProvider* dpp, CacheBlock* block, const std::string& field, std::string& value, optional_yield y)
 {
   int ret = -1;
@@ -225,7 +225,11 @@ class BlockDirectory: public Directory {
     int get(const DoutPrefixProvider* dpp, std::vector<CacheBlock>& blocks, optional_yield y);
     int copy(const DoutPrefixProvider* dpp, CacheBlock* block, const std::string& copyName, const std::string& copyBucketName, optional_yield y);
     int del(const DoutPrefixProvider* dpp, CacheBlock* block, optional_yield y);
+    //Pipelined version of del, deletes all blocks with a single command
+    int del(const DoutPrefixProvider* dpp, std::vector<CacheBlock>& blocks, optional_yield y);
     int update_field(const DoutPrefixProvider* dpp, CacheBlock* block, const std::string& field, std::string& value, optional_yield y);
+    //Pipelined version of update_field, updates the field of all existing blocks in a single round trip
+    int update_field(const DoutPrefixProvider* dpp, std::vector<CacheBlock>& blocks, const std::string& field, std::string& value, optional_yield y);
     int remove_host(const DoutPrefixProvider* dpp, CacheBlock* block, std::string& value, optional_yield y);
     int zadd(const DoutPrefixProvider* dpp, CacheBlock* block, double score, const std::string& member, optional_yield y);
     int zrange(const DoutPrefixProvider* dpp, CacheBlock* block, int start, int stop, std::vector<std::string>& members, optional_yield y);
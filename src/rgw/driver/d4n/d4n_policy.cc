@@ -68,7 +68,12 @@ int LFUDAPolicy::init(CephContext* cct, const DoutPrefixProvider* dpp, asio::io_
   driver = _driver;
   if (dpp->get_cct()->_conf->d4n_writecache_enabled) {
     quit = false;
-    tc = std::thread(&CachePolicy::cleaning, this, dpp);
+    max_dirty_bytes = dpp->get_cct()->_conf->rgw_d4n_writecache_max_dirty_bytes;
+    dirty_cond.emplace(io_context.get_executor());
+    const uint64_t num_threads = std::max<uint64_t>(1, dpp->get_cct()->_conf->rgw_d4n_cache_cleaning_threads);
+    for (uint64_t i = 0; i < num_threads; i++) {
+      tc.emplace_back(&CachePolicy::cleaning, this, dpp);
+    }
   }
 
   try {
@@ -508,7 +513,9 @@ void LFUDAPolicy::update_dirty_object(const DoutPrefixProvider* dpp, const std::
   LFUDAObjEntry* e = new LFUDAObjEntry{key, version, deleteMarker, size, creationTime, user, etag, bucket_name, bucket_id, obj_key};
   handle_type handle = object_heap.push(e);
   e->set_handle(handle);
-  o_entries_map.emplace(key, std::make_pair(e, state));
+  if (o_entries_map.emplace(key, std::make_pair(e, state)).second) {
+    dirty_bytes += size;
+  }
   cond.notify_one();
 }
 
@@ -537,21 +544,131 @@ bool LFUDAPolicy::erase(const DoutPrefixProvider* dpp, const std::string& key, o
 
 bool LFUDAPolicy::erase_dirty_object(const DoutPrefixProvider* dpp, const std::string& key, optional_yield y)
 {
-  const std::lock_guard l(lfuda_cleaning_lock);
+  std::unique_lock<std::mutex> l(lfuda_cleaning_lock);
   auto p = o_entries_map.find(key);
   if (p == o_entries_map.end()) {
     return false;
   }
 
-  object_heap.erase(p->second.first->handle);
-  delete p->second.first;
+  LFUDAObjEntry* e = p->second.first;
+  if (e->claimed) {
+    claimed_objects--;
+  }
+  dirty_bytes -= std::min(dirty_bytes, e->size);
+  object_heap.erase(e->handle);
+  delete e;
   p->second.first = nullptr;
   o_entries_map.erase(p);
   state_cond.notify_one();
+  if (dirty_cond) {
+    dirty_cond->notify(l);
+  }
 
   return true;
 }
 
+/* Returns the oldest dirty object which is not being handled by another cleaning
+   thread, or nullptr if there is none. Must be called with lfuda_cleaning_lock held. */
+LFUDAPolicy::LFUDAObjEntry* LFUDAPolicy::next_dirty_object()
+{
+  if (object_heap.size() <= claimed_objects) {
+    return nullptr;
+  }
+  if (!object_heap.top()->claimed) {
+    return object_heap.top();
+  }
+  for (auto it = object_heap.ordered_begin(); it != object_heap.ordered_end(); ++it) {
+    if (!(*it)->claimed) {
+      return *it;
+    }
+  }
+  return nullptr;
+}
+
+/* Makes an object picked up by a cleaning thread visible to the other cleaning threads
+   again. This is a no-op if the object has been written back and erased meanwhile. */
+void LFUDAPolicy::release_dirty_object(const std::string& key)
+{
+  const std::lock_guard l(lfuda_cleaning_lock);
+  auto p = o_entries_map.find(key);
+  if (p == o_entries_map.end() || !p->second.first->claimed) {
+    return;
+  }
+  p->second.first->claimed = false;
+  claimed_objects--;
+  cond.notify_one();
+}
+
+/* Applies backpressure on writers when the dirty objects that have not been written
+   back yet exceed rgw_d4n_writecache_max_dirty_bytes. Cleaning threads ignore the
+   cleaning interval while the write cache is under pressure, so writers are released
+   as soon as enough objects have been written back. A writer running in a coroutine
+   is suspended until then; other writers can't be put to sleep without blocking
+   their thread, so they get -EBUSY instead. */
+int LFUDAPolicy::writeback_throttle(const DoutPrefixProvider* dpp, uint64_t size, optional_yield y)
+{
+  if (max_dirty_bytes == 0 || !dirty_cond) {
+    return 0;
+  }
+
+  std::unique_lock<std::mutex> l(lfuda_cleaning_lock);
+  auto can_write = [this, size] {
+    return dirty_bytes == 0 || dirty_bytes + size <= max_dirty_bytes || quit;
+  };
+  if (can_write()) {
+    return 0;
+  }
+
+  cond.notify_all();
+  if (!y) {
+    ldpp_dout(dpp, 10) << "LFUDAPolicy::" << __func__ << "(): dirty_bytes=" << dirty_bytes
+                       << " exceeds the write cache limit, rejecting write" << dendl;
+    return -EBUSY;
+  }
+
+  ldpp_dout(dpp, 10) << "LFUDAPolicy::" << __func__ << "(): dirty_bytes=" << dirty_bytes
+                     << " exceeds the write cache limit, waiting for writeback" << dendl;
+  auto start = ceph::mono_clock::now();
+  boost::system::error_code ec;
+  throttled_writers++;
+  while (!ec && !can_write()) {
+    dirty_cond->async_wait(l, y.get_yield_context()[ec]);
+  }
+  throttled_writers--;
+  throttle_cond.notify_all();
+  auto stall = ceph::mono_clock::now() - start;
+  l.unlock();
+
+  if (perfcounter) {
+    perfcounter->tinc(l_rgw_d4n_writeback_stall_lat, stall);
+  }
+  if (ec) {
+    ldpp_dout(dpp, 10) << "LFUDAPolicy::" << __func__ << "(): wait for writeback canceled: " << ec.message() << dendl;
+    return -ECANCELED;
+  }
+  ldpp_dout(dpp, 10) << "LFUDAPolicy::" << __func__ << "(): write stalled for " << stall << dendl;
+  return 0;
+}
+
+/* Wakes the writers suspended in writeback_throttle() with -ECANCELED and waits for
+   them to resume. Their completions relock lfuda_cleaning_lock, so the policy must
+   outlive them. Writers whose io_context was stopped never resume, and aren't
+   waited for. */
+void LFUDAPolicy::drain_throttled_writers()
+{
+  if (!dirty_cond) {
+    return;
+  }
+  auto& ctx = asio::query(dirty_cond->get_executor(), asio::execution::context);
+  std::unique_lock<std::mutex> l(lfuda_cleaning_lock);
+  dirty_cond->cancel();
+  while (throttled_writers > 0 && !ctx.stopped()) {
+    throttle_cond.wait_for(l, std::chrono::milliseconds(100));
+  }
+  l.unlock();
+  dirty_cond.reset();
+}
+
 int LFUDAPolicy::delete_data_blocks(const DoutPrefixProvider* dpp, LFUDAObjEntry* e, optional_yield y) {
   off_t lst = e->size, fst = 0;
 
@@ -591,7 +708,12 @@ int LFUDAPolicy::delete_data_blocks(const DoutPrefixProvider* dpp, LFUDAObjEntry
 void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 {
   const int interval = dpp->get_cct()->_conf->rgw_d4n_cache_cleaning_interval;
+  std::string claimed_key;
   while(!quit) {
+    if (!claimed_key.empty()) {
+      release_dirty_object(claimed_key);
+      claimed_key.clear();
+    }
     ldpp_dout(dpp, 20) << __func__ << " : " << " Cache cleaning!" << dendl;
     uint64_t len = 0;
     rgw::sal::Attrs obj_attrs;
@@ -599,11 +721,9 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
   
     ldpp_dout(dpp, 20) << "LFUDAPolicy::" << __func__ << "" << __LINE__ << "(): Before acquiring cleaning-lock" << dendl;
     std::unique_lock<std::mutex> l(lfuda_cleaning_lock);
-    LFUDAObjEntry* e;
-    if (object_heap.size() > 0) {
-      e = object_heap.top();
-    } else {
-      cond.wait(l, [this]{ return (!object_heap.empty() || quit); });
+    LFUDAObjEntry* e = next_dirty_object();
+    if (e == nullptr) {
+      cond.wait(l, [this]{ return (object_heap.size() > claimed_objects || quit); });
       continue;
     }
     ldpp_dout(dpp, 10) <<__LINE__ << " " << __func__ << "(): e->key=" << e->key << dendl;
@@ -613,11 +733,10 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
     ldpp_dout(dpp, 10) << __LINE__ << " " << __func__ << "(): e->bucket_id=" << e->bucket_id << dendl;
     ldpp_dout(dpp, 10) << __LINE__ << " " << __func__ << "(): e->user=" << e->user << dendl;
     ldpp_dout(dpp, 10) << __LINE__ << " " << __func__ << "(): e->obj_key=" << e->obj_key << dendl;
-    l.unlock();
 
     int diff = std::difftime(time(NULL), e->creationTime);
-    if (!e->key.empty() && (diff > interval)) { // if block is dirty and written more than interval seconds ago
-      l.lock();
+    // if block is dirty and written more than interval seconds ago, or the write cache is filling up
+    if (!e->key.empty() && (diff > interval || writeback_pressure())) {
       auto p = o_entries_map.find(e->key);
       if (p == o_entries_map.end()) {
 	l.unlock();
@@ -628,6 +747,8 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
       } else {
         p->second.second = State::IN_PROGRESS;
       }
+      claim_dirty_object(e);
+      claimed_key = e->key;
       l.unlock();
       
       // If the state is invalid, the blocks must be deleted from the cache rather than written to the backend.
@@ -757,7 +878,10 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 	  off_t ofs = 0;
 
 	  rgw::sal::DataProcessor* filter = processor.get();
-	  bufferlist bl;
+	  /* adjacent cache blocks are coalesced, so that the backend is handed full stripes
+	     rather than one cache block at a time */
+	  const uint64_t stripe_size = dpp->get_cct()->_conf->rgw_obj_stripe_size;
+	  bufferlist pending;
 	  op_ret = cacheDriver->get_attrs(dpp, e->key, obj_attrs, null_yield); //get obj attrs from head
 	  if (op_ret < 0) {
 	    ldpp_dout(dpp, 20) << __func__ << "cacheDriver->get_attrs returned ret=" << op_ret << dendl;
@@ -783,11 +907,10 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 	    std::string oid_in_cache = rgw::sal::get_key_in_cache(e->key, std::to_string(fst), std::to_string(cur_len));
 	    ldpp_dout(dpp, 10) << __func__ << "(): oid_in_cache=" << oid_in_cache << dendl;
 	    rgw::sal::Attrs attrs;
-	    cacheDriver->get(dpp, oid_in_cache, 0, cur_len, data, attrs, null_yield);
+	    op_ret = cacheDriver->get(dpp, oid_in_cache, 0, cur_len, data, attrs, null_yield);
 	    if (op_ret < 0) {
 	      ldpp_dout(dpp, 20) << __func__ << "cacheDriver->get returned ret=" << op_ret << dendl;
-	      erase_dirty_object(dpp, e->key, null_yield);
-	      continue;
+	      break;
 	    }
 	    len = data.length();
 	    fst += len;
@@ -797,15 +920,31 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 	      break;
 	    }
 
-	    op_ret = filter->process(std::move(data), ofs);
+	    pending.claim_append(data);
+	    if (pending.length() >= stripe_size) {
+	      uint64_t pending_len = pending.length();
+	      op_ret = filter->process(std::move(pending), ofs);
+	      pending.clear();
+	      if (op_ret < 0) {
+		ldpp_dout(dpp, 20) << __func__ << "processor->process() returned ret=" << op_ret << dendl;
+		break;
+	      }
+	      ofs += pending_len;
+	    }
+	  } while (len > 0);
+
+	  if (op_ret >= 0 && pending.length() > 0) {
+	    uint64_t pending_len = pending.length();
+	    op_ret = filter->process(std::move(pending), ofs);
 	    if (op_ret < 0) {
 	      ldpp_dout(dpp, 20) << __func__ << "processor->process() returned ret=" << op_ret << dendl;
-	      erase_dirty_object(dpp, e->key, null_yield);
-	      continue;
 	    }
-
-	    ofs += len;
-	  } while (len > 0);
+	    ofs += pending_len;
+	  }
+	  if (op_ret < 0) {
+	    erase_dirty_object(dpp, e->key, null_yield);
+	    continue;
+	  }
 
 	  op_ret = filter->process({}, ofs);
 
@@ -825,6 +964,7 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 	     reset values */
 	  lst = e->size;
 	  fst = 0;
+	  std::vector<rgw::d4n::CacheBlock> clean_blocks;
 	  do {
 	    if (fst >= lst) {
 	break;
@@ -843,17 +983,20 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 	    block.size = cur_len;
 	    block.blockID = fst;
             if ((op_ret = cacheDriver->set_attr(dpp, oid_in_cache, RGW_CACHE_ATTR_DIRTY, "0", y)) == 0) {
-        std::string dirty = "false";
-	      op_ret = blockDir->update_field(dpp, &block, "dirty", dirty, null_yield);
-	      if (op_ret < 0) {
-		ldpp_dout(dpp, 0) << __func__ << "updating dirty flag in block directory failed, ret=" << op_ret << dendl;
-	      }
+	      clean_blocks.push_back(std::move(block));
             } else {
 	      ldpp_dout(dpp, 0) << __func__ << "(): Failed to update dirty xattr in cache, ret=" << op_ret << dendl;
             }
 
 	    fst += cur_len;
 	  } while(fst < lst);
+
+	  //update the dirty flag of all blocks in the block directory in a single round trip
+	  std::string dirty = "false";
+	  op_ret = blockDir->update_field(dpp, clean_blocks, "dirty", dirty, null_yield);
+	  if (op_ret < 0) {
+	    ldpp_dout(dpp, 0) << __func__ << "updating dirty flag in block directory failed, ret=" << op_ret << dendl;
+	  }
 	} //end-else if delete_marker
 
 	//invoke update() with dirty flag set to false, to update in-memory metadata for head
@@ -893,9 +1036,11 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 		if (null_block.version == e->version) {
 		  block.cacheObj.dirty = false;
 		  null_block.cacheObj.dirty = false;
-		  auto blk_op_ret = blockDir->set(dpp, &block, y);
-		  auto null_op_ret = blockDir->set(dpp, &null_block, y);
-		  if (blk_op_ret < 0 || null_op_ret < 0) {
+		  rgw::d4n::Pipeline p = rgw::d4n::Pipeline(conn, blockDir->redis_pool);
+		  p.start();
+		  auto blk_op_ret = blockDir->set(dpp, &block, y, &p);
+		  auto null_op_ret = blockDir->set(dpp, &null_block, y, &p);
+		  if (blk_op_ret < 0 || null_op_ret < 0 || p.execute(dpp, y) < 0) {
 		    ldpp_dout(dpp, 0) << __func__ << "(): Failed to Queue update dirty flag for latest entry/null entry in block directory" << dendl;
 		  }
 		}
@@ -969,14 +1114,16 @@ void LFUDAPolicy::cleaning(const DoutPrefixProvider* dpp)
 	    break;
 	  }//end-while (retry)
 	}
+	if (perfcounter) {
+	  perfcounter->inc(l_rgw_d4n_writeback_objects);
+	  perfcounter->inc(l_rgw_d4n_writeback_bytes, e->size);
+	}
 	//remove entry from map and queue, erase_dirty_object locks correctly
 	erase_dirty_object(dpp, e->key, null_yield);
       }
-    } else if (diff < interval) { //end-if std::difftime(time(NULL), e->creationTime) > interval
-      {
-        std::unique_lock<std::mutex> wait_lock(lfuda_cleaning_lock);
-        cond.wait_for(wait_lock, std::chrono::seconds(interval - diff), []{ return quit.load(); });
-      }
+    } else { //end-if std::difftime(time(NULL), e->creationTime) > interval
+      // woken up early if the write cache comes under pressure
+      cond.wait_for(l, std::chrono::seconds(std::max(interval - diff, 1)), [this]{ return quit.load() || writeback_pressure(); });
       continue;
     }
   } //end-while true
@@ -6,10 +6,13 @@
 #include <boost/heap/fibonacci_heap.hpp>
 #include <boost/system/detail/errc.hpp>
 
+#include "common/async/async_cond.h"
 #include "d4n_directory.h"
 #include "rgw_sal_d4n.h"
 #include "rgw_cache_driver.h"
 
+class LFUDAPolicyFixture;
+
 namespace rgw { namespace d4n {
 
 namespace asio = boost::asio;
@@ -84,6 +87,7 @@ class CachePolicy {
     virtual bool erase_dirty_object(const DoutPrefixProvider* dpp, const std::string& key, optional_yield y) = 0;
     virtual bool invalidate_dirty_object(const DoutPrefixProvider* dpp, const std::string& key) = 0;
     virtual void cleaning(const DoutPrefixProvider* dpp) = 0;
+    virtual int writeback_throttle(const DoutPrefixProvider* dpp, uint64_t size, optional_yield y) = 0;
 };
 
 class LFUDAPolicy : public CachePolicy {
@@ -130,6 +134,7 @@ class LFUDAPolicy : public CachePolicy {
     struct LFUDAObjEntry : public ObjEntry {
       using handle_type = boost::heap::fibonacci_heap<LFUDAObjEntry*, boost::heap::compare<ObjectComparator<LFUDAObjEntry>>>::handle_type;
       handle_type handle;
+      bool claimed{false}; // picked up by one of the cleaning threads
 
       LFUDAObjEntry(const std::string& key, const std::string& version, bool deleteMarker, uint64_t size,
                      double creationTime, const rgw_user& user, const std::string& etag,
@@ -149,7 +154,13 @@ class LFUDAPolicy : public CachePolicy {
     std::mutex lfuda_cleaning_lock;
     std::condition_variable cond;
     std::condition_variable state_cond;
+    std::condition_variable throttle_cond; // signalled when a throttled writer resumes
+    std::optional<ceph::async::async_cond<asio::io_context::executor_type>> dirty_cond; // signalled when dirty objects are written back or removed
     inline static std::atomic<bool> quit{false};
+    uint64_t dirty_bytes{0}; // total size of dirty objects, protected by lfuda_cleaning_lock
+    uint64_t max_dirty_bytes{0};
+    size_t claimed_objects{0};
+    size_t throttled_writers{0}; // writers waiting on dirty_cond, protected by lfuda_cleaning_lock
 
     int age = 1, weightSum = 0, postedSum = 0;
     optional_yield y = null_yield;
@@ -160,7 +171,7 @@ class LFUDAPolicy : public CachePolicy {
     rgw::cache::CacheDriver* cacheDriver;
     std::optional<asio::steady_timer> rthread_timer;
     rgw::sal::Driver* driver;
-    std::thread tc;
+    std::vector<std::thread> tc;
 
     CacheBlock* get_victim_block(const DoutPrefixProvider* dpp, optional_yield y);
     int age_sync(const DoutPrefixProvider* dpp, optional_yield y); 
@@ -180,6 +191,18 @@ class LFUDAPolicy : public CachePolicy {
       return it->second;
     }
     int delete_data_blocks(const DoutPrefixProvider* dpp, LFUDAObjEntry* e, optional_yield y);
+    LFUDAObjEntry* next_dirty_object();
+    void claim_dirty_object(LFUDAObjEntry* e) {
+      e->claimed = true;
+      claimed_objects++;
+    }
+    void release_dirty_object(const std::string& key);
+    void drain_throttled_writers();
+    bool writeback_pressure() const {
+      return max_dirty_bytes > 0 && dirty_bytes >= max_dirty_bytes / 2;
+    }
+
+    friend class ::LFUDAPolicyFixture;
 
   public:
     LFUDAPolicy(std::shared_ptr<connection>& conn, rgw::cache::CacheDriver* cacheDriver, optional_yield y) : CachePolicy(), 
@@ -193,13 +216,19 @@ class LFUDAPolicy : public CachePolicy {
     }
     ~LFUDAPolicy() {
       rthread_stop();
+      {
+        const std::lock_guard l(lfuda_cleaning_lock);
+        quit = true;
+      }
+      cond.notify_all();
+      for (auto& t : tc) {
+        if (t.joinable()) { t.join(); }
+      }
+      drain_throttled_writers();
       delete bucketDir;
       delete blockDir;
       delete objDir;
-      quit = true;
-      cond.notify_all();
-      if (tc.joinable()) { tc.join(); }
-    } 
+    }
 
     virtual int init(CephContext *cct, const DoutPrefixProvider* dpp, asio::io_context& io_context, rgw::sal::Driver *_driver);
     virtual int exist_key(const std::string& key) override;
@@ -214,6 +243,7 @@ class LFUDAPolicy : public CachePolicy {
     virtual bool erase_dirty_object(const DoutPrefixProvider* dpp, const std::string& key, optional_yield y) override;
     virtual bool invalidate_dirty_object(const DoutPrefixProvider* dpp, const std::string& key) override;
     virtual void cleaning(const DoutPrefixProvider* dpp) override;
+    virtual int writeback_throttle(const DoutPrefixProvider* dpp, uint64_t size, optional_yield y) override;
     LFUDAObjEntry* find_obj_entry(const std::string& key) {
       auto it = o_entries_map.find(key);
       if (it == o_entries_map.end()) {
@@ -251,6 +281,7 @@ class LRUPolicy : public CachePolicy {
     virtual bool erase_dirty_object(const DoutPrefixProvider* dpp, const std::string& key, optional_yield y) override;
     virtual bool invalidate_dirty_object(const DoutPrefixProvider* dpp, const std::string& key) override { return false; }
     virtual void cleaning(const DoutPrefixProvider* dpp) override {}
+    virtual int writeback_throttle(const DoutPrefixProvider* dpp, uint64_t size, optional_yield y) override { return 0; }
 };
 
 class PolicyDriver {
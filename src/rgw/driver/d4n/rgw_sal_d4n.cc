@@ -2583,8 +2583,8 @@ int D4NFilterObject::D4NFilterDeleteOp::delete_obj(const DoutPrefixProvider* dpp
         off_t lst = size;
         off_t fst = 0;
 
+      std::vector<rgw::d4n::CacheBlock> data_blocks;
       do { // loop through the data blocks
-        std::string prefix = get_cache_block_prefix(source, version);
         if (fst >= lst) {
           break;
         }
@@ -2594,30 +2594,16 @@ int D4NFilterObject::D4NFilterDeleteOp::delete_obj(const DoutPrefixProvider* dpp
         off_t cur_len = cur_size - fst;
         block.blockID = static_cast<uint64_t>(fst);
         block.size = static_cast<uint64_t>(cur_len);
-
-          if ((ret = blockDir->get(dpp, &block, y)) < 0) {
-            if (ret == -ENOENT) {
-              ldpp_dout(dpp, 10) << "D4NFilterObject::" << __func__ << "(): Directory entry for: " << source->get_oid() << " blockid: " << fst << " block size: " << cur_len << " does not exist; continuing" << dendl;
-              fst += cur_len;
-              if (fst >= lst) {
-                break;
-              }
-              continue;
-            } else {
-              ldpp_dout(dpp, 10) << "D4NFilterObject::" << __func__ << "(): Failed to retrieve directory entry for: " << source->get_oid() << " blockid: " << fst << " block size: " << cur_len << ", ret=" << ret << dendl;
-              return ret;
-            }
-          }
-
-          if ((ret = blockDir->del(dpp, &block, y)) == -ENOENT) { 
-            continue;
-          } else if (ret < 0) {
-            ldpp_dout(dpp, 0) << "D4NFilterObject::" << __func__ << "(): Failed to delete directory entry for: " << source->get_name() << " blockid: " << fst << " block size: " << cur_len << ", ret=" << ret << dendl;
-            return ret;
-          }
+        data_blocks.push_back(block);
 
         fst += cur_len;
       } while (fst < lst);
+
+      //directory entries of blocks which do not exist are skipped by the server
+      if ((ret = blockDir->del(dpp, data_blocks, y)) < 0) {
+        ldpp_dout(dpp, 0) << "D4NFilterObject::" << __func__ << "(): Failed to delete directory entries for: " << source->get_name() << ", ret=" << ret << dendl;
+        return ret;
+      }
     }
 
     if (!objDirty) {
@@ -2692,6 +2678,11 @@ int D4NFilterWriter::process(bufferlist&& data, uint64_t offset)
       std::string oid = prefix + CACHE_DELIM + std::to_string(ofs);
       std::string oid_in_cache = oid + CACHE_DELIM + std::to_string(bl_len);
       dirty = true;
+      ret = driver->get_policy_driver()->get_cache_policy()->writeback_throttle(dpp, bl.length(), y);
+      if (ret < 0) {
+        ldpp_dout(dpp, 0) << "D4NFilterWriter::" << __func__ << "(): ERROR: write cache is full, ret=" << ret << dendl;
+        return ret;
+      }
       ret = driver->get_policy_driver()->get_cache_policy()->eviction(dpp, bl.length(), y);
       if (ret == 0) {     
         if (bl.length() > 0) {          
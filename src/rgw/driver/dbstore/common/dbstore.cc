@@ -255,7 +255,11 @@ int DB::ProcessOp(const DoutPrefixProvider *dpp, std::string_view Op, DBOpParams
     ldpp_dout(dpp, 0)<<"No db_op found for Op("<<Op<<")" << dendl;
     return ret;
   }
-  ret = db_op->Execute(dpp, params);
+  if (Op.starts_with("Get") || Op.starts_with("List")) {
+    ret = db_op->Execute(dpp, params);
+  } else {
+    ret = ExecuteWriteOp(dpp, *db_op, params);
+  }
 
   if (ret) {
     ldpp_dout(dpp, 0)<<"In Process op Execute failed for fop(" << Op << ")" << dendl;
@@ -1571,6 +1571,12 @@ class DB {
     virtual int closeDB(const DoutPrefixProvider *dpp) { return 0; }
     virtual int createTables(const DoutPrefixProvider *dpp) { return 0; }
     virtual int InitializeDBOps(const DoutPrefixProvider *dpp) { return 0; }
+    /* Runs an op that modifies the db; backends may override this to
+     * group concurrent writers into one transaction. */
+    virtual int ExecuteWriteOp(const DoutPrefixProvider *dpp, DBOp& op,
+                               DBOpParams *params) {
+      return op.Execute(dpp, params);
+    }
     virtual int InitPrepareParams(const DoutPrefixProvider *dpp,
                                   DBOpPrepareParams &p_params,
                                   DBOpParams* params) = 0;
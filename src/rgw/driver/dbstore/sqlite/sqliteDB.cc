@@ -590,23 +590,31 @@ int SQLiteDB::InitializeDBOps(const DoutPrefixProvider *dpp)
   (void)createTables(dpp);
   dbops.InsertUser = make_shared<SQLInsertUser>(&this->db, this->getDBname(), cct);
   dbops.RemoveUser = make_shared<SQLRemoveUser>(&this->db, this->getDBname(), cct);
-  dbops.GetUser = make_shared<SQLGetUser>(&this->db, this->getDBname(), cct);
-  dbops.InsertBucket = make_shared<SQLInsertBucket>(&this->db, this->getDBname(), cct);
+  dbops.GetUser = make_shared<SQLGetUser>(&this->rodb, this->getDBname(), cct);
+  dbops.InsertBucket = make_shared<SQLInsertBucket>(&this->db, &this->rodb, this->getDBname(), cct);
   dbops.UpdateBucket = make_shared<SQLUpdateBucket>(&this->db, this->getDBname(), cct);
   dbops.RemoveBucket = make_shared<SQLRemoveBucket>(&this->db, this->getDBname(), cct);
-  dbops.GetBucket = make_shared<SQLGetBucket>(&this->db, this->getDBname(), cct);
-  dbops.ListUserBuckets = make_shared<SQLListUserBuckets>(&this->db, this->getDBname(), cct);
+  dbops.GetBucket = make_shared<SQLGetBucket>(&this->db, &this->rodb, this->getDBname(), cct);
+  dbops.ListUserBuckets = make_shared<SQLListUserBuckets>(&this->rodb, this->getDBname(), cct);
   dbops.InsertLCEntry = make_shared<SQLInsertLCEntry>(&this->db, this->getDBname(), cct);
   dbops.RemoveLCEntry = make_shared<SQLRemoveLCEntry>(&this->db, this->getDBname(), cct);
-  dbops.GetLCEntry = make_shared<SQLGetLCEntry>(&this->db, this->getDBname(), cct);
-  dbops.ListLCEntries = make_shared<SQLListLCEntries>(&this->db, this->getDBname(), cct);
+  dbops.GetLCEntry = make_shared<SQLGetLCEntry>(&this->rodb, this->getDBname(), cct);
+  dbops.ListLCEntries = make_shared<SQLListLCEntries>(&this->rodb, this->getDBname(), cct);
   dbops.InsertLCHead = make_shared<SQLInsertLCHead>(&this->db, this->getDBname(), cct);
   dbops.RemoveLCHead = make_shared<SQLRemoveLCHead>(&this->db, this->getDBname(), cct);
-  dbops.GetLCHead = make_shared<SQLGetLCHead>(&this->db, this->getDBname(), cct);
+  dbops.GetLCHead = make_shared<SQLGetLCHead>(&this->rodb, this->getDBname(), cct);
 
   return 0;
 }
 
+static int journal_mode_cb(void *arg, int ncols, char **vals, char **cols)
+{
+  if (ncols > 0 && vals[0]) {
+    *static_cast<std::string*>(arg) = vals[0];
+  }
+  return 0;
+}
+
 void *SQLiteDB::openDB(const DoutPrefixProvider *dpp)
 {
   string dbname;
@@ -633,20 +641,146 @@ void *SQLiteDB::openDB(const DoutPrefixProvider *dpp)
 
   exec(dpp, "PRAGMA foreign_keys=ON", NULL);
 
+  {
+    const auto& conf = cct->_conf;
+    const auto journal_mode = conf.get_val<std::string>("dbstore_journal_mode");
+    const auto synchronous = conf.get_val<std::string>("dbstore_synchronous");
+    std::string mode;
+
+    if (exec(dpp, fmt::format("PRAGMA journal_mode={}", journal_mode).c_str(),
+             journal_mode_cb, &mode)) {
+      ldpp_dout(dpp, 0) <<"Failed to set journal_mode("<<journal_mode<<")" << dendl;
+    }
+    exec(dpp, fmt::format("PRAGMA synchronous={}", synchronous).c_str(), NULL);
+    exec(dpp, fmt::format("PRAGMA wal_autocheckpoint={}",
+                          conf.get_val<uint64_t>("dbstore_wal_autocheckpoint")).c_str(),
+         NULL);
+    ldpp_dout(dpp, 10) <<"journal_mode("<<mode<<") synchronous("<<synchronous<<")" << dendl;
+
+    rodb = db;
+    if (mode == "wal") {
+      sqlite3 *ro = NULL;
+      rc = sqlite3_open_v2(dbname.c_str(), &ro,
+          SQLITE_OPEN_READONLY |
+          SQLITE_OPEN_FULLMUTEX,
+          NULL);
+      if (rc) {
+        ldpp_dout(dpp, 0) <<"Cant open read-only connection to "<<dbname \
+          <<"; Errmsg - "<<sqlite3_errmsg(ro) << "; listing on the main connection" << dendl;
+        sqlite3_close_v2(ro);
+      } else {
+        sqlite3_busy_timeout(ro, 1000);
+        rodb = ro;
+      }
+    }
+  }
+
+  // grouped writes are only visible to other requests once committed, so
+  // group them only when reads go through their own connection
+  if (rodb != db) {
+    group_commit = std::make_unique<GroupCommit>();
+  }
+
 out:
   return db;
 }
 
 int SQLiteDB::closeDB(const DoutPrefixProvider *dpp)
 {
+  if (rodb && rodb != db)
+    sqlite3_close_v2((sqlite3 *)rodb);
+
+  rodb = NULL;
+
   if (db)
     sqlite3_close((sqlite3 *)db);
 
   db = NULL;
+  group_commit.reset();
 
   return 0;
 }
 
+int SQLiteDB::commitGroup(const DoutPrefixProvider *dpp)
+{
+  if (sqlite3_get_autocommit((sqlite3 *)db)) {
+    // sqlite already rolled the transaction back after an error
+    ldpp_dout(dpp, 0) <<"Group transaction was rolled back; Errmsg - " \
+      <<sqlite3_errmsg((sqlite3 *)db) << dendl;
+    return -1;
+  }
+  if (exec(dpp, "COMMIT", NULL)) {
+    exec(dpp, "ROLLBACK", NULL);
+    return -1;
+  }
+  return 0;
+}
+
+int SQLiteDB::ExecuteWriteOp(const DoutPrefixProvider *dpp, DBOp& op,
+                             DBOpParams *params)
+{
+  if (!group_commit) {
+    return op.Execute(dpp, params);
+  }
+  const auto max_ops = cct->_conf.get_val<uint64_t>("dbstore_group_commit_max_ops");
+
+  auto& gc = *group_commit;
+  ++gc.waiting;
+  std::unique_lock l(gc.mtx);
+  gc.cond.wait(l, [&gc] { return !gc.closing; });
+  --gc.waiting;
+  if (!gc.open) {
+    if (exec(dpp, "BEGIN", NULL)) {
+      return -1;
+    }
+    gc.open = std::make_shared<GroupCommit::Batch>();
+  }
+  auto batch = gc.open;
+  if (++gc.joined >= max_ops) {
+    gc.closing = true;
+  }
+
+  /* Each writer runs in its own savepoint, so a failed op is undone
+   * without affecting the others in the batch. */
+  int ret = exec(dpp, "SAVEPOINT op", NULL);
+  if (!ret) {
+    ret = op.Execute(dpp, params);
+    if (sqlite3_get_autocommit((sqlite3 *)db)) {
+      /* sqlite rolled back the whole transaction after an error, undoing
+       * every write in the batch so far. Fail them all, and start a new
+       * transaction for the writers that follow. */
+      ldpp_dout(dpp, 0) <<"Group transaction was rolled back; Errmsg - "         <<sqlite3_errmsg((sqlite3 *)db) << dendl;
+      finishGroup(*batch, -1);
+      return ret ? ret : -1;
+    }
+    if (ret) {
+      exec(dpp, "ROLLBACK TO op", NULL);
+    }
+    exec(dpp, "RELEASE op", NULL);
+  }
+
+  if (gc.closing || gc.waiting == 0) {
+    // nobody else is about to join, so commit for everyone in the batch
+    ldpp_dout(dpp, 20) <<"Committing "<<gc.joined<<" grouped writes" << dendl;
+    finishGroup(*batch, commitGroup(dpp));
+  } else {
+    gc.cond.wait(l, [&batch] { return batch->done; });
+  }
+
+  return ret ? ret : batch->ret;
+}
+
+void SQLiteDB::finishGroup(GroupCommit::Batch& batch, int ret)
+{
+  auto& gc = *group_commit;
+  batch.ret = ret;
+  batch.done = true;
+  gc.open.reset();
+  gc.joined = 0;
+  gc.closing = false;
+  gc.cond.notify_all();
+}
+
 int SQLiteDB::Reset(const DoutPrefixProvider *dpp, sqlite3_stmt *stmt)
 {
   int ret = -1;
@@ -691,7 +825,7 @@ again:
 }
 
 int SQLiteDB::exec(const DoutPrefixProvider *dpp, const char *schema,
-    int (*callback)(void*,int,char**,char**))
+    int (*callback)(void*,int,char**,char**), void *arg)
 {
   int ret = -1;
   char *errmsg = NULL;
@@ -699,7 +833,7 @@ int SQLiteDB::exec(const DoutPrefixProvider *dpp, const char *schema,
   if (!db)
     goto out;
 
-  ret = sqlite3_exec((sqlite3*)db, schema, callback, 0, &errmsg);
+  ret = sqlite3_exec((sqlite3*)db, schema, callback, arg, &errmsg);
   if (ret != SQLITE_OK) {
     ldpp_dout(dpp, 0) <<"sqlite exec failed for schema("<<schema \
       <<"); Errmsg - "<<errmsg <<  dendl;
@@ -1056,13 +1190,13 @@ int SQLObjectOp::InitializeObjectOps(string db_name, const DoutPrefixProvider *d
 {
   PutObject = make_shared<SQLPutObject>(sdb, db_name, cct);
   DeleteObject = make_shared<SQLDeleteObject>(sdb, db_name, cct);
-  GetObject = make_shared<SQLGetObject>(sdb, db_name, cct);
+  GetObject = make_shared<SQLGetObject>(rosdb, db_name, cct);
   UpdateObject = make_shared<SQLUpdateObject>(sdb, db_name, cct);
-  ListBucketObjects = make_shared<SQLListBucketObjects>(sdb, db_name, cct);
-  ListVersionedObjects = make_shared<SQLListVersionedObjects>(sdb, db_name, cct);
+  ListBucketObjects = make_shared<SQLListBucketObjects>(rosdb, db_name, cct);
+  ListVersionedObjects = make_shared<SQLListVersionedObjects>(rosdb, db_name, cct);
   PutObjectData = make_shared<SQLPutObjectData>(sdb, db_name, cct);
   UpdateObjectData = make_shared<SQLUpdateObjectData>(sdb, db_name, cct);
-  GetObjectData = make_shared<SQLGetObjectData>(sdb, db_name, cct);
+  GetObjectData = make_shared<SQLGetObjectData>(rosdb, db_name, cct);
   DeleteObjectData = make_shared<SQLDeleteObjectData>(sdb, db_name, cct);
   DeleteStaleObjectData = make_shared<SQLDeleteStaleObjectData>(sdb, db_name, cct);
 
@@ -1430,7 +1564,7 @@ int SQLInsertBucket::Execute(const DoutPrefixProvider *dpp, struct DBOpParams *p
   string bucket_name = params->op.bucket.info.bucket.name;
   struct DBOpPrepareParams p_params = PrepareParams;
 
-  ObPtr = new SQLObjectOp(sdb, ctx());
+  ObPtr = new SQLObjectOp(sdb, rosdb, ctx());
 
   objectmapInsert(dpp, bucket_name, ObPtr);
 
@@ -1652,14 +1786,14 @@ int SQLGetBucket::Prepare(const DoutPrefixProvider *dpp, struct DBOpParams *para
   int ret = -1;
   struct DBOpPrepareParams p_params = PrepareParams;
 
-  if (!*sdb) {
+  if (!*rosdb) {
     ldpp_dout(dpp, 0)<<"In SQLGetBucket - no db" << dendl;
     goto out;
   }
 
   InitPrepareParams(dpp, p_params, params);
 
-  SQL_PREPARE(dpp, p_params, sdb, stmt, ret, "PrepareGetBucket");
+  SQL_PREPARE(dpp, p_params, rosdb, stmt, ret, "PrepareGetBucket");
 
 out:
   return ret;
@@ -1671,9 +1805,9 @@ int SQLGetBucket::Bind(const DoutPrefixProvider *dpp, struct DBOpParams *params)
   int rc = 0;
   struct DBOpPrepareParams p_params = PrepareParams;
 
-  SQL_BIND_INDEX(dpp, stmt, index, p_params.op.bucket.bucket_name, sdb);
+  SQL_BIND_INDEX(dpp, stmt, index, p_params.op.bucket.bucket_name, rosdb);
 
-  SQL_BIND_TEXT(dpp, stmt, index, params->op.bucket.info.bucket.name.c_str(), sdb);
+  SQL_BIND_TEXT(dpp, stmt, index, params->op.bucket.info.bucket.name.c_str(), rosdb);
 
 out:
   return rc;
@@ -1686,7 +1820,7 @@ int SQLGetBucket::Execute(const DoutPrefixProvider *dpp, struct DBOpParams *para
 
   params->op.name = "GetBucket";
 
-  ObPtr = new SQLObjectOp(sdb, ctx());
+  ObPtr = new SQLObjectOp(sdb, rosdb, ctx());
 
   /* For the case when the  server restarts, need to reinsert objectmap*/
   objectmapInsert(dpp, params->op.bucket.info.bucket.name, ObPtr);
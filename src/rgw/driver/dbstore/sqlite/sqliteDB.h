@@ -5,6 +5,10 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sqlite3.h>
 #include "rgw/driver/dbstore/common/dbstore.h"
@@ -15,8 +19,34 @@ class SQLiteDB : public DB, virtual public DBOp {
   private:
     sqlite3_mutex *mutex = NULL;
 
+    /* Writers that arrive while others run share one transaction, and the
+     * last of them commits it for all. A burst of small writes then costs
+     * one sync rather than one per statement. Writers execute one at a
+     * time, so each one's outcome is known. */
+    struct GroupCommit {
+      struct Batch {
+        bool done = false;
+        int ret = 0;
+      };
+      std::mutex mtx;
+      std::condition_variable cond;
+      std::shared_ptr<Batch> open; // transaction in progress, if any
+      uint64_t joined = 0; // writers that joined the open transaction
+      std::atomic<uint64_t> waiting = 0; // writers about to join
+      bool closing = false; // open transaction takes no more writers
+    };
+    std::unique_ptr<GroupCommit> group_commit;
+
+    void finishGroup(GroupCommit::Batch& batch, int ret);
+    int commitGroup(const DoutPrefixProvider *dpp);
+
   protected:
     CephContext *cct;
+    /* Read-only connection used by the Get and List ops. In WAL mode it
+     * reads alongside the writer connection instead of queueing behind it,
+     * and only sees committed writes; otherwise it is the same handle as
+     * db. */
+    void *rodb = NULL;
 
   public:
     sqlite3_stmt *stmt = NULL;
@@ -33,12 +63,14 @@ class SQLiteDB : public DB, virtual public DBOp {
     void *openDB(const DoutPrefixProvider *dpp) override;
     int closeDB(const DoutPrefixProvider *dpp) override;
     int InitializeDBOps(const DoutPrefixProvider *dpp) override;
+    int ExecuteWriteOp(const DoutPrefixProvider *dpp, DBOp& op,
+                       DBOpParams *params) override;
 
     int InitPrepareParams(const DoutPrefixProvider *dpp, DBOpPrepareParams &p_params,
                           DBOpParams* params) override;
 
     int exec(const DoutPrefixProvider *dpp, const char *schema,
-        int (*callback)(void*,int,char**,char**));
+        int (*callback)(void*,int,char**,char**), void *arg = NULL);
     int Step(const DoutPrefixProvider *dpp, DBOpInfo &op, sqlite3_stmt *stmt,
         int (*cbk)(const DoutPrefixProvider *dpp, DBOpInfo &op, sqlite3_stmt *stmt));
     int Reset(const DoutPrefixProvider *dpp, sqlite3_stmt *stmt);
@@ -74,10 +106,11 @@ class SQLiteDB : public DB, virtual public DBOp {
 class SQLObjectOp : public ObjectOp {
   private:
     sqlite3 **sdb = NULL;
+    sqlite3 **rosdb = NULL;
     CephContext *cct;
 
   public:
-    SQLObjectOp(sqlite3 **sdbi, CephContext *_cct) : sdb(sdbi), cct(_cct) {};
+    SQLObjectOp(sqlite3 **sdbi, sqlite3 **rosdbi, CephContext *_cct) : sdb(sdbi), rosdb(rosdbi), cct(_cct) {};
     ~SQLObjectOp() {}
 
     int InitializeObjectOps(std::string db_name, const DoutPrefixProvider *dpp);
@@ -143,10 +176,11 @@ class SQLGetUser : public SQLiteDB, public GetUserOp {
 class SQLInsertBucket : public SQLiteDB, public InsertBucketOp {
   private:
     sqlite3 **sdb = NULL;
+    sqlite3 **rosdb = NULL; // for the bucket's listing ops
     sqlite3_stmt *stmt = NULL; // Prepared statement
 
   public:
-    SQLInsertBucket(void **db, std::string db_name, CephContext *cct) : SQLiteDB((sqlite3 *)(*db), db_name, cct), sdb((sqlite3 **)db) {}
+    SQLInsertBucket(void **db, void **rodb, std::string db_name, CephContext *cct) : SQLiteDB((sqlite3 *)(*db), db_name, cct), sdb((sqlite3 **)db), rosdb((sqlite3 **)rodb) {}
     ~SQLInsertBucket() {
       if (stmt)
         sqlite3_finalize(stmt);
@@ -197,10 +231,11 @@ class SQLRemoveBucket : public SQLiteDB, public RemoveBucketOp {
 class SQLGetBucket : public SQLiteDB, public GetBucketOp {
   private:
     sqlite3 **sdb = NULL;
+    sqlite3 **rosdb = NULL; // for the bucket's listing ops
     sqlite3_stmt *stmt = NULL; // Prepared statement
 
   public:
-    SQLGetBucket(void **db, std::string db_name, CephContext *cct) : SQLiteDB((sqlite3 *)(*db), db_name, cct), sdb((sqlite3 **)db) {}
+    SQLGetBucket(void **db, void **rodb, std::string db_name, CephContext *cct) : SQLiteDB((sqlite3 *)(*db), db_name, cct), sdb((sqlite3 **)db), rosdb((sqlite3 **)rodb) {}
     ~SQLGetBucket() {
       if (stmt)
         sqlite3_finalize(stmt);
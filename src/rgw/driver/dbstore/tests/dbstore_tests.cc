@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
 #include <dbstore.h>
 #include <sqliteDB.h>
 #include "rgw_common.h"
@@ -669,6 +670,112 @@ TEST_F(DBStoreTest, PutObject) {
   ASSERT_EQ(ret, 0);
 }
 
+TEST_F(DBStoreTest, ConcurrentPutObject) {
+  const int nthreads = 8;
+  const int per_thread = 16;
+  std::vector<int> failures(nthreads, 0);
+  std::vector<std::thread> threads;
+
+  /* concurrent writers share group commits; every write must still
+   * be reported and be visible once it returns */
+  for (int t = 0; t < nthreads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < per_thread; i++) {
+        struct DBOpParams params = GlobalParams;
+        params.op.obj.category = RGWObjCategory::Main;
+        params.op.obj.storage_class = "STANDARD";
+        params.op.obj.state.size = 12;
+        params.op.obj.state.obj.key.name = "concurrent." + to_string(t) + "." + to_string(i);
+        params.op.obj.state.obj.key.instance = "inst";
+        if (db->ProcessOp(dpp, "PutObject", &params)) {
+          failures[t]++;
+          continue;
+        }
+        /* reads don't see other writers' uncommitted rows, but do see
+         * our own write once it has returned */
+        struct DBOpParams get = GlobalParams;
+        get.op.obj.state.obj.key = params.op.obj.state.obj.key;
+        if (db->ProcessOp(dpp, "GetObject", &get) ||
+            get.op.obj.state.size != 12) {
+          failures[t]++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (int t = 0; t < nthreads; t++) {
+    ASSERT_EQ(failures[t], 0);
+    for (int i = 0; i < per_thread; i++) {
+      struct DBOpParams params = GlobalParams;
+      params.op.obj.state.obj.key.name = "concurrent." + to_string(t) + "." + to_string(i);
+      params.op.obj.state.obj.key.instance = "inst";
+      ASSERT_EQ(db->ProcessOp(dpp, "GetObject", &params), 0);
+      ASSERT_EQ(params.op.obj.state.size, 12);
+      ASSERT_EQ(db->ProcessOp(dpp, "DeleteObject", &params), 0);
+    }
+  }
+}
+
+TEST_F(DBStoreTest, ConcurrentPutObjectWithFailure) {
+  const int nthreads = 8;
+  const int per_thread = 16;
+  std::vector<int> failures(nthreads, 0);
+  std::vector<int> unexpected(nthreads, 0);
+  std::vector<std::thread> threads;
+
+  /* every other write fails; it must report its own error without
+   * failing or undoing the writes grouped with it */
+  for (int t = 0; t < nthreads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < per_thread; i++) {
+        struct DBOpParams params = GlobalParams;
+        params.op.obj.category = RGWObjCategory::Main;
+        params.op.obj.storage_class = "STANDARD";
+        params.op.obj.state.size = 12;
+        params.op.obj.state.obj.key.name = "grouped." + to_string(t) + "." + to_string(i);
+        params.op.obj.state.obj.key.instance = "inst";
+        if (i % 2) {
+          params.op.query_str = "invalid";
+          if (db->ProcessOp(dpp, "UpdateObject", &params)) {
+            failures[t]++;
+          } else {
+            unexpected[t]++;
+          }
+        } else if (db->ProcessOp(dpp, "PutObject", &params)) {
+          unexpected[t]++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (int t = 0; t < nthreads; t++) {
+    ASSERT_EQ(unexpected[t], 0);
+    ASSERT_EQ(failures[t], per_thread / 2);
+    for (int i = 0; i < per_thread; i += 2) {
+      struct DBOpParams params = GlobalParams;
+      params.op.obj.state.obj.key.name = "grouped." + to_string(t) + "." + to_string(i);
+      params.op.obj.state.obj.key.instance = "inst";
+      ASSERT_EQ(db->ProcessOp(dpp, "GetObject", &params), 0);
+      ASSERT_EQ(params.op.obj.state.size, 12);
+      ASSERT_EQ(db->ProcessOp(dpp, "DeleteObject", &params), 0);
+    }
+  }
+
+  /* the group is still usable after the failures */
+  struct DBOpParams params = GlobalParams;
+  params.op.obj.state.size = 12;
+  params.op.obj.state.obj.key.name = "grouped.after";
+  params.op.obj.state.obj.key.instance = "inst";
+  ASSERT_EQ(db->ProcessOp(dpp, "PutObject", &params), 0);
+  ASSERT_EQ(db->ProcessOp(dpp, "DeleteObject", &params), 0);
+}
+
 TEST_F(DBStoreTest, ListAllObjects) {
   struct DBOpParams params = GlobalParams;
   int ret = -1;
@@ -14,6 +14,7 @@
 #include <shared_mutex>
 #include <condition_variable>
 #include <filesystem>
+#include <algorithm>
 #include <boost/intrusive/avl_set.hpp>
 #include "include/function2.hpp"
 #include "common/cohort_lru.h"
@@ -180,6 +181,12 @@ using fill_cache_cb_t =
   const fu2::unique_function<int(const DoutPrefixProvider* dpp,
     rgw_bucket_dir_entry&) const>;
 
+/* returns true if the listing entry cached for key is current for an object
+ * with the given mtime and size, so the provider may skip materializing it */
+using fill_cache_check_t =
+  const fu2::unique_function<bool(const DoutPrefixProvider* dpp,
+    const rgw_obj_index_key&, ceph::real_time, uint64_t) const>;
+
 using list_bucket_each_t =
   const fu2::unique_function<bool(const rgw_bucket_dir_entry&) const>;
 
@@ -205,8 +212,10 @@ struct BucketCache : public Notifiable
    * each supports 1 rw and unlimited ro transactions;  the materialized
    * listing for each bucket is stored as a database in one of these
    * environments, selected by a hash of the bucket name; a bucket's database
-   * is dropped/cleared whenever its entry is reclaimed from cache; the entire
-   * complex is cleared on restart to preserve consistency */
+   * is dropped/cleared whenever its entry is reclaimed from cache; unless
+   * persistent, the entire complex is cleared on restart to preserve
+   * consistency; a persisted listing is revalidated entry by entry when
+   * its bucket is next filled */
   class Lmdbs
   {
     std::string database_root;
@@ -215,18 +224,26 @@ struct BucketCache : public Notifiable
     sf::path dbp;
 
   public:
-    Lmdbs(std::string& database_root, uint8_t lmdb_count)
+    const bool persistent;
+
+    Lmdbs(std::string& database_root, uint8_t lmdb_count, bool persistent)
       : database_root(database_root), lmdb_count(lmdb_count),
-        dbp(database_root) {
+        dbp(database_root), persistent(persistent) {
 
       /* create a root for lmdb directory partitions (if it doesn't
        * exist already) */
       sf::path safe_root_path{dbp / fmt::format("rgw_posix_lmdbs")};
       sf::create_directory(safe_root_path);
 
-      /* purge cache completely */
-      for (const auto& dir_entry : sf::directory_iterator{safe_root_path}) {
-	sf::remove_all(dir_entry);
+      /* buckets are assigned to partitions by hash, so persisted listings
+       * are only usable with the same partition count */
+      auto nparts = std::distance(sf::directory_iterator{safe_root_path},
+				  sf::directory_iterator{});
+      if (! persistent || (nparts != 0 && nparts != lmdb_count)) {
+	/* purge cache completely */
+	for (const auto& dir_entry : sf::directory_iterator{safe_root_path}) {
+	  sf::remove_all(dir_entry);
+	}
       }
 
       /* repopulate cache basis */
@@ -254,12 +271,13 @@ struct BucketCache : public Notifiable
 public:
   BucketCache(D* driver, std::string bucket_root, std::string database_root,
 	      uint32_t max_buckets=100, uint8_t max_lanes=3,
-	      uint8_t max_partitions=3, uint8_t lmdb_count=3)
+	      uint8_t max_partitions=3, uint8_t lmdb_count=3,
+	      bool persistent=false)
     : driver(driver), bucket_root(bucket_root), max_buckets(max_buckets),
       lru(max_lanes, max_buckets/max_lanes),
       cache(max_lanes, max_buckets/max_partitions),
       rp(bucket_root),
-      lmdbs(database_root, lmdb_count),
+      lmdbs(database_root, lmdb_count, persistent),
       un(Notify::factory(this, bucket_root))
     {
       if (! (sf::exists(rp) && sf::is_directory(rp))) {
@@ -358,35 +376,165 @@ public:
     return k_str;
   }
 
+  /* fill_gen trails the entry, tagging it with the fill that last saw its
+   * object; entries written before it was added read as generation 0 */
+  static inline void serialize_entry(const rgw_bucket_dir_entry& bde,
+				     std::string& ser_data,
+				     uint64_t fill_gen = 0) {
+    zpp::bits::out out(ser_data);
+    struct timespec ts{ceph::real_clock::to_timespec(bde.meta.mtime)};
+    auto errc =
+      out(bde.key.name, bde.key.instance, /* XXX bde.key.ns, */
+	  bde.ver.pool, bde.ver.epoch, bde.exists,
+	  bde.meta.category, bde.meta.size, ts.tv_sec, ts.tv_nsec,
+	  bde.meta.owner, bde.meta.owner_display_name, bde.meta.accounted_size,
+	  bde.meta.storage_class, bde.meta.appendable, bde.meta.etag,
+	  fill_gen);
+    if (errc.code != std::errc{0}) {
+      abort();
+    }
+  }
+
+  static inline void deserialize_entry(std::string_view svv,
+				       rgw_bucket_dir_entry& bde) {
+    std::string ser_v{svv};
+    zpp::bits::in in_v(ser_v);
+    struct timespec ts;
+    auto errc =
+      in_v(bde.key.name, bde.key.instance, /* bde.key.ns, */
+	   bde.ver.pool, bde.ver.epoch, bde.exists,
+	   bde.meta.category, bde.meta.size, ts.tv_sec, ts.tv_nsec,
+	   bde.meta.owner, bde.meta.owner_display_name, bde.meta.accounted_size,
+	   bde.meta.storage_class, bde.meta.appendable, bde.meta.etag);
+    if (errc.code != std::errc{0}) {
+      abort();
+    }
+    bde.meta.mtime = ceph::real_clock::from_timespec(ts);
+  }
+
+  static inline uint64_t entry_fill_gen(std::string_view svv) {
+    std::string ser_v{svv};
+    zpp::bits::in in_v(ser_v);
+    rgw_bucket_dir_entry bde{};
+    struct timespec ts;
+    uint64_t fill_gen{0};
+    auto errc =
+      in_v(bde.key.name, bde.key.instance, /* bde.key.ns, */
+	   bde.ver.pool, bde.ver.epoch, bde.exists,
+	   bde.meta.category, bde.meta.size, ts.tv_sec, ts.tv_nsec,
+	   bde.meta.owner, bde.meta.owner_display_name, bde.meta.accounted_size,
+	   bde.meta.storage_class, bde.meta.appendable, bde.meta.etag);
+    if ((errc.code == std::errc{0}) &&
+	(in_v.position() + sizeof(fill_gen) <= ser_v.size())) {
+      (void) in_v(fill_gen);
+    }
+    return fill_gen;
+  }
+
+  /* the number of entries written per lmdb transaction during fill, so
+   * other buckets in the same environment are not locked out for the
+   * duration of a large enumeration */
+  static constexpr uint32_t fill_txn_entries = 8192;
+
   int fill(const DoutPrefixProvider* dpp, BucketCacheEntry<D, B>* bucket,
 	    B* sal_bucket, uint32_t flags, optional_yield y) /* assert: LOCKED */
   {
+      using namespace LMDBSafe;
+
+      /* a listing persisted before restart can't be trusted as a whole:
+       * objects may have been written in place, which leaves the mtime of
+       * their directory alone; every entry is checked against its object */
+      bool reconcile{false};
+
+      if (lmdbs.persistent) {
+	auto txn = bucket->env->getROTransaction();
+	MDB_stat st;
+	reconcile = (mdb_stat(*txn, bucket->dbi, &st) == 0) && (st.ms_entries > 0);
+	txn->commit();
+      }
+
+      /* providers which can report an object's mtime and size before
+       * materializing its entry support refreshing a persisted listing
+       * in place; others start over */
+      constexpr bool incremental =
+	requires(B* b, fill_cache_cb_t& cb, fill_cache_check_t& check) {
+	  b->fill_cache(dpp, y, cb, check);
+	};
+
       auto txn = bucket->env->getRWTransaction();
+      if (reconcile && ! incremental) {
+	mdb_drop(*txn, bucket->dbi, 0);
+	reconcile = false;
+      }
 
-      /* instruct the bucket provider to enumerate all entries,
-       * in any order */
-      auto rc = sal_bucket->fill_cache(dpp, y,
+      /* entries found on disk are tagged with this fill's generation, the
+       * remainder of a persisted listing is stale */
+      const uint64_t fill_gen = std::max<uint64_t>(
+	1, ceph::real_clock::now().time_since_epoch().count());
+      uint32_t pending{0};
+
+      const auto count_put = [&]() {
+	if (++pending == fill_txn_entries) {
+	  txn->commit();
+	  txn = bucket->env->getRWTransaction();
+	  pending = 0;
+	}
+      };
+
+      const auto put_entry =
 	[&](const DoutPrefixProvider* dpp, rgw_bucket_dir_entry& bde) -> int {
 	  auto concat_k = concat_key(bde.key);
 	  std::string ser_data;
-	  zpp::bits::out out(ser_data);
-	  struct timespec ts{ceph::real_clock::to_timespec(bde.meta.mtime)};
-	  auto errc =
-	    out(bde.key.name, bde.key.instance, /* XXX bde.key.ns, */
-		bde.ver.pool, bde.ver.epoch, bde.exists,
-		bde.meta.category, bde.meta.size, ts.tv_sec, ts.tv_nsec,
-		bde.meta.owner, bde.meta.owner_display_name, bde.meta.accounted_size,
-		bde.meta.storage_class, bde.meta.appendable, bde.meta.etag);
-	  /*std::cout << fmt::format("fill: bde.key.name: {}", bde.key.name)
-	    << std::endl;*/
-	  if (errc.code != std::errc{0}) {
-	    abort();
-	    return 0; // XXX non-zero return?
-	  }
+	  serialize_entry(bde, ser_data, fill_gen);
 	  txn->put(bucket->dbi, concat_k, ser_data);
-	  //std::cout << fmt::format("{} {}", __func__, bde.key.name) << '\n';
+	  count_put();
 	  return 0;
-	});
+	};
+
+      const auto check_entry =
+	[&](const DoutPrefixProvider* dpp, const rgw_obj_index_key& k,
+	    ceph::real_time obj_mtime, uint64_t obj_size) -> bool {
+	  auto concat_k = concat_key(k);
+	  std::string_view svv;
+	  if (txn->get(bucket->dbi, concat_k, svv) != MDB_SUCCESS) {
+	    return false;
+	  }
+	  rgw_bucket_dir_entry bde{};
+	  deserialize_entry(svv, bde);
+	  if ((bde.meta.mtime != obj_mtime) || (bde.meta.size != obj_size)) {
+	    return false;
+	  }
+	  std::string ser_data;
+	  serialize_entry(bde, ser_data, fill_gen);
+	  txn->put(bucket->dbi, concat_k, ser_data);
+	  count_put();
+	  return true;
+	};
+
+      /* instruct the bucket provider to enumerate all entries,
+       * in any order */
+      int rc{0};
+      if constexpr (incremental) {
+	if (reconcile) {
+	  rc = sal_bucket->fill_cache(dpp, y, put_entry, check_entry);
+	} else {
+	  rc = sal_bucket->fill_cache(dpp, y, put_entry);
+	}
+      } else {
+	rc = sal_bucket->fill_cache(dpp, y, put_entry);
+      }
+
+      if (reconcile && (rc == 0)) {
+	/* drop entries for objects removed while we weren't watching */
+	auto cursor = txn->getCursor(bucket->dbi);
+	MDBOutVal key, data;
+	for (int r = cursor.get(key, data, MDB_FIRST); r == MDB_SUCCESS;
+	     r = cursor.get(key, data, MDB_NEXT)) {
+	  if (entry_fill_gen(data.get<std::string_view>()) != fill_gen) {
+	    cursor.del();
+	  }
+	}
+      }
 
       txn->commit();
       bucket->flags |= BucketCacheEntry<D, B>::FLAG_FILLED;
@@ -419,25 +567,11 @@ public:
       bool again{true};
 
       const auto proc_result = [&]() {
-	zpp::bits::errc errc{};
 	rgw_bucket_dir_entry bde{};
 	/* XXX we may not need to recover the cache key */
 	std::string_view svk __attribute__((unused)) =
 	  key.get<string_view>(); // {name, instance, [ns]}
-	std::string_view svv = data.get<string_view>();
-	std::string ser_v{svv};
-	zpp::bits::in in_v(ser_v);
-	struct timespec ts;
-	errc =
-	  in_v(bde.key.name, bde.key.instance, /* bde.key.ns, */
-	       bde.ver.pool, bde.ver.epoch, bde.exists,
-	       bde.meta.category, bde.meta.size, ts.tv_sec, ts.tv_nsec,
-	       bde.meta.owner, bde.meta.owner_display_name, bde.meta.accounted_size,
-	       bde.meta.storage_class, bde.meta.appendable, bde.meta.etag);
-	if (errc.code != std::errc{0}) {
-	  abort();
-	}
-	bde.meta.mtime = ceph::real_clock::from_timespec(ts);
+	deserialize_entry(data.get<string_view>(), bde);
 	again = each_func(bde);
       };
 
@@ -509,17 +643,7 @@ public:
 	  auto concat_k = concat_key(bde.key);
 	  rc = driver->mint_listing_entry(b->name, bde);
 	  std::string ser_data;
-	  zpp::bits::out out(ser_data);
-	  struct timespec ts{ceph::real_clock::to_timespec(bde.meta.mtime)};
-	  auto errc =
-	    out(bde.key.name, bde.key.instance, /* XXX bde.key.ns, */
-		bde.ver.pool, bde.ver.epoch, bde.exists,
-		bde.meta.category, bde.meta.size, ts.tv_sec, ts.tv_nsec,
-		bde.meta.owner, bde.meta.owner_display_name, bde.meta.accounted_size,
-		bde.meta.storage_class, bde.meta.appendable, bde.meta.etag);
-	  if (errc.code != std::errc{0}) {
-	    abort();
-	  }
+	  serialize_entry(bde, ser_data);
 	  txn->put(b->dbi, concat_k, ser_data);
 	}
 	  break;
@@ -562,19 +686,7 @@ public:
       auto txn = b->env->getRWTransaction();
       auto concat_k = concat_key(bde.key);
       std::string ser_data;
-      zpp::bits::out out(ser_data);
-      struct timespec ts {
-        ceph::real_clock::to_timespec(bde.meta.mtime)
-      };
-      auto errc =
-          out(bde.key.name, bde.key.instance, /* XXX bde.key.ns, */
-              bde.ver.pool, bde.ver.epoch, bde.exists, bde.meta.category,
-              bde.meta.size, ts.tv_sec, ts.tv_nsec, bde.meta.owner,
-              bde.meta.owner_display_name, bde.meta.accounted_size,
-              bde.meta.storage_class, bde.meta.appendable, bde.meta.etag);
-      if (errc.code != std::errc{0}) {
-        abort();
-      }
+      serialize_entry(bde, ser_data);
       txn->put(b->dbi, concat_k, ser_data);
 
       txn->commit();
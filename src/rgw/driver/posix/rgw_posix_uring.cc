@@ -0,0 +1,292 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright contributors to the Ceph project
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw_posix_uring.h"
+#include <cerrno>
+#include <unistd.h>
+#include "acconfig.h"
+#include "common/ceph_context.h"
+#include "common/dout.h"
+#include "common/errno.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <boost/asio/error.hpp>
+#include "common/async/completion.h"
+#endif
+
+#define dout_subsys ceph_subsys_rgw
+
+namespace rgw::sal::posix_io {
+
+#ifdef HAVE_LIBURING
+
+/* A single ring per process. Coroutines fill submission queue entries under
+ * sq_lock; a reaper thread is the only consumer of the completion queue and
+ * posts each result back to the executor of the coroutine that issued it.
+ * If the reaper can't wait on the ring anymore, the ring is marked dead: the
+ * requests in flight fail and later ones use blocking I/O. */
+class Ring {
+  using Signature = void(boost::system::error_code, int);
+  using Completion = ceph::async::Completion<Signature>;
+
+  CephContext* cct;
+  struct io_uring ring;
+  bool valid{false};
+  std::atomic<bool> dead{false};
+  std::mutex sq_lock;
+  std::thread reaper;
+
+  // entries queued but not taken by the kernel yet, oldest first
+  std::deque<std::pair<struct io_uring_sqe*, std::unique_ptr<Completion>>> unsubmitted;
+  // failed entries left ahead of them as NOPs
+  unsigned stale = 0;
+  // entries taken by the kernel, protected by sq_lock
+  std::unordered_set<Completion*> in_flight;
+  // user data of entries the reaper ignores
+  static inline char skip_tag;
+
+  void reap() {
+    for (;;) {
+      struct io_uring_cqe* cqe = nullptr;
+      int r = io_uring_wait_cqe(&ring, &cqe);
+      if (r == -EINTR) {
+        continue;
+      }
+      if (r == -EAGAIN || r == -EBUSY) {
+        // completion queue overflow or out of kernel memory, try again
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      if (r < 0) {
+        fail(r);
+        return;
+      }
+      void* data = io_uring_cqe_get_data(cqe);
+      int res = cqe->res;
+      io_uring_cqe_seen(&ring, cqe);
+      if (!data) {
+        // NOP queued by the destructor
+        break;
+      }
+      if (data == &skip_tag) {
+        continue;
+      }
+      auto c = static_cast<Completion*>(data);
+      {
+        std::lock_guard l{sq_lock};
+        in_flight.erase(c);
+      }
+      Completion::post(std::unique_ptr<Completion>(c), boost::system::error_code{}, res);
+    }
+  }
+
+  /* the ring can't be waited on, so nothing in flight will ever complete.
+   * fail those requests rather than leaving their coroutines suspended
+   * forever, and send the later ones to the blocking system calls */
+  void fail(int r) {
+    lderr(cct) << "posix: io_uring failed, falling back to blocking file I/O: "
+               << cpp_strerror(-r) << dendl;
+    std::lock_guard l{sq_lock};
+    dead = true;
+    for (auto c : in_flight) {
+      Completion::post(std::unique_ptr<Completion>(c), boost::system::error_code{}, r);
+    }
+    in_flight.clear();
+  }
+
+  /* pass the queued entries to the kernel. the kernel takes them in order, so
+   * the ones it didn't take are at the back; those are failed with the error
+   * and left in the ring as NOPs the reaper ignores */
+  void flush() {
+    while (stale > 0 || !unsubmitted.empty()) {
+      int r = io_uring_submit(&ring);
+      if (r == -EINTR) {
+        continue;
+      }
+      if (r == 0) {
+        r = -EAGAIN;
+      }
+      if (r < 0) {
+        for (auto& [sqe, c] : unsubmitted) {
+          io_uring_prep_nop(sqe);
+          io_uring_sqe_set_data(sqe, &skip_tag);
+          Completion::post(std::move(c), boost::system::error_code{}, r);
+        }
+        stale += unsubmitted.size();
+        unsubmitted.clear();
+        return;
+      }
+      const unsigned skipped = std::min<unsigned>(r, stale);
+      stale -= skipped;
+      r -= skipped;
+      for (; r > 0 && !unsubmitted.empty(); --r) {
+        // owned by the ring now, the reaper takes it back
+        in_flight.insert(unsubmitted.front().second.release());
+        unsubmitted.pop_front();
+      }
+    }
+  }
+
+  // returns false, leaving c alone, if the submission queue has no room or
+  // the ring is dead
+  template <typename Prep>
+  bool queue(Prep& prep, std::unique_ptr<Completion>& c) {
+    std::lock_guard l{sq_lock};
+    if (dead) {
+      return false;
+    }
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+    if (!sqe) {
+      // submission queue is full, flush it and retry
+      flush();
+      sqe = io_uring_get_sqe(&ring);
+    }
+    if (!sqe) {
+      return false;
+    }
+    prep(sqe);
+    io_uring_sqe_set_data(sqe, c.get());
+    unsubmitted.emplace_back(sqe, std::move(c));
+    flush();
+    return true;
+  }
+
+public:
+  Ring(CephContext* cct) : cct(cct) {
+    const unsigned depth = cct->_conf.get_val<uint64_t>("rgw_posix_io_uring_depth");
+    int r = io_uring_queue_init(depth, &ring, 0);
+    if (r < 0) {
+      ldout(cct, 1) << "posix: io_uring unavailable, using blocking file I/O: "
+                    << cpp_strerror(-r) << dendl;
+      return;
+    }
+    valid = true;
+    reaper = std::thread([this] { reap(); });
+    ldout(cct, 5) << "posix: file I/O through io_uring, depth=" << depth << dendl;
+  }
+
+  ~Ring() {
+    if (!valid) {
+      return;
+    }
+    if (!dead) {
+      std::lock_guard l{sq_lock};
+      struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+      if (!sqe) {
+        io_uring_submit(&ring);
+        sqe = io_uring_get_sqe(&ring);
+      }
+      if (sqe) {
+        io_uring_prep_nop(sqe);
+        io_uring_sqe_set_data(sqe, nullptr);
+        io_uring_submit(&ring);
+      }
+    }
+    if (reaper.joinable()) {
+      reaper.join();
+    }
+    io_uring_queue_exit(&ring);
+  }
+
+  bool is_valid() const { return valid && !dead; }
+
+  /// queue the operation set up by prep and suspend the coroutine until it
+  /// completes. returns nullopt if the ring had no room for it or died
+  template <typename Prep>
+  std::optional<int> submit(Prep&& prep, optional_yield y) {
+    auto& yield = y.get_yield_context();
+    boost::system::error_code ec;
+    auto token = yield[ec];
+    int res = boost::asio::async_initiate<decltype(token), Signature>(
+        [this, &prep, ex = yield.get_executor()] (auto handler) {
+          auto c = Completion::create(ex, std::move(handler));
+          if (!queue(prep, c)) {
+            Completion::post(std::move(c), boost::asio::error::no_buffer_space, 0);
+          }
+        }, token);
+    if (ec == boost::asio::error::no_buffer_space) {
+      return std::nullopt;
+    }
+    if (ec) {
+      return -ec.value();
+    }
+    return res;
+  }
+};
+
+static Ring* get_ring(const DoutPrefixProvider* dpp, optional_yield y)
+{
+  if (!y) {
+    return nullptr;
+  }
+  CephContext* cct = dpp->get_cct();
+  if (!cct->_conf.get_val<bool>("rgw_posix_io_uring")) {
+    return nullptr;
+  }
+  auto& ring = cct->lookup_or_create_singleton_object<Ring>(
+      "rgw::sal::posix_io::Ring", false, cct);
+  return ring.is_valid() ? &ring : nullptr;
+}
+
+#endif // HAVE_LIBURING
+
+ssize_t pread(const DoutPrefixProvider* dpp, int fd, void* buf, size_t len,
+              off_t ofs, optional_yield y)
+{
+#ifdef HAVE_LIBURING
+  if (auto ring = get_ring(dpp, y); ring) {
+    auto ret = ring->submit([=] (struct io_uring_sqe* sqe) {
+        io_uring_prep_read(sqe, fd, buf, len, ofs);
+      }, y);
+    if (ret) {
+      return *ret;
+    }
+    // the ring is saturated or dead, do this one synchronously
+  }
+#endif
+  ssize_t ret = ::pread(fd, buf, len, ofs);
+  return ret < 0 ? -errno : ret;
+}
+
+ssize_t pwrite(const DoutPrefixProvider* dpp, int fd, const void* buf, size_t len,
+               off_t ofs, optional_yield y)
+{
+#ifdef HAVE_LIBURING
+  if (auto ring = get_ring(dpp, y); ring) {
+    auto ret = ring->submit([=] (struct io_uring_sqe* sqe) {
+        io_uring_prep_write(sqe, fd, buf, len, ofs);
+      }, y);
+    if (ret) {
+      return *ret;
+    }
+    // the ring is saturated or dead, do this one synchronously
+  }
+#endif
+  ssize_t ret = ::pwrite(fd, buf, len, ofs);
+  return ret < 0 ? -errno : ret;
+}
+
+} // namespace rgw::sal::posix_io
@@ -0,0 +1,42 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright contributors to the Ceph project
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include "common/async/yield_context.h"
+
+class DoutPrefixProvider;
+
+namespace rgw::sal::posix_io {
+
+/* File data I/O for the POSIX driver.
+ *
+ * When called from a coroutine (y is set) and rgw_posix_io_uring is enabled,
+ * the request is queued on an io_uring shared by the whole process and the
+ * coroutine is suspended until it completes, so a busy disk does not block the
+ * frontend thread. Otherwise, and whenever the ring cannot be set up (no
+ * liburing, or a kernel/seccomp policy without io_uring), the plain blocking
+ * system call is used. So is it for a request that finds no room in the ring.
+ *
+ * All functions return the number of bytes transferred, or a negative error
+ * code. As with the system calls, reads and writes may be short.
+ */
+ssize_t pread(const DoutPrefixProvider* dpp, int fd, void* buf, size_t len,
+              off_t ofs, optional_yield y);
+ssize_t pwrite(const DoutPrefixProvider* dpp, int fd, const void* buf, size_t len,
+               off_t ofs, optional_yield y);
+
+} // namespace rgw::sal::posix_io
@@ -14,12 +14,20 @@
  */
 
 #include "rgw_sal_posix.h"
+#include "rgw_posix_uring.h"
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/xattr.h>
 #include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include "rgw_multi.h"
 #include "include/scope_guard.h"
+#include "common/async/async_cond.h"
 #include "common/Clock.h" // for ceph_clock_now()
 #include "common/errno.h"
 
@@ -178,6 +186,72 @@ static inline int copy_dir_fd(int old_fd)
   return openat(old_fd, ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
 }
 
+// set on the driver's fill pool threads, whose nested fills run inline
+static thread_local bool in_fill_pool = false;
+
+/* Run func(ix) for ix in [0, count) on up to ntasks threads of pool,
+ * stopping at the first error. A caller with a yield context is suspended
+ * rather than blocked while it waits for the tasks. Without a pool, the
+ * work runs inline. */
+template <typename F>
+static int parallel_for(boost::asio::thread_pool* pool, optional_yield y,
+                        unsigned ntasks, size_t count, const F& func)
+{
+  if (ntasks > count) {
+    ntasks = count;
+  }
+  if (!pool || ntasks <= 1 || in_fill_pool) {
+    for (size_t ix = 0; ix < count; ++ix) {
+      int ret = func(ix);
+      if (ret < 0) {
+        return ret;
+      }
+    }
+    return 0;
+  }
+
+  std::atomic<size_t> next{0};
+  std::atomic<int> err{0};
+  std::mutex mutex;
+  std::condition_variable done;
+  std::optional<ceph::async::async_cond<boost::asio::any_io_executor>> async_done;
+  if (y) {
+    async_done.emplace(y.get_yield_context().get_executor());
+  }
+  unsigned running = ntasks;
+
+  for (unsigned i = 0; i < ntasks; ++i) {
+    boost::asio::post(*pool, [&] {
+      in_fill_pool = true;
+      for (size_t ix = next++; ix < count && err == 0; ix = next++) {
+        int ret = func(ix);
+        if (ret < 0) {
+          int expected = 0;
+          err.compare_exchange_strong(expected, ret);
+        }
+      }
+      std::unique_lock l{mutex};
+      if (--running == 0) {
+        if (async_done) {
+          async_done->notify(l);
+        } else {
+          done.notify_one();
+        }
+      }
+    });
+  }
+
+  std::unique_lock l{mutex};
+  if (async_done) {
+    while (running > 0) {
+      async_done->async_wait(l, y.get_yield_context());
+    }
+  } else {
+    done.wait(l, [&] { return running == 0; });
+  }
+  return err;
+}
+
 static int get_x_attrs(optional_yield y, const DoutPrefixProvider* dpp, int fd,
 		       Attrs& attrs, const std::string& display)
 {
@@ -594,24 +668,16 @@ int File::write(int64_t ofs, bufferlist& bl, const DoutPrefixProvider* dpp,
   }
 
 
-  ret = lseek(fd, ofs, SEEK_SET);
-  if (ret < 0) {
-    ret = errno;
-    ldpp_dout(dpp, 0) << "ERROR: could not seek object " << get_name() << " to "
-      << ofs << " :" << cpp_strerror(ret) << dendl;
-    return -ret;
-  }
-
   while (left > 0) {
-    ret = ::write(fd, curp, left);
+    ret = posix_io::pwrite(dpp, fd, curp, left, ofs, y);
     if (ret < 0) {
-      ret = errno;
       ldpp_dout(dpp, 0) << "ERROR: could not write object " << get_name() << ": "
-	<< cpp_strerror(ret) << dendl;
-      return -ret;
+	<< cpp_strerror(-ret) << dendl;
+      return ret;
     }
 
     curp += ret;
+    ofs += ret;
     left -= ret;
   }
 
@@ -624,26 +690,18 @@ int File::read(int64_t ofs, int64_t left, bufferlist& bl,
   int64_t len = std::min(left, READ_SIZE);
   ssize_t ret;
 
-  ret = lseek(fd, ofs, SEEK_SET);
+  bufferptr bp = buffer::create(len);
+  ret = posix_io::pread(dpp, fd, bp.c_str(), len, ofs, y);
   if (ret < 0) {
-    ret = errno;
-    ldpp_dout(dpp, 0) << "ERROR: could not seek object " << get_name() << " to "
-                      << ofs << " :" << cpp_strerror(ret) << dendl;
-    return -ret;
-    }
-
-    char read_buf[READ_SIZE];
-    ret = ::read(fd, read_buf, len);
-    if (ret < 0) {
-      ret = errno;
-      ldpp_dout(dpp, 0) << "ERROR: could not read object " << get_name() << ": "
-	<< cpp_strerror(ret) << dendl;
-      return -ret;
-    }
+    ldpp_dout(dpp, 0) << "ERROR: could not read object " << get_name() << ": "
+		      << cpp_strerror(-ret) << dendl;
+    return ret;
+  }
 
-    bl.append(read_buf, ret);
+  bp.set_length(ret);
+  bl.append(std::move(bp));
 
-    return ret;
+  return ret;
 }
 
 int File::copy(const DoutPrefixProvider *dpp, optional_yield y,
@@ -1082,25 +1140,103 @@ int Directory::get_ent(const DoutPrefixProvider *dpp, optional_yield y, const st
 int Directory::fill_cache(const DoutPrefixProvider *dpp, optional_yield y,
                           fill_cache_cb_t &cb)
 {
-  int ret = for_each(dpp, [this, &cb, &dpp, &y](const char *name) {
-    std::unique_ptr<FSEnt> ent;
+  return fill_cache_entries(dpp, y, cb, nullptr);
+}
 
-    if (name[0] == '.') {
-      /* Skip dotfiles */
-      return 0;
-    }
+/* Names are read in batches; the statx(), open() and xattr reads for a batch
+ * are spread over the driver's fill pool, and the resulting entries are
+ * passed to cb on the calling thread. Small directories (e.g. the versions of
+ * an object) are handled inline. */
+static constexpr size_t fill_batch_size = 4096;
+static constexpr size_t fill_parallel_min = 64;
+
+int Directory::fill_cache_entries(const DoutPrefixProvider *dpp, optional_yield y,
+                                  fill_cache_cb_t &cb, fill_cache_check_t* check,
+                                  boost::asio::thread_pool* pool)
+{
+  const unsigned nthreads =
+    ctx->_conf.get_val<uint64_t>("rgw_posix_cache_fill_threads");
+  std::vector<std::string> names;
+  names.reserve(fill_batch_size);
+
+  auto fill_batch = [&]() -> int {
+    const unsigned nt = names.size() < fill_parallel_min ? 1 : nthreads;
+    // worker threads can't suspend the caller's coroutine
+    optional_yield wy = nt > 1 ? null_yield : y;
+    std::vector<std::unique_ptr<FSEnt>> ents(names.size());
 
-    int ret = get_ent(dpp, y, name, std::string(), ent);
+    int ret = parallel_for(pool, y, nt, names.size(), [&](size_t ix) {
+      int ret = get_ent(dpp, wy, names[ix], std::string(), ents[ix]);
+      if (ret < 0)
+        return ret;
+      ents[ix]->stat(dpp); // Stat the object to get the type
+      return 0;
+    });
     if (ret < 0)
       return ret;
 
-    ent->stat(dpp); // Stat the object to get the type
+    if (check) {
+      for (auto& ent : ents) {
+        /* only plain objects are checked; versioned and multipart
+         * directories are always enumerated */
+        if (ent->get_type() != ObjectType::FILE) {
+          continue;
+        }
+        rgw_obj_key key = decode_obj_key(ent->get_name());
+        if (get_type() == ObjectType::MULTIPART) {
+          key.ns = mp_ns;
+        }
+        rgw_obj_index_key ikey;
+        key.get_index_key(&ikey);
+        auto& stx = ent->get_stx();
+        if ((*check)(dpp, ikey, from_statx_timestamp(stx.stx_mtime), stx.stx_size)) {
+          ent.reset();
+        }
+      }
+    }
 
-    ret = ent->fill_cache(dpp, y, cb);
+    std::vector<std::vector<rgw_bucket_dir_entry>> bdes(ents.size());
+    ret = parallel_for(pool, y, nt, ents.size(), [&](size_t ix) {
+      if (!ents[ix]) {
+        return 0;
+      }
+      int ret = ents[ix]->fill_cache(dpp, wy,
+          [&bdes, ix](const DoutPrefixProvider *dpp, rgw_bucket_dir_entry &bde) -> int {
+            bdes[ix].push_back(std::move(bde));
+            return 0;
+          });
+      ents[ix].reset(); // don't hold a whole batch of fds open
+      return ret;
+    });
     if (ret < 0)
       return ret;
+
+    for (auto& v : bdes) {
+      for (auto& bde : v) {
+        ret = cb(dpp, bde);
+        if (ret < 0)
+          return ret;
+      }
+    }
+    names.clear();
     return 0;
+  };
+
+  int ret = for_each(dpp, [&names, &fill_batch](const char *name) {
+    if (name[0] == '.') {
+      /* Skip dotfiles */
+      return 0;
+    }
+
+    names.emplace_back(name);
+    if (names.size() < fill_batch_size) {
+      return 0;
+    }
+    return fill_batch();
   });
+  if (ret >= 0) {
+    ret = fill_batch();
+  }
 
   if (ret < 0) {
     ldpp_dout(dpp, 0) << "ERROR: could not list directory " << get_name() << ": "
@@ -1797,33 +1933,7 @@ int VersionedDirectory::remove(const DoutPrefixProvider* dpp, optional_yield y,
 int VersionedDirectory::fill_cache(const DoutPrefixProvider *dpp, optional_yield y,
                           fill_cache_cb_t &cb)
 {
-  int ret = for_each(dpp, [this, &cb, &dpp, &y](const char *name) {
-    std::unique_ptr<FSEnt> ent;
-
-    if (name[0] == '.') {
-      /* Skip dotfiles */
-      return 0;
-    }
-
-    int ret = get_ent(dpp, y, name, std::string(), ent);
-    if (ret < 0)
-      return ret;
-
-    ent->stat(dpp); // Stat the object to get the type
-
-    ret = ent->fill_cache(dpp, y, cb);
-    if (ret < 0)
-      return ret;
-    return 0;
-  });
-
-  if (ret < 0) {
-    ldpp_dout(dpp, 0) << "ERROR: could not list directory " << get_name() << ": "
-      << cpp_strerror(ret) << dendl;
-    return ret;
-  }
-
-  return 0;
+  return fill_cache_entries(dpp, y, cb, nullptr);
 }
 
 std::string VersionedDirectory::get_cur_version()
@@ -1959,6 +2069,10 @@ int POSIXDriver::initialize(CephContext *cct, const DoutPrefixProvider *dpp)
 
   ldpp_dout(dpp, 20) << "Initializing POSIX driver: " << base_path << dendl;
 
+  /* threads reading entry metadata for cache fills, shared by all buckets */
+  fill_pool = std::make_unique<boost::asio::thread_pool>(
+      g_conf().get_val<uint64_t>("rgw_posix_cache_fill_threads"));
+
   /* ordered listing cache */
   bucket_cache.reset(
     new BucketCache(
@@ -1967,7 +2081,8 @@ int POSIXDriver::initialize(CephContext *cct, const DoutPrefixProvider *dpp)
       g_conf().get_val<int64_t>("rgw_posix_cache_max_buckets"),
       g_conf().get_val<int64_t>("rgw_posix_cache_lanes"),
       g_conf().get_val<int64_t>("rgw_posix_cache_partitions"),
-      g_conf().get_val<int64_t>("rgw_posix_cache_lmdb_count")));
+      g_conf().get_val<int64_t>("rgw_posix_cache_lmdb_count"),
+      g_conf().get_val<bool>("rgw_posix_cache_persistent")));
 
   root_dir = std::make_unique<Directory>(base_path, nullptr, ctx());
   ret = root_dir->open(dpp);
@@ -2409,7 +2524,13 @@ std::unique_ptr<RGWRole> POSIXDriver::get_role(const RGWRoleInfo& info)
 int POSIXBucket::fill_cache(const DoutPrefixProvider* dpp, optional_yield y,
 			  fill_cache_cb_t& cb)
 {
-return dir->fill_cache(dpp, y, cb);
+return dir->fill_cache_entries(dpp, y, cb, nullptr, driver->get_fill_pool());
+}
+
+int POSIXBucket::fill_cache(const DoutPrefixProvider* dpp, optional_yield y,
+			  fill_cache_cb_t& cb, fill_cache_check_t& check)
+{
+return dir->fill_cache_entries(dpp, y, cb, &check, driver->get_fill_pool());
 }
 
 int POSIXBucket::list(const DoutPrefixProvider* dpp, ListParams& params,
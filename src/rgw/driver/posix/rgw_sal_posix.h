@@ -18,6 +18,7 @@
 #include "rgw_sal_filter.h"
 #include "rgw_sal_store.h"
 #include <memory>
+#include <boost/asio/thread_pool.hpp>
 #include "common/dout.h"
 #include "bucket_cache.h"
 #include "posixDB.h"
@@ -32,6 +33,7 @@ using BucketCache = file::listing::BucketCache<POSIXDriver, POSIXBucket>;
 
 /* integration w/bucket listing cache */
 using fill_cache_cb_t = file::listing::fill_cache_cb_t;
+using fill_cache_check_t = file::listing::fill_cache_check_t;
 
 struct ObjectType {
   enum Type {
@@ -211,6 +213,11 @@ public:
   virtual int copy(const DoutPrefixProvider *dpp, optional_yield y, Directory* dst_dir, const std::string& name) override;
   virtual int link_temp_file(const DoutPrefixProvider* dpp, optional_yield y, std::string target_fname) override;
   virtual int fill_cache(const DoutPrefixProvider* dpp, optional_yield y, fill_cache_cb_t& cb) override;
+  /* enumerate entries for fill_cache, skipping files which check reports as
+   * already cached */
+  int fill_cache_entries(const DoutPrefixProvider* dpp, optional_yield y,
+                         fill_cache_cb_t& cb, fill_cache_check_t* check,
+                         boost::asio::thread_pool* pool = nullptr);
 
   int get_ent(const DoutPrefixProvider *dpp, optional_yield y, const std::string& name, const std::string& version, std::unique_ptr<FSEnt>& ent);
 };
@@ -472,6 +479,7 @@ protected:
   std::unique_ptr<rgw::store::POSIXUserDB> userDB;
   POSIXZone zone;
   std::unique_ptr<BucketCache> bucket_cache;
+  std::unique_ptr<boost::asio::thread_pool> fill_pool;
   std::string base_path;
   std::unique_ptr<Directory> root_dir;
   int root_fd;
@@ -762,7 +770,11 @@ public:
   virtual const std::string& get_compression_type(const rgw_placement_rule& rule) override;
   virtual bool valid_placement(const rgw_placement_rule& rule) override { return true; } 
 
-  virtual void finalize(void) override {}
+  virtual void finalize(void) override {
+    if (fill_pool) {
+      fill_pool->join();
+    }
+  }
 
   virtual CephContext* ctx(void) override { return userDB->ctx(); }
 
@@ -774,6 +786,7 @@ public:
   Directory* get_root_dir() { return root_dir.get(); }
   const std::string& get_base_path() const { return base_path; }
   BucketCache* get_bucket_cache() { return bucket_cache.get(); }
+  boost::asio::thread_pool* get_fill_pool() { return fill_pool.get(); }
 
   /* called by BucketCache layer when a new object is discovered
    * by inotify or similar */
@@ -956,6 +969,9 @@ public:
 
   /* enumerate all entries by callback, in any order */
   int fill_cache(const DoutPrefixProvider* dpp, optional_yield y, fill_cache_cb_t& cb);
+  /* as above, but only materialize entries which check reports as stale */
+  int fill_cache(const DoutPrefixProvider* dpp, optional_yield y, fill_cache_cb_t& cb,
+                 fill_cache_check_t& check);
   
 private:
   int write_attrs(const DoutPrefixProvider *dpp, optional_yield y);
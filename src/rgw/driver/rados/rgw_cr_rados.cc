@@ -846,7 +846,8 @@ int RGWAsyncFetchRemoteObj::_send_request(const DoutPrefixProvider *dpp)
                        source_trace_entry,
                        &zones_trace,
                        &bytes_transferred,
-                       keep_tags);
+                       keep_tags,
+                       prefetched.get());
 
   if (r < 0) {
     ldpp_dout(dpp, 0) << "store->fetch_remote_obj() returned r=" << r << dendl;
@@ -1132,6 +1132,7 @@ class RGWAsyncFetchRemoteObj : public RGWAsyncRadosRequest {
   PerfCounters* counters;
   const DoutPrefixProvider *dpp;
   bool keep_tags;
+  std::shared_ptr<const rgw_sync_obj_batch_entry> prefetched;
 
 protected:
   int _send_request(const DoutPrefixProvider *dpp) override;
@@ -1152,7 +1153,8 @@ public:
                          rgw_zone_set *_zones_trace,
                          PerfCounters* counters,
                          const DoutPrefixProvider *dpp,
-                         bool _keep_tags)
+                         bool _keep_tags,
+                         std::shared_ptr<const rgw_sync_obj_batch_entry> _prefetched = nullptr)
     : RGWAsyncRadosRequest(caller, cn), store(_store),
       source_zone(_source_zone),
       user_id(_user_id),
@@ -1168,7 +1170,8 @@ public:
       source_trace_entry(source_trace_entry),
       counters(counters),
       dpp(dpp),
-      keep_tags(_keep_tags)
+      keep_tags(_keep_tags),
+      prefetched(std::move(_prefetched))
   {
     if (_zones_trace) {
       zones_trace = *_zones_trace;
@@ -1205,6 +1208,7 @@ class RGWFetchRemoteObjCR : public RGWSimpleCoroutine {
   PerfCounters* counters;
   const DoutPrefixProvider *dpp;
   bool keep_tags;
+  std::shared_ptr<const rgw_sync_obj_batch_entry> prefetched;
 
 public:
   RGWFetchRemoteObjCR(RGWAsyncRadosProcessor *_async_rados, rgw::sal::RadosStore* _store,
@@ -1223,7 +1227,8 @@ public:
                       rgw_zone_set *_zones_trace,
                       PerfCounters* counters,
                       const DoutPrefixProvider *dpp,
-                      bool _keep_tags)
+                      bool _keep_tags,
+                      std::shared_ptr<const rgw_sync_obj_batch_entry> _prefetched = nullptr)
     : RGWSimpleCoroutine(_store->ctx()), cct(_store->ctx()),
       async_rados(_async_rados), store(_store),
       source_zone(_source_zone),
@@ -1239,7 +1244,8 @@ public:
       req(NULL),
       stat_follow_olh(_stat_follow_olh),
       source_trace_entry(source_trace_entry),
-      zones_trace(_zones_trace), counters(counters), dpp(dpp), keep_tags(_keep_tags) {}
+      zones_trace(_zones_trace), counters(counters), dpp(dpp), keep_tags(_keep_tags),
+      prefetched(std::move(_prefetched)) {}
 
 
   ~RGWFetchRemoteObjCR() override {
@@ -1257,7 +1263,8 @@ public:
     req = new RGWAsyncFetchRemoteObj(this, stack->create_completion_notifier(), store,
     source_zone, user_id, src_bucket, dest_placement_rule, dest_bucket_info,
                                      key, dest_key, versioned_epoch, copy_if_newer, filter,
-                                     stat_follow_olh, source_trace_entry, zones_trace, counters, dpp, keep_tags);
+                                     stat_follow_olh, source_trace_entry, zones_trace, counters, dpp, keep_tags,
+                                     prefetched);
     async_rados->queue(req);
     return 0;
   }
@@ -2905,6 +2905,15 @@ class RGWObjFetchCR : public RGWCoroutine {
   int try_num{0};
   std::shared_ptr<bool> need_retry;
   bool replicate_tags{true};
+
+  // feedback for the adaptive spawn window controller
+  bool fetch_pending{false};
+  ceph::coarse_mono_time fetch_start;
+
+  void fetch_done(int r) {
+    fetch_pending = false;
+    sc->lcc.fetch_finished(ceph::coarse_mono_clock::now() - fetch_start, r);
+  }
 public:
   RGWObjFetchCR(RGWDataSyncCtx *_sc,
                 rgw_bucket_sync_pipe& _sync_pipe,
@@ -2924,6 +2933,11 @@ public:
                                               zones_trace(_zones_trace) {
   }
 
+  ~RGWObjFetchCR() override {
+    if (fetch_pending) {
+      fetch_done(-ECANCELED);
+    }
+  }
 
   int operate(const DoutPrefixProvider *dpp) override {
     reenter(this) {
@@ -3033,6 +3047,18 @@ public:
                                                             std::move(dest_params),
                                                             need_retry);
 
+          // user mode sync needs the source to check permissions, which
+          // the batched fetch doesn't do
+          std::shared_ptr<const rgw_sync_obj_batch_entry> prefetched;
+          if (param_mode != rgw_sync_pipe_params::MODE_USER) {
+            prefetched = sc->take_prefetched(
+                {sync_pipe.info.dest_bucket,
+                 rgw_obj{sync_pipe.info.source_bs.bucket, key}});
+          }
+
+          sc->lcc.fetch_started();
+          fetch_pending = true;
+          fetch_start = ceph::coarse_mono_clock::now();
           call(new RGWFetchRemoteObjCR(sync_env->async_rados, sync_env->driver, sc->source_zone,
                                        param_user,
                                        sync_pipe.source_bucket_info.bucket,
@@ -3042,8 +3068,10 @@ public:
                                        std::static_pointer_cast<RGWFetchObjFilter>(filter),
                                        stat_follow_olh,
                                        source_trace_entry, zones_trace,
-                                       sync_env->counters, dpp, replicate_tags));
+                                       sync_env->counters, dpp, replicate_tags,
+                                       std::move(prefetched)));
         }
+        fetch_done(retcode);
         if (retcode < 0) {
           if (*need_retry) {
             continue;
@@ -4080,6 +4108,74 @@ public:
   }
 };
 
+/// \brief Fetch a batch of small objects from the source zone
+///
+/// The objects returned are added to the prefetch cache of the sync
+/// context, where RGWObjFetchCR picks them up instead of sending a GET
+/// per object. Objects the source declined to batch are simply absent
+/// and get fetched the regular way.
+class RGWFetchRemoteObjBatchCR : public RGWCoroutine {
+  RGWDataSyncCtx *sc;
+  RGWDataSyncEnv *sync_env;
+  const rgw_bucket bucket;
+  const string bucket_key;
+  const rgw_bucket dest_bucket;
+  const string max_size;
+  const string dst_zone_trace;
+  bufferlist in;
+  bufferlist out;
+  std::vector<rgw_obj> *fetched;
+
+public:
+  RGWFetchRemoteObjBatchCR(RGWDataSyncCtx *_sc, const rgw_bucket& bucket,
+                           const std::vector<rgw_obj_key>& keys,
+                           uint64_t max_size, const rgw_bucket& dest_bucket,
+                           std::vector<rgw_obj> *fetched)
+    : RGWCoroutine(_sc->cct), sc(_sc), sync_env(_sc->env),
+      bucket(bucket), bucket_key(bucket.get_key()), dest_bucket(dest_bucket),
+      max_size(std::to_string(max_size)),
+      dst_zone_trace(rgw_zone_set_entry(sync_env->svc->zone->get_zone().id,
+                                        dest_bucket.get_key()).to_str()),
+      fetched(fetched) {
+    encode(keys, in);
+  }
+
+  int operate(const DoutPrefixProvider *dpp) override {
+    reenter(this) {
+      yield {
+        rgw_http_param_pair pairs[] = { { "type", "bucket-objects" },
+                                        { "bucket-instance", bucket_key.c_str() },
+                                        { "max-size", max_size.c_str() },
+                                        { RGW_SYS_PARAM_PREFIX "if-not-replicated-to",
+                                          dst_zone_trace.c_str() },
+                                        { NULL, NULL } };
+        call(new RGWPostRawRESTResourceCR<bufferlist>(sync_env->cct, sc->conn,
+                                                      sync_env->http_manager,
+                                                      "/admin/log", pairs, nullptr,
+                                                      in, &out));
+      }
+      if (retcode < 0) {
+        return set_cr_error(retcode);
+      }
+      try {
+        std::vector<rgw_sync_obj_batch_entry> entries;
+        auto p = out.cbegin();
+        decode(entries, p);
+        for (auto& entry : entries) {
+          rgw_obj obj{bucket, entry.key};
+          sc->put_prefetched({dest_bucket, obj}, std::move(entry));
+          fetched->push_back(std::move(obj));
+        }
+      } catch (const buffer::error&) {
+        ldpp_dout(dpp, 0) << "ERROR: failed to decode batched object fetch response" << dendl;
+        return set_cr_error(-EIO);
+      }
+      return set_cr_done();
+    }
+    return 0;
+  }
+};
+
 struct next_bilog_result {
   uint64_t generation = 0;
   int num_shards = 0;
@@ -4539,6 +4635,29 @@ class RGWBucketFullSyncCR : public RGWCoroutine {
   RGWSyncTraceNodeRef tn;
   RGWBucketFullSyncMarkerTrack marker_tracker;
 
+  // small objects of the current listing page to fetch in batches. Each
+  // batch is fetched when the entry loop reaches its first object, so
+  // at most one batch per bucket is ahead of the objects being synced
+  struct obj_batch {
+    std::vector<rgw_obj_key> keys;
+    uint64_t bytes{0};
+  };
+  std::vector<obj_batch> obj_batches;
+  std::vector<obj_batch>::iterator obj_batch_iter;
+  // small objects of the current and previous listing page that were
+  // fetched in batches
+  uint64_t obj_batch_max_size{0};
+  std::vector<rgw_obj> prefetched;
+  std::vector<rgw_obj> prev_prefetched;
+
+  void prepare_obj_batches();
+  void drop_prefetched(std::vector<rgw_obj>& objs) {
+    for (const auto& obj : objs) {
+      sc->drop_prefetched({sync_pipe.info.dest_bucket, obj});
+    }
+    objs.clear();
+  }
+
   struct _prefix_handler {
     RGWBucketSyncFlowManager::pipe_rules_ref rules;
     RGWBucketSyncFlowManager::pipe_rules::prefix_map_t::const_iterator iter;
@@ -4603,9 +4722,46 @@ public:
     prefix_handler.set_rules(sync_pipe.get_rules());
   }
 
+  ~RGWBucketFullSyncCR() override {
+    drop_prefetched(prev_prefetched);
+    drop_prefetched(prefetched);
+  }
+
   int operate(const DoutPrefixProvider *dpp) override;
 };
 
+// prefetched objects not claimed by then were most likely skipped, e.g.
+// because the destination already had them
+static constexpr auto prefetch_max_age = std::chrono::minutes(5);
+
+void RGWBucketFullSyncCR::prepare_obj_batches()
+{
+  obj_batches.clear();
+  obj_batch_iter = obj_batches.begin();
+  obj_batch_max_size = cct->_conf.get_val<Option::size_t>("rgw_sync_obj_batch_max_size");
+  if (obj_batch_max_size == 0 || sc->obj_batch_unsupported) {
+    return;
+  }
+  const auto max_entries = cct->_conf.get_val<uint64_t>("rgw_sync_obj_batch_max_entries");
+  // a batch larger than the whole budget could never be fetched
+  const auto max_bytes = cct->_conf.get_val<Option::size_t>("rgw_sync_obj_batch_prefetch_budget");
+  auto handler = prefix_handler; // don't disturb the listing position
+  for (const auto& e : list_result.entries) {
+    if (e.delete_marker || e.size > obj_batch_max_size ||
+        e.size > max_bytes || !handler.check_key_handled(e.key)) {
+      continue;
+    }
+    if (obj_batches.empty() ||
+        obj_batches.back().keys.size() >= max_entries ||
+        obj_batches.back().bytes + e.size > max_bytes) {
+      obj_batches.emplace_back();
+    }
+    obj_batches.back().keys.push_back(e.key);
+    obj_batches.back().bytes += e.size;
+  }
+  obj_batch_iter = obj_batches.begin();
+}
+
 int RGWBucketFullSyncCR::operate(const DoutPrefixProvider *dpp)
 {
   reenter(this) {
@@ -4642,6 +4798,11 @@ int RGWBucketFullSyncCR::operate(const DoutPrefixProvider *dpp)
       if (list_result.entries.size() > 0) {
         tn->set_flag(RGW_SNS_FLAG_ACTIVE); /* actually have entries to sync */
       }
+      /* entries of the previous page that were not consumed by now most
+       * likely won't be, e.g. because they were skipped */
+      drop_prefetched(prev_prefetched);
+      std::swap(prev_prefetched, prefetched);
+      prepare_obj_batches();
       entries_iter = list_result.entries.begin();
       for (; entries_iter != list_result.entries.end(); ++entries_iter) {
         if (lease_cr && !lease_cr->is_locked()) {
@@ -4663,6 +4824,29 @@ int RGWBucketFullSyncCR::operate(const DoutPrefixProvider *dpp)
           tn->log(20, SSTR("skipping entry due to policy rules: " << entries_iter->key));
           continue;
         }
+        if (obj_batch_iter != obj_batches.end() &&
+            obj_batch_iter->keys.front() == entry->key) {
+          if (sc->prefetch_headroom(prefetch_max_age) < obj_batch_iter->bytes) {
+            tn->log(20, "prefetch budget exhausted, fetching objects one at a time");
+          } else {
+            set_status("fetching small objects");
+            yield call(new RGWFetchRemoteObjBatchCR(sc, bs.bucket, obj_batch_iter->keys,
+                                                    obj_batch_max_size,
+                                                    sync_pipe.info.dest_bucket,
+                                                    &prefetched));
+            if (retcode < 0) {
+              tn->log(5, SSTR("batched object fetch failed, fetching objects one at a time: retcode=" << retcode));
+              if (retcode == -ERR_METHOD_NOT_ALLOWED || retcode == -ERR_NOT_IMPLEMENTED) {
+                sc->obj_batch_unsupported = true;
+                obj_batches.clear();
+                obj_batch_iter = obj_batches.end();
+              }
+            }
+          }
+          if (obj_batch_iter != obj_batches.end()) {
+            ++obj_batch_iter;
+          }
+        }
         total_entries++;
         if (!marker_tracker.start(entry->key, total_entries, real_time())) {
           tn->log(0, SSTR("ERROR: cannot start syncing " << entry->key << ". Duplicate entry?"));
@@ -4676,7 +4860,8 @@ int RGWBucketFullSyncCR::operate(const DoutPrefixProvider *dpp)
                                  entry->key, &marker_tracker, zones_trace, tn),
                       false);
         }
-        drain_with_cb(sc->lcc.adj_concurrency(cct->_conf->rgw_bucket_sync_spawn_window),
+        drain_with_cb(sc->lcc.adj_fetch_concurrency(cct->_conf->rgw_bucket_sync_spawn_window,
+                                                    num_spawned()),
                       [&](uint64_t stack_id, int ret) {
                 if (ret < 0) {
                   tn->log(10, "a sync operation returned error");
@@ -5085,7 +5270,8 @@ int RGWBucketShardIncrementalSyncCR::operate(const DoutPrefixProvider *dpp)
                   false);
           }
         // }
-	  drain_with_cb(sc->lcc.adj_concurrency(cct->_conf->rgw_bucket_sync_spawn_window),
+	  drain_with_cb(sc->lcc.adj_fetch_concurrency(cct->_conf->rgw_bucket_sync_spawn_window,
+                                                      num_spawned()),
                       [&](uint64_t stack_id, int ret) {
                 if (ret < 0) {
                   tn->log(10, "a sync operation returned error");
@@ -5349,7 +5535,8 @@ int RGWRunBucketSourcesSyncCR::operate(const DoutPrefixProvider *dpp)
 
       yield_spawn_window(sync_bucket_shard_cr(sc, lease_cr, sync_pair,
                                               gen, tn, &*cur_shard_progress),
-                         sc->lcc.adj_concurrency(cct->_conf->rgw_bucket_sync_spawn_window),
+                         sc->lcc.adj_fetch_concurrency(cct->_conf->rgw_bucket_sync_spawn_window,
+                                                       num_spawned()),
                          [&](uint64_t stack_id, int ret) {
                            if (ret < 0) {
                              tn->log(10, SSTR("ERROR: a sync operation returned error: " << ret));
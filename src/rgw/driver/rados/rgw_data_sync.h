@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <deque>
+#include <tuple>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -254,6 +257,49 @@ struct rgw_datalog_shard_data {
   void decode_json(JSONObj *obj);
 };
 
+/// \brief An object returned by the batched object fetch API
+///
+/// Small objects are fetched from the source zone many at a time with
+/// POST /admin/log?type=bucket-objects. Each entry carries what the
+/// source would have sent in response to a GET with
+/// rgwx-prepend-metadata, so the regular fetch path can consume it
+/// in place of a network request.
+struct rgw_sync_obj_batch_entry {
+  rgw_obj_key key;
+  ceph::real_time mtime;
+  // mtime for If-Modified-Since checks, accounts for RGW_ATTR_INTERNAL_MTIME
+  ceph::real_time cond_mtime;
+  std::string etag;
+  uint64_t size{0};
+  bufferlist metadata; // json-encoded attrs and mtime
+  bufferlist data;
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(key, bl);
+    encode(mtime, bl);
+    encode(cond_mtime, bl);
+    encode(etag, bl);
+    encode(size, bl);
+    encode(metadata, bl);
+    encode(data, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(key, bl);
+    decode(mtime, bl);
+    decode(cond_mtime, bl);
+    decode(etag, bl);
+    decode(size, bl);
+    decode(metadata, bl);
+    decode(data, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(rgw_sync_obj_batch_entry)
+
 class RGWAsyncRadosProcessor;
 class RGWDataSyncControlCR;
 class RGWSyncErrorLogger;
@@ -316,15 +362,93 @@ void pretty_print(const RGWDataSyncEnv* env, const S& fmt, T&& ...t) {
 ///
 /// Keep a running average of operation latency and scale concurrency
 /// down when latency rises.
+///
+/// When rgw_sync_adaptive_spawn_window is enabled, object fetches
+/// also feed an additive-increase/multiplicative-decrease controller
+/// that scales the configured spawn windows up while fetches from
+/// the source zone complete quickly and cuts them in half on errors
+/// or slow fetches. Since a single instance is shared by all shards
+/// syncing from a source zone, it also enforces the global
+/// rgw_data_sync_fetch_budget.
 class LatencyConcurrencyControl : public LatencyMonitor {
   static constexpr auto dout_subsys = ceph_subsys_rgw;
   ceph::coarse_mono_time last_warning;
+
+  // scale factor applied to the configured spawn windows
+  double fetch_scale = 1.0;
+  // smoothed object fetch latency, used to pace back-off
+  ceph::timespan fetch_latency{};
+  ceph::coarse_mono_time last_backoff;
+  uint64_t fetches_in_flight = 0;
+
+  static bool is_congestion_error(int r) {
+    switch (r) {
+    case -EIO:
+    case -EBUSY:
+    case -EAGAIN:
+    case -ETIMEDOUT:
+    case -ECONNREFUSED:
+    case -ECONNRESET:
+    case -ERR_SERVICE_UNAVAILABLE:
+    case -ERR_RATE_LIMITED:
+    case -ERR_INTERNAL_ERROR:
+      return true;
+    default:
+      return false;
+    }
+  }
+
 public:
   CephContext* cct;
 
   LatencyConcurrencyControl(CephContext* cct)
     : cct(cct)  {}
 
+  /// \brief Account for an object fetch being started
+  void fetch_started() {
+    ++fetches_in_flight;
+  }
+
+  /// \brief Feed the result of an object fetch to the controller
+  ///
+  /// Each fast, successful fetch grows the window by roughly one slot
+  /// per window's worth of completions. An error that indicates an
+  /// overloaded peer, or a fetch slower than
+  /// rgw_sync_fetch_latency_target, halves it. Back-offs are spaced
+  /// by at least the smoothed fetch latency so that one burst of
+  /// failures only counts once.
+  void fetch_finished(ceph::timespan latency, int r) {
+    using namespace std::literals;
+    if (fetches_in_flight > 0) {
+      --fetches_in_flight;
+    }
+    if (!cct->_conf.get_val<bool>("rgw_sync_adaptive_spawn_window")) {
+      return;
+    }
+    fetch_latency = fetch_latency == 0s ? latency :
+      (fetch_latency * 7 + latency) / 8;
+
+    const auto target =
+      cct->_conf.get_val<std::chrono::milliseconds>("rgw_sync_fetch_latency_target");
+    const bool slow = target > 0ms && latency > target;
+    if (is_congestion_error(r) || slow) {
+      auto now = ceph::coarse_mono_clock::now();
+      if (now - last_backoff >= fetch_latency) {
+        fetch_scale = std::max(fetch_scale / 2, min_fetch_scale());
+        last_backoff = now;
+        ldout(cct, 10) << "sync fetch backoff r=" << r << " latency="
+                       << latency << " scale=" << fetch_scale << dendl;
+      }
+    } else if (r >= 0) {
+      const double max_scale =
+        cct->_conf.get_val<double>("rgw_sync_adaptive_spawn_window_max_scale");
+      const double base = std::max<int64_t>(
+          1, cct->_conf->rgw_bucket_sync_spawn_window);
+      fetch_scale = std::min(fetch_scale + 1.0 / (base * base * fetch_scale),
+                             max_scale);
+    }
+  }
+
   /// \brief Lower concurrency when latency rises
   ///
   /// Since we have multiple spawn windows (data sync overall and
@@ -346,10 +470,34 @@ public:
       }
       return 1;
     } else if (avg_latency() >= threshold) [[unlikely]] {
-      return concurrency / 2;
-    } else [[likely]] {
-      return concurrency;
+      concurrency /= 2;
+    }
+    if (cct->_conf.get_val<bool>("rgw_sync_adaptive_spawn_window")) {
+      concurrency = std::max<int64_t>(1, concurrency * fetch_scale);
     }
+    return concurrency;
+  }
+
+  /// \brief Concurrency for a window of object fetches
+  ///
+  /// Like adj_concurrency(), but also bounded by
+  /// rgw_data_sync_fetch_budget. A window keeps what it has in flight
+  /// and may only grow into the headroom left in the global budget.
+  int64_t adj_fetch_concurrency(int64_t concurrency, int64_t own_in_flight) {
+    concurrency = adj_concurrency(concurrency);
+    const auto budget = cct->_conf.get_val<uint64_t>("rgw_data_sync_fetch_budget");
+    if (budget > 0) {
+      const int64_t headroom = fetches_in_flight >= budget ? 0 :
+        budget - fetches_in_flight;
+      concurrency = std::min(concurrency,
+                             std::max<int64_t>(1, own_in_flight + headroom));
+    }
+    return concurrency;
+  }
+
+private:
+  double min_fetch_scale() const {
+    return 1.0 / std::max<int64_t>(1, cct->_conf->rgw_bucket_sync_spawn_window);
   }
 };
 
@@ -362,6 +510,71 @@ struct RGWDataSyncCtx {
 
   LatencyConcurrencyControl lcc{nullptr};
 
+  /// small objects fetched ahead of time by full sync, consumed by
+  /// RGWObjFetchCR. Keyed by destination bucket and source object, since
+  /// several pipes may sync the same source bucket. Shared by all the
+  /// buckets synced from the source zone, and bounded by
+  /// rgw_sync_obj_batch_prefetch_budget. Only accessed from the coroutine
+  /// thread.
+  using prefetch_key = std::pair<rgw_bucket, rgw_obj>;
+  struct prefetched_obj {
+    std::shared_ptr<const rgw_sync_obj_batch_entry> entry;
+    uint64_t seq{0};
+  };
+  std::map<prefetch_key, prefetched_obj> prefetched_objs;
+  /// object data held by prefetched_objs
+  uint64_t prefetched_bytes{0};
+  /// insertion order of prefetched_objs, used to evict unclaimed entries.
+  /// May refer to entries that were claimed or dropped since.
+  std::deque<std::tuple<uint64_t, ceph::coarse_mono_time, prefetch_key>> prefetch_order;
+  uint64_t prefetch_seq{0};
+  /// set once the source zone rejects the batched fetch API
+  bool obj_batch_unsupported{false};
+
+  /// remaining room in the prefetch budget, after evicting entries that
+  /// sat unclaimed for longer than max_age
+  uint64_t prefetch_headroom(ceph::timespan max_age) {
+    const auto budget = cct->_conf.get_val<Option::size_t>("rgw_sync_obj_batch_prefetch_budget");
+    const auto expired = ceph::coarse_mono_clock::now() - max_age;
+    while (!prefetch_order.empty()) {
+      auto& [seq, stamp, key] = prefetch_order.front();
+      auto i = prefetched_objs.find(key);
+      if (i != prefetched_objs.end() && i->second.seq == seq) {
+        if (stamp > expired && prefetched_bytes <= budget) {
+          break;
+        }
+        prefetched_bytes -= i->second.entry->data.length();
+        prefetched_objs.erase(i);
+      }
+      prefetch_order.pop_front();
+    }
+    return budget > prefetched_bytes ? budget - prefetched_bytes : 0;
+  }
+
+  void put_prefetched(prefetch_key key, rgw_sync_obj_batch_entry&& entry) {
+    drop_prefetched(key);
+    prefetched_bytes += entry.data.length();
+    const auto seq = ++prefetch_seq;
+    prefetch_order.emplace_back(seq, ceph::coarse_mono_clock::now(), key);
+    prefetched_objs.emplace(std::move(key), prefetched_obj{
+        std::make_shared<const rgw_sync_obj_batch_entry>(std::move(entry)), seq});
+  }
+
+  std::shared_ptr<const rgw_sync_obj_batch_entry> take_prefetched(const prefetch_key& key) {
+    auto i = prefetched_objs.find(key);
+    if (i == prefetched_objs.end()) {
+      return nullptr;
+    }
+    auto entry = std::move(i->second.entry);
+    prefetched_bytes -= entry->data.length();
+    prefetched_objs.erase(i);
+    return entry;
+  }
+
+  void drop_prefetched(const prefetch_key& key) {
+    take_prefetched(key);
+  }
+
   RGWDataSyncCtx() = default;
 
   RGWDataSyncCtx(RGWDataSyncEnv* env,
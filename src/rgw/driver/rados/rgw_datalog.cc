@@ -173,6 +173,13 @@ public:
 	      y);
     return;
   }
+  void push(const DoutPrefixProvider *dpp, int index,
+	    entries&& items, asio::yield_context y) override {
+    r.execute(oids[index], loc,
+	      neorados::WriteOp{}.exec(nlog::add(std::get<centries>(items))),
+	      y);
+    return;
+  }
 
   asio::awaitable<std::tuple<std::span<rgw_data_change_log_entry>,
 			     std::string>>
@@ -302,6 +309,10 @@ public:
 	    buffer::list&& bl, asio::yield_context y) override {
     fifos[index].push(dpp, std::move(bl), y);
   }
+  void push(const DoutPrefixProvider* dpp, int index,
+	    entries&& items, asio::yield_context y) override {
+    fifos[index].push(dpp, std::move(std::get<centries>(items)), y);
+  }
   asio::awaitable<std::tuple<std::span<rgw_data_change_log_entry>,
 			     std::string>>
   list(const DoutPrefixProvider* dpp, int shard,
@@ -923,9 +934,8 @@ void RGWDataChangesLog::add_entry(const DoutPrefixProvider* dpp,
     change.gen = gen.gen;
     encode(change, bl);
 
-    auto be = bes->head();
     // Failure on push is fatal if we're bypassing semaphores.
-    be->push(dpp, index, now, change.key, std::move(bl), y);
+    push_batched(dpp, index, now, std::move(change.key), std::move(bl), y);
     return;
   }
 
@@ -986,10 +996,9 @@ void RGWDataChangesLog::add_entry(const DoutPrefixProvider* dpp,
 
   ldpp_dout(dpp, 20) << "RGWDataChangesLog::add_entry() sending update with now=" << now << " cur_expiration=" << expiration << dendl;
 
-  auto be = bes->head();
   // Failure on push isn't fatal.
   try {
-    be->push(dpp, index, now, change.key, std::move(bl), y);
+    push_batched(dpp, index, now, std::move(change.key), std::move(bl), y);
   } catch (const std::exception& e) {
     ldpp_dout(dpp, 5) << "RGWDataChangesLog::add_entry(): Backend push failed "
 		      << "with exception: " << e.what() << dendl;
@@ -1010,6 +1019,53 @@ void RGWDataChangesLog::add_entry(const DoutPrefixProvider* dpp,
   return;
 }
 
+void RGWDataChangesLog::push_batched(const DoutPrefixProvider* dpp, int index,
+				     ceph::real_time now, std::string key,
+				     buffer::list&& bl, asio::yield_context y)
+{
+  auto& q = *push_queues[index];
+  auto result = std::make_shared<PushQueue::Result>();
+  std::unique_lock l(q.lock);
+  q.pending.push_back({now, std::move(key), std::move(bl), result});
+  while (!result->done) {
+    if (q.flushing) {
+      // our entry goes out with the next push
+      q.cond.async_wait(l, y);
+      continue;
+    }
+    q.flushing = true;
+    auto batch = std::move(q.pending);
+    q.pending.clear();
+    l.unlock();
+
+    ldpp_dout(dpp, 20) << "RGWDataChangesLog::push_batched(): pushing "
+		       << batch.size() << " entries to shard " << index << dendl;
+    std::exception_ptr eptr;
+    try {
+      auto be = bes->head();
+      RGWDataChangesBE::entries items;
+      for (auto& p : batch) {
+	be->prepare(p.now, p.key, std::move(p.bl), items);
+      }
+      be->push(dpp, index, std::move(items), y);
+    } catch (...) {
+      eptr = std::current_exception();
+    }
+
+    l.lock();
+    for (auto& p : batch) {
+      p.result->eptr = eptr;
+      p.result->done = true;
+    }
+    q.flushing = false;
+    q.cond.notify(l);
+  }
+  l.unlock();
+  if (result->eptr) {
+    std::rethrow_exception(result->eptr);
+  }
+}
+
 int RGWDataChangesLog::add_entry(const DoutPrefixProvider* dpp,
 				 const RGWBucketInfo& bucket_info,
 				 const rgw::bucket_log_layout_generation& gen,
@@ -411,6 +411,41 @@ class RGWDataChangesLog {
   bc::flat_set<BucketGen> cur_cycle;
   std::vector<bc::flat_set<std::string>> semaphores{unsigned(num_shards)};
 
+  // Entries waiting to be pushed to a shard. While a push to the shard
+  // is in flight, new entries queue up here and all go out together in
+  // the next push, so a busy shard gets one write per round trip rather
+  // than one per entry.
+  struct PushQueue {
+    struct Result {
+      bool done = false;
+      std::exception_ptr eptr;
+    };
+    struct Pending {
+      ceph::real_time now;
+      std::string key;
+      ceph::buffer::list bl;
+      std::shared_ptr<Result> result;
+    };
+
+    std::mutex lock;
+    ceph::async::async_cond<executor_t> cond;
+    bool flushing = false;
+    std::vector<Pending> pending;
+
+    PushQueue(executor_t executor) : cond(executor) {}
+  };
+  std::vector<std::unique_ptr<PushQueue>> make_push_queues() {
+    std::vector<std::unique_ptr<PushQueue>> queues;
+    for (auto i = 0; i < num_shards; ++i) {
+      queues.push_back(std::make_unique<PushQueue>(executor));
+    }
+    return queues;
+  }
+  std::vector<std::unique_ptr<PushQueue>> push_queues = make_push_queues();
+  void push_batched(const DoutPrefixProvider *dpp, int index,
+		    ceph::real_time now, std::string key,
+		    ceph::buffer::list&& bl, asio::yield_context y);
+
   ChangeStatusPtr _get_change(const rgw_bucket_shard& bs, uint64_t gen);
   bool register_renew(BucketGen bg);
   void update_renewed(const rgw_bucket_shard& bs,
@@ -572,6 +607,8 @@ public:
 		    const std::string& key,
 		    ceph::buffer::list&& bl,
 		    asio::yield_context y) = 0;
+  virtual void push(const DoutPrefixProvider *dpp, int index,
+		    entries&& items, asio::yield_context y) = 0;
   virtual asio::awaitable<std::tuple<std::span<rgw_data_change_log_entry>,
 			  std::string>>
   list(const DoutPrefixProvider* dpp, int shard,
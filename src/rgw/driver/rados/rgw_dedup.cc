@@ -58,6 +58,7 @@
 #include <cinttypes>
 #include <cstring>
 #include <span>
+#include <set>
 #include <mutex>
 #include <thread>
 
@@ -74,6 +75,7 @@ using namespace rgw::dedup;
 #include "rgw_dedup_store.h"
 #include "rgw_dedup_cluster.h"
 #include "rgw_dedup_epoch.h"
+#include "rgw_dedup_fp_index.h"
 #include "rgw_perf_counters.h"
 #include "include/ceph_assert.h"
 
@@ -397,7 +399,8 @@ namespace rgw::dedup {
     dpp(&dp),
     cct(_cct),
     d_cluster(dpp, cct, driver),
-    d_watcher_ctx(this)
+    d_watcher_ctx(this),
+    d_fp_index(dpp)
   {
     d_min_obj_size_for_dedup = cct->_conf->rgw_max_chunk_size;
     d_head_object_size = cct->_conf->rgw_max_chunk_size;
@@ -420,7 +423,8 @@ namespace rgw::dedup {
                                                const parsed_etag_t    *p_parsed_etag,
                                                const std::string      &obj_name,
                                                uint64_t                obj_size,
-                                               const std::string      &storage_class)
+                                               const std::string      &storage_class,
+                                               std::vector<disk_record_t> *p_fp_recs)
   {
     disk_record_t rec(p_bucket, obj_name, p_parsed_etag, obj_size, storage_class);
     // First pass using only ETAG and size taken from bucket-index
@@ -432,6 +436,9 @@ namespace rgw::dedup {
     if (unlikely(ret != 0)) {
       return ret;
     }
+    if (p_fp_recs) {
+      p_fp_recs->push_back(rec);
+    }
     ldpp_dout(dpp, 20) << __func__ << "::" << p_bucket->get_name() << "/"
                        << obj_name << " was written to block_idx="
                        << rec_info.block_id << " rec_id=" << rec_info.rec_id << dendl;
@@ -809,8 +816,15 @@ namespace rgw::dedup {
         return ret;
       }
 
-      // free tail objects based on TGT manifest
-      free_tail_objs_by_manifest(ref_tag, tgt_oid, tgt_manifest);
+      if (tgt_manifest.has_explicit_objs()) {
+        // the TGT was split into chunks which other objects might share,
+        // only drop its references
+        rollback_ref_by_manifest(ref_tag, tgt_oid, tgt_manifest);
+      }
+      else {
+        // free tail objects based on TGT manifest
+        free_tail_objs_by_manifest(ref_tag, tgt_oid, tgt_manifest);
+      }
 
       if (!has_shared_manifest_src) {
         // When SRC OBJ A has two or more dups (B, C) we set SHARED_MANIFEST
@@ -843,6 +857,330 @@ namespace rgw::dedup {
     return ret;
   }
 
+  //---------------------------------------------------------------------------
+  // CDC chunk objects don't belong to any bucket.
+  // The marker and namespace keep their oids apart from bucket data sharing the
+  // pool, and a non-empty namespace keeps the manifest decoder from mistaking
+  // the first chunk for the head object
+  static constexpr const char* CDC_CHUNK_MARKER = "dedup";
+  static constexpr const char* CDC_CHUNK_NS     = "cdc";
+
+  static rgw_obj cdc_chunk_obj(const rgw_pool &pool, const uint8_t *p_hash)
+  {
+    char name[BLAKE3_OUT_LEN * 2 + 1];
+    buf_to_hex(p_hash, BLAKE3_OUT_LEN, name);
+
+    rgw_bucket b;
+    b.name = CDC_CHUNK_MARKER;
+    b.marker = CDC_CHUNK_MARKER;
+    b.bucket_id = CDC_CHUNK_MARKER;
+    b.explicit_placement.data_pool = pool;
+    return rgw_obj(b, rgw_obj_key(name, "", CDC_CHUNK_NS));
+  }
+
+  //---------------------------------------------------------------------------
+  // read the full object data (head and tail) following its manifest
+  int Background::cdc_read_object_data(const RGWObjManifest &manifest,
+                                       bufferlist           *p_bl,
+                                       rgw_pool             *p_tail_pool)
+  {
+    for (auto p = manifest.obj_begin(dpp); p != manifest.obj_end(dpp); ++p) {
+      rgw_raw_obj raw_obj = p.get_location().get_raw_obj(rados);
+      if (p.get_stripe_ofs() >= manifest.get_head_size() && p_tail_pool->empty()) {
+        *p_tail_pool = raw_obj.pool;
+      }
+      rgw_rados_ref obj;
+      int ret = rgw_get_rados_ref(dpp, rados_handle, raw_obj, &obj);
+      if (ret < 0) {
+        ldpp_dout(dpp, 1) << __func__ << "::failed rgw_get_rados_ref() for oid: "
+                          << raw_obj.oid << ", err is " << cpp_strerror(-ret) << dendl;
+        return ret;
+      }
+
+      bufferlist bl;
+      uint64_t stripe_size = p.get_stripe_size();
+      ret = obj.ioctx.read(raw_obj.oid, bl, stripe_size, p.location_ofs());
+      if (unlikely(ret < 0 || bl.length() != stripe_size)) {
+        ldpp_dout(dpp, 1) << __func__ << "::ERR: failed to read " << raw_obj.oid
+                          << ", ret=" << ret << dendl;
+        return (ret < 0 ? ret : -EIO);
+      }
+      p_bl->claim_append(bl);
+    }
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  // Take a reference on an existing chunk object or create it with our
+  // reference as the only one.
+  // New chunks get an explicit refcount so the last put removes them
+  int Background::cdc_get_chunk_ref(librados::IoCtx   &ioctx,
+                                    const std::string &oid,
+                                    const std::string &ref_tag,
+                                    const bufferlist  &chunk_bl,
+                                    bool              *p_created)
+  {
+    // a chunk can be created or removed by someone else between our ops
+    static constexpr unsigned MAX_CHUNK_REF_RETRY = 3;
+    for (unsigned i = 0; i < MAX_CHUNK_REF_RETRY; i++) {
+      librados::ObjectWriteOperation get_op;
+      get_op.assert_exists();
+      cls_refcount_get(get_op, ref_tag);
+      d_ctl.metadata_access_throttle.acquire();
+      int ret = ioctx.operate(oid, &get_op);
+      if (ret != -ENOENT) {
+        *p_created = false;
+        return ret;
+      }
+
+      librados::ObjectWriteOperation create_op;
+      create_op.create(true);
+      create_op.write_full(chunk_bl);
+      std::list<std::string> refs{ref_tag};
+      cls_refcount_set(create_op, refs);
+      d_ctl.metadata_access_throttle.acquire();
+      ret = ioctx.operate(oid, &create_op);
+      if (ret != -EEXIST) {
+        *p_created = (ret == 0);
+        return ret;
+      }
+    }
+    ldpp_dout(dpp, 1) << __func__ << "::ERR: failed to reference chunk " << oid << dendl;
+    return -EAGAIN;
+  }
+
+  //---------------------------------------------------------------------------
+  void Background::cdc_put_chunk_refs(const std::string              &ref_tag,
+                                      const std::vector<rgw_raw_obj> &chunks)
+  {
+    std::unique_ptr<rgw::Aio> aio = rgw::make_throttle(cct->_conf->rgw_max_copy_obj_concurrent_io, null_yield);
+    for (const auto &raw_obj : chunks) {
+      rgw_rados_ref obj;
+      int ret = rgw_get_rados_ref(dpp, rados_handle, raw_obj, &obj);
+      if (ret < 0) {
+        ldpp_dout(dpp, 1) << __func__ << "::ERR: failed to open context "
+                          << raw_obj << dendl;
+        continue;
+      }
+
+      ObjectWriteOperation op;
+      cls_refcount_put(op, ref_tag);
+      d_ctl.metadata_access_throttle.acquire();
+      rgw::AioResultList completed = aio->get(obj.obj,
+                                              rgw::Aio::librados_op(obj.ioctx, std::move(op), null_yield),
+                                              cost, id);
+    }
+    rgw::AioResultList completed = aio->drain();
+    int ret = rgw::check_for_errors(completed);
+    if (ret < 0) {
+      ldpp_dout(dpp, 1) << __func__ << "::ERR: failed to drop chunk references, ret="
+                        << ret << dendl;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  // Singleton objects have no full copy to dedup against, but may still share
+  // most of their data with other objects (e.g. successive backup images).
+  // Split the object data into content-defined chunks and keep a single copy of
+  // each chunk in a rados object named after its BLAKE3 hash, shared between
+  // objects through cls_refcount with each object's tail tag.
+  // The head object is then switched to an explicit manifest listing the chunks,
+  // so reads, copies and GC go through the chunks like any other tail object
+  int Background::cdc_dedup_object(const disk_record_t *p_rec, md5_stats_t *p_stats)
+  {
+    if (p_rec->s.obj_bytes_size > d_cdc_max_obj_size) {
+      ldpp_dout(dpp, 20) << __func__ << "::skip large obj::" << p_rec->obj_name
+                         << "::" << p_rec->s.obj_bytes_size << dendl;
+      return 0;
+    }
+
+    rgw_bucket b{p_rec->tenant_name, p_rec->bucket_name, p_rec->bucket_id};
+    unique_ptr<rgw::sal::Bucket> bucket;
+    int ret = driver->load_bucket(dpp, b, &bucket, null_yield);
+    if (unlikely(ret != 0)) {
+      ldpp_dout(dpp, 15) << __func__ << "::Failed driver->load_bucket(): "
+                         << cpp_strerror(-ret) << dendl;
+      return 0;
+    }
+    unique_ptr<rgw::sal::Object> p_obj = bucket->get_object(p_rec->obj_name);
+    if (unlikely(!p_obj)) {
+      return 0;
+    }
+    d_ctl.metadata_access_throttle.acquire();
+    ret = p_obj->get_obj_attrs(null_yield, dpp);
+    if (unlikely(ret < 0)) {
+      ldpp_dout(dpp, 10) << __func__ << "::ERR: failed to stat object(" << p_rec->obj_name
+                         << "), returned error: " << cpp_strerror(-ret) << dendl;
+      return 0;
+    }
+
+    // the data is read and rewritten as stored, so skip encrypted and
+    // compressed objects like full dedup does.
+    // Objects with a shared manifest have their tail owned by another object
+    const rgw::sal::Attrs& attrs = p_obj->get_attrs();
+    if (attrs.find(RGW_ATTR_CRYPT_MODE) != attrs.end() ||
+        attrs.find(RGW_ATTR_COMPRESSION) != attrs.end() ||
+        attrs.find(RGW_ATTR_SHARE_MANIFEST) != attrs.end()) {
+      ldpp_dout(dpp, 20) << __func__ << "::skip obj::" << p_rec->obj_name << dendl;
+      return 0;
+    }
+
+    auto etag_itr = attrs.find(RGW_ATTR_ETAG);
+    auto manifest_itr = attrs.find(RGW_ATTR_MANIFEST);
+    auto tag_itr = attrs.find(RGW_ATTR_TAIL_TAG);
+    if (tag_itr == attrs.end()) {
+      tag_itr = attrs.find(RGW_ATTR_ID_TAG);
+    }
+    if (etag_itr == attrs.end() || manifest_itr == attrs.end() || tag_itr == attrs.end()) {
+      p_stats->ingress_corrupted_obj_attrs++;
+      return 0;
+    }
+
+    parsed_etag_t parsed_etag;
+    if (!parse_etag_string(etag_itr->second.to_str(), &parsed_etag) ||
+        parsed_etag.md5_high != p_rec->s.md5_high ||
+        parsed_etag.md5_low != p_rec->s.md5_low ||
+        p_obj->get_size() != p_rec->s.obj_bytes_size) {
+      ldpp_dout(dpp, 15) <<__func__ << "::Skipping changed object "
+                         << p_rec->obj_name << dendl;
+      p_stats->ingress_skip_changed_objs++;
+      return 0;
+    }
+
+    RGWObjManifest manifest;
+    try {
+      auto bl_iter = manifest_itr->second.cbegin();
+      decode(manifest, bl_iter);
+    } catch (buffer::error& err) {
+      ldpp_dout(dpp, 1) << __func__ << "::ERROR: bad manifest for: "
+                        << p_rec->obj_name << dendl;
+      p_stats->ingress_corrupted_obj_attrs++;
+      return 0;
+    }
+    // explicit manifests are legacy objects or objects we already split
+    if (manifest.has_explicit_objs() || !manifest.has_tail() ||
+        manifest.get_obj_size() != p_rec->s.obj_bytes_size) {
+      return 0;
+    }
+
+    bufferlist data_bl;
+    rgw_pool tail_pool;
+    ret = cdc_read_object_data(manifest, &data_bl, &tail_pool);
+    if (unlikely(ret != 0 || data_bl.length() != p_rec->s.obj_bytes_size)) {
+      p_stats->cdc_failed++;
+      return 0;
+    }
+    // a single buffer takes the vectorized chunking path
+    data_bl.rebuild();
+    std::vector<std::pair<uint64_t, uint64_t>> chunks;
+    d_cdc->calc_chunks(data_bl, &chunks);
+
+    const std::string ref_tag = tag_itr->second.to_str();
+    std::map<uint64_t, RGWObjManifestPart> objs;
+    std::set<rgw_raw_obj> referenced;
+    std::vector<rgw_raw_obj> ref_chunks;
+    uint64_t new_chunks = 0, shared_chunks = 0, shared_bytes = 0;
+    for (const auto& [ofs, len] : chunks) {
+      bufferlist chunk_bl;
+      chunk_bl.substr_of(data_bl, ofs, len);
+      uint8_t hash[BLAKE3_OUT_LEN];
+      blake3_hasher hmac;
+      blake3_hasher_init(&hmac);
+      for (const auto& bptr : chunk_bl.buffers()) {
+        blake3_hasher_update(&hmac, (const unsigned char *)bptr.c_str(), bptr.length());
+      }
+      blake3_hasher_finalize(&hmac, hash, BLAKE3_OUT_LEN);
+
+      RGWObjManifestPart &part = objs[ofs];
+      part.loc = cdc_chunk_obj(tail_pool, hash);
+      part.loc_ofs = 0;
+      part.size = len;
+
+      // the object holds a single reference on a chunk it uses more than once
+      rgw_raw_obj raw_obj = rgw_obj_select(part.loc).get_raw_obj(rados);
+      if (!referenced.insert(raw_obj).second) {
+        shared_bytes += len;
+        continue;
+      }
+      rgw_rados_ref obj;
+      ret = rgw_get_rados_ref(dpp, rados_handle, raw_obj, &obj);
+      if (ret == 0) {
+        bool created = false;
+        ret = cdc_get_chunk_ref(obj.ioctx, raw_obj.oid, ref_tag, chunk_bl, &created);
+        if (ret == 0) {
+          ref_chunks.push_back(raw_obj);
+          if (created) {
+            new_chunks++;
+          }
+          else {
+            shared_chunks++;
+            shared_bytes += len;
+          }
+        }
+      }
+      if (unlikely(ret != 0)) {
+        ldpp_dout(dpp, 1) << __func__ << "::ERR: failed to reference chunk "
+                          << raw_obj.oid << ", err is " << cpp_strerror(-ret) << dendl;
+        cdc_put_chunk_refs(ref_tag, ref_chunks);
+        p_stats->cdc_failed++;
+        return 0;
+      }
+    }
+
+    // all the data moves to the chunks, leaving an empty head like multipart
+    RGWObjManifest cdc_manifest;
+    cdc_manifest.set_explicit(p_rec->s.obj_bytes_size, objs);
+    cdc_manifest.set_head(manifest.get_head_placement_rule(), manifest.get_obj(), 0);
+    const rgw_bucket_placement& tail_placement = manifest.get_tail_placement();
+    cdc_manifest.set_tail_placement(tail_placement.placement_rule, tail_placement.bucket);
+    bufferlist cdc_manifest_bl;
+    encode(cdc_manifest, cdc_manifest_bl);
+
+    std::string oid;
+    librados::IoCtx ioctx;
+    ret = get_ioctx(dpp, driver, rados, p_rec, &ioctx, &oid);
+    if (unlikely(ret != 0)) {
+      cdc_put_chunk_refs(ref_tag, ref_chunks);
+      p_stats->cdc_failed++;
+      return 0;
+    }
+    // make sure the object wasn't overwritten since we read it
+    librados::ObjectWriteOperation op;
+    op.cmpxattr(RGW_ATTR_ETAG, CEPH_OSD_CMPXATTR_OP_EQ, etag_itr->second);
+    op.cmpxattr(RGW_ATTR_MANIFEST, CEPH_OSD_CMPXATTR_OP_EQ, manifest_itr->second);
+    op.truncate(0);
+    op.setxattr(RGW_ATTR_MANIFEST, cdc_manifest_bl);
+    d_ctl.metadata_access_throttle.acquire();
+    ret = ioctx.operate(oid, &op);
+    if (unlikely(ret != 0)) {
+      ldpp_dout(dpp, 1) << __func__ << "::ERR: failed ioctx.operate("
+                        << oid << "), err is " << cpp_strerror(-ret) << dendl;
+      cdc_put_chunk_refs(ref_tag, ref_chunks);
+      if (ret == -ECANCELED) {
+        p_stats->ingress_skip_changed_objs++;
+      }
+      else {
+        p_stats->cdc_failed++;
+      }
+      return 0;
+    }
+
+    // drop our reference on the old tail objects, which removes them unless
+    // a copy of the object still uses them
+    rollback_ref_by_manifest(ref_tag, oid, manifest);
+
+    p_stats->cdc_objects++;
+    p_stats->cdc_objects_bytes += p_rec->s.obj_bytes_size;
+    p_stats->cdc_new_chunks += new_chunks;
+    p_stats->cdc_shared_chunks += shared_chunks;
+    p_stats->cdc_shared_bytes += shared_bytes;
+    ldpp_dout(dpp, 20) << __func__ << "::" << p_rec->bucket_name << "/"
+                       << p_rec->obj_name << "::chunks=" << chunks.size()
+                       << "::new=" << new_chunks << "::shared=" << shared_chunks
+                       << "::shared_bytes=" << shared_bytes << dendl;
+    return 0;
+  }
+
   //---------------------------------------------------------------------------
   int Background::calc_object_blake3(const disk_record_t *p_rec, uint8_t *p_hash)
   {
@@ -1020,6 +1358,20 @@ namespace rgw::dedup {
     return ret;
   }
 
+  //---------------------------------------------------------------------------
+  // records taken from the fingerprint-index might point to objects which were
+  // removed or overwritten since they were indexed
+  void Background::drop_stale_fp_index_rec(const disk_record_t *p_rec,
+                                           md5_stats_t *p_stats)
+  {
+    if (p_rec->s.flags.is_fp_index()) {
+      p_stats->fp_index_stale_entries++;
+      ldpp_dout(dpp, 15) << __func__ << "::" << p_rec->bucket_name << "/"
+                         << p_rec->obj_name << dendl;
+      d_fp_index.remove(p_rec);
+    }
+  }
+
   //---------------------------------------------------------------------------
   // We purged all entries not marked for-dedup (i.e. singleton bit is set) from the table
   //   so all entries left are sources of dedup with multiple copies.
@@ -1068,6 +1420,10 @@ namespace rgw::dedup {
         p_stats->skipped_singleton_bytes += ondisk_byte_size;
         ldpp_dout(dpp, 20) << __func__ << "::skipped singleton::"
                            << p_rec->obj_name << std::dec << dendl;
+        if (d_cdc) {
+          // no full copy exists, but parts of it might
+          return cdc_dedup_object(p_rec, p_stats);
+        }
       }
       return 0;
     }
@@ -1082,6 +1438,9 @@ namespace rgw::dedup {
       p_stats->ingress_failed_load_bucket++;
       ldpp_dout(dpp, 15) << __func__ << "::Failed driver->load_bucket(): "
                          << cpp_strerror(-ret) << dendl;
+      if (ret == -ENOENT) {
+        drop_stale_fp_index_rec(p_rec, p_stats);
+      }
       return 0;
     }
 
@@ -1100,6 +1459,9 @@ namespace rgw::dedup {
       p_stats->ingress_failed_get_obj_attrs++;
       ldpp_dout(dpp, 10) << __func__ << "::ERR: failed to stat object(" << p_rec->obj_name
                          << "), returned error: " << cpp_strerror(-ret) << dendl;
+      if (ret == -ENOENT) {
+        drop_stale_fp_index_rec(p_rec, p_stats);
+      }
       return ret;
     }
 
@@ -1155,6 +1517,7 @@ namespace rgw::dedup {
       ldpp_dout(dpp, 15) <<__func__ << "::Skipping changed object "
                          << p_rec->obj_name << dendl;
       p_stats->ingress_skip_changed_objs++;
+      drop_stale_fp_index_rec(p_rec, p_stats);
       return 0;
     }
 
@@ -1267,6 +1630,10 @@ namespace rgw::dedup {
       // the table entry point to this record which means it is a dedup source so nothing to do
       p_stats->skipped_source_record++;
       ldpp_dout(dpp, 20) << __func__ << "::skipped source-record" << dendl;
+      if (d_fp_index_active) {
+        // future copies should be deduped against the source object
+        d_fp_index.upsert(p_tgt_rec);
+      }
       return 0;
     }
 
@@ -1518,7 +1885,8 @@ namespace rgw::dedup {
   int Background::ingress_bucket_idx_single_object(disk_block_array_t         &disk_arr,
                                                    const rgw::sal::Bucket     *p_bucket,
                                                    const rgw_bucket_dir_entry &entry,
-                                                   worker_stats_t             *p_worker_stats /*IN-OUT*/)
+                                                   worker_stats_t             *p_worker_stats /*IN-OUT*/,
+                                                   std::vector<disk_record_t> *p_fp_recs /*OUT*/)
   {
     parsed_etag_t parsed_etag;
     if (unlikely(!parse_etag_string(entry.meta.etag, &parsed_etag))) {
@@ -1584,7 +1952,80 @@ namespace rgw::dedup {
 
     return add_disk_rec_from_bucket_idx(disk_arr, p_bucket, &parsed_etag,
                                         entry.key.name, entry.meta.size,
-                                        storage_class);
+                                        storage_class, p_fp_recs);
+  }
+
+  //---------------------------------------------------------------------------
+  // Incremental scans only ingest objects which were modified after the last
+  // completed scan, older copies of the same data are taken from the
+  // fingerprint-index and added to the slabs next to the new objects.
+  // Fingerprints not found in the index are added to it.
+  int Background::sync_fp_index(disk_block_array_t               &disk_arr,
+                                const std::vector<disk_record_t> &fp_recs,
+                                worker_stats_t                   *p_worker_stats)
+  {
+    std::map<std::string, fp_index_entry_t> found;
+    // a full scan ingests all objects so there is nothing to look for
+    if (d_fp_incremental) {
+      int ret = d_fp_index.lookup(fp_recs, &found);
+      if (unlikely(ret != 0)) {
+        p_worker_stats->fp_index_failures++;
+        return ret;
+      }
+    }
+
+    std::vector<const disk_record_t*> new_recs;
+    for (const disk_record_t &rec : fp_recs) {
+      std::string key = fp_index_t::build_key(&rec);
+      auto itr = found.find(key);
+      if (itr == found.end()) {
+        new_recs.push_back(&rec);
+        continue;
+      }
+
+      const fp_index_entry_t &entry = itr->second;
+      if (entry.bucket_id == rec.bucket_id && entry.obj_name == rec.obj_name) {
+        // the object is its own representative (it was rewritten with same data)
+        continue;
+      }
+      if (!d_fp_emitted.insert(key).second) {
+        // this worker already added the representative
+        continue;
+      }
+
+      // same fingerprint so we can reuse the ETAG/size/storage-class from @rec
+      disk_record_t src_rec(rec);
+      src_rec.tenant_name       = entry.tenant_name;
+      src_rec.s.tenant_name_len = src_rec.tenant_name.length();
+      src_rec.bucket_name       = entry.bucket_name;
+      src_rec.s.bucket_name_len = src_rec.bucket_name.length();
+      src_rec.bucket_id         = entry.bucket_id;
+      src_rec.s.bucket_id_len   = src_rec.bucket_id.length();
+      src_rec.obj_name          = entry.obj_name;
+      src_rec.s.obj_name_len    = src_rec.obj_name.length();
+      src_rec.s.flags.set_fp_index();
+
+      auto p_disk = disk_arr.get_shard_block_seq(src_rec.s.md5_low);
+      disk_block_seq_t::record_info_t rec_info;
+      int ret = p_disk->add_record(d_dedup_cluster_ioctx, &src_rec, &rec_info);
+      if (unlikely(ret != 0)) {
+        p_worker_stats->fp_index_failures++;
+        continue;
+      }
+      p_worker_stats->fp_index_hits++;
+      ldpp_dout(dpp, 20) << __func__ << "::" << rec.bucket_name << "/" << rec.obj_name
+                         << " matched FP-Index entry " << entry.bucket_name << "/"
+                         << entry.obj_name << dendl;
+    }
+
+    if (!new_recs.empty()) {
+      int ret = d_fp_index.insert(new_recs);
+      if (unlikely(ret != 0)) {
+        p_worker_stats->fp_index_failures++;
+        return ret;
+      }
+    }
+    return 0;
   }
 
   //---------------------------------------------------------------------------
@@ -1656,6 +2097,22 @@ namespace rgw::dedup {
     const int max_entries = 1000;
     uint32_t obj_count = 0;
 
+    // index_ver of our shards when the last completed scan started listing them
+    std::map<std::string, uint64_t> stored_vers;
+    if (d_fp_incremental) {
+      std::vector<std::string> shard_oids;
+      for (uint32_t shard = worker_id; shard < num_shards; shard += num_work_shards) {
+        shard_oids.push_back(oids[shard]);
+      }
+      if (d_fp_index.read_shard_vers(shard_oids, &stored_vers) != 0) {
+        // ingest all entries of this bucket
+        p_worker_stats->fp_index_failures++;
+        stored_vers.clear();
+      }
+    }
+    bool shard_listed = false;
+    uint64_t shard_start_ver = 0;
+
     while (current_shard < num_shards ) {
       check_and_update_worker_heartbeat(worker_id, p_worker_stats->ingress_obj);
       if (unlikely(d_ctl.should_pause())) {
@@ -1678,9 +2135,18 @@ namespace rgw::dedup {
                           << ret << "::" << cpp_strerror(-ret) << dendl;
         current_shard = move_to_next_bucket_index_shard(dpp, current_shard, num_work_shards,
                                                         bucket->get_name(), &marker);
+        shard_listed = false;
         continue;
       }
+      if (!shard_listed) {
+        // entries completed from now on get an index_ver which is not smaller
+        shard_listed = true;
+        shard_start_ver = result.dir.header.ver;
+      }
+      auto stored_itr = stored_vers.find(oid);
+      const bool has_stored_ver = (stored_itr != stored_vers.end());
       obj_count += result.dir.m.size();
+      std::vector<disk_record_t> fp_recs;
       for (auto& entry : result.dir.m) {
         const rgw_bucket_dir_entry& dirent = entry.second;
         if (unlikely((!dirent.exists && !dirent.is_delete_marker()) || !dirent.pending_map.empty())) {
@@ -1692,7 +2158,17 @@ namespace rgw::dedup {
           continue;
         }
         marker = dirent.key;
-        ret = ingress_bucket_idx_single_object(disk_arr, bucket, dirent, p_worker_stats);
+        if (has_stored_ver && dirent.index_ver < stored_itr->second) {
+          // completed before the last completed scan listed this shard
+          // -> fingerprint is in the index
+          p_worker_stats->ingress_skip_unchanged++;
+          continue;
+        }
+        ret = ingress_bucket_idx_single_object(disk_arr, bucket, dirent, p_worker_stats,
+                                               d_fp_index_active ? &fp_recs : nullptr);
+      }
+      if (!fp_recs.empty()) {
+        sync_fp_index(disk_arr, fp_recs, p_worker_stats);
       }
       // TBD: advance marker only once here!
       if (result.is_truncated) {
@@ -1700,6 +2176,10 @@ namespace rgw::dedup {
                            << "]result.is_truncated::count=" << obj_count << dendl;
       }
       else {
+        if (d_fp_index_active) {
+          d_fp_listed_vers[oid] = shard_start_ver;
+        }
+        shard_listed = false;
         // we reached the end of this shard -> move to the next shard
         current_shard = move_to_next_bucket_index_shard(dpp, current_shard, num_work_shards,
                                                         bucket->get_name(), &marker);
@@ -1977,6 +2457,7 @@ namespace rgw::dedup {
     }
     disk_block_array_t disk_arr(dpp, raw_mem, raw_mem_size, worker_id,
                                 p_worker_stats, num_md5_shards);
+    d_fp_emitted.clear();
     bool has_more = true;
     // iterate over all buckets
     while (ret == 0 && has_more) {
@@ -2283,6 +2764,35 @@ namespace rgw::dedup {
 #endif
     ldpp_dout(dpp, 10) << __func__ << "::" << d_ctl.dedup_type << dendl;
 
+    d_cdc.reset();
+    if (d_ctl.dedup_type == dedup_req_type_t::DEDUP_TYPE_EXEC &&
+        cct->_conf.get_val<bool>("rgw_dedup_cdc")) {
+      d_cdc = CDC::create("fastcdc",
+                          cct->_conf.get_val<uint64_t>("rgw_dedup_cdc_chunk_bits"));
+      d_cdc_max_obj_size = cct->_conf.get_val<Option::size_t>("rgw_dedup_cdc_max_obj_size");
+    }
+
+    d_fp_index_active = false;
+    d_fp_incremental = false;
+    d_fp_listed_vers.clear();
+    if (d_ctl.dedup_type == dedup_req_type_t::DEDUP_TYPE_EXEC &&
+        cct->_conf.get_val<bool>("rgw_dedup_incremental_scan")) {
+      ret = d_fp_index.init(store, p_epoch->num_md5_shards);
+      if (ret == 0) {
+        d_fp_index_active = true;
+        // no epoch means the index was never fully built -> run a full scan
+        utime_t last_scan_time;
+        d_fp_incremental = (d_fp_index.read_epoch(&last_scan_time) == 0);
+        ldpp_dout(dpp, 5) << __func__ << "::incremental scan::last_scan="
+                          << last_scan_time << "::incremental="
+                          << d_fp_incremental << dendl;
+      }
+      else {
+        ldpp_dout(dpp, 1) << __func__ << "::ERR: failed FP-Index init, using a full scan"
+                          << dendl;
+      }
+    }
+
     return 0;
   }
 
@@ -2717,6 +3227,12 @@ namespace rgw::dedup {
                                RAW_MEM_SIZE, num_work_shards, num_md5_shards);
             // Wait for all other md5 shards to finish
             md5_shards_barrier(num_md5_shards);
+            if (d_fp_index_active && !d_ctl.should_stop()) {
+              // the next scan only needs entries completed after we listed them
+              if (d_fp_index.write_shard_vers(d_fp_listed_vers) == 0) {
+                d_fp_index.write_epoch(epoch.time);
+              }
+            }
             safe_pool_delete(store, dpp, pool_id);
           }
           else {
@@ -14,13 +14,17 @@
 
 #pragma once
 #include "common/dout.h"
+#include "common/CDC.h"
 #include "rgw_common.h"
 #include "rgw_dedup_utils.h"
 #include "rgw_dedup_table.h"
 #include "rgw_dedup_cluster.h"
+#include "rgw_dedup_fp_index.h"
 #include "rgw_realm_reloader.h"
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <iostream>
 #include <ostream>
@@ -114,7 +118,11 @@ namespace rgw::dedup {
     int  ingress_bucket_idx_single_object(disk_block_array_t         &disk_arr,
                                           const rgw::sal::Bucket     *bucket,
                                           const rgw_bucket_dir_entry &entry,
-                                          worker_stats_t             *p_worker_stats /*IN-OUT*/);
+                                          worker_stats_t             *p_worker_stats /*IN-OUT*/,
+                                          std::vector<disk_record_t> *p_fp_recs /*OUT*/);
+    int  sync_fp_index(disk_block_array_t               &disk_arr,
+                       const std::vector<disk_record_t> &fp_recs,
+                       worker_stats_t                   *p_worker_stats /*IN-OUT*/);
     int  process_bucket_shards(disk_block_array_t &disk_arr,
                                const rgw::sal::Bucket *bucket,
                                std::map<int,std::string> &oids,
@@ -162,7 +170,8 @@ namespace rgw::dedup {
                                      const parsed_etag_t    *p_parsed_etag,
                                      const std::string      &obj_name,
                                      uint64_t                obj_size,
-                                     const std::string      &storage_class);
+                                     const std::string      &storage_class,
+                                     std::vector<disk_record_t> *p_fp_recs);
 
     int add_record_to_dedup_table(dedup_table_t *p_table,
                                   const struct disk_record_t *p_rec,
@@ -212,10 +221,22 @@ namespace rgw::dedup {
     int free_tail_objs_by_manifest(const std::string &ref_tag,
                                    const std::string &oid,
                                    RGWObjManifest    &tgt_manifest);
+    void drop_stale_fp_index_rec(const disk_record_t *p_rec, md5_stats_t *p_stats);
     int dedup_object(const disk_record_t *p_src_rec,
                      const disk_record_t *p_tgt_rec,
                      md5_stats_t         *p_stats,
                      bool                 is_shared_manifest_src);
+    int cdc_read_object_data(const RGWObjManifest &manifest,
+                             bufferlist           *p_bl,
+                             rgw_pool             *p_tail_pool);
+    int cdc_get_chunk_ref(librados::IoCtx   &ioctx,
+                          const std::string &oid,
+                          const std::string &ref_tag,
+                          const bufferlist  &chunk_bl,
+                          bool              *p_created);
+    void cdc_put_chunk_refs(const std::string              &ref_tag,
+                            const std::vector<rgw_raw_obj> &chunks);
+    int cdc_dedup_object(const disk_record_t *p_rec, md5_stats_t *p_stats);
 #endif
     int  remove_slabs(unsigned worker_id, unsigned md5_shard, uint32_t slab_count);
     int  init_rados_access_handles(bool init_pool);
@@ -240,6 +261,19 @@ namespace rgw::dedup {
     control_t d_ctl;
     uint64_t d_watch_handle = 0;
     DedupWatcher d_watcher_ctx;
+    fp_index_t d_fp_index;
+    // the fingerprint-index is only maintained by incremental exec scans
+    bool d_fp_index_active = false;
+    // skip bucket-index entries completed before the last completed scan
+    // listed their shard (false for a full scan)
+    bool d_fp_incremental = false;
+    // bucket-index shards fully listed by this RGW -> index_ver at listing start
+    std::map<std::string, uint64_t> d_fp_listed_vers;
+    // fingerprints this worker already added from the fingerprint-index
+    std::unordered_set<std::string> d_fp_emitted;
+    // splits singleton objects into shared chunks (exec scans only)
+    std::unique_ptr<CDC> d_cdc;
+    uint64_t d_cdc_max_obj_size = 0;
 
     std::thread d_runner;
     std::mutex  d_cond_mutex;
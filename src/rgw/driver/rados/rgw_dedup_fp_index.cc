@@ -0,0 +1,425 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2;
+// vim: ts=8 sw=2 sts=2 expandtab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "rgw_dedup_fp_index.h"
+#include "rgw_tools.h"
+#include "svc_zone.h"
+#include "common/errno.h"
+#include "include/ceph_hash.h"
+#include "include/encoding.h"
+#include "driver/rados/rgw_sal_rados.h"
+#include <cinttypes>
+#include <set>
+
+static constexpr auto dout_subsys = ceph_subsys_rgw_dedup;
+
+namespace rgw::dedup {
+  static constexpr const char* FP_INDEX_ATTR_EPOCH  = "rgw.dedup.fp.epoch";
+  static constexpr const char* FP_INDEX_ATTR_LAYOUT = "rgw.dedup.fp.layout";
+
+  //---------------------------------------------------------------------------
+  void encode(const fp_index_layout_t& l, ceph::bufferlist& bl)
+  {
+    ENCODE_START(1, 1, bl);
+    encode(l.gen, bl);
+    encode(l.num_shards, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  //---------------------------------------------------------------------------
+  void decode(fp_index_layout_t& l, ceph::bufferlist::const_iterator& bl)
+  {
+    DECODE_START(1, bl);
+    decode(l.gen, bl);
+    decode(l.num_shards, bl);
+    DECODE_FINISH(bl);
+  }
+
+  //---------------------------------------------------------------------------
+  void encode(const fp_index_entry_t& e, ceph::bufferlist& bl)
+  {
+    ENCODE_START(1, 1, bl);
+    encode(e.tenant_name, bl);
+    encode(e.bucket_name, bl);
+    encode(e.bucket_id, bl);
+    encode(e.obj_name, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  //---------------------------------------------------------------------------
+  void decode(fp_index_entry_t& e, ceph::bufferlist::const_iterator& bl)
+  {
+    DECODE_START(1, bl);
+    decode(e.tenant_name, bl);
+    decode(e.bucket_name, bl);
+    decode(e.bucket_id, bl);
+    decode(e.obj_name, bl);
+    DECODE_FINISH(bl);
+  }
+
+  //---------------------------------------------------------------------------
+  static void rec_to_entry(const disk_record_t *p_rec, fp_index_entry_t *p_entry)
+  {
+    p_entry->tenant_name = p_rec->tenant_name;
+    p_entry->bucket_name = p_rec->bucket_name;
+    p_entry->bucket_id   = p_rec->bucket_id;
+    p_entry->obj_name    = p_rec->obj_name;
+  }
+
+  //---------------------------------------------------------------------------
+  std::string fp_index_t::build_key(const disk_record_t *p_rec)
+  {
+    char buff[80];
+    int n = snprintf(buff, sizeof(buff), "%016" PRIx64 "%016" PRIx64 ".%x.%" PRIx64 ".",
+                     p_rec->s.md5_high, p_rec->s.md5_low, p_rec->s.num_parts,
+                     p_rec->s.obj_bytes_size);
+    return std::string(buff, n) + p_rec->stor_class;
+  }
+
+  //---------------------------------------------------------------------------
+  static std::string build_shard_oid(const char *prefix,
+                                     const fp_index_layout_t &layout,
+                                     uint32_t shard)
+  {
+    char buff[64];
+    int n = snprintf(buff, sizeof(buff), "%s%x.%04x", prefix, layout.gen, shard);
+    return std::string(buff, n);
+  }
+
+  //---------------------------------------------------------------------------
+  std::string fp_index_t::shard_oid(uint64_t md5_low) const
+  {
+    return build_shard_oid(FP_INDEX_SHARD_PREFIX, d_layout,
+                           md5_low % d_layout.num_shards);
+  }
+
+  //---------------------------------------------------------------------------
+  std::string fp_index_t::ver_shard_oid(const std::string &bucket_shard_oid) const
+  {
+    uint32_t hash = ceph_str_hash_linux(bucket_shard_oid.data(),
+                                        bucket_shard_oid.size());
+    return build_shard_oid(FP_INDEX_VER_PREFIX, d_layout,
+                           hash % d_layout.num_shards);
+  }
+
+  //---------------------------------------------------------------------------
+  // calc_num_md5_shards() doubles the md5 shards for every 4x objects, so the
+  // object count grows with the square of the md5 shards.
+  // The md5 shard count is taken from the dedup epoch so all RGWs agree on it
+  static uint32_t calc_num_shards(uint32_t num_md5_shards)
+  {
+    static constexpr uint64_t OBJS_PER_SQUARE_MD5_SHARD = 64*1024;
+    const uint64_t obj_count =
+      uint64_t(num_md5_shards) * num_md5_shards * OBJS_PER_SQUARE_MD5_SHARD;
+    uint32_t num_shards = FP_INDEX_MIN_SHARDS;
+    while (num_shards < FP_INDEX_MAX_SHARDS &&
+           uint64_t(num_shards) * FP_INDEX_SHARD_KEYS < obj_count) {
+      num_shards *= 2;
+    }
+    return num_shards;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::init(rgw::sal::RadosStore *store, uint32_t num_md5_shards)
+  {
+    const rgw_pool& log_pool = store->svc()->zone->get_zone_params().log_pool;
+    auto rados_handle = store->getRados()->get_rados_handle();
+    int ret = rgw_init_ioctx(dpp, rados_handle, log_pool, d_ioctx, true, true);
+    if (unlikely(ret < 0)) {
+      ldpp_dout(dpp, 1) << __func__ << "::ERR: failed rgw_init_ioctx() for log_pool ret="
+                        << ret << "::" << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
+
+    const uint32_t num_shards = calc_num_shards(num_md5_shards);
+    fp_index_layout_t layout;
+    ret = read_layout(&layout);
+    if (ret == 0) {
+      if (layout.num_shards >= num_shards) {
+        d_layout = layout;
+        return 0;
+      }
+      return reset(&layout, num_shards);
+    }
+    else if (ret == -ENOENT || ret == -ENODATA) {
+      return reset(nullptr, num_shards);
+    }
+    return ret;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::read_layout(fp_index_layout_t *p_layout)
+  {
+    bufferlist bl;
+    int ret = d_ioctx.getxattr(FP_INDEX_HEAD_OID, FP_INDEX_ATTR_LAYOUT, bl);
+    if (ret <= 0) {
+      return (ret == 0 ? -ENODATA : ret);
+    }
+    try {
+      auto p = bl.cbegin();
+      decode(*p_layout, p);
+    } catch (const buffer::error&) {
+      ldpp_dout(dpp, 0) << __func__ << "::failed layout decode!" << dendl;
+      return -EINVAL;
+    }
+    if (unlikely(p_layout->num_shards == 0)) {
+      return -EINVAL;
+    }
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  // Start a new (empty) generation with @num_shards shards.
+  // All RGWs compute the same shard count, so when several of them race
+  // the first one wins and the others adopt its layout
+  int fp_index_t::reset(const fp_index_layout_t *p_old_layout, uint32_t num_shards)
+  {
+    fp_index_layout_t layout;
+    layout.gen = p_old_layout ? p_old_layout->gen + 1 : 0;
+    layout.num_shards = num_shards;
+    bufferlist bl, empty_bl;
+    encode(layout, bl);
+
+    librados::ObjectWriteOperation op;
+    if (p_old_layout) {
+      bufferlist old_bl;
+      encode(*p_old_layout, old_bl);
+      op.cmpxattr(FP_INDEX_ATTR_LAYOUT, CEPH_OSD_CMPXATTR_OP_EQ, old_bl);
+    }
+    else {
+      // fails with -ECANCELED if a peer created the layout first
+      bufferlist no_layout_bl;
+      op.create(false);
+      op.cmpxattr(FP_INDEX_ATTR_LAYOUT, CEPH_OSD_CMPXATTR_OP_EQ, no_layout_bl);
+    }
+    op.setxattr(FP_INDEX_ATTR_LAYOUT, bl);
+    // the new generation is empty, so the next scan must be a full scan
+    op.setxattr(FP_INDEX_ATTR_EPOCH, empty_bl);
+    int ret = rgw_rados_operate(dpp, d_ioctx, FP_INDEX_HEAD_OID, std::move(op), null_yield);
+    if (ret == -ECANCELED) {
+      ldpp_dout(dpp, 10) << __func__ << "::FP-Index layout was changed by a peer" << dendl;
+      return read_layout(&d_layout);
+    }
+    else if (unlikely(ret < 0)) {
+      ldpp_dout(dpp, 1) << __func__ << "::ERR: failed rgw_rados_operate() ret="
+                        << ret << "::" << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
+
+    ldpp_dout(dpp, 5) << __func__ << "::FP-Index gen=" << layout.gen
+                      << "::num_shards=" << layout.num_shards << dendl;
+    d_layout = layout;
+    if (p_old_layout) {
+      remove_shards(*p_old_layout);
+    }
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  void fp_index_t::remove_shards(const fp_index_layout_t &layout)
+  {
+    for (uint32_t shard = 0; shard < layout.num_shards; shard++) {
+      for (const char *prefix : {FP_INDEX_SHARD_PREFIX, FP_INDEX_VER_PREFIX}) {
+        int ret = d_ioctx.remove(build_shard_oid(prefix, layout, shard));
+        if (unlikely(ret < 0 && ret != -ENOENT)) {
+          ldpp_dout(dpp, 5) << __func__ << "::ERR: failed to remove shard "
+                            << shard << " of gen " << layout.gen << dendl;
+        }
+      }
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::read_epoch(utime_t *p_epoch_time)
+  {
+    bufferlist bl;
+    int ret = d_ioctx.getxattr(FP_INDEX_HEAD_OID, FP_INDEX_ATTR_EPOCH, bl);
+    if (ret <= 0) {
+      // zero length read means no data
+      return (ret == 0 ? -ENODATA : ret);
+    }
+    try {
+      auto p = bl.cbegin();
+      decode(*p_epoch_time, p);
+    } catch (const buffer::error&) {
+      ldpp_dout(dpp, 0) << __func__ << "::failed epoch decode!" << dendl;
+      return -EINVAL;
+    }
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::write_epoch(const utime_t &epoch_time)
+  {
+    bufferlist bl;
+    encode(epoch_time, bl);
+    librados::ObjectWriteOperation op;
+    op.create(false);
+    op.setxattr(FP_INDEX_ATTR_EPOCH, bl);
+    int ret = rgw_rados_operate(dpp, d_ioctx, FP_INDEX_HEAD_OID, std::move(op), null_yield);
+    if (unlikely(ret < 0)) {
+      ldpp_dout(dpp, 1) << __func__ << "::ERR: failed rgw_rados_operate() ret="
+                        << ret << "::" << cpp_strerror(-ret) << dendl;
+    }
+    return ret;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::read_shard_vers(const std::vector<std::string> &oids,
+                                  std::map<std::string, uint64_t> *p_vers)
+  {
+    std::map<std::string, std::set<std::string>> shard_keys;
+    for (const auto& oid : oids) {
+      shard_keys[ver_shard_oid(oid)].insert(oid);
+    }
+
+    for (const auto& [oid, keys] : shard_keys) {
+      std::map<std::string, bufferlist> vals;
+      int rval = 0;
+      librados::ObjectReadOperation op;
+      op.omap_get_vals_by_keys(keys, &vals, &rval);
+      int ret = rgw_rados_operate(dpp, d_ioctx, oid, std::move(op), nullptr, null_yield);
+      if (ret == -ENOENT) {
+        continue;
+      }
+      else if (unlikely(ret < 0)) {
+        ldpp_dout(dpp, 5) << __func__ << "::ERR: failed omap_get_vals_by_keys("
+                          << oid << ") ret=" << ret << "::" << cpp_strerror(-ret) << dendl;
+        return ret;
+      }
+
+      for (auto& [key, bl] : vals) {
+        uint64_t ver;
+        try {
+          auto p = bl.cbegin();
+          decode(ver, p);
+        } catch (const buffer::error&) {
+          ldpp_dout(dpp, 5) << __func__ << "::ERR: failed ver decode::" << key << dendl;
+          continue;
+        }
+        (*p_vers)[key] = ver;
+      }
+    }
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::write_shard_vers(const std::map<std::string, uint64_t> &vers)
+  {
+    std::map<std::string, std::map<std::string, bufferlist>> shard_vals;
+    for (const auto& [bucket_shard_oid, ver] : vers) {
+      bufferlist bl;
+      encode(ver, bl);
+      shard_vals[ver_shard_oid(bucket_shard_oid)][bucket_shard_oid] = std::move(bl);
+    }
+
+    int err = 0;
+    for (auto& [oid, vals] : shard_vals) {
+      librados::ObjectWriteOperation op;
+      op.omap_set(vals);
+      int ret = rgw_rados_operate(dpp, d_ioctx, oid, std::move(op), null_yield);
+      if (unlikely(ret < 0)) {
+        ldpp_dout(dpp, 5) << __func__ << "::ERR: failed omap_set(" << oid
+                          << ") ret=" << ret << "::" << cpp_strerror(-ret) << dendl;
+        err = ret;
+      }
+    }
+    return err;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::lookup(const std::vector<disk_record_t> &recs,
+                         std::map<std::string, fp_index_entry_t> *p_found)
+  {
+    std::map<std::string, std::set<std::string>> shard_keys;
+    for (const auto& rec : recs) {
+      shard_keys[shard_oid(rec.s.md5_low)].insert(build_key(&rec));
+    }
+
+    for (const auto& [oid, keys] : shard_keys) {
+      std::map<std::string, bufferlist> vals;
+      int rval = 0;
+      librados::ObjectReadOperation op;
+      op.omap_get_vals_by_keys(keys, &vals, &rval);
+      int ret = rgw_rados_operate(dpp, d_ioctx, oid, std::move(op), nullptr, null_yield);
+      if (ret == -ENOENT) {
+        continue;
+      }
+      else if (unlikely(ret < 0)) {
+        ldpp_dout(dpp, 5) << __func__ << "::ERR: failed omap_get_vals_by_keys("
+                          << oid << ") ret=" << ret << "::" << cpp_strerror(-ret) << dendl;
+        return ret;
+      }
+
+      for (auto& [key, bl] : vals) {
+        fp_index_entry_t entry;
+        try {
+          auto p = bl.cbegin();
+          decode(entry, p);
+        } catch (const buffer::error&) {
+          ldpp_dout(dpp, 5) << __func__ << "::ERR: failed entry decode::" << key << dendl;
+          continue;
+        }
+        (*p_found)[key] = std::move(entry);
+      }
+    }
+    return 0;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::insert(const std::vector<const disk_record_t*> &recs)
+  {
+    std::map<std::string, std::map<std::string, bufferlist>> shard_vals;
+    for (const disk_record_t *p_rec : recs) {
+      fp_index_entry_t entry;
+      rec_to_entry(p_rec, &entry);
+      bufferlist bl;
+      encode(entry, bl);
+      shard_vals[shard_oid(p_rec->s.md5_low)][build_key(p_rec)] = std::move(bl);
+    }
+
+    int err = 0;
+    for (auto& [oid, vals] : shard_vals) {
+      librados::ObjectWriteOperation op;
+      op.omap_set(vals);
+      int ret = rgw_rados_operate(dpp, d_ioctx, oid, std::move(op), null_yield);
+      if (unlikely(ret < 0)) {
+        ldpp_dout(dpp, 5) << __func__ << "::ERR: failed omap_set(" << oid
+                          << ") ret=" << ret << "::" << cpp_strerror(-ret) << dendl;
+        err = ret;
+      }
+    }
+    return err;
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::upsert(const disk_record_t *p_rec)
+  {
+    return insert({p_rec});
+  }
+
+  //---------------------------------------------------------------------------
+  int fp_index_t::remove(const disk_record_t *p_rec)
+  {
+    librados::ObjectWriteOperation op;
+    op.omap_rm_keys({build_key(p_rec)});
+    int ret = rgw_rados_operate(dpp, d_ioctx, shard_oid(p_rec->s.md5_low),
+                                std::move(op), null_yield);
+    if (unlikely(ret < 0 && ret != -ENOENT)) {
+      ldpp_dout(dpp, 5) << __func__ << "::ERR: failed omap_rm_keys() ret="
+                        << ret << "::" << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
+    return 0;
+  }
+
+} //namespace rgw::dedup
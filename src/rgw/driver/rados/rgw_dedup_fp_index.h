@@ -0,0 +1,101 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2;
+// vim: ts=8 sw=2 sts=2 expandtab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#pragma once
+#include "common/dout.h"
+#include "include/rados/librados.hpp"
+#include "include/utime.h"
+#include "rgw_dedup_utils.h"
+#include "rgw_dedup_store.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rgw::sal {
+  class RadosStore;
+}
+
+namespace rgw::dedup {
+  // The fingerprint-index keeps one representative object for every
+  // fingerprint (ETAG, size, storage-class) seen by previous dedup scans.
+  // It lives in the zone log-pool so it survives the removal of the dedup-pool
+  // at the end of every scan.
+  // Incremental scans only ingest bucket-index entries completed after the
+  // last completed scan listed their shard, and use the index to find older
+  // copies of the same data.
+  // The index is sharded by the object count so shards stay below the
+  // large-omap limits. When the cluster outgrows the shard count, a new
+  // generation of the index is started and rebuilt by a full scan.
+  static constexpr const char* FP_INDEX_SHARD_PREFIX = "DEDUP.FP.IDX.";
+  static constexpr const char* FP_INDEX_VER_PREFIX   = "DEDUP.FP.VER.";
+  static constexpr const char* FP_INDEX_HEAD_OID     = "DEDUP.FP.IDX.HEAD";
+  static constexpr uint32_t    FP_INDEX_MIN_SHARDS   = 16;
+  static constexpr uint32_t    FP_INDEX_MAX_SHARDS   = 64*1024;
+  // half of the default osd_deep_scrub_large_omap_object_key_threshold
+  static constexpr uint64_t    FP_INDEX_SHARD_KEYS   = 100*1000;
+
+  struct fp_index_layout_t {
+    uint32_t gen = 0;
+    uint32_t num_shards = 0;
+  };
+  void encode(const fp_index_layout_t& l, ceph::bufferlist& bl);
+  void decode(fp_index_layout_t& l, ceph::bufferlist::const_iterator& bl);
+
+  struct fp_index_entry_t {
+    std::string tenant_name;
+    std::string bucket_name;
+    std::string bucket_id;
+    std::string obj_name;
+  };
+  void encode(const fp_index_entry_t& e, ceph::bufferlist& bl);
+  void decode(fp_index_entry_t& e, ceph::bufferlist::const_iterator& bl);
+
+  class fp_index_t {
+  public:
+    fp_index_t(const DoutPrefixProvider *_dpp) : dpp(_dpp) {}
+    // open the index, starting a new generation if it has too few shards for
+    // a cluster using @num_md5_shards
+    int  init(rgw::sal::RadosStore *store, uint32_t num_md5_shards);
+    bool is_valid() const { return d_ioctx.is_valid(); }
+
+    // time of the last scan which completed on all shards
+    int  read_epoch(utime_t *p_epoch_time);
+    int  write_epoch(const utime_t &epoch_time);
+
+    // versions of bucket-index shards (keyed by their oid) when the last
+    // completed scan started listing them.
+    // entries completed later have an index_ver which is not smaller
+    int  read_shard_vers(const std::vector<std::string> &oids,
+                         std::map<std::string, uint64_t> *p_vers /* OUT */);
+    int  write_shard_vers(const std::map<std::string, uint64_t> &vers);
+
+    // a single round-trip per index-shard
+    int  lookup(const std::vector<disk_record_t> &recs,
+                std::map<std::string, fp_index_entry_t> *p_found /* OUT */);
+    int  insert(const std::vector<const disk_record_t*> &recs);
+    int  upsert(const disk_record_t *p_rec);
+    int  remove(const disk_record_t *p_rec);
+
+    static std::string build_key(const disk_record_t *p_rec);
+  private:
+    int  read_layout(fp_index_layout_t *p_layout);
+    int  reset(const fp_index_layout_t *p_old_layout, uint32_t num_shards);
+    void remove_shards(const fp_index_layout_t &layout);
+    std::string shard_oid(uint64_t md5_low) const;
+    std::string ver_shard_oid(const std::string &bucket_shard_oid) const;
+
+    const DoutPrefixProvider *dpp;
+    librados::IoCtx d_ioctx;
+    fp_index_layout_t d_layout;
+  };
+
+} //namespace rgw::dedup
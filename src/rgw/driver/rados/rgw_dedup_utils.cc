@@ -384,6 +384,9 @@ namespace rgw::dedup {
     this->ingress_skip_too_small += other.ingress_skip_too_small;
     this->ingress_skip_too_small_64KB_bytes += other.ingress_skip_too_small_64KB_bytes;
     this->ingress_skip_too_small_64KB += other.ingress_skip_too_small_64KB;
+    this->ingress_skip_unchanged += other.ingress_skip_unchanged;
+    this->fp_index_hits += other.fp_index_hits;
+    this->fp_index_failures += other.fp_index_failures;
 
     return *this;
   }
@@ -448,6 +451,18 @@ namespace rgw::dedup {
                            this->ingress_skip_too_small_64KB_bytes);
         }
       }
+      if (this->ingress_skip_unchanged) {
+        f->dump_unsigned("Ingress skip: unchanged objs",
+                         this->ingress_skip_unchanged);
+      }
+    }
+
+    if (this->fp_index_hits || this->fp_index_failures) {
+      Formatter::ObjectSection fp_index(*f, "fingerprint index");
+      f->dump_unsigned("FP-Index hits", this->fp_index_hits);
+      if (this->fp_index_failures) {
+        f->dump_unsigned("FP-Index failures", this->fp_index_failures);
+      }
     }
 
     {
@@ -475,7 +490,7 @@ namespace rgw::dedup {
   //---------------------------------------------------------------------------
   void encode(const worker_stats_t& w, ceph::bufferlist& bl)
   {
-    ENCODE_START(1, 1, bl);
+    ENCODE_START(2, 1, bl);
     encode(w.ingress_obj, bl);
     encode(w.ingress_obj_bytes, bl);
     encode(w.egress_records, bl);
@@ -503,13 +518,16 @@ namespace rgw::dedup {
     encode(w.ingress_skip_too_small_64KB, bl);
 
     encode(w.duration, bl);
+    encode(w.ingress_skip_unchanged, bl);
+    encode(w.fp_index_hits, bl);
+    encode(w.fp_index_failures, bl);
     ENCODE_FINISH(bl);
   }
 
   //---------------------------------------------------------------------------
   void decode(worker_stats_t& w, ceph::bufferlist::const_iterator& bl)
   {
-    DECODE_START(1, bl);
+    DECODE_START(2, bl);
     decode(w.ingress_obj, bl);
     decode(w.ingress_obj_bytes, bl);
     decode(w.egress_records, bl);
@@ -532,6 +550,11 @@ namespace rgw::dedup {
     decode(w.ingress_skip_too_small_64KB, bl);
 
     decode(w.duration, bl);
+    if (struct_v >= 2) {
+      decode(w.ingress_skip_unchanged, bl);
+      decode(w.fp_index_hits, bl);
+      decode(w.fp_index_failures, bl);
+    }
     DECODE_FINISH(bl);
   }
 
@@ -583,6 +606,13 @@ namespace rgw::dedup {
     this->md_throttle_sleep_time_usec += other.md_throttle_sleep_time_usec;
     this->failed_table_load       += other.failed_table_load;
     this->failed_map_overflow     += other.failed_map_overflow;
+    this->fp_index_stale_entries  += other.fp_index_stale_entries;
+    this->cdc_objects             += other.cdc_objects;
+    this->cdc_objects_bytes       += other.cdc_objects_bytes;
+    this->cdc_new_chunks          += other.cdc_new_chunks;
+    this->cdc_shared_chunks       += other.cdc_shared_chunks;
+    this->cdc_shared_bytes        += other.cdc_shared_bytes;
+    this->cdc_failed              += other.cdc_failed;
     return *this;
   }
 
@@ -621,6 +651,18 @@ namespace rgw::dedup {
       f->dump_unsigned("Dedup Bytes Estimate", ds.dedup_bytes_estimate);
     }
 
+    if (this->cdc_objects || this->cdc_failed) {
+      Formatter::ObjectSection cdc(*f, "CDC");
+      f->dump_unsigned("Chunked Obj (this cycle)", this->cdc_objects);
+      f->dump_unsigned("Chunked Bytes (this cycle)", this->cdc_objects_bytes);
+      f->dump_unsigned("New Chunks", this->cdc_new_chunks);
+      f->dump_unsigned("Shared Chunks", this->cdc_shared_chunks);
+      f->dump_unsigned("Shared Chunk Bytes", this->cdc_shared_bytes);
+      if (this->cdc_failed) {
+        f->dump_unsigned("Failed Chunking", this->cdc_failed);
+      }
+    }
+
     // Potential Dedup Section:
     // What could be gained by allowing dedup for smaller objects (64KB-4MB)
     // Space wasted because of duplicated head-object (4MB)
@@ -684,6 +726,9 @@ namespace rgw::dedup {
       if (this->ingress_skip_changed_objs) {
         f->dump_unsigned("Skipped Changed Object", this->ingress_skip_changed_objs);
       }
+      if (this->fp_index_stale_entries) {
+        f->dump_unsigned("Skipped stale FP-Index entries", this->fp_index_stale_entries);
+      }
     }
 
     {
@@ -734,7 +779,7 @@ namespace rgw::dedup {
   //---------------------------------------------------------------------------
   void encode(const md5_stats_t& m, ceph::bufferlist& bl)
   {
-    ENCODE_START(1, 1, bl);
+    ENCODE_START(3, 1, bl);
 
     encode(m.small_objs_stat, bl);
     encode(m.big_objs_stat, bl);
@@ -782,13 +827,20 @@ namespace rgw::dedup {
     encode(m.failed_map_overflow, bl);
 
     encode(m.duration, bl);
+    encode(m.fp_index_stale_entries, bl);
+    encode(m.cdc_objects, bl);
+    encode(m.cdc_objects_bytes, bl);
+    encode(m.cdc_new_chunks, bl);
+    encode(m.cdc_shared_chunks, bl);
+    encode(m.cdc_shared_bytes, bl);
+    encode(m.cdc_failed, bl);
     ENCODE_FINISH(bl);
   }
 
   //---------------------------------------------------------------------------
   void decode(md5_stats_t& m, ceph::bufferlist::const_iterator& bl)
   {
-    DECODE_START(1, bl);
+    DECODE_START(3, bl);
     decode(m.small_objs_stat, bl);
     decode(m.big_objs_stat, bl);
     decode(m.ingress_slabs, bl);
@@ -835,6 +887,17 @@ namespace rgw::dedup {
     decode(m.failed_map_overflow, bl);
 
     decode(m.duration, bl);
+    if (struct_v >= 2) {
+      decode(m.fp_index_stale_entries, bl);
+    }
+    if (struct_v >= 3) {
+      decode(m.cdc_objects, bl);
+      decode(m.cdc_objects_bytes, bl);
+      decode(m.cdc_new_chunks, bl);
+      decode(m.cdc_shared_chunks, bl);
+      decode(m.cdc_shared_bytes, bl);
+      decode(m.cdc_failed, bl);
+    }
     DECODE_FINISH(bl);
   }
 } //namespace rgw::dedup
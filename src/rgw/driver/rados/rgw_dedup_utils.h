@@ -70,6 +70,7 @@ namespace rgw::dedup {
     static constexpr uint8_t RGW_DEDUP_FLAG_SHARED_MANIFEST   = 0x02; // REC + TAB
     static constexpr uint8_t RGW_DEDUP_FLAG_OCCUPIED          = 0x04; // TAB
     static constexpr uint8_t RGW_DEDUP_FLAG_FASTLANE          = 0x08; // REC
+    static constexpr uint8_t RGW_DEDUP_FLAG_FP_INDEX          = 0x10; // REC
 
   public:
     dedup_flags_t() : flags(0) {}
@@ -84,6 +85,9 @@ namespace rgw::dedup {
     inline void clear_occupied() { this->flags &= ~RGW_DEDUP_FLAG_OCCUPIED; }
     inline bool is_fastlane()  const { return ((flags & RGW_DEDUP_FLAG_FASTLANE) != 0); }
     inline void set_fastlane()  { flags |= RGW_DEDUP_FLAG_FASTLANE; }
+    // record was loaded from the fingerprint-index and not from a bucket-index
+    inline bool is_fp_index()  const { return ((flags & RGW_DEDUP_FLAG_FP_INDEX) != 0); }
+    inline void set_fp_index()  { flags |= RGW_DEDUP_FLAG_FP_INDEX; }
   private:
     uint8_t flags;
   };
@@ -219,6 +223,11 @@ namespace rgw::dedup {
     uint64_t ingress_skip_too_small_64KB_bytes = 0;
     uint64_t ingress_skip_too_small_64KB = 0;
 
+    // incremental scans
+    uint64_t ingress_skip_unchanged = 0;
+    uint64_t fp_index_hits = 0;
+    uint64_t fp_index_failures = 0;
+
     utime_t  duration = {0, 0};
   };
   std::ostream& operator<<(std::ostream &out, const worker_stats_t &s);
@@ -276,6 +285,14 @@ namespace rgw::dedup {
     uint64_t md_throttle_sleep_time_usec = 0;
     uint64_t failed_table_load = 0;
     uint64_t failed_map_overflow = 0;
+    uint64_t fp_index_stale_entries = 0;
+    // content-defined chunking of singleton objects
+    uint64_t cdc_objects = 0;
+    uint64_t cdc_objects_bytes = 0;
+    uint64_t cdc_new_chunks = 0;
+    uint64_t cdc_shared_chunks = 0;
+    uint64_t cdc_shared_bytes = 0;
+    uint64_t cdc_failed = 0;
     utime_t  duration = {0, 0};
   };
   std::ostream &operator<<(std::ostream &out, const md5_stats_t &s);
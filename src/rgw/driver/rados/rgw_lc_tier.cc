@@ -4,6 +4,8 @@
 #include <string.h>
 #include <iostream>
 #include <map>
+#include <optional>
+#include <vector>
 
 #include "common/XMLFormatter.h"
 #include <common/errno.h>
@@ -19,19 +21,13 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #define dout_context g_ceph_context
 #define dout_subsys ceph_subsys_rgw
 
 using namespace std;
 
-struct rgw_lc_multipart_part_info {
-  int part_num{0};
-  uint64_t ofs{0};
-  uint64_t size{0};
-  std::string etag;
-};
-
 struct rgw_lc_obj_properties {
   ceph::real_time mtime;
   std::string etag;
@@ -49,32 +45,6 @@ struct rgw_lc_obj_properties {
     target_storage_class(_t_storage_class) {}
 };
 
-struct rgw_lc_multipart_upload_info {
-  std::string upload_id;
-  uint64_t obj_size;
-  ceph::real_time mtime;
-  std::string etag;
-
-  void encode(bufferlist& bl) const {
-    ENCODE_START(1, 1, bl);
-    encode(upload_id, bl);
-    encode(obj_size, bl);
-    encode(mtime, bl);
-    encode(etag, bl);
-    ENCODE_FINISH(bl);
-  }
-
-  void decode(bufferlist::const_iterator& bl) {
-    DECODE_START(1, bl);
-    decode(upload_id, bl);
-    decode(obj_size, bl);
-    decode(mtime, bl);
-    decode(etag, bl);
-    DECODE_FINISH(bl);
-  }
-};
-WRITE_CLASS_ENCODER(rgw_lc_multipart_upload_info)
-
 static inline string get_key_instance(const rgw_obj_key& key)
 {
   // if non-current entry, add versionID to the
@@ -141,7 +111,7 @@ static int read_upload_status(const DoutPrefixProvider *dpp, rgw::sal::Driver *d
 }
 
 static int put_upload_status(const DoutPrefixProvider *dpp, rgw::sal::Driver *driver,
-    const rgw_raw_obj *status_obj, rgw_lc_multipart_upload_info *status)
+    const rgw_raw_obj *status_obj, const rgw_lc_multipart_upload_info *status)
 {
   int ret = 0;
   rgw::sal::RadosStore *rados = dynamic_cast<rgw::sal::RadosStore*>(driver);
@@ -183,6 +153,87 @@ static int delete_upload_status(const DoutPrefixProvider *dpp, rgw::sal::Driver
   return ret;
 }
 
+/* Paces the cloud transitions of the process to rgw_lc_cloud_tier_max_bandwidth.
+ * Every transfer reserves its length, and may start once the transfers
+ * reserved before it have used up their share of the budget. */
+class RGWLCCloudTierBandwidth {
+  ceph::mutex lock = ceph::make_mutex("RGWLCCloudTierBandwidth");
+  ceph::mono_time next = ceph::mono_time::min();
+
+public:
+  /* returns how long the transfer has to wait */
+  ceph::timespan reserve(CephContext *cct, uint64_t len) {
+    const uint64_t rate = cct->_conf.get_val<Option::size_t>("rgw_lc_cloud_tier_max_bandwidth");
+    if (rate == 0) {
+      return ceph::timespan::zero();
+    }
+    const auto now = ceph::mono_clock::now();
+    std::lock_guard l{lock};
+    const auto start = std::max(now, next);
+    next = start + std::chrono::duration_cast<ceph::timespan>(
+        std::chrono::duration<double>(static_cast<double>(len) / rate));
+    return start - now;
+  }
+};
+
+static RGWLCCloudTierBandwidth cloud_tier_bandwidth;
+
+/* Runs an upload of len bytes on the cloud tier upload threads once the
+ * bandwidth budget allows it. The wait for the budget is a timer, so it holds
+ * neither an upload thread nor the lifecycle worker. */
+template <typename F>
+static void cloud_tier_schedule_upload(RGWLCCloudTierCtx& tier_ctx, uint64_t len, F&& f)
+{
+  auto rados = static_cast<rgw::sal::RadosStore*>(tier_ctx.driver)->getRados();
+  auto timer = std::make_unique<boost::asio::steady_timer>(
+      rados->get_lc_cloud_tier_context(),
+      cloud_tier_bandwidth.reserve(tier_ctx.cct, len));
+  auto& t = *timer;
+  t.async_wait([timer = std::move(timer), f = std::forward<F>(f)]
+               (boost::system::error_code) mutable {
+      timer.reset();
+      std::move(f)();
+    });
+}
+
+void rgw_cloud_tier_init_parts(rgw_lc_multipart_upload_info& status,
+                               uint64_t obj_size, uint64_t min_part_size)
+{
+#define MULTIPART_MAX_PARTS 10000
+  min_part_size = std::max<uint64_t>(min_part_size, MULTIPART_MIN_POSSIBLE_PART_SIZE);
+  const uint64_t part_size = std::max(min_part_size, obj_size / MULTIPART_MAX_PARTS);
+
+  status.parts.clear();
+  uint64_t cur_ofs = 0;
+  for (int cur_part = 1; cur_ofs < obj_size; ++cur_part) {
+    rgw_lc_multipart_part_info& cur_part_info = status.parts[cur_part];
+    cur_part_info.part_num = cur_part;
+    cur_part_info.ofs = cur_ofs;
+    cur_part_info.size = std::min(part_size, obj_size - cur_ofs);
+    cur_ofs += cur_part_info.size;
+  }
+}
+
+bool rgw_cloud_tier_can_resume(const rgw_lc_multipart_upload_info& status,
+                               ceph::real_time mtime, uint64_t obj_size,
+                               const std::string& etag)
+{
+  // the status has no part layout when written by an older version
+  return status.mtime == mtime && status.obj_size == obj_size &&
+         status.etag == etag && !status.parts.empty();
+}
+
+std::vector<int> rgw_cloud_tier_pending_parts(const rgw_lc_multipart_upload_info& status)
+{
+  std::vector<int> pending;
+  for (const auto& [num, part] : status.parts) {
+    if (part.etag.empty()) {
+      pending.push_back(num);
+    }
+  }
+  return pending;
+}
+
 static std::set<string> keep_headers = { "CONTENT_TYPE",
                                          "CONTENT_ENCODING",
                                          "CONTENT_DISPOSITION",
@@ -943,13 +994,25 @@ static int cloud_tier_plain_transfer(RGWLCCloudTierCtx& tier_ctx) {
   writef.reset(new RGWLCCloudStreamPut(tier_ctx.dpp, obj_properties, tier_ctx.conn,
                dest_obj));
 
-  /* actual Read & Write */
-  ret = cloud_tier_transfer_object(tier_ctx.dpp, readf.get(), writef.get());
+  /* actual Read & Write, on the upload threads */
+  ceph::mutex lock = ceph::make_mutex("cloud_tier_plain_transfer");
+  ceph::condition_variable cond;
+  std::optional<int> result;
+  cloud_tier_schedule_upload(tier_ctx, tier_ctx.o.meta.size, [&] {
+      int r = cloud_tier_transfer_object(tier_ctx.dpp, readf.get(), writef.get());
+      std::lock_guard l{lock};
+      result = r;
+      cond.notify_one();
+    });
+  std::unique_lock l{lock};
+  cond.wait(l, [&] { return result.has_value(); });
+  ret = *result;
 
   return ret;
 }
 
 static int cloud_tier_send_multipart_part(RGWLCCloudTierCtx& tier_ctx,
+                                rgw::sal::Object *obj,
                                 const std::string& upload_id,
                                 const rgw_lc_multipart_part_info& part_info,
                                 std::string *petag) {
@@ -965,21 +1028,21 @@ static int cloud_tier_send_multipart_part(RGWLCCloudTierCtx& tier_ctx,
   dest_bucket.name = tier_ctx.target_bucket_name;
 
   target_obj_name = tier_ctx.bucket_info.bucket.name + "/" +
-    tier_ctx.obj->get_name();
+    obj->get_name();
   if (!tier_ctx.o.is_current()) {
-    target_obj_name += get_key_instance(tier_ctx.obj->get_key());
+    target_obj_name += get_key_instance(obj->get_key());
   }
 
   rgw_obj dest_obj(dest_bucket, rgw_obj_key(target_obj_name));
 
-  tier_ctx.obj->set_atomic(true);
+  obj->set_atomic(true);
 
   /* TODO: Define readf, writef as stack variables. For some reason,
    * when used as stack variables (esp., readf), the transition seems to
    * be taking lot of time eventually erroring out at times. */
   std::shared_ptr<RGWLCStreamRead> readf;
   readf.reset(new RGWLCStreamRead(tier_ctx.cct, tier_ctx.dpp,
-        tier_ctx.obj, tier_ctx.o.meta.mtime));
+        obj, tier_ctx.o.meta.mtime));
 
   std::shared_ptr<RGWLCCloudStreamPut> writef;
   writef.reset(new RGWLCCloudStreamPut(tier_ctx.dpp, obj_properties, tier_ctx.conn,
@@ -1286,6 +1349,84 @@ static int cloud_tier_abort_multipart_upload(RGWLCCloudTierCtx& tier_ctx,
   return 0;
 }
 
+/* Upload the parts of status that have no etag yet, up to
+ * rgw_lc_cloud_tier_multipart_window of them at a time on the upload threads
+ * shared by all transitions. The upload status is saved as parts complete, so
+ * that a transition whose worker dies only redoes the parts that were in
+ * flight. */
+static int cloud_tier_send_multipart_parts(RGWLCCloudTierCtx& tier_ctx,
+                                           const rgw_raw_obj& status_obj,
+                                           rgw_lc_multipart_upload_info& status) {
+  const std::vector<int> pending = rgw_cloud_tier_pending_parts(status);
+  if (pending.empty()) {
+    return 0;
+  }
+
+  const uint64_t window = std::clamp<uint64_t>(
+      tier_ctx.cct->_conf.get_val<uint64_t>("rgw_lc_cloud_tier_multipart_window"),
+      1, pending.size());
+  ldpp_dout(tier_ctx.dpp, 20) << "uploading " << pending.size() << " of "
+      << status.parts.size() << " parts, " << window << " at a time, upload_id="
+      << status.upload_id << dendl;
+
+  ceph::mutex lock = ceph::make_mutex("cloud_tier_send_multipart_parts");
+  ceph::condition_variable cond;
+  size_t next = 0;
+  uint64_t in_flight = 0;
+  int error = 0;
+  bool dirty = false; // parts completed since the status was saved
+  auto last_saved = ceph::mono_clock::now();
+
+  std::unique_lock l{lock};
+  for (;;) {
+    while (error == 0 && next < pending.size() && in_flight < window) {
+      const rgw_lc_multipart_part_info part = status.parts[pending[next++]];
+      ++in_flight;
+      cloud_tier_schedule_upload(tier_ctx, part.size, [&, part] {
+          /* each upload reads through its own object handle, the object
+           * state cached in a handle is not meant to be shared between
+           * threads */
+          auto obj = tier_ctx.obj->get_bucket()->get_object(tier_ctx.obj->get_key());
+          std::string etag;
+          int ret = cloud_tier_send_multipart_part(tier_ctx, obj.get(),
+                                                   status.upload_id, part, &etag);
+          std::lock_guard l{lock};
+          if (ret < 0) {
+            ldpp_dout(tier_ctx.dpp, 0) << "ERROR: failed to send multipart part of obj=" << tier_ctx.obj << ", sync via multipart upload, upload_id=" << status.upload_id << " part number " << part.part_num << " (error: " << cpp_strerror(-ret) << ")" << dendl;
+            if (error == 0) {
+              error = ret;
+            }
+          } else {
+            status.parts[part.part_num].etag = std::move(etag);
+            dirty = true;
+          }
+          --in_flight;
+          cond.notify_one();
+        });
+    }
+    if (in_flight == 0) {
+      break;
+    }
+    cond.wait(l);
+
+    const auto now = ceph::mono_clock::now();
+    if (dirty && now - last_saved >= std::chrono::seconds(1)) {
+      last_saved = now;
+      dirty = false;
+      const rgw_lc_multipart_upload_info snapshot = status;
+      l.unlock();
+
+      int ret = put_upload_status(tier_ctx.dpp, tier_ctx.driver, &status_obj, &snapshot);
+      if (ret < 0) {
+        ldpp_dout(tier_ctx.dpp, 0) << "WARNING: failed to save multipart upload state, ret=" << ret << dendl;
+        // progress is only lost if the worker dies
+      }
+      l.lock();
+    }
+  }
+  return error;
+}
+
 static int cloud_tier_multipart_transfer(RGWLCCloudTierCtx& tier_ctx) {
   rgw_obj src_obj;
   rgw_obj dest_obj;
@@ -1310,13 +1451,6 @@ static int cloud_tier_multipart_transfer(RGWLCCloudTierCtx& tier_ctx) {
         tier_ctx.o.versioned_epoch, tier_ctx.acl_mappings,
         tier_ctx.target_storage_class);
 
-  uint32_t part_size{0};
-  uint32_t num_parts{0};
-
-  int cur_part{0};
-  uint64_t cur_ofs{0};
-  std::map<int, rgw_lc_multipart_part_info> parts;
-
   obj_size = tier_ctx.o.meta.size;
 
   target_bucket.name = tier_ctx.target_bucket_name;
@@ -1339,11 +1473,14 @@ static int cloud_tier_multipart_transfer(RGWLCCloudTierCtx& tier_ctx) {
   }
 
   if (ret >= 0) {
-    // check here that mtime and size did not change 
-    if (status.mtime != obj_properties.mtime || status.obj_size != obj_size ||
-        status.etag != obj_properties.etag) {
+    // check here that mtime and size did not change
+    if (!rgw_cloud_tier_can_resume(status, obj_properties.mtime, obj_size,
+                                   obj_properties.etag)) {
       cloud_tier_abort_multipart_upload(tier_ctx, dest_obj, status_obj, status.upload_id);
+      status = rgw_lc_multipart_upload_info{};
       ret = -ENOENT;
+    } else {
+      ldpp_dout(tier_ctx.dpp, 10) << "resuming multipart upload of obj=" << tier_ctx.obj << " upload_id=" << status.upload_id << dendl;
     }
   }
 
@@ -1365,51 +1502,28 @@ static int cloud_tier_multipart_transfer(RGWLCCloudTierCtx& tier_ctx) {
     status.mtime = obj_properties.mtime;
     status.etag = obj_properties.etag;
 
+    rgw_cloud_tier_init_parts(status, obj_size, tier_ctx.multipart_min_part_size);
+    ldpp_dout(tier_ctx.dpp, 20) << "obj size = " << obj_size << ", num_parts:" << status.parts.size() << dendl;
+
     ret = put_upload_status(tier_ctx.dpp, tier_ctx.driver, &status_obj, &status);
 
     if (ret < 0) {
       ldpp_dout(tier_ctx.dpp, 0) << "ERROR: failed to driver multipart upload state, ret=" << ret << dendl;
       // continue with upload anyway 
     }
-
-#define MULTIPART_MAX_PARTS 10000
-#define MULTIPART_MAX_PARTS 10000
-    uint64_t min_part_size = obj_size / MULTIPART_MAX_PARTS;
-    uint64_t min_conf_size = tier_ctx.multipart_min_part_size;
-
-    if (min_conf_size < MULTIPART_MIN_POSSIBLE_PART_SIZE) {
-      min_conf_size = MULTIPART_MIN_POSSIBLE_PART_SIZE;
-    }
-
-    part_size = std::max(min_conf_size, min_part_size);
-    num_parts = (obj_size + part_size - 1) / part_size;
-    cur_part = 1;
-    cur_ofs = 0;
   }
 
-  for (; (uint32_t)cur_part <= num_parts; ++cur_part) {
-    ldpp_dout(tier_ctx.dpp, 20) << "cur_part = "<< cur_part << ", info.ofs = " << cur_ofs << ", info.size = " << part_size << ", obj size = " << obj_size<< ", num_parts:" << num_parts << dendl;
-    rgw_lc_multipart_part_info& cur_part_info = parts[cur_part];
-    cur_part_info.part_num = cur_part;
-    cur_part_info.ofs = cur_ofs;
-    cur_part_info.size = std::min((uint64_t)part_size, obj_size - cur_ofs);
-
-    cur_ofs += cur_part_info.size;
-
-    ret = cloud_tier_send_multipart_part(tier_ctx,
-            status.upload_id,
-            cur_part_info,
-            &cur_part_info.etag);
-
-    if (ret < 0) {
-      ldpp_dout(tier_ctx.dpp, 0) << "ERROR: failed to send multipart part of obj=" << tier_ctx.obj << ", sync via multipart upload, upload_id=" << status.upload_id << " part number " << cur_part << " (error: " << cpp_strerror(-ret) << ")" << dendl;
-      cloud_tier_abort_multipart_upload(tier_ctx, dest_obj, status_obj, status.upload_id);
-      return ret;
-    }
-
+  ret = cloud_tier_send_multipart_parts(tier_ctx, status_obj, status);
+  if (ret < 0) {
+    /* nothing is left behind on a failure we get to see: the next attempt may
+     * never come (the object can be removed or the rule changed), and neither
+     * the upload on the endpoint nor the status obj would be cleaned up then.
+     * the saved status only serves a transition whose worker died */
+    cloud_tier_abort_multipart_upload(tier_ctx, dest_obj, status_obj, status.upload_id);
+    return ret;
   }
 
-  ret = cloud_tier_complete_multipart(tier_ctx.dpp, tier_ctx.conn, dest_obj, status.upload_id, parts);
+  ret = cloud_tier_complete_multipart(tier_ctx.dpp, tier_ctx.conn, dest_obj, status.upload_id, status.parts);
   if (ret < 0) {
     ldpp_dout(tier_ctx.dpp, 0) << "ERROR: failed to complete multipart upload of obj=" << tier_ctx.obj << " (error: " << cpp_strerror(-ret) << ")" << dendl;
     cloud_tier_abort_multipart_upload(tier_ctx, dest_obj, status_obj, status.upload_id);
@@ -1419,7 +1533,7 @@ static int cloud_tier_multipart_transfer(RGWLCCloudTierCtx& tier_ctx) {
   /* remove status obj */
   ret = delete_upload_status(tier_ctx.dpp, tier_ctx.driver, &status_obj);
   if (ret < 0) {
-    ldpp_dout(tier_ctx.dpp, 0) << "ERROR: failed to abort multipart upload obj=" << tier_ctx.obj << " upload_id=" << status.upload_id << " part number " << cur_part << " (" << cpp_strerror(-ret) << ")" << dendl;
+    ldpp_dout(tier_ctx.dpp, 0) << "ERROR: failed to abort multipart upload obj=" << tier_ctx.obj << " upload_id=" << status.upload_id << " (" << cpp_strerror(-ret) << ")" << dendl;
     // ignore error, best effort 
   }
   return 0;
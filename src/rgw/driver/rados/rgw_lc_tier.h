@@ -13,6 +13,64 @@
 #define DEFAULT_MULTIPART_SYNC_PART_SIZE (32 * 1024 * 1024)
 #define MULTIPART_MIN_POSSIBLE_PART_SIZE (5 * 1024 * 1024)
 
+struct rgw_lc_multipart_part_info {
+  int part_num{0};
+  uint64_t ofs{0};
+  uint64_t size{0};
+  std::string etag;
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    encode(part_num, bl);
+    encode(ofs, bl);
+    encode(size, bl);
+    encode(etag, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START(1, bl);
+    decode(part_num, bl);
+    decode(ofs, bl);
+    decode(size, bl);
+    decode(etag, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(rgw_lc_multipart_part_info)
+
+struct rgw_lc_multipart_upload_info {
+  std::string upload_id;
+  uint64_t obj_size{0};
+  ceph::real_time mtime;
+  std::string etag;
+  /* all the parts of the upload; the ones with an etag were uploaded */
+  std::map<int, rgw_lc_multipart_part_info> parts;
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(2, 1, bl);
+    encode(upload_id, bl);
+    encode(obj_size, bl);
+    encode(mtime, bl);
+    encode(etag, bl);
+    encode(parts, bl);
+    ENCODE_FINISH(bl);
+  }
+
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START(2, bl);
+    decode(upload_id, bl);
+    decode(obj_size, bl);
+    decode(mtime, bl);
+    decode(etag, bl);
+    if (struct_v >= 2) {
+      decode(parts, bl);
+    }
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(rgw_lc_multipart_upload_info)
+
 struct RGWLCCloudTierCtx {
   CephContext *cct;
   const DoutPrefixProvider *dpp;
@@ -73,3 +131,17 @@ int cloud_tier_restore(const DoutPrefixProvider *dpp,
 
 bool is_restore_in_progress(const DoutPrefixProvider *dpp,
                             std::map<std::string, std::string>& headers);
+
+/* Lays out the parts of a multipart transition of an object of obj_size bytes,
+ * no smaller than min_part_size and no more than the endpoint accepts */
+void rgw_cloud_tier_init_parts(rgw_lc_multipart_upload_info& status,
+                               uint64_t obj_size, uint64_t min_part_size);
+
+/* Whether a saved upload status can be resumed: it is for the same version of
+ * the object and records the part layout */
+bool rgw_cloud_tier_can_resume(const rgw_lc_multipart_upload_info& status,
+                               ceph::real_time mtime, uint64_t obj_size,
+                               const std::string& etag);
+
+/* The parts of an upload that were not sent yet */
+std::vector<int> rgw_cloud_tier_pending_parts(const rgw_lc_multipart_upload_info& status);
@@ -318,6 +318,13 @@ public:
     fifo->push(dpp, std::move(entry), y);
   }
 
+  void push(const DoutPrefixProvider *dpp,
+	    std::deque<ceph::buffer::list> entries,
+	    asio::yield_context y) {
+    lazy_init(dpp, y);
+    fifo->push(dpp, std::move(entries), y);
+  }
+
   asio::awaitable<std::tuple<std::span<fifo::entry>, std::optional<std::string>>>
   list(const DoutPrefixProvider *dpp, std::string markstr,
        std::span<fifo::entry> entries) {
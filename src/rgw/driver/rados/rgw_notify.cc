@@ -26,6 +26,7 @@
 #include "common/async/yield_waiter.h"
 #include <future>
 
+#include <deque>
 #include <unordered_map>
 
 #define dout_subsys ceph_subsys_rgw_notification
@@ -382,11 +383,117 @@ private:
     return 0;
   }
 
+  // remove the entries of a queue up to the end marker, and commit again the
+  // ones that are migrating
+  // return an error if processing of the queue should stop
+  int remove_queue_entries(const std::string& queue_name, const std::string& end_marker,
+                           uint64_t entries_to_remove, std::vector<cls_queue_entry> entries_to_migrate,
+                           boost::asio::yield_context yield) {
+    auto& rados_ioctx = rados_store->getRados()->get_notif_pool_ctx();
+    librados::ObjectWriteOperation op;
+    op.assert_exists();
+    rados::cls::lock::assert_locked(&op, queue_name+"_lock", 
+      ClsLockType::EXCLUSIVE,
+      lock_cookie, 
+      "" /*no tag*/);
+    cls_2pc_queue_remove_entries(op, end_marker, entries_to_remove);
+    // check ownership and deleted entries in one batch
+    auto ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), yield);
+    if (ret == -ENOENT) {
+      // queue was deleted
+      ldpp_dout(this, 10) << "INFO: queue: " << queue_name
+                          << ". was removed. processing will stop" << dendl;
+      return ret;
+    }
+    if (ret == -EBUSY) {
+      ldpp_dout(this, 10)
+          << "WARNING: queue: " << queue_name
+          << " ownership moved to another daemon. processing will stop"
+          << dendl;
+      return ret;
+    }
+    if (ret < 0) {
+      ldpp_dout(this, 1) << "ERROR: failed to remove entries and/or lock queue up to: " << end_marker <<  " from queue: " 
+        << queue_name << ". error: " << ret << dendl;
+      return ret;
+    } else {
+      ldpp_dout(this, 20) << "INFO: removed entries up to: " << end_marker <<  " from queue: " << queue_name << dendl;
+    }
+
+    // reserving and committing the migrating entries
+    if (!entries_to_migrate.empty()) {
+      std::vector<bufferlist> migration_vector;
+      std::string tenant_name;
+      // TODO: extract tenant name from queue_name once it is fixed
+      uint64_t size_to_migrate = 0;
+      RGWPubSub ps(rados_store, tenant_name, site);
+
+      rgw_pubsub_topic topic;
+      auto ret_of_get_topic = ps.get_topic(this, queue_name, topic,
+                                           yield, nullptr);
+      if (ret_of_get_topic < 0) {
+        // we can't migrate entries without topic info
+        ldpp_dout(this, 1) << "ERROR: failed to fetch topic: " << queue_name << " error: "
+          << ret_of_get_topic << ". Aborting migration!" << dendl;
+        return ret_of_get_topic;
+      }
+
+      for (auto entry: entries_to_migrate) {
+        event_entry_t event_entry;
+        auto iter = entry.data.cbegin();
+        try {
+          decode(event_entry, iter);
+        } catch (buffer::error& err) {
+          ldpp_dout(this, 5) << "WARNING: failed to decode entry. error: " << err.what() << dendl;
+          continue;
+        }
+        size_to_migrate += entry.data.length();
+        event_entry.creation_time = ceph::coarse_real_clock::now();
+        event_entry.time_to_live = topic.dest.time_to_live;
+        event_entry.max_retries = topic.dest.max_retries;
+        event_entry.retry_sleep_duration = topic.dest.retry_sleep_duration;
+
+        bufferlist bl;
+        encode(event_entry, bl);
+        migration_vector.push_back(bl);
+      }
+
+      cls_2pc_reservation::id_t reservation_id;
+      buffer::list obl;
+      int rval;
+      op = librados::ObjectWriteOperation();
+      cls_2pc_queue_reserve(op, size_to_migrate, migration_vector.size(), &obl, &rval);
+      ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), yield, librados::OPERATION_RETURNVEC);
+      if (ret < 0) {
+        ldpp_dout(this, 1) << "ERROR: failed to reserve migration space on queue: " << queue_name << ". error: " << ret << dendl;
+        return ret;
+      }
+      ret = cls_2pc_queue_reserve_result(obl, reservation_id);
+      if (ret < 0) {
+        ldpp_dout(this, 1) << "ERROR: failed to parse reservation id for migration. error: " << ret << dendl;
+        return ret;
+      }
+
+      op = librados::ObjectWriteOperation();
+      cls_2pc_queue_commit(op, migration_vector, reservation_id);
+      ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), yield);
+      reservation_id = cls_2pc_reservation::NO_ID;
+      if (ret < 0) {
+        ldpp_dout(this, 1) << "ERROR: failed to commit reservation to queue: " << queue_name << ". error: " << ret << dendl;
+      }
+    }
+    return 0;
+  }
+
   // processing of a specific queue
   void process_queue(const std::string& queue_name, boost::asio::yield_context yield) {
     constexpr auto max_elements = 1024;
     auto is_idle = false;
-    const std::string start_marker;
+    // the removal of processed entries runs along with the next listing,
+    // which then starts where the removal ends
+    std::string start_marker;
+    tokens_waiter removal_waiter(this);
+    int removal_ret = 0;
 
     // start a the cleanup coroutine for the queue
     boost::asio::spawn(make_strand(io_context), std::allocator_arg, make_stack_allocator(),
@@ -407,10 +514,8 @@ private:
       // get list of entries in the queue
       auto& rados_ioctx = rados_store->getRados()->get_notif_pool_ctx();
       is_idle = true;
-      bool truncated = false;
       std::string end_marker;
-      std::vector<cls_queue_entry> entries;
-      auto total_entries = 0U;
+      cls_queue_list_ret list_ret;
       {
         librados::ObjectReadOperation op;
         op.assert_exists();
@@ -420,9 +525,14 @@ private:
           ClsLockType::EXCLUSIVE,
           lock_cookie, 
           "" /*no tag*/);
-        cls_2pc_queue_list_entries(op, start_marker, max_elements, &obl, &rval);
+        cls_2pc_queue_list_entries_bulk(op, start_marker, max_elements, &obl, &rval);
         // check ownership and list entries in one batch
         auto ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), nullptr, yield);
+        removal_waiter.async_wait(yield);
+        if (removal_ret < 0) {
+          return;
+        }
+        start_marker.clear();
         if (ret == -ENOENT) {
           // queue was deleted
           topics_persistency_tracker.erase(queue_name);
@@ -443,14 +553,17 @@ private:
             << queue_name << ". error: " << ret << " (will retry)" << dendl;
           continue;
         }
-        ret = cls_2pc_queue_list_entries_result(obl, entries, &truncated, end_marker);
+        ret = cls_2pc_queue_list_entries_result(obl, list_ret);
         if (ret < 0) {
           ldpp_dout(this, 5) << "WARNING: failed to parse list of entries in queue: " 
             << queue_name << ". error: " << ret << " (will retry)" << dendl;
           continue;
         }
+        end_marker = list_ret.next_marker;
       }
-      total_entries = entries.size();
+      // entries are sliced out of the listing only when they are reached
+      cls_queue_list_iterator next_entry(list_ret);
+      const auto total_entries = next_entry.size();
       if (total_entries == 0) {
         // nothing in the queue
         continue;
@@ -458,6 +571,12 @@ private:
       // log when queue is not idle
       ldpp_dout(this, 20) << "INFO: found: " << total_entries << " entries in: " << queue_name <<
         ". end marker is: " << end_marker << dendl;
+      std::deque<cls_queue_entry> entries;
+      if (next_entry.next(entries.emplace_back()) <= 0) {
+        ldpp_dout(this, 5) << "WARNING: failed to parse entry: " << next_entry.marker()
+          << " in queue: " << queue_name << " (will retry)" << dendl;
+        continue;
+      }
       rgw_pubsub_topic topic_info;
       if (get_topic_info(queue_name, entries.front(), topic_info, yield) < 0) {
         continue;
@@ -481,11 +600,23 @@ private:
       auto remove_entries = false;
       auto entry_idx = 1U;
       tokens_waiter tw(this);
-      std::vector<bool> needs_migration_vector(entries.size(), false);
-      for (auto& entry : entries) {
-        if (stop_processing) {
-          break;
+      std::vector<bool> needs_migration_vector;
+      while (!stop_processing) {
+        if (entry_idx > entries.size()) {
+          const auto r = next_entry.next(entries.emplace_back());
+          if (r <= 0) {
+            entries.pop_back();
+            if (r < 0) {
+              // entries from the malformed one on are kept in the queue
+              ldpp_dout(this, 1) << "ERROR: failed to parse entry: " << next_entry.marker()
+                << " in queue: " << queue_name << dendl;
+              end_marker = next_entry.marker();
+            }
+            break;
+          }
         }
+        auto& entry = entries[entry_idx - 1];
+        needs_migration_vector.push_back(false);
 
         entries_persistency_tracker& notifs_persistency_tracker = topics_persistency_tracker[queue_name];
         tokens_waiter::token token(&tw);
@@ -538,7 +669,7 @@ private:
         tw.async_wait(yield);
       }
 
-      // delete all published entries from queue
+      // delete all published entries from queue, along with the next listing
       if (remove_entries) {
         std::vector<cls_queue_entry> entries_to_migrate;
         uint64_t index = 0;
@@ -554,99 +685,17 @@ private:
           index++;
         }
 
-        uint64_t entries_to_remove = index;
-        librados::ObjectWriteOperation op;
-        op.assert_exists();
-        rados::cls::lock::assert_locked(&op, queue_name+"_lock", 
-          ClsLockType::EXCLUSIVE,
-          lock_cookie, 
-          "" /*no tag*/);
-        cls_2pc_queue_remove_entries(op, end_marker, entries_to_remove);
-        // check ownership and deleted entries in one batch
-        auto ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), yield);
-        if (ret == -ENOENT) {
-          // queue was deleted
-          ldpp_dout(this, 10) << "INFO: queue: " << queue_name
-                              << ". was removed. processing will stop" << dendl;
-          return;
-        }
-        if (ret == -EBUSY) {
-          ldpp_dout(this, 10)
-              << "WARNING: queue: " << queue_name
-              << " ownership moved to another daemon. processing will stop"
-              << dendl;
-          return;
-        }
-        if (ret < 0) {
-          ldpp_dout(this, 1) << "ERROR: failed to remove entries and/or lock queue up to: " << end_marker <<  " from queue: " 
-            << queue_name << ". error: " << ret << dendl;
-          return;
-        } else {
-          ldpp_dout(this, 20) << "INFO: removed entries up to: " << end_marker <<  " from queue: " << queue_name << dendl;
-        }
-
-        // reserving and committing the migrating entries
-        if (!entries_to_migrate.empty()) {
-          std::vector<bufferlist> migration_vector;
-          std::string tenant_name;
-          // TODO: extract tenant name from queue_name once it is fixed
-          uint64_t size_to_migrate = 0;
-          RGWPubSub ps(rados_store, tenant_name, site);
-
-          rgw_pubsub_topic topic;
-          auto ret_of_get_topic = ps.get_topic(this, queue_name, topic,
-                                               yield, nullptr);
-          if (ret_of_get_topic < 0) {
-            // we can't migrate entries without topic info
-            ldpp_dout(this, 1) << "ERROR: failed to fetch topic: " << queue_name << " error: "
-              << ret_of_get_topic << ". Aborting migration!" << dendl;
-            return;
-          }
-
-          for (auto entry: entries_to_migrate) {
-            event_entry_t event_entry;
-            auto iter = entry.data.cbegin();
-            try {
-              decode(event_entry, iter);
-            } catch (buffer::error& err) {
-              ldpp_dout(this, 5) << "WARNING: failed to decode entry. error: " << err.what() << dendl;
-              continue;
-            }
-            size_to_migrate += entry.data.length();
-            event_entry.creation_time = ceph::coarse_real_clock::now();
-            event_entry.time_to_live = topic.dest.time_to_live;
-            event_entry.max_retries = topic.dest.max_retries;
-            event_entry.retry_sleep_duration = topic.dest.retry_sleep_duration;
-
-            bufferlist bl;
-            encode(event_entry, bl);
-            migration_vector.push_back(bl);
-          }
-
-          cls_2pc_reservation::id_t reservation_id;
-          buffer::list obl;
-          int rval;
-          op = librados::ObjectWriteOperation();
-          cls_2pc_queue_reserve(op, size_to_migrate, migration_vector.size(), &obl, &rval);
-          ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), yield, librados::OPERATION_RETURNVEC);
-          if (ret < 0) {
-            ldpp_dout(this, 1) << "ERROR: failed to reserve migration space on queue: " << queue_name << ". error: " << ret << dendl;
-            return;
-          }
-          ret = cls_2pc_queue_reserve_result(obl, reservation_id);
-          if (ret < 0) {
-            ldpp_dout(this, 1) << "ERROR: failed to parse reservation id for migration. error: " << ret << dendl;
-            return;
-          }
-
-          op = librados::ObjectWriteOperation();
-          cls_2pc_queue_commit(op, migration_vector, reservation_id);
-          ret = rgw_rados_operate(this, rados_ioctx, queue_name, std::move(op), yield);
-          reservation_id = cls_2pc_reservation::NO_ID;
-          if (ret < 0) {
-            ldpp_dout(this, 1) << "ERROR: failed to commit reservation to queue: " << queue_name << ". error: " << ret << dendl;
-          }
-        }
+        start_marker = end_marker;
+        tokens_waiter::token token(&removal_waiter);
+        boost::asio::spawn(yield, std::allocator_arg, make_stack_allocator(),
+          [this, &queue_name, &removal_ret, end_marker, entries_to_remove = index,
+           entries_to_migrate = std::move(entries_to_migrate),
+           token = std::move(token)](boost::asio::yield_context yield) mutable {
+            removal_ret = remove_queue_entries(queue_name, end_marker, entries_to_remove,
+                                               std::move(entries_to_migrate), yield);
+        }, [] (std::exception_ptr eptr) {
+          if (eptr) std::rethrow_exception(eptr);
+        });
       }
 
       // updating perfcounters with topic stats
@@ -660,6 +709,7 @@ private:
         queue_counters_container.set(l_rgw_persistent_topic_size, entries_size);
       }
     }
+    removal_waiter.async_wait(yield);
     ldpp_dout(this, 5) << "INFO: manager stopped. done processing for queue: " << queue_name << dendl;
   }
 
@@ -285,11 +285,40 @@ int ManifestObjectProcessor::next(uint64_t offset, uint64_t *pstripe_size)
 
 
 
+uint64_t inline_small_object_size(uint64_t configured_size, bool same_pool,
+                                  uint64_t head_max_size,
+                                  uint64_t max_head_chunk_size)
+{
+  if (!same_pool || head_max_size > 0) {
+    return 0;
+  }
+  return std::min(configured_size, max_head_chunk_size);
+}
+
 int AtomicObjectProcessor::process_first_chunk(bufferlist&& data,
                                                DataProcessor **processor)
 {
-  first_chunk = std::move(data);
   *processor = &stripe;
+  if (small_object_max_size == 0) {
+    first_chunk = std::move(data);
+    return 0;
+  }
+  if (data.length() > small_object_max_size) {
+    // too big to inline after all, so the head stays empty
+    return stripe.process(std::move(data), 0);
+  }
+  // this is the whole object. restart the manifest with a head that holds it
+  manifest.set_trivial_rule(data.length(), stripe_size);
+  int r = manifest_gen.create_begin(store->ctx(), &manifest,
+                                    bucket_info.placement_rule,
+                                    &tail_placement_rule,
+                                    head_obj.bucket, head_obj);
+  if (r < 0) {
+    return r;
+  }
+  ldpp_dout(dpp, 20) << "inlining small object of size " << data.length()
+      << " in the head" << dendl;
+  first_chunk = std::move(data);
   return 0;
 }
 
@@ -339,7 +368,6 @@ int AtomicObjectProcessor::prepare(optional_yield y)
     chunk_size = max_head_chunk_size;
   }
 
-  uint64_t stripe_size;
   const uint64_t default_stripe_size = store->ctx()->_conf->rgw_obj_stripe_size;
 
   store->get_max_aligned_size(default_stripe_size, alignment, &stripe_size);
@@ -361,7 +389,16 @@ int AtomicObjectProcessor::prepare(optional_yield y)
     return r;
   }
 
-  set_head_chunk_size(head_max_size);
+  small_object_max_size = inline_small_object_size(
+      store->ctx()->_conf.get_val<Option::size_t>("rgw_inline_small_object_max_size"),
+      same_pool, head_max_size, max_head_chunk_size);
+  if (small_object_max_size > 0) {
+    // buffer one byte past the limit, so process_first_chunk() sees either
+    // the whole object or enough to know that it doesn't fit
+    set_head_chunk_size(small_object_max_size + 1);
+  } else {
+    set_head_chunk_size(head_max_size);
+  }
   // initialize the processors
   chunk = ChunkProcessor(&writer, chunk_size);
   stripe = StripeProcessor(&chunk, this, head_max_size);
@@ -165,12 +165,22 @@ class ManifestObjectProcessor : public HeadObjectProcessor,
 };
 
 
+// the size up to which AtomicObjectProcessor stores a whole object in its head
+// when the placement keeps no data there. only placements whose tail pool is
+// the head pool qualify, so data never leaves the pool of its storage class
+uint64_t inline_small_object_size(uint64_t configured_size, bool same_pool,
+                                  uint64_t head_max_size,
+                                  uint64_t max_head_chunk_size);
+
 // a processor that completes with an atomic write to the head object as part of
 // a bucket index transaction
 class AtomicObjectProcessor : public ManifestObjectProcessor {
   const std::optional<uint64_t> olh_epoch;
   const std::string unique_tag;
   bufferlist first_chunk; // written with the head in complete()
+  // when data isn't otherwise inlined, objects up to this size still are
+  uint64_t small_object_max_size = 0;
+  uint64_t stripe_size = 0;
 
   int process_first_chunk(bufferlist&& data, rgw::sal::DataProcessor **processor) override;
  public:
@@ -10,6 +10,7 @@
 #include <boost/algorithm/string.hpp>
 #include <string_view>
 
+#include <boost/asio/post.hpp>
 #include <boost/container/flat_set.hpp>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
@@ -25,6 +26,7 @@
 #include "common/async/blocked_completion.h"
 
 #include "rgw_asio_thread.h"
+#include "rgw_readahead.h"
 #include "rgw_cksum.h"
 #include "rgw_sal.h"
 #include "rgw_zone.h"
@@ -41,6 +43,7 @@
 #include "rgw_lc_tier.h"
 #include "rgw_restore.h"
 
+#include "cls/lock/cls_lock_client.h"
 #include "cls/rgw/cls_rgw_ops.h"
 #include "cls/rgw/cls_rgw_client.h"
 #include "cls/rgw/cls_rgw_const.h"
@@ -473,6 +476,48 @@ int RGWDataNotifier::process(const DoutPrefixProvider *dpp)
   return 0;
 }
 
+/*
+ * Rolls the hourly usage records older than rgw_usage_log_rollup_age up into
+ * daily ones. Each usage shard is rolled up by one gateway at a time under a
+ * lease, from the cursor saved on the shard by the previous pass.
+ */
+class RGWUsageRollupThread : public RGWRadosThread {
+  static constexpr uint32_t period = 24 * 60 * 60;
+  /* saves a shard pass per hour; the shards keep their own cursors */
+  uint64_t last_end = 0;
+
+  uint64_t interval_msec() override {
+    return 60 * 60 * 1000;
+  }
+public:
+  RGWUsageRollupThread(RGWRados *_driver) : RGWRadosThread(_driver, "usage-rollup") {}
+
+  int process(const DoutPrefixProvider *dpp) override;
+};
+
+int RGWUsageRollupThread::process(const DoutPrefixProvider *dpp)
+{
+  const uint64_t age = cct->_conf.get_val<std::chrono::seconds>("rgw_usage_log_rollup_age").count();
+  const uint64_t now = ceph_clock_now().sec();
+  if (age == 0 || now <= age) {
+    return 0;
+  }
+  uint64_t end = now - age;
+  end -= end % period;
+  if (end <= last_end) {
+    return 0;
+  }
+
+  ldpp_dout(dpp, 10) << "usage rollup up to " << end << dendl;
+  int r = store->rollup_usage(dpp, 0, end, period, null_yield);
+  if (r < 0) {
+    /* retried from the shard cursors on the next pass */
+    return r;
+  }
+  last_end = end;
+  return 0;
+}
+
 class RGWSyncProcessorThread : public RGWRadosThread {
 public:
   RGWSyncProcessorThread(RGWRados *_driver, const string& thread_name = "radosgw") : RGWRadosThread(_driver, thread_name) {}
@@ -1108,10 +1153,17 @@ void RGWRados::finalize()
     data_notifier->stop();
     delete data_notifier;
   }
+  if (usage_rollup_thread) {
+    usage_rollup_thread->stop();
+    delete usage_rollup_thread;
+    usage_rollup_thread = nullptr;
+  }
   delete sync_tracer;
   
   delete lc;
   lc = NULL; 
+  // after the lifecycle workers waiting for uploads are gone
+  lc_cloud_tier_uploads.stop();
 
   delete gc;
   gc = NULL;
@@ -1154,6 +1206,12 @@ void RGWRados::finalize()
   restore = NULL;
 }
 
+boost::asio::io_context& RGWRados::get_lc_cloud_tier_context()
+{
+  lc_cloud_tier_uploads.start(cct->_conf.get_val<uint64_t>("rgw_lc_cloud_tier_upload_threads"));
+  return lc_cloud_tier_uploads;
+}
+
 /** 
  * Initialize the RADOS instance and prepare to do other ops
  * Returns 0 on success, -ERR# on failure.
@@ -1238,6 +1296,10 @@ int RGWRados::init_complete(const DoutPrefixProvider *dpp, optional_yield y, rgw
 {
   int ret;
 
+  if (cct->_conf.get_val<Option::size_t>("rgw_get_obj_readahead_size") > 0) {
+    readahead = std::make_shared<rgw::rados::ReadAhead>(cct);
+  }
+
   /*
    * create sync module instance even if we don't run sync thread, might need it for radosgw-admin
    */
@@ -1374,6 +1436,12 @@ int RGWRados::init_complete(const DoutPrefixProvider *dpp, optional_yield y, rgw
     data_notifier->start();
   }
 
+  if (use_gc_thread && cct->_conf->rgw_enable_usage_log &&
+      cct->_conf.get_val<std::chrono::seconds>("rgw_usage_log_rollup_age").count() > 0) {
+    usage_rollup_thread = new RGWUsageRollupThread(this);
+    usage_rollup_thread->start();
+  }
+
   binfo_cache = new RGWChainedCacheImpl<bucket_info_entry>;
   binfo_cache->init(svc.cache);
 
@@ -1839,6 +1907,113 @@ int RGWRados::clear_usage(const DoutPrefixProvider *dpp, optional_yield y)
   return ret;
 }
 
+static constexpr const char* usage_rollup_lock_name = "usage_rollup";
+static constexpr const char* usage_rollup_cursor_attr = "rgw.usage.rollup";
+
+int RGWRados::rollup_usage(const DoutPrefixProvider *dpp, uint64_t start_epoch, uint64_t end_epoch, uint32_t period, optional_yield y)
+{
+  auto max_shards = cct->_conf->rgw_usage_max_shards;
+  for (unsigned i = 0; i < max_shards; i++) {
+    string oid = RGW_USAGE_OBJ_PREFIX + to_string(i);
+    int ret = rollup_usage_shard(dpp, oid, start_epoch, end_epoch, period, y);
+    if (ret < 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
+int RGWRados::rollup_usage_shard(const DoutPrefixProvider *dpp, const string& oid,
+                                 uint64_t start_epoch, uint64_t end_epoch,
+                                 uint32_t period, optional_yield y)
+{
+  rgw_rados_ref ref;
+  int ret = get_raw_obj_ref(dpp, rgw_raw_obj(svc.zone->get_zone_params().usage_log_pool, oid), &ref);
+  if (ret < 0) {
+    return ret;
+  }
+
+  /* everything before the cursor was rolled up by an earlier pass */
+  bufferlist cursor_bl;
+  ret = ref.ioctx.getxattr(oid, usage_rollup_cursor_attr, cursor_bl);
+  if (ret == -ENOENT) {
+    return 0;
+  }
+  if (ret > 0) {
+    try {
+      uint64_t cursor;
+      auto p = cursor_bl.cbegin();
+      decode(cursor, p);
+      start_epoch = std::max(start_epoch, cursor);
+    } catch (const buffer::error&) {
+      ldpp_dout(dpp, 0) << "WARNING: usage rollup ignores a bad cursor on oid="
+          << oid << dendl;
+    }
+  }
+  if (start_epoch >= end_epoch) {
+    return 0;
+  }
+
+  /* start from the oldest record of the shard, so that the first pass over
+   * a long history does not walk through every empty period before it */
+  string read_iter;
+  map<rgw_user_bucket, rgw_usage_log_entry> usage;
+  bool truncated = false;
+  ret = cls_obj_usage_log_read(dpp, oid, "", "", start_epoch, end_epoch, 1,
+                               read_iter, usage, &truncated);
+  if (ret == -ENOENT) {
+    return 0;
+  }
+  if (ret < 0) {
+    ldpp_dout(dpp, 0) << "ERROR: usage rollup failed to read oid=" << oid
+        << " ret=" << ret << dendl;
+    return ret;
+  }
+
+  rados::cls::lock::Lock l(usage_rollup_lock_name);
+  l.set_duration(utime_t(60 * 60, 0));
+  ret = l.lock_exclusive(&ref.ioctx, oid);
+  if (ret == -EBUSY) { /* another gateway is rolling this shard up */
+    ldpp_dout(dpp, 10) << "usage rollup failed to acquire lock on " << oid << dendl;
+    return 0;
+  }
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (!usage.empty()) {
+    uint64_t epoch = std::max(start_epoch, usage.begin()->second.epoch);
+    epoch -= epoch % period;
+
+    for (; epoch < end_epoch; epoch += period) {
+      /* the record at the start of the period is the rolled up one, leave it
+       * out of the range so that it does not get listed over and over */
+      ret = cls_obj_usage_log_rollup(dpp, oid, epoch + 1,
+                                     std::min<uint64_t>(epoch + period, end_epoch),
+                                     period, y);
+      if (ret < 0 && ret != -ENOENT) {
+        ldpp_dout(dpp, 0) << "ERROR: usage rollup on oid=" << oid
+            << " failed with ret=" << ret << dendl;
+        l.unlock(&ref.ioctx, oid);
+        return ret;
+      }
+    }
+  }
+
+  librados::ObjectWriteOperation op;
+  l.assert_locked_exclusive(&op);
+  bufferlist bl;
+  encode(end_epoch, bl);
+  op.setxattr(usage_rollup_cursor_attr, bl);
+  ret = rgw_rados_operate(dpp, ref.ioctx, oid, std::move(op), y);
+  if (ret < 0) {
+    ldpp_dout(dpp, 0) << "ERROR: usage rollup failed to save the cursor of oid="
+        << oid << " ret=" << ret << dendl;
+  }
+  l.unlock(&ref.ioctx, oid);
+  return ret;
+}
+
 int RGWRados::decode_policy(const DoutPrefixProvider *dpp,
 			    ceph::buffer::list& bl,
 			    ACLOwner *owner)
@@ -4457,7 +4632,8 @@ int RGWRados::fetch_remote_obj(RGWObjectCtx& dest_obj_ctx,
                std::optional<rgw_zone_set_entry> source_trace_entry,
                rgw_zone_set *zones_trace,
                std::optional<uint64_t>* bytes_transferred,
-               bool keep_tags)
+               bool keep_tags,
+               const rgw_sync_obj_batch_entry* prefetched)
 {
   /* source is in a different zonegroup, copy from there */
 
@@ -4610,27 +4786,58 @@ int RGWRados::fetch_remote_obj(RGWObjectCtx& dest_obj_ctx,
   static constexpr bool sync_cloudtiered = true;
 
   static constexpr int NUM_ENPOINT_IOERROR_RETRIES = 20;
-  for (int tries = 0; tries < NUM_ENPOINT_IOERROR_RETRIES; tries++) {
-    ret = conn->get_obj(rctx.dpp, user_id, perm_check_uid, info, src_obj, pmod, unmod_ptr,
-                        dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver, prepend_meta, get_op, rgwx_stat,
-                        sync_manifest, skip_decrypt, &dst_zone_trace,
-                        sync_cloudtiered, true,
-                        &cb, &in_stream_req);
+  if (prefetched) {
+    // the object was already read by a batched fetch from the source
+    // zone. apply the If-Modified-Since check that the source would
+    // have done, then feed the response body through the callback
+    if (pmod) {
+      obj_time_weight src_weight;
+      src_weight.init(prefetched->cond_mtime, 0, 0);
+      src_weight.high_precision = true;
+      obj_time_weight dest_weight;
+      dest_weight.init(*pmod, 0, 0);
+      dest_weight.high_precision = true;
+      if (!(dest_weight < src_weight)) {
+        ldpp_dout(rctx.dpp, 20) << "prefetched " << fetched_obj
+            << " is not newer than the destination" << dendl;
+        ret = -ERR_NOT_MODIFIED;
+        goto set_err_state;
+      }
+    }
+    bufferlist bl = prefetched->metadata;
+    bl.append(prefetched->data);
+    cb.set_extra_data_len(prefetched->metadata.length());
+    bool pause = false;
+    ret = cb.handle_data(bl, &pause);
     if (ret < 0) {
       goto set_err_state;
     }
+    etag = prefetched->etag;
+    set_mtime = prefetched->mtime;
+    accounted_size = prefetched->size;
+  } else {
+    for (int tries = 0; tries < NUM_ENPOINT_IOERROR_RETRIES; tries++) {
+      ret = conn->get_obj(rctx.dpp, user_id, perm_check_uid, info, src_obj, pmod, unmod_ptr,
+                          dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver, prepend_meta, get_op, rgwx_stat,
+                          sync_manifest, skip_decrypt, &dst_zone_trace,
+                          sync_cloudtiered, true,
+                          &cb, &in_stream_req);
+      if (ret < 0) {
+        goto set_err_state;
+      }
 
-    ret = conn->complete_request(rctx.dpp, in_stream_req, &etag, &set_mtime,
-                                 &accounted_size, nullptr, nullptr, rctx.y);
-    if (ret < 0) {
-      if (ret == -ERR_INTERNAL_ERROR && tries < NUM_ENPOINT_IOERROR_RETRIES - 1) {
-        ldpp_dout(rctx.dpp, 20) << __func__ << "(): failed to fetch " << fetched_obj
-                                << " from remote. retries=" << tries << dendl;
-        continue;
+      ret = conn->complete_request(rctx.dpp, in_stream_req, &etag, &set_mtime,
+                                   &accounted_size, nullptr, nullptr, rctx.y);
+      if (ret < 0) {
+        if (ret == -ERR_INTERNAL_ERROR && tries < NUM_ENPOINT_IOERROR_RETRIES - 1) {
+          ldpp_dout(rctx.dpp, 20) << __func__ << "(): failed to fetch " << fetched_obj
+                                  << " from remote. retries=" << tries << dendl;
+          continue;
+        }
+        goto set_err_state;
       }
-      goto set_err_state;
+      break;
     }
-    break;
   }
   ret = cb.flush();
   if (ret < 0) {
@@ -5189,7 +5396,7 @@ int RGWRados::copy_obj(RGWObjectCtx& src_obj_ctx,
   std::unique_ptr<rgw::Aio> aio;
   rgw::AioResultList all_results;
   if (!copy_itself) {
-    aio = rgw::make_throttle(cct->_conf->rgw_max_copy_obj_concurrent_io, y);
+    aio = rgw::make_throttle(cct->_conf->rgw_max_copy_obj_concurrent_io, y, dpp);
     attrs.erase(RGW_ATTR_TAIL_TAG);
     manifest = *amanifest;
     const rgw_bucket_placement& tail_placement = manifest.get_tail_placement();
@@ -5331,7 +5538,7 @@ int RGWRados::copy_obj_data(RGWObjectCtx& obj_ctx,
   string tag;
   append_rand_alpha(cct, tag, tag, 32);
 
-  auto aio = rgw::make_throttle(cct->_conf->rgw_put_obj_min_window_size, y);
+  auto aio = rgw::make_throttle(cct->_conf->rgw_put_obj_min_window_size, y, dpp);
   using namespace rgw::putobj;
   jspan_context no_trace{false, false};
   AtomicObjectProcessor processor(aio.get(), this, dest_bucket_info,
@@ -5484,7 +5691,7 @@ int RGWRados::restore_obj_from_cloud(RGWLCCloudTierCtx& tier_ctx,
   bufferlist t, t_tier;
   string tag;
   append_rand_alpha(cct, tag, tag, 32);
-  auto aio = rgw::make_throttle(cct->_conf->rgw_put_obj_min_window_size, y);
+  auto aio = rgw::make_throttle(cct->_conf->rgw_put_obj_min_window_size, y, dpp);
   using namespace rgw::putobj;
   jspan_context no_trace{false, false};
 
@@ -5777,7 +5984,7 @@ int RGWRados::store_delete_bucket_info_flag(RGWBucketInfo& bucket_info, std::map
     for (int i = 0; i < shards_num; ++i) {
       ldpp_dout(dpp, 10) << "adding to data_log shard_id: " << i << " of gen:" << index_log.gen << dendl;
       int ret = svc.datalog_rados->add_entry(dpp, bucket_info, index_log, i,
-                                                  null_yield);
+                                                  y);
       if (ret < 0) {
         ldpp_dout(dpp, 1) << "WARNING: failed writing data log for bucket="
         << bucket_info.bucket << ", shard_id=" << i << "of generation="
@@ -5947,7 +6154,7 @@ int RGWRados::delete_bucket(RGWBucketInfo& bucket_info, std::map<std::string, bu
     RGWBucketEntryPoint ep;
     r = ctl.bucket->read_bucket_entrypoint_info(bucket_info.bucket,
                                                 &ep,
-						null_yield,
+						y,
                                                 dpp,
                                                 RGWBucketCtl::Bucket::GetParams()
                                                 .set_objv_tracker(&objv_tracker));
@@ -6147,7 +6354,7 @@ void RGWRados::delete_objs_inline(const DoutPrefixProvider *dpp, cls_rgw_obj_cha
   ioctx.set_pool_full_try();  // allow deletion at pool quota limit
 
   // issue deletions in parallel, up to max_aio at a time
-  auto aio = rgw::make_throttle(cct->_conf->rgw_multi_obj_del_max_aio, y);
+  auto aio = rgw::make_throttle(cct->_conf->rgw_multi_obj_del_max_aio, y, dpp);
   static constexpr uint64_t cost = 1; // 1 throttle unit per request
   static constexpr uint64_t id = 0; // ids unused
 
@@ -7142,6 +7349,7 @@ int RGWRados::Object::Stat::wait(const DoutPrefixProvider *dpp)
     return state.ret;
   }
 
+  maybe_warn_about_blocking(dpp);
   state.completion->wait_for_complete();
   state.ret = state.completion->get_return_value();
   state.completion->release();
@@ -8242,6 +8450,55 @@ static int _get_obj_iterate_cb(const DoutPrefixProvider *dpp,
                                       is_head_obj, astate, arg);
 }
 
+// read a tail object through read-ahead: take prefetched data, wait for a
+// prefetch in flight, or read from rados when neither covers the range
+static rgw::Aio::OpFunc readahead_op(std::shared_ptr<rgw::rados::ReadAhead> readahead,
+                                     librados::IoCtx ioctx, rgw_raw_obj obj,
+                                     uint64_t ofs, uint64_t len, optional_yield y)
+{
+  return [readahead = std::move(readahead), ioctx = std::move(ioctx),
+          obj = std::move(obj), ofs, len, y] (rgw::Aio* aio, rgw::AioResult& r) mutable {
+    auto read = [ioctx, ofs, len, y] (rgw::Aio* aio, rgw::AioResult& r) {
+      librados::ObjectReadOperation op;
+      op.read(ofs, len, nullptr, nullptr);
+      auto f = rgw::Aio::librados_op(ioctx, std::move(op), y);
+      std::move(f)(aio, r);
+    };
+    auto on_fetch = [aio, &r, read, y] (int ret, bufferlist&& bl) {
+      auto complete = [aio, &r, read, ret, bl = std::move(bl)] () mutable {
+        if (ret < 0) {
+          // the prefetch failed, so read the range ourselves
+          read(aio, r);
+          return;
+        }
+        r.data = std::move(bl);
+        r.result = 0;
+        aio->put(r);
+      };
+      if (y) {
+        // complete on the request's strand, like the librados completions
+        boost::asio::post(y.get_yield_context().get_executor(), std::move(complete));
+      } else {
+        complete();
+      }
+    };
+
+    bufferlist bl;
+    switch (readahead->lookup(obj, ofs, len, bl, std::move(on_fetch))) {
+    case rgw::rados::ReadAhead::Lookup::hit:
+      r.data = std::move(bl);
+      r.result = 0;
+      aio->put(r);
+      break;
+    case rgw::rados::ReadAhead::Lookup::pending:
+      break;
+    case rgw::rados::ReadAhead::Lookup::miss:
+      read(aio, r);
+      break;
+    }
+  };
+}
+
 int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
                                  const rgw_raw_obj& read_obj, off_t obj_ofs,
                                  off_t read_ofs, off_t len, bool is_head_obj,
@@ -8276,6 +8533,9 @@ int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
     }
   }
 
+  const uint64_t cost = len;
+  const uint64_t id = obj_ofs; // use logical object offset for sorting replies
+
   rgw_rados_ref obj;
   int r = rgw_get_rados_ref(dpp, d->rgwrados->get_rados_handle(), read_obj,
 			    &obj);
@@ -8285,16 +8545,79 @@ int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
   }
 
   ldpp_dout(dpp, 20) << "rados->get_obj_iterate_cb oid=" << read_obj.oid << " obj-ofs=" << obj_ofs << " read_ofs=" << read_ofs << " len=" << len << dendl;
-  op.read(read_ofs, len, nullptr, nullptr);
 
-  const uint64_t cost = len;
-  const uint64_t id = obj_ofs; // use logical object offset for sorting replies
+  if (!is_head_obj && readahead) {
+    auto completed = d->aio->get(obj.obj,
+        readahead_op(readahead, obj.ioctx, read_obj, read_ofs, len, d->yield),
+        cost, id);
+    return d->flush(std::move(completed));
+  }
+
+  op.read(read_ofs, len, nullptr, nullptr);
 
   auto completed = d->aio->get(obj.obj, rgw::Aio::librados_op(obj.ioctx, std::move(op), d->yield), cost, id);
 
   return d->flush(std::move(completed));
 }
 
+struct readahead_read {
+  std::shared_ptr<rgw::rados::ReadAhead> readahead;
+  librados::IoCtx ioctx;
+  rgw_raw_obj obj;
+  uint64_t ofs = 0;
+  bufferlist bl;
+};
+
+static void readahead_complete(rados_completion_t completion, void* arg)
+{
+  std::unique_ptr<readahead_read> rd{static_cast<readahead_read*>(arg)};
+  rd->readahead->finish_fetch(rd->obj, rd->ofs,
+                              rados_aio_get_return_value(completion),
+                              std::move(rd->bl));
+}
+
+// issue a read whose data is kept for a later request. head objects can be
+// overwritten in place, so only tail reads are prefetched
+static int _readahead_cb(const DoutPrefixProvider *dpp,
+                         const rgw_raw_obj& read_obj, off_t obj_ofs,
+                         off_t read_ofs, off_t len, bool is_head_obj,
+                         RGWObjState *astate, void *arg)
+{
+  if (is_head_obj) {
+    return 0;
+  }
+  RGWRados* store = static_cast<RGWRados*>(arg);
+
+  rgw_rados_ref ref;
+  int r = rgw_get_rados_ref(dpp, store->get_rados_handle(), read_obj, &ref);
+  if (r < 0) {
+    return r;
+  }
+  // reads of this range find the reservation and wait for it
+  if (!store->readahead->start_fetch(read_obj, read_ofs, len)) {
+    return 0;
+  }
+
+  auto rd = std::make_unique<readahead_read>();
+  rd->readahead = store->readahead;
+  rd->ioctx = ref.ioctx;
+  rd->obj = read_obj;
+  rd->ofs = read_ofs;
+
+  ldpp_dout(dpp, 20) << "prefetching oid=" << read_obj.oid << " obj-ofs=" << obj_ofs << " read_ofs=" << read_ofs << " len=" << len << dendl;
+  librados::ObjectReadOperation op;
+  op.read(read_ofs, len, &rd->bl, nullptr);
+  aio_completion_ptr completion{librados::Rados::aio_create_completion(rd.get(), readahead_complete)};
+  r = rd->ioctx.aio_operate(ref.obj.oid, completion.get(), &op, nullptr);
+  if (r < 0) {
+    store->readahead->finish_fetch(read_obj, read_ofs, r, {});
+    return r;
+  }
+  // released inside the callback
+  rd.release();
+  return 0;
+}
+
 int RGWRados::Object::Read::iterate(const DoutPrefixProvider *dpp, int64_t ofs, int64_t end, RGWGetDataCB *cb,
                                     optional_yield y)
 {
@@ -8303,7 +8626,7 @@ int RGWRados::Object::Read::iterate(const DoutPrefixProvider *dpp, int64_t ofs,
   const uint64_t chunk_size = cct->_conf->rgw_get_obj_max_req_size;
   const uint64_t window_size = cct->_conf->rgw_get_obj_window_size;
 
-  auto aio = rgw::make_throttle(window_size, y);
+  auto aio = rgw::make_throttle(window_size, y, dpp);
   get_obj_data data(store, cb, &*aio, ofs, y);
 
   if (state.obj.empty()) {
@@ -8318,9 +8641,42 @@ int RGWRados::Object::Read::iterate(const DoutPrefixProvider *dpp, int64_t ofs,
     return r;
   }
 
+  // prefetch while this request's reads are in flight, so the next request
+  // finds the data or waits on it rather than reading it again
+  if (store->readahead && !store->get_use_datacache()) {
+    prefetch(dpp, ofs, end, chunk_size, y);
+  }
+
   return data.drain();
 }
 
+void RGWRados::Object::Read::prefetch(const DoutPrefixProvider *dpp,
+                                      int64_t ofs, int64_t end,
+                                      uint64_t chunk_size, optional_yield y)
+{
+  RGWRados *store = source->get_store();
+  RGWObjState *astate = nullptr;
+  RGWObjManifest *manifest = nullptr;
+  int r = store->get_obj_state(dpp, &source->get_ctx(), source->get_bucket_info(),
+                               state.obj, &astate, &manifest, false, y);
+  if (r < 0 || !manifest || !manifest->has_tail()) {
+    return;
+  }
+
+  auto range = store->readahead->note_read(state.head_obj, ofs, end, astate->size);
+  if (!range) {
+    return;
+  }
+  ldpp_dout(dpp, 20) << "sequential read of " << state.obj << ", reading ahead "
+      << range->first << "-" << range->second << dendl;
+  // failures only cost the next request a cache miss
+  r = store->iterate_obj(dpp, source->get_ctx(), source->get_bucket_info(), state.obj,
+                         range->first, range->second, chunk_size, _readahead_cb, store, y);
+  if (r < 0) {
+    ldpp_dout(dpp, 5) << "read-ahead failed with " << r << dendl;
+  }
+}
+
 int RGWRados::iterate_obj(const DoutPrefixProvider *dpp, RGWObjectCtx& obj_ctx,
                           RGWBucketInfo& bucket_info, const rgw_obj& obj,
                           off_t ofs, off_t end, uint64_t max_chunk_size,
@@ -8883,7 +9239,8 @@ int RGWRados::bucket_index_link_olh(const DoutPrefixProvider *dpp, RGWBucketInfo
                                     uint64_t olh_epoch,
                                     real_time unmod_since, bool high_precision_time,
 				    optional_yield y,
-                                    rgw_zone_set *_zones_trace, bool log_data_change)
+                                    rgw_zone_set *_zones_trace, bool log_data_change,
+                                    rgw_cls_link_olh_ret *link_ret)
 {
   rgw_rados_ref ref;
   int r = get_obj_head_ref(dpp, bucket_info, obj_instance, &ref);
@@ -8906,11 +9263,20 @@ int RGWRados::bucket_index_link_olh(const DoutPrefixProvider *dpp, RGWBucketInfo
 		      librados::ObjectWriteOperation op;
 		      op.assert_exists(); // bucket index shard must exist
 		      cls_rgw_guard_bucket_resharding(op, -ERR_BUSY_RESHARDING);
+		      bufferlist reply;
 		      cls_rgw_bucket_link_olh(op, key, olh_state.olh_tag,
                                               delete_marker, op_tag, meta, olh_epoch,
 					      unmod_since, high_precision_time,
-					      log_data_change, zones_trace);
-                      return rgw_rados_operate(dpp, ref.ioctx, ref.obj.oid, std::move(op), y);
+					      log_data_change, zones_trace,
+					      link_ret ? &reply : nullptr);
+                      int r = rgw_rados_operate(dpp, ref.ioctx, ref.obj.oid, std::move(op), y,
+                                                link_ret ? librados::OPERATION_RETURNVEC : 0);
+                      if (r >= 0 && link_ret &&
+                          cls_rgw_bucket_link_olh_result(reply, *link_ret) < 0) {
+                        // older osds don't reply; the caller reads the log instead
+                        *link_ret = rgw_cls_link_olh_ret{};
+                      }
+                      return r;
                     }, y);
   if (r < 0) {
     ldpp_dout(dpp, 20) << "rgw_rados_operate() after cls_rgw_bucket_link_olh() returned r=" << r << dendl;
@@ -9398,16 +9764,25 @@ int RGWRados::update_olh(const DoutPrefixProvider* dpp,
 			 rgw_zone_set* zones_trace,
 			 bool null_verid,
 			 bool log_op,
-			 const bool force)
+			 const bool force,
+			 const map<uint64_t, vector<rgw_bucket_olh_log_entry> > *known_log)
 {
   map<uint64_t, vector<rgw_bucket_olh_log_entry> > log;
   bool is_truncated;
   uint64_t ver_marker = 0;
 
   do {
-    int ret = bucket_index_read_olh_log(dpp, bucket_info, *state, obj, ver_marker, &log, &is_truncated, y);
-    if (ret < 0) {
-      return ret;
+    int ret = 0;
+    if (known_log) {
+      // the link that just completed reported the entire log
+      log = *known_log;
+      is_truncated = false;
+      known_log = nullptr;
+    } else {
+      ret = bucket_index_read_olh_log(dpp, bucket_info, *state, obj, ver_marker, &log, &is_truncated, y);
+      if (ret < 0) {
+        return ret;
+      }
     }
     ret = apply_olh_log(dpp, obj_ctx, *state, bucket_info, obj,
 			state->olh_tag, log, &ver_marker, y,
@@ -9435,6 +9810,7 @@ int RGWRados::set_olh(const DoutPrefixProvider *dpp, RGWObjectCtx& obj_ctx,
 
   RGWObjState *state = NULL;
   RGWObjManifest *manifest = nullptr;
+  rgw_cls_link_olh_ret link_ret;
 
   int ret = 0;
   int i;
@@ -9464,7 +9840,8 @@ int RGWRados::set_olh(const DoutPrefixProvider *dpp, RGWObjectCtx& obj_ctx,
     } else {
       ret = bucket_index_link_olh(dpp, bucket_info, *state, target_obj,
 		                              delete_marker, op_tag, meta, olh_epoch, unmod_since,
-		                              high_precision_time, y, zones_trace, log_data_change);
+		                              high_precision_time, y, zones_trace, log_data_change,
+		                              &link_ret);
     }
     if (ret < 0) {
       ldpp_dout(dpp, 20) << "bucket_index_link_olh() target_obj=" << target_obj << " delete_marker=" << (int)delete_marker << " returned " << ret << dendl;
@@ -9503,7 +9880,29 @@ int RGWRados::set_olh(const DoutPrefixProvider *dpp, RGWObjectCtx& obj_ctx,
     return 0;
   }
 
-  ret = update_olh(dpp, obj_ctx, state, bucket_info, olh_obj, y, zones_trace, log_data_change);
+  if (link_ret.own_log) {
+    // nobody else has pending olh changes, so the log holds exactly what
+    // the link added and doesn't have to be read back
+    cls_rgw_obj_key key(target_obj.key.get_index_key_name(), target_obj.key.instance);
+    map<uint64_t, vector<rgw_bucket_olh_log_entry> > log;
+    auto& entries = log[link_ret.olh_epoch];
+    rgw_bucket_olh_log_entry entry;
+    entry.epoch = link_ret.olh_epoch;
+    entry.op = CLS_RGW_OLH_OP_LINK_OLH;
+    entry.op_tag = op_tag;
+    entry.key = key;
+    entry.delete_marker = delete_marker;
+    entries.push_back(entry);
+    if (link_ret.removing) {
+      entry.op = CLS_RGW_OLH_OP_REMOVE_INSTANCE;
+      entry.delete_marker = false;
+      entries.push_back(std::move(entry));
+    }
+    ret = update_olh(dpp, obj_ctx, state, bucket_info, olh_obj, y, zones_trace,
+                     log_data_change, true, false, &log);
+  } else {
+    ret = update_olh(dpp, obj_ctx, state, bucket_info, olh_obj, y, zones_trace, log_data_change);
+  }
   if (ret == -ECANCELED) { /* already did what we needed, no need to retry, raced with another user */
     ret = 0;
   }
@@ -11157,6 +11556,35 @@ int RGWRados::cls_obj_usage_log_trim(const DoutPrefixProvider *dpp, const string
   return r;
 }
 
+int RGWRados::cls_obj_usage_log_rollup(const DoutPrefixProvider *dpp, const string& oid, uint64_t start_epoch, uint64_t end_epoch,
+                                       uint32_t period, optional_yield y)
+{
+  rgw_raw_obj obj(svc.zone->get_zone_params().usage_log_pool, oid);
+
+  rgw_rados_ref ref;
+  int r = get_raw_obj_ref(dpp, obj, &ref);
+  if (r < 0) {
+    return r;
+  }
+
+  do {
+    librados::ObjectWriteOperation op;
+    bufferlist reply;
+    cls_rgw_usage_log_rollup(op, start_epoch, end_epoch, period, &reply);
+    r = rgw_rados_operate(dpp, ref.ioctx, ref.obj.oid, std::move(op), y,
+                          librados::OPERATION_RETURNVEC);
+    rgw_cls_usage_log_rollup_ret ret;
+    if (r >= 0 && cls_rgw_usage_log_rollup_result(reply, ret) == 0) {
+      start_epoch = ret.next_epoch;
+    }
+  } while (r >= 0 && start_epoch < end_epoch);
+
+  if (r == -ENODATA) {
+    return 0;
+  }
+  return r;
+}
+
 int RGWRados::cls_obj_usage_log_clear(const DoutPrefixProvider *dpp, string& oid, optional_yield y)
 {
   rgw_raw_obj obj(svc.zone->get_zone_params().usage_log_pool, oid);
@@ -45,6 +45,9 @@
 
 struct D3nDataCache;
 struct RGWLCCloudTierCtx;
+struct rgw_sync_obj_batch_entry;
+struct rgw_cls_link_olh_ret;
+namespace rgw::rados { class ReadAhead; }
 
 class RGWWatcher;
 class ACLOwner;
@@ -56,6 +59,7 @@ class RGWObjectExpirer;
 class RGWMetaSyncProcessorThread;
 class RGWDataSyncProcessorThread;
 class RGWSyncLogTrimThread;
+class RGWUsageRollupThread;
 class RGWSyncTraceManager;
 struct RGWZoneGroup;
 struct RGWZoneParams;
@@ -393,11 +397,14 @@ class RGWRados
 
   boost::optional<rgw::BucketTrimManager> bucket_trim;
   RGWSyncLogTrimThread* sync_log_trimmer{nullptr};
+  RGWUsageRollupThread* usage_rollup_thread{nullptr};
 
   ceph::mutex meta_sync_thread_lock{ceph::make_mutex("meta_sync_thread_lock")};
   ceph::mutex data_sync_thread_lock{ceph::make_mutex("data_sync_thread_lock")};
 
   ceph::async::io_context_pool v1_topic_migration;
+  // uploads of the objects transitioned to cloud tiers
+  ceph::async::io_context_pool lc_cloud_tier_uploads;
 
   librados::IoCtx root_pool_ctx;      // .rgw
 
@@ -503,6 +510,9 @@ public:
     return lc;
   }
 
+  // starts the cloud tier upload threads on first use
+  boost::asio::io_context& get_lc_cloud_tier_context();
+
   RGWGC *get_gc() {
     return gc;
   }
@@ -647,6 +657,8 @@ public:
 		 rgw_usage_log_entry>& usage);
   int trim_usage(const DoutPrefixProvider *dpp, const rgw_user& user, const std::string& bucket_name, uint64_t start_epoch, uint64_t end_epoch, optional_yield y);
   int clear_usage(const DoutPrefixProvider *dpp, optional_yield y);
+  int rollup_usage(const DoutPrefixProvider *dpp, uint64_t start_epoch, uint64_t end_epoch, uint32_t period, optional_yield y);
+  int rollup_usage_shard(const DoutPrefixProvider *dpp, const std::string& oid, uint64_t start_epoch, uint64_t end_epoch, uint32_t period, optional_yield y);
 
   int create_pool(const DoutPrefixProvider *dpp, const rgw_pool& pool);
 
@@ -815,6 +827,9 @@ public:
       static int range_to_ofs(uint64_t obj_size, int64_t &ofs, int64_t &end);
       int read(int64_t ofs, int64_t end, bufferlist& bl, optional_yield y, const DoutPrefixProvider *dpp);
       int iterate(const DoutPrefixProvider *dpp, int64_t ofs, int64_t end, RGWGetDataCB *cb, optional_yield y);
+      // after a read of [ofs, end], prefetch what a sequential reader asks for next
+      void prefetch(const DoutPrefixProvider *dpp, int64_t ofs, int64_t end,
+                    uint64_t chunk_size, optional_yield y);
       int get_attr(const DoutPrefixProvider *dpp, const char *name, bufferlist& dest, optional_yield y);
     }; // struct RGWRados::Object::Read
 
@@ -1152,6 +1167,8 @@ public:
   };
 
   D3nDataCache* d3n_data_cache{nullptr};
+  // shared with the prefetches in flight, which may outlive RGWRados
+  std::shared_ptr<rgw::rados::ReadAhead> readahead;
 
   int rewrite_obj(RGWBucketInfo& dest_bucket_info, const rgw_obj& obj, const DoutPrefixProvider *dpp, optional_yield y);
   int reindex_obj(rgw::sal::Driver* driver,
@@ -1214,7 +1231,8 @@ public:
                        std::optional<rgw_zone_set_entry> source_trace_entry,
                        rgw_zone_set *zones_trace = nullptr,
                        std::optional<uint64_t>* bytes_transferred = 0,
-                       bool keep_tags = true);
+                       bool keep_tags = true,
+                       const rgw_sync_obj_batch_entry* prefetched = nullptr);
   /**
    * Copy an object.
    * dest_obj: the object to copy into
@@ -1424,7 +1442,8 @@ int restore_obj_from_cloud(RGWLCCloudTierCtx& tier_ctx,
                             ceph::real_time unmod_since, bool high_precision_time,
 			    optional_yield y,
                             rgw_zone_set *zones_trace = nullptr,
-                            bool log_data_change = false);
+                            bool log_data_change = false,
+                            rgw_cls_link_olh_ret *link_ret = nullptr);
   int bucket_index_unlink_instance(const DoutPrefixProvider *dpp,
                                    RGWBucketInfo& bucket_info,
                                    const rgw_obj& obj_instance,
@@ -1449,7 +1468,8 @@ int restore_obj_from_cloud(RGWLCCloudTierCtx& tier_ctx,
   int update_olh(const DoutPrefixProvider *dpp, RGWObjectCtx& obj_ctx, RGWObjState *state,
 		 RGWBucketInfo& bucket_info, const rgw_obj& obj, optional_yield y,
 		 rgw_zone_set *zones_trace = nullptr, bool null_verid = false,
-		 bool log_op = true, const bool force = false);
+		 bool log_op = true, const bool force = false,
+		 const std::map<uint64_t, std::vector<rgw_bucket_olh_log_entry> > *known_log = nullptr);
   int clear_olh(const DoutPrefixProvider *dpp,
                 RGWObjectCtx& obj_ctx,
                 const rgw_obj& obj,
@@ -1616,6 +1636,8 @@ public:
   int cls_obj_usage_log_trim(const DoutPrefixProvider *dpp, const std::string& oid, const std::string& user, const std::string& bucket, uint64_t start_epoch,
                              uint64_t end_epoch, optional_yield y);
   int cls_obj_usage_log_clear(const DoutPrefixProvider *dpp, std::string& oid, optional_yield y);
+  int cls_obj_usage_log_rollup(const DoutPrefixProvider *dpp, const std::string& oid, uint64_t start_epoch, uint64_t end_epoch,
+                               uint32_t period, optional_yield y);
 
   int get_target_shard_id(const rgw::bucket_index_normal_layout& layout, const std::string& obj_key, int *shard_id);
 
@@ -0,0 +1,197 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright contributors to the Ceph project
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "rgw_readahead.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+#include <tuple>
+
+#include "common/ceph_context.h"
+#include "common/config.h"
+
+namespace rgw::rados {
+
+std::optional<std::pair<uint64_t, uint64_t>>
+ReadAhead::note_read(const rgw_raw_obj& head, uint64_t ofs, uint64_t end,
+                     uint64_t obj_size)
+{
+  const uint64_t max_ahead =
+      cct->_conf.get_val<Option::size_t>("rgw_get_obj_readahead_size");
+  if (max_ahead == 0 || end < ofs) {
+    return std::nullopt;
+  }
+  const auto now = clock::now();
+
+  std::scoped_lock lock{mutex};
+
+  // forget streams that went idle
+  while (!streams_lru.empty()) {
+    auto i = streams.find(streams_lru.front());
+    if (streams.size() <= max_streams && now - i->second.stamp < stream_timeout) {
+      break;
+    }
+    streams.erase(i);
+    streams_lru.pop_front();
+  }
+
+  auto [i, inserted] = streams.try_emplace(head);
+  auto& stream = i->second;
+  if (inserted) {
+    stream.lru = streams_lru.insert(streams_lru.end(), head);
+  } else {
+    streams_lru.splice(streams_lru.end(), streams_lru, stream.lru);
+  }
+
+  const bool sequential = !inserted && ofs == stream.next_ofs;
+  stream.next_ofs = end + 1;
+  stream.stamp = now;
+  if (!sequential) {
+    stream.prefetched = 0;
+    return std::nullopt;
+  }
+  if (end + 1 >= obj_size) {
+    return std::nullopt;
+  }
+
+  // stay one range ahead of the client, sized like its last one
+  const uint64_t first = std::max(end + 1, stream.prefetched);
+  const uint64_t last = std::min(end + std::min(end - ofs + 1, max_ahead),
+                                 obj_size - 1);
+  if (first > last) {
+    return std::nullopt;
+  }
+  stream.prefetched = last + 1;
+  return std::make_pair(first, last);
+}
+
+auto ReadAhead::find_chunk(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len)
+  -> std::map<ChunkKey, Chunk>::iterator
+{
+  // find the last chunk of this object that starts at or before ofs
+  auto i = chunks.upper_bound(ChunkKey{obj, ofs});
+  if (i == chunks.begin()) {
+    return chunks.end();
+  }
+  --i;
+  if (!(i->first.first == obj) ||
+      ofs + len > i->first.second + i->second.len) {
+    return chunks.end();
+  }
+  return i;
+}
+
+auto ReadAhead::lookup(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len,
+                       ceph::buffer::list& bl, Callback&& cb) -> Lookup
+{
+  std::scoped_lock lock{mutex};
+  auto i = find_chunk(obj, ofs, len);
+  if (i == chunks.end()) {
+    return Lookup::miss;
+  }
+  auto& [key, chunk] = *i;
+  if (chunk.pending) {
+    chunk.waiters.push_back(Waiter{ofs, len, std::move(cb)});
+    return Lookup::pending;
+  }
+  bl.substr_of(chunk.bl, ofs - key.second, len);
+  chunks_lru.splice(chunks_lru.end(), chunks_lru, chunk.lru);
+  return Lookup::hit;
+}
+
+bool ReadAhead::start_fetch(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len)
+{
+  const uint64_t max_bytes =
+      cct->_conf.get_val<Option::size_t>("rgw_get_obj_readahead_cache_size");
+  if (len == 0 || len > max_bytes) {
+    return false;
+  }
+
+  std::scoped_lock lock{mutex};
+  if (find_chunk(obj, ofs, len) != chunks.end()) {
+    return false;
+  }
+  // make room by evicting complete chunks. memory held by other prefetches
+  // can't be reclaimed until they finish, so skip this one instead
+  trim_chunks(max_bytes - len);
+  if (cached_bytes + len > max_bytes) {
+    return false;
+  }
+  auto [i, inserted] = chunks.try_emplace(ChunkKey{obj, ofs});
+  if (!inserted) {
+    return false;
+  }
+  i->second.len = len;
+  cached_bytes += len;
+  return true;
+}
+
+void ReadAhead::finish_fetch(const rgw_raw_obj& obj, uint64_t ofs, int r,
+                             ceph::buffer::list&& bl)
+{
+  const uint64_t max_bytes =
+      cct->_conf.get_val<Option::size_t>("rgw_get_obj_readahead_cache_size");
+
+  // results for the waiters, delivered after the lock is dropped
+  std::vector<std::tuple<Callback, int, ceph::buffer::list>> results;
+  {
+    std::scoped_lock lock{mutex};
+    auto i = chunks.find(ChunkKey{obj, ofs});
+    if (i == chunks.end() || !i->second.pending) {
+      return;
+    }
+    auto& chunk = i->second;
+    for (auto& w : chunk.waiters) {
+      ceph::buffer::list data;
+      int ret = r;
+      if (ret >= 0 && w.ofs + w.len > ofs + bl.length()) {
+        ret = -ENODATA; // short read, the waiter reads it from rados
+      } else if (ret >= 0) {
+        data.substr_of(bl, w.ofs - ofs, w.len);
+      }
+      results.emplace_back(std::move(w.cb), ret, std::move(data));
+    }
+    chunk.waiters.clear();
+
+    cached_bytes -= chunk.len;
+    if (r < 0 || bl.length() == 0) {
+      chunks.erase(i);
+    } else {
+      chunk.pending = false;
+      chunk.len = bl.length();
+      chunk.bl = std::move(bl);
+      chunk.lru = chunks_lru.insert(chunks_lru.end(), i->first);
+      cached_bytes += chunk.len;
+      trim_chunks(max_bytes);
+    }
+  }
+
+  for (auto& [cb, ret, data] : results) {
+    cb(ret, std::move(data));
+  }
+}
+
+void ReadAhead::trim_chunks(uint64_t max_bytes)
+{
+  while (cached_bytes > max_bytes && !chunks_lru.empty()) {
+    auto i = chunks.find(chunks_lru.front());
+    cached_bytes -= i->second.len;
+    chunks.erase(i);
+    chunks_lru.pop_front();
+  }
+}
+
+} // namespace rgw::rados
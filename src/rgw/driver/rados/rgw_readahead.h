@@ -0,0 +1,117 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright contributors to the Ceph project
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+#include "include/buffer.h"
+#include "rgw_obj_types.h"
+
+namespace rgw::rados {
+
+/// read-ahead for clients that fetch an object through a series of ranged
+/// GETs, as video players do. streams are tracked per head object. once a
+/// GET starts where the previous one ended, the range after it is prefetched
+/// from the tail objects and served to the next GET from memory, or handed to
+/// it when the prefetch completes. tail objects are never rewritten in place,
+/// so data cached from them can't go stale
+class ReadAhead {
+ public:
+  explicit ReadAhead(CephContext* cct) : cct(cct) {}
+
+  /// record a read of [ofs, end] from the object with the given head. if it
+  /// continues a stream, return the range [first, last] to prefetch for it
+  std::optional<std::pair<uint64_t, uint64_t>>
+  note_read(const rgw_raw_obj& head, uint64_t ofs, uint64_t end,
+            uint64_t obj_size);
+
+  /// receives the data of a prefetch that was still in flight at lookup(),
+  /// or its error. called without the lock held, from the thread that
+  /// completed the prefetch
+  using Callback = std::function<void(int r, ceph::buffer::list&& bl)>;
+
+  enum class Lookup {
+    miss,
+    hit, // the data was copied out
+    pending, // the callback will be called with the data
+  };
+
+  /// find prefetched data covering len bytes at ofs of a tail object. cb is
+  /// only consumed if the prefetch is still in flight
+  Lookup lookup(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len,
+                ceph::buffer::list& bl, Callback&& cb);
+
+  /// reserve memory for a prefetch of len bytes at ofs of a tail object.
+  /// returns false if that range is cached or in flight already, or if the
+  /// cache is taken up by other prefetches in flight
+  bool start_fetch(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len);
+
+  /// complete a prefetch reserved by start_fetch(), passing its data to the
+  /// reads that waited for it
+  void finish_fetch(const rgw_raw_obj& obj, uint64_t ofs, int r,
+                    ceph::buffer::list&& bl);
+
+ private:
+  using clock = ceph::coarse_mono_clock;
+  // streams untouched for this long are forgotten
+  static constexpr auto stream_timeout = std::chrono::seconds(30);
+  static constexpr size_t max_streams = 4096;
+
+  struct Stream {
+    uint64_t next_ofs = 0; // where a sequential read would start
+    uint64_t prefetched = 0; // end of the data prefetched so far
+    clock::time_point stamp;
+    std::list<rgw_raw_obj>::iterator lru;
+  };
+  using ChunkKey = std::pair<rgw_raw_obj, uint64_t>;
+  struct Waiter {
+    uint64_t ofs;
+    uint64_t len;
+    Callback cb;
+  };
+  struct Chunk {
+    uint64_t len = 0; // bytes reserved, or held once complete
+    bool pending = true;
+    ceph::buffer::list bl;
+    std::vector<Waiter> waiters;
+    std::list<ChunkKey>::iterator lru; // only complete chunks can be evicted
+  };
+
+  CephContext* const cct;
+  ceph::mutex mutex = ceph::make_mutex("rgw::rados::ReadAhead");
+
+  std::map<rgw_raw_obj, Stream> streams;
+  std::list<rgw_raw_obj> streams_lru; // most recent at the back
+
+  std::map<ChunkKey, Chunk> chunks;
+  std::list<ChunkKey> chunks_lru; // most recent at the back
+  uint64_t cached_bytes = 0; // includes prefetches in flight
+
+  // the chunk holding [ofs, ofs + len) of obj
+  std::map<ChunkKey, Chunk>::iterator find_chunk(const rgw_raw_obj& obj,
+                                                 uint64_t ofs, uint64_t len);
+  void trim_chunks(uint64_t max_bytes);
+};
+
+} // namespace rgw::rados
@@ -38,6 +38,8 @@
 
 #define dout_context g_ceph_context
 #define LOG_CLASS_LIST_MAX_ENTRIES (1000)
+#define BUCKET_OBJS_FETCH_MAX_SIZE (4 * 1024 * 1024)
+#define BUCKET_OBJS_FETCH_MAX_TOTAL (64 * 1024 * 1024)
 #define dout_subsys ceph_subsys_rgw
 
 using namespace std;
@@ -652,6 +654,181 @@ void RGWOp_BILog_Delete::execute(optional_yield y) {
   return;
 }
 
+// skip objects whose GET involves more than returning their stored
+// data; the sink falls back to a regular GET for anything not returned
+static bool can_batch_fetch(const rgw::sal::Attrs& attrs,
+                            const std::optional<rgw_zone_set_entry>& dst_zone_trace)
+{
+  if (attrs.count(RGW_ATTR_COMPRESSION) ||
+      attrs.count(RGW_ATTR_CRYPT_MODE) ||
+      attrs.count(RGW_ATTR_USER_MANIFEST) ||
+      attrs.count(RGW_ATTR_SLO_MANIFEST) ||
+      attrs.count(RGW_ATTR_CLOUD_TIER_TYPE)) {
+    return false;
+  }
+  if (auto i = attrs.find(RGW_ATTR_OBJ_REPLICATION_STATUS);
+      i != attrs.end() && i->second.to_str() == "PENDING") {
+    // let the regular GET path update the replication status
+    return false;
+  }
+  if (auto i = attrs.find(RGW_ATTR_OBJ_REPLICATION_TRACE);
+      i != attrs.end() && dst_zone_trace) {
+    try {
+      std::vector<rgw_zone_set_entry> zones;
+      auto p = i->second.cbegin();
+      decode(zones, p);
+      for (const auto& zone : zones) {
+        if (zone == *dst_zone_trace) {
+          return false;
+        }
+      }
+    } catch (const buffer::error&) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RGWOp_BucketObjs_Fetch::execute(optional_yield y) {
+  const string bucket_key = s->info.args.get("bucket-instance");
+  const string max_size_str = s->info.args.get("max-size");
+  const string dst_zone_str = s->info.args.get(RGW_SYS_PARAM_PREFIX "if-not-replicated-to");
+
+  if (bucket_key.empty() || max_size_str.empty()) {
+    ldpp_dout(this, 5) << "ERROR: bucket-instance and max-size are mandatory" << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+
+  string err;
+  uint64_t max_size = strict_strtoll(max_size_str.c_str(), 10, &err);
+  if (!err.empty()) {
+    ldpp_dout(this, 5) << "Error parsing max-size " << max_size_str << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+  max_size = std::min<uint64_t>(max_size, BUCKET_OBJS_FETCH_MAX_SIZE);
+
+  rgw_bucket b;
+  int shard_id{-1}; // unused
+  op_ret = rgw_bucket_parse_bucket_key(s->cct, bucket_key, &b, &shard_id);
+  if (op_ret < 0) {
+    ldpp_dout(this, 5) << "invalid bucket-instance " << bucket_key << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+
+  bufferlist in;
+  std::tie(op_ret, in) = rgw_rest_read_all_input(s, s->cct->_conf->rgw_max_put_param_size);
+  if (op_ret < 0) {
+    return;
+  }
+
+  std::vector<rgw_obj_key> keys;
+  try {
+    auto p = in.cbegin();
+    decode(keys, p);
+  } catch (const buffer::error&) {
+    ldpp_dout(this, 5) << "ERROR: failed to decode object keys" << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+  if (keys.size() > LOG_CLASS_LIST_MAX_ENTRIES) {
+    keys.resize(LOG_CLASS_LIST_MAX_ENTRIES);
+  }
+
+  std::optional<rgw_zone_set_entry> dst_zone_trace;
+  if (!dst_zone_str.empty()) {
+    dst_zone_trace.emplace(dst_zone_str);
+  }
+
+  std::unique_ptr<rgw::sal::Bucket> bucket;
+  op_ret = driver->load_bucket(s, b, &bucket, y);
+  if (op_ret < 0) {
+    ldpp_dout(this, 5) << "could not get bucket info for bucket=" << b << dendl;
+    return;
+  }
+
+  // objects past the response budget are left for the sink to GET
+  uint64_t total = 0;
+  entries.reserve(keys.size());
+  for (const auto& key : keys) {
+    if (total >= BUCKET_OBJS_FETCH_MAX_TOTAL) {
+      ldpp_dout(this, 20) << "response budget reached after "
+          << entries.size() << " objects" << dendl;
+      break;
+    }
+    auto obj = bucket->get_object(key);
+    auto read_op = obj->get_read_op();
+    rgw_sync_obj_batch_entry entry;
+    read_op->params.lastmod = &entry.mtime;
+
+    int r = read_op->prepare(y, this);
+    if (r < 0) {
+      ldpp_dout(this, 20) << "skipping " << key << ": prepare returned r=" << r << dendl;
+      continue;
+    }
+    auto& attrs = obj->get_attrs();
+    entry.size = obj->get_size();
+    if (entry.size > max_size || !can_batch_fetch(attrs, dst_zone_trace)) {
+      continue;
+    }
+    if (total + entry.size > BUCKET_OBJS_FETCH_MAX_TOTAL) {
+      continue;
+    }
+
+    if (auto i = attrs.find(RGW_ATTR_ETAG); i != attrs.end()) {
+      entry.etag = i->second.to_str();
+    }
+    entry.cond_mtime = entry.mtime;
+    if (auto i = attrs.find(RGW_ATTR_INTERNAL_MTIME); i != attrs.end()) {
+      try {
+        ceph::real_time internal_mtime;
+        auto p = i->second.cbegin();
+        decode(internal_mtime, p);
+        entry.cond_mtime = std::max(entry.cond_mtime, internal_mtime);
+      } catch (const buffer::error&) {}
+    }
+
+    // same format as a GET with rgwx-prepend-metadata
+    JSONFormatter jf;
+    jf.open_object_section("obj_metadata");
+    encode_json("attrs", attrs, &jf);
+    utime_t ut(entry.mtime);
+    encode_json("mtime", ut, &jf);
+    jf.close_section();
+    stringstream ss;
+    jf.flush(ss);
+    entry.metadata.append(ss.str());
+
+    if (entry.size > 0) {
+      r = read_op->read(0, entry.size - 1, entry.data, y, this);
+      if (r < 0 || entry.data.length() != entry.size) {
+        ldpp_dout(this, 10) << "skipping " << key << ": read returned r=" << r << dendl;
+        continue;
+      }
+    }
+    entry.key = key;
+    total += entry.metadata.length() + entry.data.length();
+    entries.push_back(std::move(entry));
+  }
+}
+
+void RGWOp_BucketObjs_Fetch::send_response() {
+  set_req_state_err(s, op_ret);
+  dump_errno(s);
+
+  if (op_ret < 0) {
+    end_header(s);
+    return;
+  }
+
+  bufferlist bl;
+  encode(entries, bl);
+  end_header(s, this, "application/octet-stream", bl.length());
+  dump_body(s, bl);
+}
+
 void RGWOp_DATALog_List::execute(optional_yield y) {
   string   shard = s->info.args.get("id");
 
@@ -1279,6 +1456,8 @@ RGWOp *RGWHandler_Log::op_post() {
       return new RGWOp_MDLog_Unlock;
     else if (s->info.args.exists("notify"))
       return new RGWOp_MDLog_Notify;
+  } else if (type.compare("bucket-objects") == 0) {
+    return new RGWOp_BucketObjs_Fetch;
   } else if (type.compare("data") == 0) {
     if (s->info.args.exists("notify")) {
       return new RGWOp_DATALog_Notify;
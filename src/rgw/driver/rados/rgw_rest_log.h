@@ -87,6 +87,29 @@ public:
   }
 };
 
+class RGWOp_BucketObjs_Fetch : public RGWRESTOp {
+  std::vector<rgw_sync_obj_batch_entry> entries;
+public:
+  RGWOp_BucketObjs_Fetch() {}
+  ~RGWOp_BucketObjs_Fetch() override {}
+
+  int check_caps(const RGWUserCaps& caps) override {
+    return caps.check_cap("bilog", RGW_CAP_READ);
+  }
+  int verify_permission(optional_yield y) override {
+    // returns object data, which is only meant for multisite sync
+    if (!s->system_request) {
+      return -EACCES;
+    }
+    return check_caps(s->user->get_caps());
+  }
+  void execute(optional_yield y) override;
+  void send_response() override;
+  const char* name() const override {
+    return "fetch_bucket_objects";
+  }
+};
+
 class RGWOp_MDLog_List : public RGWRESTOp {
   std::vector<cls::log::entry> entries;
   std::string last_marker;
@@ -2612,7 +2612,7 @@ std::unique_ptr<Writer> RadosStore::get_append_writer(const DoutPrefixProvider *
 {
   RGWBucketInfo& bucket_info = obj->get_bucket()->get_info();
   RGWObjectCtx& obj_ctx = static_cast<RadosObject*>(obj)->get_ctx();
-  auto aio = rgw::make_throttle(ctx()->_conf->rgw_put_obj_min_window_size, y);
+  auto aio = rgw::make_throttle(ctx()->_conf->rgw_put_obj_min_window_size, y, dpp);
   return std::make_unique<RadosAppendWriter>(dpp, y,
 				 bucket_info, obj_ctx, obj->get_obj(),
 				 this, std::move(aio), owner,
@@ -2631,7 +2631,7 @@ std::unique_ptr<Writer> RadosStore::get_atomic_writer(const DoutPrefixProvider *
 {
   RGWBucketInfo& bucket_info = obj->get_bucket()->get_info();
   RGWObjectCtx& obj_ctx = static_cast<RadosObject*>(obj)->get_ctx();
-  auto aio = rgw::make_throttle(ctx()->_conf->rgw_put_obj_min_window_size, y);
+  auto aio = rgw::make_throttle(ctx()->_conf->rgw_put_obj_min_window_size, y, dpp);
   return std::make_unique<RadosAtomicWriter>(dpp, y,
 				 bucket_info, obj_ctx, obj->get_obj(),
 				 this, std::move(aio), owner,
@@ -3376,7 +3376,7 @@ int RadosObject::handle_obj_expiry(const DoutPrefixProvider* dpp, optional_yield
   // object is not restored/temporary; go for regular deletion
     ldpp_dout(dpp, 10) << "Deleting expired obj:" << get_key() << dendl;
 
-    ret = obj->delete_object(dpp, null_yield, rgw::sal::FLAG_LOG_OP, nullptr, nullptr);
+    ret = obj->delete_object(dpp, y, rgw::sal::FLAG_LOG_OP, nullptr, nullptr);
 
   return ret;
 }
@@ -3937,7 +3937,7 @@ int RadosMultipartUpload::abort(const DoutPrefixProvider *dpp, CephContext *cct,
             head->get_key().get_index_key(&key);
             remove_objs.push_back(key);
 
-            cleanup_part_history(dpp, null_yield, obj_part, remove_objs, it->second);
+            cleanup_part_history(dpp, y, obj_part, remove_objs, it->second);
           }
         }
         parts_accounted_size += obj_part->info.accounted_size;
@@ -4471,7 +4471,7 @@ std::unique_ptr<Writer> RadosMultipartUpload::get_writer(
 {
   RGWBucketInfo& bucket_info = obj->get_bucket()->get_info();
   RGWObjectCtx& obj_ctx = static_cast<RadosObject*>(obj)->get_ctx();
-  auto aio = rgw::make_throttle(store->ctx()->_conf->rgw_put_obj_min_window_size, y);
+  auto aio = rgw::make_throttle(store->ctx()->_conf->rgw_put_obj_min_window_size, y, dpp);
   return std::make_unique<RadosMultipartWriter>(dpp, y, get_upload_id(),
 				 bucket_info, obj_ctx,
 				 obj->get_obj(), store, std::move(aio), owner,
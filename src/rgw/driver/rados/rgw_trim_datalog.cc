@@ -56,10 +56,10 @@ class DatalogTrimImplCR : public RGWSimpleCoroutine {
 		  << " marker=" << marker << " returned r=" << r << dendl;
 
     set_status() << "request complete; ret=" << r;
-    if (r != -ENODATA) {
+    if (r < 0 && r != -ENODATA) {
       return r;
     }
-    // nothing left to trim, update last_trim_marker
+    // trimmed through marker, update last_trim_marker
     if (*last_trim_marker < marker &&
 	marker != store->svc()->datalog_rados->max_marker()) {
       *last_trim_marker = marker;
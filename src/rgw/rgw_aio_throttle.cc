@@ -14,6 +14,7 @@
  */
 
 #include "rgw_aio_throttle.h"
+#include "rgw_asio_thread.h"
 
 namespace rgw {
 
@@ -27,6 +28,17 @@ bool Throttle::waiter_ready() const
   }
 }
 
+void BlockingAioThrottle::wait_for(std::unique_lock<ceph::mutex>& lock, Wait w)
+{
+  if (dpp) {
+    maybe_warn_about_blocking(dpp);
+  }
+  ceph_assert(waiter == Wait::None);
+  waiter = w;
+  cond.wait(lock, [this] { return waiter_ready(); });
+  waiter = Wait::None;
+}
+
 AioResultList BlockingAioThrottle::get(rgw_raw_obj obj,
                                        OpFunc&& f,
                                        uint64_t cost, uint64_t id)
@@ -44,10 +56,7 @@ AioResultList BlockingAioThrottle::get(rgw_raw_obj obj,
     // wait for the write size to become available
     pending_size += p->cost;
     if (!is_available()) {
-      ceph_assert(waiter == Wait::None);
-      waiter = Wait::Available;
-      cond.wait(lock, [this] { return is_available(); });
-      waiter = Wait::None;
+      wait_for(lock, Wait::Available);
     }
 
     // register the pending write and attach a completion
@@ -88,10 +97,7 @@ AioResultList BlockingAioThrottle::wait()
 {
   std::unique_lock lock{mutex};
   if (completed.empty() && !pending.empty()) {
-    ceph_assert(waiter == Wait::None);
-    waiter = Wait::Completion;
-    cond.wait(lock, [this] { return has_completion(); });
-    waiter = Wait::None;
+    wait_for(lock, Wait::Completion);
   }
   return std::move(completed);
 }
@@ -100,10 +106,7 @@ AioResultList BlockingAioThrottle::drain()
 {
   std::unique_lock lock{mutex};
   if (!pending.empty()) {
-    ceph_assert(waiter == Wait::None);
-    waiter = Wait::Drained;
-    cond.wait(lock, [this] { return is_drained(); });
-    waiter = Wait::None;
+    wait_for(lock, Wait::Drained);
   }
   return std::move(completed);
 }
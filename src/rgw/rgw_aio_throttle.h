@@ -55,13 +55,19 @@ class Throttle {
 class BlockingAioThrottle final : public Aio, private Throttle {
   ceph::mutex mutex = ceph::make_mutex("AioThrottle");
   ceph::condition_variable cond;
+  // if given, waits are reported to maybe_warn_about_blocking()
+  const DoutPrefixProvider* dpp;
+
+  void wait_for(std::unique_lock<ceph::mutex>& lock, Wait w);
 
   struct Pending : AioResultEntry {
     BlockingAioThrottle *parent = nullptr;
     uint64_t cost = 0;
   };
  public:
-  BlockingAioThrottle(uint64_t window) : Throttle(window) {}
+  BlockingAioThrottle(uint64_t window,
+                      const DoutPrefixProvider* dpp = nullptr)
+    : Throttle(window), dpp(dpp) {}
 
   virtual ~BlockingAioThrottle() override {};
 
@@ -112,14 +118,15 @@ class YieldingAioThrottle final : public Aio, private Throttle {
 };
 
 // return a smart pointer to Aio
-inline auto make_throttle(uint64_t window_size, optional_yield y)
+inline auto make_throttle(uint64_t window_size, optional_yield y,
+                          const DoutPrefixProvider* dpp = nullptr)
 {
   std::unique_ptr<Aio> aio;
   if (y) {
     aio = std::make_unique<YieldingAioThrottle>(window_size,
                                                 y.get_yield_context());
   } else {
-    aio = std::make_unique<BlockingAioThrottle>(window_size);
+    aio = std::make_unique<BlockingAioThrottle>(window_size, dpp);
   }
   return aio;
 }
@@ -1,11 +1,13 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
 // vim: ts=8 sw=2 sts=2 expandtab ft=cpp
 
+#include <array>
 #include <atomic>
 #include <ctime>
 #include <iomanip>
 #include <list>
 #include <memory>
+#include <string>
 
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/bind_cancellation_slot.hpp>
@@ -64,6 +66,10 @@ using timeout_timer = rgw::basic_timeout_timer<ceph::coarse_mono_clock,
 static constexpr size_t parse_buffer_size = 65536;
 using parse_buffer = boost::beast::flat_static_buffer<parse_buffer_size>;
 
+// responses to pipelined requests are held back until this much output is
+// pending, or until the client stops pipelining
+static constexpr size_t pipelined_output_max = 65536;
+
 // use mmap/mprotect to allocate 512k coroutine stacks
 auto make_stack_allocator() {
   return boost::context::protected_fixedsize_stack{512*1024};
@@ -116,44 +122,34 @@ class StreamIO : public rgw::asio::ClientIO {
   timeout_timer& timeout;
   optional_yield y;
   parse_buffer& buffer;
+  // output held back from earlier pipelined requests on this connection
+  std::string& pending_output;
+  // whether this request's output may be held back too
+  const bool pipelined;
   boost::system::error_code fatal_ec;
  public:
   StreamIO(CephContext *cct, Stream& stream, timeout_timer& timeout,
            rgw::asio::parser_type& parser, optional_yield y,
-           parse_buffer& buffer, bool is_ssl,
+           parse_buffer& buffer, std::string& pending_output,
+           bool pipelined, bool is_ssl,
            const tcp::endpoint& local_endpoint,
            const tcp::endpoint& remote_endpoint)
       : ClientIO(parser, is_ssl, local_endpoint, remote_endpoint),
         cct(cct), stream(stream), timeout(timeout), y(y),
-        buffer(buffer)
+        buffer(buffer), pending_output(pending_output),
+        pipelined(pipelined)
   {}
 
   boost::system::error_code get_fatal_error_code() const { return fatal_ec; }
 
   size_t write_data(const char* buf, size_t len) override {
-    boost::system::error_code ec;
-    timeout.start();
-    size_t bytes = 0;
-    if (y) {
-      boost::asio::yield_context& yield = y.get_yield_context();
-      bytes = boost::asio::async_write(stream, boost::asio::buffer(buf, len),
-                                       yield[ec]);
-    } else {
-      bytes = boost::asio::write(stream, boost::asio::buffer(buf, len), ec);
+    if (pipelined && pending_output.size() + len <= pipelined_output_max) {
+      // the client already sent its next request, so coalesce the responses
+      pending_output.append(buf, len);
+      return len;
     }
-    timeout.cancel();
-    if (ec) {
-      ldout(cct, 4) << "write_data failed: " << ec.message() << dendl;
-      if (ec == boost::asio::error::broken_pipe) {
-        boost::system::error_code ec_ignored;
-        stream.lowest_layer().shutdown(tcp::socket::shutdown_both, ec_ignored);
-      }
-      if (!fatal_ec) {
-        fatal_ec = ec;
-      }
-      throw rgw::io::Exception(ec.value(), std::system_category());
-    }
-    return bytes;
+    write(buf, len);
+    return len;
   }
 
   size_t recv_body(char* buf, size_t max) override {
@@ -162,6 +158,11 @@ class StreamIO : public rgw::asio::ClientIO {
     body_remaining.data = buf;
     body_remaining.size = max;
 
+    if (!pending_output.empty() && body_remaining.size && !parser.is_done()) {
+      // the client may wait for earlier responses before sending the body
+      write(nullptr, 0);
+    }
+
     while (body_remaining.size && !parser.is_done()) {
       boost::system::error_code ec;
       timeout.start();
@@ -185,6 +186,35 @@ class StreamIO : public rgw::asio::ClientIO {
     }
     return max - body_remaining.size;
   }
+
+ private:
+  void write(const char* buf, size_t len) {
+    // send anything held back along with this write
+    const std::array<boost::asio::const_buffer, 2> buffers = {
+      boost::asio::buffer(pending_output), boost::asio::buffer(buf, len)
+    };
+    boost::system::error_code ec;
+    timeout.start();
+    if (y) {
+      boost::asio::yield_context& yield = y.get_yield_context();
+      boost::asio::async_write(stream, buffers, yield[ec]);
+    } else {
+      boost::asio::write(stream, buffers, ec);
+    }
+    timeout.cancel();
+    pending_output.clear();
+    if (ec) {
+      ldout(cct, 4) << "write_data failed: " << ec.message() << dendl;
+      if (ec == boost::asio::error::broken_pipe) {
+        boost::system::error_code ec_ignored;
+        stream.lowest_layer().shutdown(tcp::socket::shutdown_both, ec_ignored);
+      }
+      if (!fatal_ec) {
+        fatal_ec = ec;
+      }
+      throw rgw::io::Exception(ec.value(), std::system_category());
+    }
+  }
 };
 
 // output the http version as a string, ie 'HTTP/1.1'
@@ -247,16 +277,47 @@ std::ostream& operator<<(std::ostream& out, const log_apache_time& a) {
 
 using SharedMutex = ceph::async::SharedMutex<boost::asio::any_io_executor>;
 
+// write out any responses held back for pipelined requests
 template <typename Stream>
-void handle_connection(boost::asio::io_context& context,
-                       RGWProcessEnv& env, Stream& stream,
-                       timeout_timer& timeout, size_t header_limit,
-                       parse_buffer& buffer, bool is_ssl,
-                       SharedMutex& pause_mutex,
-                       rgw::dmclock::Scheduler *scheduler,
-                       const std::string& uri_prefix,
-                       boost::system::error_code& ec,
-                       boost::asio::yield_context yield)
+void flush_pending_output(CephContext* cct, Stream& stream,
+                          timeout_timer& timeout, std::string& pending_output,
+                          boost::asio::yield_context yield)
+{
+  if (pending_output.empty()) {
+    return;
+  }
+  boost::system::error_code ec;
+  timeout.start();
+  boost::asio::async_write(stream, boost::asio::buffer(pending_output),
+                           yield[ec]);
+  timeout.cancel();
+  pending_output.clear();
+  if (ec) {
+    ldout(cct, 4) << "failed to write pipelined responses: "
+        << ec.message() << dendl;
+  }
+}
+
+// whether the buffer holds the entire header of the next request, so that
+// reading it won't wait on the client
+static bool has_complete_header(const parse_buffer& buffer)
+{
+  const auto data = buffer.data();
+  const std::string_view buffered{static_cast<const char*>(data.data()),
+                                  data.size()};
+  return buffered.find("\r\n\r\n") != buffered.npos;
+}
+
+template <typename Stream>
+void handle_requests(RGWProcessEnv& env, Stream& stream,
+                     timeout_timer& timeout, size_t header_limit,
+                     parse_buffer& buffer, bool is_ssl,
+                     SharedMutex& pause_mutex,
+                     rgw::dmclock::Scheduler *scheduler,
+                     const std::string& uri_prefix,
+                     std::string& pending_output,
+                     boost::system::error_code& ec,
+                     boost::asio::yield_context yield)
 {
   // don't impose a limit on the body, since we read it in pieces
   static constexpr size_t body_limit = std::numeric_limits<size_t>::max();
@@ -265,6 +326,11 @@ void handle_connection(boost::asio::io_context& context,
 
   // read messages from the stream until eof
   for (;;) {
+    if (!has_complete_header(buffer)) {
+      // a pipelining client may wait for our responses before sending more
+      flush_pending_output(cct, stream, timeout, pending_output, yield);
+    }
+
     // configure the parser
     rgw::asio::parser_type parser;
     parser.header_limit(header_limit);
@@ -286,6 +352,7 @@ void handle_connection(boost::asio::io_context& context,
     auto& message = parser.get();
     if (ec) {
       ldout(cct, 1) << "failed to read header: " << ec.message() << dendl;
+      flush_pending_output(cct, stream, timeout, pending_output, yield);
       http::response<http::empty_body> response;
       response.result(http::status::bad_request);
       response.version(message.version() == 10 ? 10 : 11);
@@ -328,7 +395,12 @@ void handle_connection(boost::asio::io_context& context,
       if (cct->_conf->rgw_beast_enable_async) {
         y = optional_yield{yield};
       }
+      // a request without a body whose successor is already buffered comes
+      // from a pipelining client, which reads responses only after sending
+      // its requests. its response can wait for the ones that follow
+      const bool pipelined = parser.is_done() && buffer.size() > 0;
       StreamIO real_client{cct, stream, timeout, parser, y, buffer,
+                           pending_output, pipelined,
                            is_ssl, local_endpoint, remote_endpoint};
 
       auto real_client_io = rgw::io::add_reordering(
@@ -381,6 +453,9 @@ void handle_connection(boost::asio::io_context& context,
 
     // if we failed before reading the entire message, discard any remaining
     // bytes before reading the next
+    if (!parser.is_done()) {
+      flush_pending_output(cct, stream, timeout, pending_output, yield);
+    }
     while (!parser.is_done()) {
       static std::array<char, 1024*1024> discard_buffer;
 
@@ -406,6 +481,27 @@ void handle_connection(boost::asio::io_context& context,
   }
 }
 
+template <typename Stream>
+void handle_connection(boost::asio::io_context& context,
+                       RGWProcessEnv& env, Stream& stream,
+                       timeout_timer& timeout, size_t header_limit,
+                       parse_buffer& buffer, bool is_ssl,
+                       SharedMutex& pause_mutex,
+                       rgw::dmclock::Scheduler *scheduler,
+                       const std::string& uri_prefix,
+                       boost::system::error_code& ec,
+                       boost::asio::yield_context yield)
+{
+  // output held back for pipelined requests. however the connection ends,
+  // write out what the client may still be waiting on
+  std::string pending_output;
+  handle_requests(env, stream, timeout, header_limit, buffer, is_ssl,
+                  pause_mutex, scheduler, uri_prefix, pending_output,
+                  ec, yield);
+  flush_pending_output(env.driver->ctx(), stream, timeout, pending_output,
+                       yield);
+}
+
 // timeout support requires that connections are reference-counted, because the
 // timeout_handler can outlive the coroutine
 struct Connection : boost::intrusive::list_base_hook<>,
@@ -18,6 +18,7 @@
 #include "common/BackTrace.h"
 #include "common/dout.h"
 #include "include/ceph_assert.h"
+#include "rgw_perf_counters.h"
 
 thread_local bool is_asio_thread = false;
 
@@ -32,6 +33,10 @@ void maybe_warn_about_blocking(const DoutPrefixProvider* dpp)
   const auto& conf = dpp->get_cct()->_conf;
   ceph_assert_always(!conf->rgw_asio_assert_yielding);
 
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_asio_blocking);
+  }
+
   // otherwise just log the warning and optional backtrace
   ldpp_dout(dpp, 20) << "WARNING: blocking librados call" << dendl;
 #ifdef _BACKTRACE_LOGGING
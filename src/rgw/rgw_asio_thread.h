@@ -24,7 +24,8 @@ class DoutPrefixProvider;
 extern thread_local bool is_asio_thread;
 
 /// call when an operation will block the calling thread due to an empty
-/// optional_yield. a warning is logged when is_asio_thread is true
+/// optional_yield. a warning is logged and the asio_blocking perf counter
+/// incremented when is_asio_thread is true
 void maybe_warn_about_blocking(const DoutPrefixProvider* dpp);
 
 /// enables warnings while in scope. these scopes must not be nested
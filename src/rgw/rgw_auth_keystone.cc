@@ -22,6 +22,7 @@
 
 #include "common/ceph_crypto.h"
 #include "common/Cond.h"
+#include "include/scope_guard.h"
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -41,7 +42,8 @@ boost::optional<TokenEngine::token_envelope_t>
 TokenEngine::get_from_keystone(const DoutPrefixProvider* dpp,
                                const std::string& token,
                                bool allow_expired,
-                               optional_yield y) const
+                               optional_yield y,
+                               bool* rejected) const
 {
   /* Unfortunately, we can't use the short form of "using" here. It's because
    * we're aliasing a class' member, not namespace. */
@@ -119,6 +121,11 @@ admin_token_retry:
         RGWValidateKeystoneToken::HTTP_STATUS_NOTFOUND) {
     ldpp_dout(dpp, 5) << "Failed keystone auth from " << url << " with "
                   << validate.get_http_status() << dendl;
+    /* a 404 is about the subject token. a 401 is too, unless the request
+     * was authorized with the admin token */
+    if (rejected) {
+      *rejected = !admin_token_unauthorized || !allow_expired;
+    }
     return boost::none;
   }
   // throw any other http or connection errors
@@ -345,11 +352,47 @@ TokenEngine::authenticate(const DoutPrefixProvider* dpp,
     }
   }
 
+  /* Outcomes below only depend on the token when it is validated on its own
+   * (without a service token), so only these are shared through the cache:
+   * a token Keystone refused recently is refused again without asking, and
+   * requests arriving with the same token while it is being validated wait
+   * for that validation instead of issuing their own. */
+  bool validating = false;
+  auto validation_guard = make_scope_guard([&] {
+    if (validating) {
+      token_cache.end_validation(token_id);
+    }
+  });
+  if (! allow_expired) {
+    if (token_cache.is_rejected(token_id)) {
+      ldpp_dout(dpp, 20) << "token was recently rejected by Keystone" << dendl;
+      return result_t::deny(-EACCES);
+    }
+    validating = token_cache.begin_validation(token_id, y);
+    if (! validating) {
+      t = token_cache.find(token_id);
+      if (t) {
+        ldpp_dout(dpp, 20) << "token validated by a concurrent request, project.id="
+                           << t->get_project_id() << dendl;
+        auto apl = apl_factory->create_apl_remote(cct, s, get_acl_strategy(*t),
+                                                  get_creds_info(*t));
+        return result_t::grant(std::move(apl));
+      }
+      if (token_cache.is_rejected(token_id)) {
+        return result_t::deny(-EACCES);
+      }
+    }
+  }
+
   /* Token not in cache. Go to the Keystone for validation. This happens even
    * for the legacy PKI/PKIz token types. That's it, after the PKI/PKIz
    * RadosGW-side validation has been removed, we always ask Keystone. */
-  t = get_from_keystone(dpp, token, allow_expired, y);
+  bool rejected = false;
+  t = get_from_keystone(dpp, token, allow_expired, y, &rejected);
   if (! t) {
+    if (rejected && ! allow_expired) {
+      token_cache.add_rejected(token_id);
+    }
     return result_t::deny(-EACCES);
   }
   t->update_roles(roles.admin, roles.reader);
@@ -365,6 +408,7 @@ TokenEngine::authenticate(const DoutPrefixProvider* dpp,
       ldpp_dout(dpp, 0) << "got expired token: " << t->get_project_name()
                     << ":" << t->get_user_name()
                     << " expired: " << t->get_expires() << dendl;
+      token_cache.add_rejected(token_id);
       return result_t::deny(-EPERM);
     }
   }
@@ -592,9 +636,13 @@ auto EC2Engine::get_access_token(const DoutPrefixProvider* dpp,
   boost::optional<std::string> secret;
   int failure_reason;
 
-  /* Get a token from the cache if one has already been stored */
+  /* Get a token from the cache if one has already been stored. A request
+   * that can be checked against Keystone may be asked to revalidate an entry
+   * that is about to expire, so that the others keep hitting the cache. */
+  const std::string key_id(access_key_id);
+  bool refresh = false;
   boost::optional<boost::tuple<rgw::keystone::TokenEnvelope, std::string>>
-    t = secret_cache.find(std::string(access_key_id));
+    t = secret_cache.find(key_id, ignore_signature ? nullptr : &refresh);
 
   /* Check that credentials can correctly be used to sign data */
   if (t) {
@@ -607,8 +655,14 @@ auto EC2Engine::get_access_token(const DoutPrefixProvider* dpp,
       std::string sig(signature);
       server_signature_t server_signature = signature_factory(cct, t->get<1>(), string_to_sign);
       if (sig.compare(server_signature) == 0) {
+        if (refresh) {
+          refresh_secret(dpp, key_id, string_to_sign, signature, y);
+        }
         return {t->get<0>(), t->get<1>(), 0};
       } else {
+        if (refresh) {
+          secret_cache.end_refresh(key_id);
+        }
         ldpp_dout(dpp, 0) << "Secret string does not correctly sign payload, cache miss" << dendl;
       }
     }
@@ -634,6 +688,37 @@ auto EC2Engine::get_access_token(const DoutPrefixProvider* dpp,
   return {token, secret, failure_reason};
 }
 
+/*
+ * Revalidate a cached secret ahead of its expiry. The cached one is still
+ * valid, so it keeps being used if Keystone can't be reached.
+ */
+void EC2Engine::refresh_secret(const DoutPrefixProvider* dpp,
+                               const std::string& access_key_id,
+                               const std::string& string_to_sign,
+                               const std::string_view& signature,
+                               optional_yield y) const
+{
+  ldpp_dout(dpp, 20) << "cached secret is about to expire, revalidating it" << dendl;
+  try {
+    auto [token, failure_reason] =
+        get_from_keystone(dpp, access_key_id, string_to_sign, signature, y);
+    if (token) {
+      auto [secret, secret_failure] =
+          get_secret_from_keystone(dpp, token->get_user_id(), access_key_id, y);
+      if (secret) {
+        secret_cache.add(access_key_id, *token, *secret);
+        return;
+      }
+      failure_reason = secret_failure;
+    }
+    ldpp_dout(dpp, 5) << "failed to revalidate cached secret: "
+                      << failure_reason << dendl;
+  } catch (int err) {
+    ldpp_dout(dpp, 5) << "failed to revalidate cached secret: " << err << dendl;
+  }
+  secret_cache.end_refresh(access_key_id);
+}
+
 EC2Engine::acl_strategy_t
 EC2Engine::get_acl_strategy(const EC2Engine::token_envelope_t&) const
 {
@@ -754,7 +839,8 @@ rgw::auth::Engine::result_t EC2Engine::authenticate(
 
 bool SecretCache::find(const std::string& token_id,
                        SecretCache::token_envelope_t& token,
-		       std::string &secret)
+		       std::string &secret,
+                       bool* refresh)
 {
   std::lock_guard<std::mutex> l(lock);
 
@@ -777,9 +863,24 @@ bool SecretCache::find(const std::string& token_id,
   secrets_lru.push_front(token_id);
   entry.lru_iter = secrets_lru.begin();
 
+  if (refresh && !entry.refreshing && now + refresh_window > entry.expires) {
+    entry.refreshing = true;
+    *refresh = true;
+  }
+
   return true;
 }
 
+void SecretCache::end_refresh(const std::string& token_id)
+{
+  std::lock_guard<std::mutex> l(lock);
+
+  auto iter = secrets.find(token_id);
+  if (iter != secrets.end()) {
+    iter->second.refreshing = false;
+  }
+}
+
 void SecretCache::add(const std::string& token_id,
                       const SecretCache::token_envelope_t& token,
 		      const std::string& secret)
@@ -799,6 +900,7 @@ void SecretCache::add(const std::string& token_id,
   entry.secret = secret;
   entry.expires = now + s3_token_expiry_length;
   entry.lru_iter = secrets_lru.begin();
+  entry.refreshing = false;
 
   while (secrets_lru.size() > max) {
     list<string>::reverse_iterator riter = secrets_lru.rbegin();
@@ -37,11 +37,14 @@ class TokenEngine : public rgw::auth::Engine {
   /* Helper methods. */
   bool is_applicable(const std::string& token) const noexcept;
 
+  /* Returns none if Keystone refused the token; rejected is set if it
+   * reported the subject token itself as invalid. */
   boost::optional<token_envelope_t>
   get_from_keystone(const DoutPrefixProvider* dpp,
                     const std::string& token,
                     bool allow_expired,
-                    optional_yield y) const;
+                    optional_yield y,
+                    bool* rejected = nullptr) const;
 
   acl_strategy_t get_acl_strategy(const token_envelope_t& token) const;
   auth_info_t get_creds_info(const token_envelope_t& token) const noexcept;
@@ -85,6 +88,8 @@ class SecretCache {
     std::string secret;
     utime_t expires;
     std::list<std::string>::iterator lru_iter;
+    /* A request is revalidating the secret ahead of its expiry. */
+    bool refreshing = false;
   };
 
   const boost::intrusive_ptr<CephContext> cct;
@@ -97,12 +102,16 @@ class SecretCache {
   const size_t max;
 
   const utime_t s3_token_expiry_length;
+  /* How long before its expiry an entry gets revalidated. */
+  const utime_t refresh_window;
 
   SecretCache()
     : cct(g_ceph_context),
       lock(),
       max(cct->_conf->rgw_keystone_token_cache_size),
-      s3_token_expiry_length(cct->_conf->rgw_keystone_token_cache_ttl, 0) {
+      s3_token_expiry_length(cct->_conf->rgw_keystone_token_cache_ttl, 0),
+      refresh_window(std::min<int64_t>(cct->_conf->rgw_keystone_token_cache_refresh_window,
+                                       cct->_conf->rgw_keystone_token_cache_ttl / 2), 0) {
   }
 
   ~SecretCache() {}
@@ -117,16 +126,22 @@ public:
     return instance;
   }
 
-  bool find(const std::string& token_id, token_envelope_t& token, std::string& secret);
-  boost::optional<boost::tuple<token_envelope_t, std::string>> find(const std::string& token_id) {
+  /* If refresh is given, it is set for exactly one caller once the entry
+   * gets close to its expiry. That caller is expected to revalidate the
+   * secret with Keystone, then either add() it again or end_refresh(). */
+  bool find(const std::string& token_id, token_envelope_t& token, std::string& secret,
+            bool* refresh = nullptr);
+  boost::optional<boost::tuple<token_envelope_t, std::string>> find(const std::string& token_id,
+                                                                     bool* refresh = nullptr) {
     token_envelope_t token_envlp;
     std::string secret;
-    if (find(token_id, token_envlp, secret)) {
+    if (find(token_id, token_envlp, secret, refresh)) {
       return boost::make_tuple(token_envlp, secret);
     }
     return boost::none;
   }
   void add(const std::string& token_id, const token_envelope_t& token, const std::string& secret);
+  void end_refresh(const std::string& token_id);
 }; /* class SecretCache */
 
 class EC2Engine : public rgw::auth::s3::AWSEngine {
@@ -166,6 +181,11 @@ class EC2Engine : public rgw::auth::s3::AWSEngine {
 		   const signature_factory_t& signature_factory,
                    bool ignore_signature,
                    optional_yield y) const;
+  void refresh_secret(const DoutPrefixProvider* dpp,
+                      const std::string& access_key_id,
+                      const std::string& string_to_sign,
+                      const std::string_view& signature,
+                      optional_yield y) const;
   result_t authenticate(const DoutPrefixProvider* dpp,
                         const std::string_view& access_key_id,
                         const std::string_view& signature,
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "common/armor.h"
+#include "common/lru_map.h"
 #include "common/utf8.h"
 #include "common/split.h"
 #include "include/timegm.h"
@@ -951,6 +952,51 @@ transform_secret_key(const std::string_view& secret_access_key)
   return secret_key_utf8;
 }
 
+/*
+ * derived signing keys, keyed by credential scope and secret. A scope only
+ * changes once a day, so nearly every request of an active client hits. A
+ * rotated secret simply misses and its old entries age out of the LRU.
+ */
+class SigningKeyCache {
+  lru_map<std::string, sha256_digest_t> keys;
+
+  static std::string make_key(const std::string_view& credential_scope,
+                              const std::string_view& secret_access_key) {
+    /* the scope comes from the request, prefix its length so that no two
+     * (scope, secret) pairs can produce the same key */
+    std::string key = std::to_string(credential_scope.size());
+    key.reserve(key.size() + 1 + credential_scope.size() + secret_access_key.size());
+    key.append(":", 1).append(credential_scope).append(secret_access_key);
+    return key;
+  }
+
+public:
+  explicit SigningKeyCache(size_t size) : keys(size) {}
+
+  bool find(const std::string_view& credential_scope,
+            const std::string_view& secret_access_key,
+            sha256_digest_t& signing_key) {
+    return keys.find(make_key(credential_scope, secret_access_key), signing_key);
+  }
+
+  void add(const std::string_view& credential_scope,
+           const std::string_view& secret_access_key,
+           sha256_digest_t signing_key) {
+    keys.add(make_key(credential_scope, secret_access_key), signing_key);
+  }
+};
+
+static SigningKeyCache* get_signing_key_cache(CephContext* const cct)
+{
+  static const size_t size =
+    cct->_conf.get_val<uint64_t>("rgw_s3_auth_signing_key_cache_size");
+  if (size == 0) {
+    return nullptr;
+  }
+  static SigningKeyCache cache(size);
+  return &cache;
+}
+
 /*
  * calculate the SigningKey of AWS auth version 4
  */
@@ -960,6 +1006,13 @@ get_v4_signing_key(CephContext* const cct,
                    const std::string_view& secret_access_key,
                    const DoutPrefixProvider *dpp)
 {
+  auto cache = get_signing_key_cache(cct);
+  if (sha256_digest_t cached; cache &&
+      cache->find(credential_scope, secret_access_key, cached)) {
+    ldpp_dout(dpp, 10) << "signing_k = " << cached << " (cached)" << dendl;
+    return cached;
+  }
+
   std::string_view date, region, service;
   std::tie(date, region, service) = parse_cred_scope(credential_scope);
 
@@ -977,6 +1030,9 @@ get_v4_signing_key(CephContext* const cct,
   ldpp_dout(dpp, 10) << "service_k = " << service_k << dendl;
   ldpp_dout(dpp, 10) << "signing_k = " << signing_key << dendl;
 
+  if (cache) {
+    cache->add(credential_scope, secret_access_key, signing_key);
+  }
   return signing_key;
 }
 
@@ -1156,24 +1212,45 @@ AWSv4ComplMulti::ChunkMeta::create_next(CephContext* const cct,
   } /* no-signature */
 } /* AWSv4ComplMulti::ChunkMeta::create_next */
 
-std::string
-AWSv4ComplMulti::calc_chunk_signature(const std::string& payload_hash) const
+AWSEngine::VersionAbstractor::server_signature_t
+AWSv4ComplMulti::calc_chunk_signature(const std::string_view payload_hash)
 {
-  const auto string_to_sign = string_join_reserve("\n",
+  const std::string_view pieces[] = {
     AWS4_HMAC_SHA256_PAYLOAD_STR,
     date,
     credential_scope,
     prev_chunk_signature,
     AWS4_EMPTY_PAYLOAD_HASH,
-    payload_hash);
+    payload_hash
+  };
 
-  ldout(cct(), 20) << "AWSv4ComplMulti: string_to_sign=\n" << string_to_sign
-                 << dendl;
+  if (cct()->_conf->subsys.should_gather(ceph_subsys_rgw, 20)) [[unlikely]] {
+    ldout(cct(), 20) << "AWSv4ComplMulti: string_to_sign=\n"
+                     << string_join_reserve("\n", pieces[0], pieces[1],
+                                            pieces[2], pieces[3], pieces[4],
+                                            pieces[5])
+                     << dendl;
+  }
+
+  /* Feed the string to sign piecewise into the HMAC keyed once for the
+   * whole upload rather than joining it into a temporary string. */
+  chunk_hmac.Restart();
+  for (size_t i = 0; i < std::size(pieces); ++i) {
+    if (i > 0) {
+      chunk_hmac.Update(reinterpret_cast<const unsigned char*>("\n"), 1);
+    }
+    chunk_hmac.Update(reinterpret_cast<const unsigned char*>(pieces[i].data()),
+                      pieces[i].size());
+  }
+  sha256_digest_t sig;
+  chunk_hmac.Final(sig.v);
 
   /* new chunk signature */
-  const auto sig = calc_hmac_sha256(signing_key, string_to_sign);
-  /* FIXME(rzarzynski): std::string here is really unnecessary. */
-  return sig.to_str();
+  using srv_signature_t = AWSEngine::VersionAbstractor::server_signature_t;
+  srv_signature_t signature(srv_signature_t::initialized_later(),
+                            sig.SIZE * 2);
+  buf_to_hex(sig.v, sig.SIZE, signature.begin());
+  return signature;
 }
 
 bool AWSv4ComplMulti::is_signature_mismatched()
@@ -1190,8 +1267,14 @@ bool AWSv4ComplMulti::is_signature_mismatched()
 
   /* The validity of previous chunk can be verified only after getting meta-
    * data of the next one. */
-  const auto payload_hash = calc_hash_sha256_restart_stream(&sha256_hash);
-  const auto calc_signature = calc_chunk_signature(payload_hash);
+  unsigned char payload_digest[CEPH_CRYPTO_SHA256_DIGESTSIZE];
+  sha256_hash->Final(payload_digest);
+  sha256_hash->Restart();
+  char payload_hash[CEPH_CRYPTO_SHA256_DIGESTSIZE * 2 + 1];
+  buf_to_hex(payload_digest, CEPH_CRYPTO_SHA256_DIGESTSIZE, payload_hash);
+
+  const auto calc_signature = calc_chunk_signature(
+    std::string_view(payload_hash, CEPH_CRYPTO_SHA256_DIGESTSIZE * 2));
 
   if (cct()->_conf->subsys.should_gather(ceph_subsys_rgw, 16)) [[unlikely]] {
     ldout(cct(), 16) << "AWSv4ComplMulti: declared signature="
@@ -1208,7 +1291,7 @@ bool AWSv4ComplMulti::is_signature_mismatched()
       return chunk_meta.get_signature() == prev_chunk_signature;
     }
     /* all other cases */
-    return chunk_meta.get_signature() == calc_signature;
+    return chunk_meta.get_signature() == std::string_view(calc_signature);
   };
 
   if (! match_signatures()) [[unlikely]] {
@@ -1510,16 +1593,8 @@ bool AWSv4ComplMulti::complete()
     return false;
   } else {
     /* now it's time to verify the signature of the last, zero-length chunk */
-    const auto string_to_sign = string_join_reserve("\n",
-    "AWS4-HMAC-SHA256-PAYLOAD",
-    date,
-    credential_scope,
-    prev_chunk_signature,
-    AWS4_EMPTY_PAYLOAD_HASH,
-    AWS4_EMPTY_PAYLOAD_HASH);
-
     const auto final_chunk_signature =
-      calc_hmac_sha256(signing_key, string_to_sign).to_str();
+      calc_chunk_signature(AWS4_EMPTY_PAYLOAD_HASH);
 
     ldout(cct(), 10) << "final chunk signature = "
 		     << final_chunk_signature
@@ -285,6 +285,8 @@ class AWSv4ComplMulti : public rgw::auth::Completer,
   const std::string_view credential_scope;
   const uint32_t flags;
   const signing_key_t signing_key;
+  /* keyed once with signing_key, restarted for every chunk signature */
+  ceph::crypto::HMACSHA256 chunk_hmac;
 
   class ChunkMeta {
     size_t data_offset_in_stream = 0;
@@ -359,7 +361,8 @@ class AWSv4ComplMulti : public rgw::auth::Completer,
   std::string prev_chunk_signature;
 
   bool is_signature_mismatched();
-  std::string calc_chunk_signature(const std::string& payload_hash) const;
+  AWSEngine::VersionAbstractor::server_signature_t
+  calc_chunk_signature(std::string_view payload_hash);
 
   struct ReceiveChunkResult {
     size_t received;
@@ -415,6 +418,7 @@ class AWSv4ComplMulti : public rgw::auth::Completer,
       credential_scope(std::move(credential_scope)),
       flags(_flags),
       signing_key(signing_key),
+      chunk_hmac(this->signing_key.v, this->signing_key.SIZE),
 
       /* The evolving state. */
       chunk_meta(ChunkMeta::create_first(
@@ -14,20 +14,38 @@
 #include <mutex>
 #include <map>
 #include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <set>
 
 #include "arrow/type.h"
 #include "arrow/buffer.h"
+#include "arrow/csv/reader.h"
 #include "arrow/io/interfaces.h"
+#include "arrow/io/memory.h"
 #include "arrow/ipc/reader.h"
+#include "arrow/ipc/writer.h"
 #include "arrow/table.h"
 
 #include "arrow/flight/server.h"
 
 #include "parquet/arrow/reader.h"
+#include "parquet/metadata.h"
+#include "parquet/statistics.h"
+
+#include <fmt/format.h>
 
 #include "common/dout.h"
+#include "include/encoding.h"
 #include "rgw_op.h"
 
+#ifdef WITH_RADOSGW_RADOS
+#include "driver/rados/rgw_sal_rados.h"
+#include "driver/rados/rgw_tools.h"
+#include "services/svc_zone.h"
+#endif
+
 #include "rgw_flight.h"
 #include "rgw_flight_frontend.h"
 
@@ -58,6 +76,81 @@ arw::Result<FlightKey> TicketToFlightKey(const flt::Ticket& t) {
   }
 }
 
+static arw::Result<FlightPredicate> ParsePredicate(std::string_view expr) {
+  static constexpr std::pair<std::string_view, FlightPredicate::Op> ops[] = {
+    // two-character operators first so "<=" is not taken for "<"
+    {"!=", FlightPredicate::Op::ne},
+    {"<=", FlightPredicate::Op::le},
+    {">=", FlightPredicate::Op::ge},
+    {"=", FlightPredicate::Op::eq},
+    {"<", FlightPredicate::Op::lt},
+    {">", FlightPredicate::Op::gt},
+  };
+
+  const auto pos = expr.find_first_of("!<>=");
+  if (pos == 0 || pos == std::string_view::npos) {
+    return arw::Status::Invalid("malformed predicate \"", expr, "\"");
+  }
+  for (const auto& [str, op] : ops) {
+    if (expr.substr(pos, str.size()) != str) {
+      continue;
+    }
+    const std::string value(expr.substr(pos + str.size()));
+    char* end = nullptr;
+    errno = 0;
+    const double v = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || errno == ERANGE) {
+      return arw::Status::Invalid("predicate value must be a number in \"",
+				  expr, "\"");
+    }
+    return FlightPredicate{std::string(expr.substr(0, pos)), op, v};
+  }
+  return arw::Status::Invalid("malformed predicate \"", expr, "\"");
+}
+
+arw::Result<FlightTicket> ParseTicket(const flt::Ticket& t) {
+  std::string_view rest = t.ticket;
+  auto pos = rest.find(';');
+
+  flt::Ticket key_only;
+  key_only.ticket = std::string(rest.substr(0, pos));
+  FlightTicket result;
+  ARROW_ASSIGN_OR_RAISE(result.key, TicketToFlightKey(key_only));
+
+  while (pos != std::string_view::npos) {
+    rest = rest.substr(pos + 1);
+    pos = rest.find(';');
+    const auto option = rest.substr(0, pos);
+    if (option.starts_with("columns=")) {
+      auto names = option.substr(sizeof("columns=") - 1);
+      for (auto comma = names.find(','); !names.empty();
+	   comma = names.find(',')) {
+	result.columns.emplace_back(names.substr(0, comma));
+	names = comma == std::string_view::npos ?
+	  std::string_view() : names.substr(comma + 1);
+      }
+    } else if (option.starts_with("where=")) {
+      ARROW_ASSIGN_OR_RAISE(result.predicate,
+			    ParsePredicate(option.substr(sizeof("where=") - 1)));
+    } else if (!option.empty()) {
+      return arw::Status::Invalid("unknown ticket option \"", option, "\"");
+    }
+  }
+  return result;
+}
+
+bool FlightPredicate::may_match(double min, double max) const {
+  switch (op) {
+  case Op::eq: return min <= value && value <= max;
+  case Op::ne: return !(min == value && max == value);
+  case Op::lt: return min < value;
+  case Op::le: return min <= value;
+  case Op::gt: return max > value;
+  case Op::ge: return max >= value;
+  }
+  return true;
+}
+
 // FlightData
 
 FlightData::FlightData(const std::string& _uri,
@@ -68,9 +161,11 @@ FlightData::FlightData(const std::string& _uri,
 		       uint64_t _obj_size,
 		       std::shared_ptr<arw::Schema>& _schema,
 		       std::shared_ptr<const arw::KeyValueMetadata>& _kv_metadata,
-		       rgw_user _user_id) :
+		       rgw_user _user_id,
+		       FlightFormat _format) :
   key(++next_flight_key),
-  /* expires(coarse_real_clock::now() + lifespan), */
+  expires(real_clock::now() + lifespan),
+  format(_format),
   uri(_uri),
   tenant_name(_tenant_name),
   bucket_name(_bucket_name),
@@ -82,6 +177,13 @@ FlightData::FlightData(const std::string& _uri,
   user_id(_user_id)
 { }
 
+FlightData::FlightData() :
+  key(null_flight_key),
+  format(FlightFormat::parquet),
+  num_records(0),
+  obj_size(0)
+{ }
+
 /**** FlightStore ****/
 
 FlightStore::FlightStore(const DoutPrefix& _dp) :
@@ -142,6 +244,247 @@ int MemoryFlightStore::expire_flights() {
   return 0;
 }
 
+#ifdef WITH_RADOSGW_RADOS
+
+/**** RadosFlightStore ****/
+
+// the schema travels in the arrow IPC format, everything else in the
+// usual ceph encoding
+static arw::Status encode_flight(const FlightData& fd, bufferlist& bl) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arw::Buffer> schema,
+			arw::ipc::SerializeSchema(*fd.schema));
+  std::vector<std::string> kv_keys, kv_values;
+  if (fd.kv_metadata) {
+    kv_keys = fd.kv_metadata->keys();
+    kv_values = fd.kv_metadata->values();
+  }
+
+  using ceph::encode;
+  ENCODE_START(1, 1, bl);
+  encode(fd.key, bl);
+  encode(fd.expires, bl);
+  encode(static_cast<uint8_t>(fd.format), bl);
+  encode(fd.uri, bl);
+  encode(fd.tenant_name, bl);
+  encode(fd.bucket_name, bl);
+  encode(fd.object_key, bl);
+  encode(fd.num_records, bl);
+  encode(fd.obj_size, bl);
+  encode(schema->ToString(), bl);
+  encode(kv_keys, bl);
+  encode(kv_values, bl);
+  encode(fd.user_id, bl);
+  ENCODE_FINISH(bl);
+  return arw::Status::OK();
+}
+
+static arw::Result<FlightData> decode_flight(const bufferlist& bl) {
+  FlightData fd;
+  std::string schema;
+  std::vector<std::string> kv_keys, kv_values;
+  try {
+    using ceph::decode;
+    auto p = bl.cbegin();
+    DECODE_START(1, p);
+    uint8_t format;
+    decode(fd.key, p);
+    decode(fd.expires, p);
+    decode(format, p);
+    fd.format = static_cast<FlightFormat>(format);
+    decode(fd.uri, p);
+    decode(fd.tenant_name, p);
+    decode(fd.bucket_name, p);
+    decode(fd.object_key, p);
+    decode(fd.num_records, p);
+    decode(fd.obj_size, p);
+    decode(schema, p);
+    decode(kv_keys, p);
+    decode(kv_values, p);
+    decode(fd.user_id, p);
+    DECODE_FINISH(p);
+  } catch (const buffer::error& e) {
+    return arw::Status::IOError("could not decode flight: ", e.what());
+  }
+
+  arw::io::BufferReader schema_reader(arw::Buffer::FromString(std::move(schema)));
+  arw::ipc::DictionaryMemo memo;
+  ARROW_ASSIGN_OR_RAISE(fd.schema, arw::ipc::ReadSchema(&schema_reader, &memo));
+  if (!kv_keys.empty()) {
+    fd.kv_metadata = std::make_shared<const arw::KeyValueMetadata>(
+      std::move(kv_keys), std::move(kv_values));
+  }
+  return fd;
+}
+
+RadosFlightStore::RadosFlightStore(const DoutPrefix& _dp) :
+  FlightStore(_dp)
+{ }
+
+RadosFlightStore::~RadosFlightStore() { }
+
+int RadosFlightStore::init(rgw::sal::RadosStore* store) {
+  const rgw_pool& log_pool = store->svc()->zone->get_zone_params().log_pool;
+  int ret = rgw_init_ioctx(&dp, store->getRados()->get_rados_handle(),
+			   log_pool, ioctx, true, true);
+  if (ret < 0) {
+    ERROR << "failed to open log pool " << log_pool << ", ret=" << ret << dendl;
+    return ret;
+  }
+  next_expire = real_clock::now() + lifespan;
+  return 0;
+}
+
+// zero padded so that omap order is key order
+std::string RadosFlightStore::omap_key(const FlightKey& key) {
+  return fmt::format("{:010}", key);
+}
+
+FlightKey RadosFlightStore::allocate_key() {
+  // any write bumps the object version; the 32 low bits of the new
+  // version are unique until the counter wraps around
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    librados::ObjectWriteOperation op;
+    op.create(false);
+    op.setxattr("flight.seq", bufferlist());
+    version_t ver = 0;
+    int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op),
+				null_yield, 0, nullptr, &ver);
+    if (ret < 0) {
+      ERROR << "failed to allocate a flight key, ret=" << ret << dendl;
+      return null_flight_key;
+    }
+    const FlightKey key = static_cast<FlightKey>(ver);
+    if (key != null_flight_key) {
+      return key;
+    }
+  }
+  return null_flight_key;
+}
+
+FlightKey RadosFlightStore::add_flight(FlightData&& flight) {
+  {
+    std::unique_lock lock(expire_mtx);
+    if (real_clock::now() >= next_expire) {
+      next_expire = real_clock::now() + lifespan;
+      lock.unlock();
+      (void) expire_flights();
+    }
+  }
+
+  flight.key = allocate_key();
+  if (flight.key == null_flight_key) {
+    return null_flight_key;
+  }
+
+  bufferlist bl;
+  auto s = encode_flight(flight, bl);
+  if (!s.ok()) {
+    ERROR << "failed to encode flight " << flight.key << ": " << s << dendl;
+    return null_flight_key;
+  }
+
+  librados::ObjectWriteOperation op;
+  op.omap_set({{omap_key(flight.key), std::move(bl)}});
+  int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op), null_yield);
+  if (ret < 0) {
+    ERROR << "failed to store flight " << flight.key << ", ret=" << ret << dendl;
+    return null_flight_key;
+  }
+  return flight.key;
+}
+
+arw::Result<FlightData> RadosFlightStore::get_flight(const FlightKey& key) const {
+  std::map<std::string, bufferlist> vals;
+  int rval = 0;
+  librados::ObjectReadOperation op;
+  op.omap_get_vals_by_keys({omap_key(key)}, &vals, &rval);
+  int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op), nullptr,
+			      null_yield);
+  if (ret < 0 && ret != -ENOENT) {
+    return arw::Status::IOError("could not read Flight with Key ", key,
+				", error code: ", ret);
+  }
+  if (vals.empty()) {
+    return arw::Status::KeyError("could not find Flight with Key ", key);
+  }
+  return decode_flight(vals.begin()->second);
+}
+
+std::optional<FlightData> RadosFlightStore::after_key(const FlightKey& key) const {
+  std::map<std::string, bufferlist> vals;
+  bool more = false;
+  int rval = 0;
+  librados::ObjectReadOperation op;
+  op.omap_get_vals2(omap_key(key), 1, &vals, &more, &rval);
+  int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op), nullptr,
+			      null_yield);
+  if (ret < 0 || vals.empty()) {
+    if (ret < 0 && ret != -ENOENT) {
+      ERROR << "failed to list flights, ret=" << ret << dendl;
+    }
+    return std::nullopt;
+  }
+  auto fd = decode_flight(vals.begin()->second);
+  if (!fd.ok()) {
+    ERROR << "skipping flight " << vals.begin()->first << ": " <<
+      fd.status() << dendl;
+    return std::nullopt;
+  }
+  return std::move(fd).ValueUnsafe();
+}
+
+int RadosFlightStore::remove_flight(const FlightKey& key) {
+  librados::ObjectWriteOperation op;
+  op.omap_rm_keys({omap_key(key)});
+  int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op), null_yield);
+  return ret == -ENOENT ? 0 : ret;
+}
+
+// returns the number of flights removed or a negative error code
+int RadosFlightStore::expire_flights() {
+  static constexpr uint64_t page = 1000;
+  const auto now = real_clock::now();
+  std::string marker;
+  std::set<std::string> expired;
+  bool more = true;
+  while (more) {
+    std::map<std::string, bufferlist> vals;
+    int rval = 0;
+    librados::ObjectReadOperation op;
+    op.omap_get_vals2(marker, page, &vals, &more, &rval);
+    int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op), nullptr,
+				null_yield);
+    if (ret == -ENOENT) {
+      return 0;
+    } else if (ret < 0) {
+      return ret;
+    }
+    for (const auto& [k, bl] : vals) {
+      auto fd = decode_flight(bl);
+      if (!fd.ok() || fd->expires <= now) {
+	expired.insert(k);
+      }
+    }
+    if (!vals.empty()) {
+      marker = vals.rbegin()->first;
+    }
+  }
+
+  if (expired.empty()) {
+    return 0;
+  }
+  librados::ObjectWriteOperation op;
+  op.omap_rm_keys(expired);
+  int ret = rgw_rados_operate(&dp, ioctx, index_oid, std::move(op), null_yield);
+  if (ret < 0) {
+    return ret;
+  }
+  STATUS << "expired " << expired.size() << " flights" << dendl;
+  return expired.size();
+}
+
+#endif // WITH_RADOSGW_RADOS
+
 /**** FlightServer ****/
 
 FlightServer::FlightServer(RGWProcessEnv& _env,
@@ -151,7 +494,14 @@ FlightServer::FlightServer(RGWProcessEnv& _env,
   driver(env.driver),
   dp(_dp),
   flight_store(_flight_store)
-{ }
+{
+  const auto io_threads =
+    dp.get_cct()->_conf.get_val<uint64_t>("rgw_flight_io_threads");
+  auto s = arw::io::SetIOThreadPoolCapacity(io_threads);
+  if (!s.ok()) {
+    WARN << "could not size the arrow io thread pool; status=" << s << dendl;
+  }
+}
 
 FlightServer::~FlightServer()
 { }
@@ -499,34 +849,87 @@ public:
 }; // class LocalRandomAccessFile
 #endif
 
+// An arrow Buffer over the data of a bufferlist. RADOS reads that stay
+// within one stripe come back as a single segment, and are handed to
+// arrow without copying; only ranges spanning stripes are flattened.
+class BufferlistBuffer : public arw::Buffer {
+
+  bufferlist bl;
+
+  BufferlistBuffer(bufferlist&& _bl, const char* data) :
+    Buffer(reinterpret_cast<const uint8_t*>(data), _bl.length()),
+    bl(std::move(_bl))
+    { }
+
+public:
+
+  static std::shared_ptr<arw::Buffer> make(bufferlist&& bl) {
+    // moving the bufferlist keeps the underlying raw buffers in place
+    const char* data = bl.c_str();
+    return std::shared_ptr<arw::Buffer>(new BufferlistBuffer(std::move(bl), data));
+  }
+}; // class BufferlistBuffer
+
 class RandomAccessObject : public arw::io::RandomAccessFile {
 
+  // ReadOps carry per-read state, so each concurrent ReadAt() from the
+  // arrow io thread pool gets one of its own; they are reused across reads
+  struct Reader {
+    std::unique_ptr<rgw::sal::Object> obj;
+    std::unique_ptr<rgw::sal::Object::ReadOp> op;
+  };
+
   FlightData flight_data;
   const DoutPrefix dp;
+  std::shared_ptr<rgw::sal::Bucket> bucket;
 
   int64_t position;
   bool is_closed;
-  std::unique_ptr<rgw::sal::Object::ReadOp> op;
+
+  std::mutex readers_mtx; // for idle_readers
+  std::vector<std::unique_ptr<Reader>> idle_readers;
+
+  arw::Result<std::unique_ptr<Reader>> get_reader() {
+    {
+      const std::lock_guard lock(readers_mtx);
+      if (!idle_readers.empty()) {
+	auto reader = std::move(idle_readers.back());
+	idle_readers.pop_back();
+	return reader;
+      }
+    }
+
+    auto reader = std::make_unique<Reader>();
+    reader->obj = bucket->get_object(flight_data.object_key);
+    reader->op = reader->obj->get_read_op();
+    int ret = reader->op->prepare(null_yield, &dp);
+    if (ret < 0) {
+      return arw::Status::IOError(
+	"unable to prepare object with error ", ret);
+    }
+    return reader;
+  }
+
+  void put_reader(std::unique_ptr<Reader> reader) {
+    const std::lock_guard lock(readers_mtx);
+    idle_readers.push_back(std::move(reader));
+  }
 
 public:
 
   RandomAccessObject(const FlightData& _flight_data,
-		     std::unique_ptr<rgw::sal::Object>& obj,
+		     std::shared_ptr<rgw::sal::Bucket> _bucket,
 		     const DoutPrefix _dp) :
     flight_data(_flight_data),
     dp(_dp),
+    bucket(std::move(_bucket)),
     position(-1),
     is_closed(false)
-    {
-      op = obj->get_read_op();
-    }
+    { }
 
   arw::Status Open() {
-    int ret = op->prepare(null_yield, &dp);
-    if (ret < 0) {
-      return arw::Status::IOError(
-	"unable to prepare object with error %d", ret);
-    }
+    ARROW_ASSIGN_OR_RAISE(auto reader, get_reader());
+    put_reader(std::move(reader));
     INFO << "file opened successfully" << dendl;
     position = 0;
     return arw::Status::OK();
@@ -537,7 +940,10 @@ public:
   arw::Status Close() override {
     position = -1;
     is_closed = true;
-    (void) op.reset();
+    {
+      const std::lock_guard lock(readers_mtx);
+      idle_readers.clear();
+    }
     INFO << "object closed" << dendl;
     return arw::Status::OK();
   }
@@ -554,60 +960,76 @@ public:
     return is_closed;
   }
 
-  arw::Result<int64_t> Read(int64_t nbytes, void* out) override {
-    INFO << "entered: asking for " << nbytes << " bytes" << dendl;
+  // implement RandomAccessFile; safe to call concurrently
 
-    if (position < 0) {
-      ERROR << "error, position indicated error" << dendl;
-      return arw::Status::IOError("object read op is in bad state");
+  arw::Result<std::shared_ptr<arw::Buffer>> ReadAt(int64_t offset,
+						   int64_t nbytes) override {
+    INFO << "entered: asking for " << nbytes << " bytes at " << offset << dendl;
+
+    const int64_t size = flight_data.obj_size;
+    if (offset < 0 || nbytes < 0) {
+      return arw::Status::Invalid("invalid read of ", nbytes, " bytes at ",
+				  offset);
     }
+    nbytes = std::min(nbytes, std::max<int64_t>(size - offset, 0));
 
-    // note: read function reads through end_position inclusive
-    int64_t end_position = position + nbytes - 1;
+    ARROW_ASSIGN_OR_RAISE(auto reader, get_reader());
 
+    // a single read never crosses a stripe, so loop for larger ranges
     bufferlist bl;
-
-    const int64_t bytes_read =
-      op->read(position, end_position, bl, null_yield, &dp);
-    if (bytes_read < 0) {
-      const int64_t former_position = position;
-      position = -1;
-      ERROR << "read operation returned " << bytes_read << dendl;
-      return arw::Status::IOError(
-	"unable to read object at position %" PRId64 ", error code: %" PRId64,
-	former_position,
-	bytes_read);
+    while (static_cast<int64_t>(bl.length()) < nbytes) {
+      const int64_t ofs = offset + bl.length();
+      // note: read function reads through end inclusive
+      const int64_t end = offset + nbytes - 1;
+      bufferlist part;
+      const int64_t bytes_read = reader->op->read(ofs, end, part, null_yield, &dp);
+      if (bytes_read < 0) {
+	ERROR << "read operation returned " << bytes_read << dendl;
+	return arw::Status::IOError(
+	  "unable to read object at position ", ofs,
+	  ", error code: ", bytes_read);
+      } else if (bytes_read == 0) {
+	break;
+      }
+      bl.claim_append(part);
     }
+    put_reader(std::move(reader));
 
-    // TODO: see if there's a way to get rid of this copy, perhaps
-    // updating rgw::sal::read_op
-    bl.cbegin().copy(bytes_read, reinterpret_cast<char*>(out));
+    INFO << bl.length() << " bytes read in " << bl.get_num_buffers() <<
+      " segments" << dendl;
+    return BufferlistBuffer::make(std::move(bl));
+  }
 
-    position += bytes_read;
+  arw::Result<int64_t> ReadAt(int64_t offset, int64_t nbytes,
+			      void* out) override {
+    ARROW_ASSIGN_OR_RAISE(auto buffer, ReadAt(offset, nbytes));
+    std::memcpy(out, buffer->data(), buffer->size());
+    return buffer->size();
+  }
 
-    if (nbytes != bytes_read) {
-      INFO << "partial read: nbytes=" << nbytes <<
-	", bytes_read=" << bytes_read << dendl;
+  arw::Result<int64_t> Read(int64_t nbytes, void* out) override {
+    if (position < 0) {
+      ERROR << "error, position indicated error" << dendl;
+      return arw::Status::IOError("object read op is in bad state");
     }
-    INFO << bytes_read << " bytes read" << dendl;
+    ARROW_ASSIGN_OR_RAISE(const int64_t bytes_read,
+			  ReadAt(position, nbytes, out));
+    position += bytes_read;
     return bytes_read;
   }
 
   arw::Result<std::shared_ptr<arw::Buffer>> Read(int64_t nbytes) override {
-    INFO << "entered: asking for " << nbytes << " bytes" << dendl;
-
-    std::shared_ptr<OwnedBuffer> buffer;
-    ARROW_ASSIGN_OR_RAISE(buffer, OwnedBuffer::make(nbytes));
-
-    ARROW_ASSIGN_OR_RAISE(const int64_t bytes_read,
-			  Read(nbytes, buffer->writeable_data()));
-    buffer->set_size(bytes_read);
-
+    if (position < 0) {
+      ERROR << "error, position indicated error" << dendl;
+      return arw::Status::IOError("object read op is in bad state");
+    }
+    ARROW_ASSIGN_OR_RAISE(auto buffer, ReadAt(position, nbytes));
+    position += buffer->size();
     return buffer;
   }
 
   bool supports_zero_copy() const override {
-    return false;
+    return true;
   }
 
   // implement Seekable
@@ -620,16 +1042,16 @@ public:
   arw::Result<std::string_view> Peek(int64_t nbytes) override {
     INFO << "entered: " << nbytes << " bytes" << dendl;
 
-    int64_t saved_position = position;
+    if (position < 0) {
+      ERROR << "error, position indicated error" << dendl;
+      return arw::Status::IOError("object read op is in bad state");
+    }
 
     ARROW_ASSIGN_OR_RAISE(OwningStringView buffer,
 			  OwningStringView::make(nbytes));
 
     ARROW_ASSIGN_OR_RAISE(const int64_t bytes_read,
-			  Read(nbytes, (void*) buffer.writeable_data()));
-
-    // restore position for a peek
-    position = saved_position;
+			  ReadAt(position, nbytes, (void*) buffer.writeable_data()));
 
     if (bytes_read < nbytes) {
       // create new OwningStringView with moved buffer
@@ -662,13 +1084,154 @@ public:
   }
 }; // class RandomAccessObject
 
+// parquet: only the requested columns of the row groups that may match
+// the predicate are read. Column chunks are prefetched concurrently on
+// the arrow io thread pool, in ranges of at most one RADOS stripe.
+static arw::Result<std::shared_ptr<arw::RecordBatchReader>>
+make_parquet_reader(std::shared_ptr<RandomAccessObject> input,
+		    const FlightTicket& ticket,
+		    int64_t stripe_size,
+		    const DoutPrefix& dp) {
+  parquet::ArrowReaderProperties props = parquet::default_arrow_reader_properties();
+  props.set_pre_buffer(true);
+  props.set_use_threads(true);
+  auto cache_options = arw::io::CacheOptions::Defaults();
+  cache_options.range_size_limit = stripe_size;
+  props.set_cache_options(cache_options);
+
+  parquet::arrow::FileReaderBuilder builder;
+  ARROW_RETURN_NOT_OK(builder.Open(input));
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  ARROW_RETURN_NOT_OK(builder.properties(props)->
+		      memory_pool(arw::default_memory_pool())->
+		      Build(&reader));
+
+  const auto metadata = reader->parquet_reader()->metadata();
+  const parquet::SchemaDescriptor* schema = metadata->schema();
+
+  std::vector<int> columns;
+  if (ticket.columns.empty()) {
+    for (int i = 0; i < schema->num_columns(); ++i) {
+      columns.push_back(i);
+    }
+  } else {
+    for (const auto& name : ticket.columns) {
+      const int i = schema->ColumnIndex(name);
+      if (i < 0) {
+	return arw::Status::KeyError("no column named \"", name, "\"");
+      }
+      columns.push_back(i);
+    }
+  }
+
+  std::vector<int> row_groups;
+  int pred_column = -1;
+  if (ticket.predicate) {
+    pred_column = schema->ColumnIndex(ticket.predicate->column);
+    if (pred_column < 0) {
+      return arw::Status::KeyError("no column named \"",
+				   ticket.predicate->column, "\"");
+    }
+    if (schema->Column(pred_column)->sort_order() != parquet::SortOrder::SIGNED) {
+      // statistics of unsigned or byte array columns can't be compared
+      // with a number
+      pred_column = -1;
+    }
+  }
+  for (int rg = 0; rg < metadata->num_row_groups(); ++rg) {
+    if (pred_column >= 0) {
+      const auto chunk = metadata->RowGroup(rg)->ColumnChunk(pred_column);
+      const auto stats = chunk->statistics();
+      if (stats && stats->HasMinMax()) {
+	bool keep = true;
+	switch (stats->physical_type()) {
+	case parquet::Type::INT32: {
+	  auto s = std::static_pointer_cast<parquet::Int32Statistics>(stats);
+	  keep = ticket.predicate->may_match(s->min(), s->max());
+	  break;
+	}
+	case parquet::Type::INT64: {
+	  auto s = std::static_pointer_cast<parquet::Int64Statistics>(stats);
+	  keep = ticket.predicate->may_match(s->min(), s->max());
+	  break;
+	}
+	case parquet::Type::FLOAT: {
+	  auto s = std::static_pointer_cast<parquet::FloatStatistics>(stats);
+	  keep = ticket.predicate->may_match(s->min(), s->max());
+	  break;
+	}
+	case parquet::Type::DOUBLE: {
+	  auto s = std::static_pointer_cast<parquet::DoubleStatistics>(stats);
+	  keep = ticket.predicate->may_match(s->min(), s->max());
+	  break;
+	}
+	default:
+	  break;
+	}
+	if (!keep) {
+	  continue;
+	}
+      }
+    }
+    row_groups.push_back(rg);
+  }
+  STATUS << "reading " << row_groups.size() << " of " <<
+    metadata->num_row_groups() << " row groups, " << columns.size() <<
+    " of " << schema->num_columns() << " columns" << dendl;
+
+  std::unique_ptr<arw::RecordBatchReader> batch_reader;
+  ARROW_RETURN_NOT_OK(reader->GetRecordBatchReader(row_groups, columns,
+						   &batch_reader));
+
+  // the batch reader refers to the file reader, keep it alive alongside
+  class OwningReader : public arw::RecordBatchReader {
+    std::unique_ptr<parquet::arrow::FileReader> file_reader;
+    std::unique_ptr<arw::RecordBatchReader> batch_reader;
+  public:
+    OwningReader(std::unique_ptr<parquet::arrow::FileReader> f,
+		 std::unique_ptr<arw::RecordBatchReader> b) :
+      file_reader(std::move(f)), batch_reader(std::move(b))
+      { }
+    std::shared_ptr<arw::Schema> schema() const override {
+      return batch_reader->schema();
+    }
+    arw::Status ReadNext(std::shared_ptr<arw::RecordBatch>* batch) override {
+      return batch_reader->ReadNext(batch);
+    }
+  };
+  return std::make_shared<OwningReader>(std::move(reader),
+					std::move(batch_reader));
+}
+
+// csv: parsed block by block as it streams in, one stripe per block
+static arw::Result<std::shared_ptr<arw::RecordBatchReader>>
+make_csv_reader(std::shared_ptr<RandomAccessObject> input,
+		const FlightTicket& ticket,
+		int64_t stripe_size,
+		const DoutPrefix& dp) {
+  if (ticket.predicate) {
+    WARN << "predicates are not pushed down into csv objects" << dendl;
+  }
+  auto read_options = arw::csv::ReadOptions::Defaults();
+  read_options.use_threads = true;
+  read_options.block_size = stripe_size;
+  auto convert_options = arw::csv::ConvertOptions::Defaults();
+  convert_options.include_columns = ticket.columns;
+
+  ARROW_ASSIGN_OR_RAISE(auto reader,
+			arw::csv::StreamingReader::Make(
+			  arw::io::default_io_context(), input, read_options,
+			  arw::csv::ParseOptions::Defaults(), convert_options));
+  return reader;
+}
+
 arw::Status FlightServer::DoGet(const flt::ServerCallContext &context,
 				const flt::Ticket &request,
 				std::unique_ptr<flt::FlightDataStream> *stream) {
   int ret;
 
-  ARROW_ASSIGN_OR_RAISE(FlightKey key, TicketToFlightKey(request));
-  ARROW_ASSIGN_OR_RAISE(FlightData fd, get_flight_store()->get_flight(key));
+  ARROW_ASSIGN_OR_RAISE(FlightTicket ticket, ParseTicket(request));
+  ARROW_ASSIGN_OR_RAISE(FlightData fd, get_flight_store()->get_flight(ticket.key));
 
 #if 0
   /* load_bucket no longer requires a user parameter. Keep this code
@@ -695,38 +1258,33 @@ arw::Status FlightServer::DoGet(const flt::ServerCallContext &context,
                             &bucket, null_yield);
   if (ret < 0) {
     ERROR << "get_bucket returned " << ret << dendl;
-    // TODO return something
+    return arw::Status::IOError("unable to load bucket ", fd.bucket_name,
+				", error code: ", ret);
   }
 
-  std::unique_ptr<rgw::sal::Object> object = bucket->get_object(fd.object_key);
-
-  auto input = std::make_shared<RandomAccessObject>(fd, object, dp);
+  auto input = std::make_shared<RandomAccessObject>(fd, std::move(bucket), dp);
   ARROW_RETURN_NOT_OK(input->Open());
 
-  std::unique_ptr<parquet::arrow::FileReader> reader;
-  ARROW_RETURN_NOT_OK(parquet::arrow::OpenFile(input,
-					       arw::default_memory_pool(),
-					       &reader));
-
-  std::shared_ptr<arrow::Table> table;
-  ARROW_RETURN_NOT_OK(reader->ReadTable(&table));
-
-  std::vector<std::shared_ptr<arw::RecordBatch>> batches;
-  arw::TableBatchReader batch_reader(*table);
-  while (true) {
-    std::shared_ptr<arw::RecordBatch> p;
-    auto s = batch_reader.ReadNext(&p);
-    if (!s.ok()) {
-      break;
-    }
-    batches.push_back(p);
+  const int64_t stripe_size =
+    dp.get_cct()->_conf.get_val<Option::size_t>("rgw_obj_stripe_size");
+
+  std::shared_ptr<arw::RecordBatchReader> batch_reader;
+  switch (fd.format) {
+  case FlightFormat::csv:
+    ARROW_ASSIGN_OR_RAISE(batch_reader,
+			  make_csv_reader(input, ticket, stripe_size, dp));
+    break;
+  case FlightFormat::parquet:
+  default:
+    ARROW_ASSIGN_OR_RAISE(batch_reader,
+			  make_parquet_reader(input, ticket, stripe_size, dp));
+    break;
   }
 
-  ARROW_ASSIGN_OR_RAISE(auto owning_reader,
-			arw::RecordBatchReader::Make(
-			  std::move(batches), table->schema()));
+  // batches are produced as the stream is consumed rather than
+  // materializing the whole table first
   *stream = std::unique_ptr<flt::FlightDataStream>(
-    new flt::RecordBatchStream(owning_reader));
+    new flt::RecordBatchStream(batch_reader));
 
   return arw::Status::OK();
 } // flightServer::DoGet
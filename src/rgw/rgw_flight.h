@@ -14,6 +14,8 @@
 #include <map>
 #include <mutex>
 #include <atomic>
+#include <optional>
+#include <vector>
 
 #include "include/common_fwd.h"
 #include "common/ceph_context.h"
@@ -23,6 +25,10 @@
 #include "arrow/type.h"
 #include "arrow/flight/server.h"
 
+#ifdef WITH_RADOSGW_RADOS
+#include "include/rados/librados.hpp"
+#endif
+
 #include "rgw_flight_frontend.h"
 
 
@@ -43,13 +49,23 @@ namespace flt = arrow::flight;
 
 struct req_state;
 
+namespace rgw::sal {
+class RadosStore;
+}
+
 namespace rgw::flight {
 
 static const coarse_real_clock::duration lifespan = std::chrono::hours(1);
 
+enum class FlightFormat : uint8_t {
+  parquet = 0,
+  csv = 1,
+};
+
 struct FlightData {
   FlightKey key;
-  // coarse_real_clock::time_point expires;
+  ceph::real_time expires;
+  FlightFormat format;
   std::string uri;
   std::string tenant_name;
   std::string bucket_name;
@@ -71,7 +87,11 @@ struct FlightData {
 	     uint64_t _obj_size,
 	     std::shared_ptr<arw::Schema>& _schema,
 	     std::shared_ptr<const arw::KeyValueMetadata>& _kv_metadata,
-	     rgw_user _user_id);
+	     rgw_user _user_id,
+	     FlightFormat _format = FlightFormat::parquet);
+
+  // used when decoding a flight from a persistent FlightStore
+  FlightData();
 };
 
 // stores flights that have been created and helps expire them
@@ -111,6 +131,61 @@ public:
   int expire_flights() override;
 };
 
+#ifdef WITH_RADOSGW_RADOS
+// Keeps flights in the omap of a single object in the zone's log pool,
+// one entry per flight, so that flights outlive the radosgw that created
+// them. Flight keys come from the version of that object, which RADOS
+// bumps atomically, so several radosgws can share the store.
+class RadosFlightStore : public FlightStore {
+  static constexpr const char* index_oid = "flight.index";
+
+  mutable librados::IoCtx ioctx;
+
+  std::mutex expire_mtx;
+  ceph::real_time next_expire;
+
+  static std::string omap_key(const FlightKey& key);
+  FlightKey allocate_key();
+
+public:
+
+  RadosFlightStore(const DoutPrefix& dp);
+  virtual ~RadosFlightStore();
+  int init(rgw::sal::RadosStore* store);
+
+  FlightKey add_flight(FlightData&& flight) override;
+  arw::Result<FlightData> get_flight(const FlightKey& key) const override;
+  std::optional<FlightData> after_key(const FlightKey& key) const override;
+  int remove_flight(const FlightKey& key) override;
+  int expire_flights() override;
+};
+#endif // WITH_RADOSGW_RADOS
+
+// What a DoGet asks for. A ticket is the flight key, optionally followed
+// by ';'-separated options:
+//   columns=<name>[,<name>...]   only return these columns
+//   where=<column><op><number>   with op one of = != < <= > >=; parquet
+//                                row groups whose statistics show that no
+//                                row can match are not read at all
+// Pruning is per row group, so rows that do not match the predicate may
+// still be returned.
+struct FlightPredicate {
+  enum class Op { eq, ne, lt, le, gt, ge };
+
+  std::string column;
+  Op op;
+  double value;
+
+  // true unless no value in [min, max] can satisfy the predicate
+  bool may_match(double min, double max) const;
+};
+
+struct FlightTicket {
+  FlightKey key;
+  std::vector<std::string> columns;
+  std::optional<FlightPredicate> predicate;
+};
+
 class FlightServer : public flt::FlightServerBase {
 
   using Data1 = std::vector<std::shared_ptr<arw::RecordBatch>>;
@@ -223,5 +298,6 @@ public:
 
 flt::Ticket FlightKeyToTicket(const FlightKey& key);
 arw::Status TicketToFlightKey(const flt::Ticket& t, FlightKey& key);
+arw::Result<FlightTicket> ParseTicket(const flt::Ticket& t);
 
 } // namespace rgw::flight
@@ -13,7 +13,10 @@
 #include <filesystem>
 #include <sstream>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include "arrow/type.h"
+#include "arrow/csv/reader.h"
 #include "arrow/flight/server.h"
 #include "arrow/io/file.h"
 
@@ -24,6 +27,10 @@
 #include "rgw_flight_frontend.h"
 #include "rgw_flight.h"
 
+#ifdef WITH_RADOSGW_RADOS
+#include "driver/rados/rgw_sal_rados.h"
+#endif
+
 
 // logging
 constexpr unsigned dout_subsys = ceph_subsys_rgw_flight;
@@ -42,7 +49,23 @@ FlightFrontend::FlightFrontend(RGWProcessEnv& _env,
   port(_port),
   dp(env.driver->ctx(), dout_subsys, dout_prefix_str)
 {
-  env.flight_store = new MemoryFlightStore(dp);
+#ifdef WITH_RADOSGW_RADOS
+  const auto store_type =
+    env.driver->ctx()->_conf.get_val<std::string>("rgw_flight_store");
+  auto rados = dynamic_cast<rgw::sal::RadosStore*>(env.driver);
+  if (store_type == "rados" && rados) {
+    auto store = new RadosFlightStore(dp);
+    if (store->init(rados) == 0) {
+      env.flight_store = store;
+    } else {
+      WARN << "falling back to keeping flights in memory" << dendl;
+      delete store;
+    }
+  }
+#endif
+  if (!env.flight_store) {
+    env.flight_store = new MemoryFlightStore(dp);
+  }
   env.flight_server = new FlightServer(env, env.flight_store, dp);
   INFO << "flight server started" << dendl;
 }
@@ -191,6 +214,9 @@ int FlightGetObj_Filter::handle_data(bufferlist& bl,
       std::shared_ptr<const arw::KeyValueMetadata> kv_metadata;
       std::shared_ptr<arw::Schema> aw_schema;
       int64_t num_rows = 0;
+      const FlightFormat format =
+	boost::algorithm::iends_with(object_key.name, ".csv") ?
+	FlightFormat::csv : FlightFormat::parquet;
 
       auto process_metadata = [&aw_schema, &num_rows, &kv_metadata, this]() -> arrow::Status {
 	ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::ReadableFile> file,
@@ -207,7 +233,24 @@ int FlightGetObj_Filter::handle_data(bufferlist& bl,
 	return arrow::Status::OK();
       };
 
-      schema_status = process_metadata();
+      // csv carries no metadata; the schema is inferred from the first
+      // block and the number of rows is unknown
+      auto process_csv_header = [&aw_schema, &num_rows, this]() -> arrow::Status {
+	ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::ReadableFile> file,
+			      arrow::io::ReadableFile::Open(temp_file_name));
+	ARROW_ASSIGN_OR_RAISE(auto reader,
+			      arrow::csv::StreamingReader::Make(
+				arrow::io::default_io_context(), file,
+				arrow::csv::ReadOptions::Defaults(),
+				arrow::csv::ParseOptions::Defaults(),
+				arrow::csv::ConvertOptions::Defaults()));
+	aw_schema = reader->schema();
+	num_rows = -1;
+	return file->Close();
+      };
+
+      schema_status = format == FlightFormat::csv ?
+	process_csv_header() : process_metadata();
       if (!schema_status.ok()) {
 	ERROR << "reading metadata to access schema, error=" << schema_status << dendl;
       } else {
@@ -217,7 +260,7 @@ int FlightGetObj_Filter::handle_data(bufferlist& bl,
 	  store->add_flight(FlightData(uri, tenant_name, bucket_name,
 				       object_key, num_rows,
 				       expected_size, aw_schema,
-				       kv_metadata, user_id));
+				       kv_metadata, user_id, format));
 	(void) key; // suppress unused variable warning
       }
     } // if last block
@@ -26,10 +26,12 @@ static inline void buf_to_hex(const unsigned char* const buf,
                               const size_t len,
                               char* const str)
 {
-  str[0] = '\0';
+  static constexpr char digits[] = "0123456789abcdef";
   for (size_t i = 0; i < len; i++) {
-    ::sprintf(&str[i*2], "%02x", static_cast<int>(buf[i]));
+    str[i*2] = digits[buf[i] >> 4];
+    str[i*2 + 1] = digits[buf[i] & 0xf];
   }
+  str[len*2] = '\0';
 }
 
 template<size_t N> static inline std::array<char, N * 2 + 1>
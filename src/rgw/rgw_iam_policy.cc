@@ -1197,6 +1197,14 @@ Effect Statement::eval(const Environment& e,
 		       boost::optional<const rgw::auth::Identity&> ida,
 		       uint64_t act, boost::optional<const ARN&> res, boost::optional<PolicyPrincipal&> princ_type) const {
 
+  // The action test is a bit lookup and rejects most statements of a large
+  // policy before any principal or ARN matching. It can't go first when the
+  // caller asks for princ_type, which eval_principal() sets for every
+  // statement visited.
+  if (!princ_type && (!(action[act] == 1) || (notaction[act] == 1))) {
+    return Effect::Pass;
+  }
+
   if (eval_principal(e, ida, princ_type) == Effect::Deny) {
     return Effect::Pass;
   }
@@ -6,6 +6,9 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/defer.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/spawn.hpp>
 #include <fstream>
 
 #include "common/errno.h"
@@ -144,6 +147,9 @@ int Service::get_admin_token(const DoutPrefixProvider *dpp,
     ldpp_dout(dpp, 20) << "found cached admin token" << dendl;
     token = t.token.id;
     token_cached = true;
+    if (token_cache.begin_admin_refresh(t)) {
+      refresh_admin_token(dpp, token_cache, config, y);
+    }
     return 0;
   }
 
@@ -157,6 +163,37 @@ int Service::get_admin_token(const DoutPrefixProvider *dpp,
   return ret;
 }
 
+void Service::refresh_admin_token(const DoutPrefixProvider *dpp,
+                                  TokenCache& token_cache,
+                                  const Config& config,
+                                  optional_yield y)
+{
+  ldpp_dout(dpp, 20) << "admin token is about to expire, renewing it" << dendl;
+
+  /* The cached token is still good, so don't make this request wait for the
+   * new one: renew it in a coroutine of its own. The cache and the config
+   * are singletons and outlive it, the request's dpp doesn't. */
+  if (y) {
+    auto cct = dpp->get_cct();
+    boost::asio::spawn(y.get_yield_context().get_executor(),
+        [cct, &token_cache, &config] (boost::asio::yield_context yield) {
+          NoDoutPrefix no_dpp(cct, ceph_subsys_rgw);
+          TokenEnvelope t;
+          if (issue_admin_token_request(&no_dpp, config, yield, t) == 0) {
+            token_cache.add_admin(t);
+          }
+          token_cache.end_admin_refresh();
+        }, boost::asio::detached);
+    return;
+  }
+
+  TokenEnvelope t;
+  if (issue_admin_token_request(dpp, config, y, t) == 0) {
+    token_cache.add_admin(t);
+  }
+  token_cache.end_admin_refresh();
+}
+
 int Service::issue_admin_token_request(const DoutPrefixProvider *dpp,
                                        const Config& config,
                                        optional_yield y,
@@ -333,21 +370,23 @@ void TokenEnvelope::update_roles(const std::vector<std::string> & admin,
 bool TokenCache::find(const std::string& token_id,
                       rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
-  return find_locked(token_id, token, tokens, tokens_lru);
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  return find_locked(token_id, token, shard.tokens, shard.tokens_lru);
 }
 
 bool TokenCache::find_service(const std::string& token_id,
                               rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
-  return find_locked(token_id, token, service_tokens, service_tokens_lru);
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  return find_locked(token_id, token, shard.service_tokens,
+                     shard.service_tokens_lru);
 }
 
 bool TokenCache::find_locked(const std::string& token_id, rgw::keystone::TokenEnvelope& token,
                              std::map<std::string, token_entry>& tokens, std::list<std::string>& tokens_lru)
 {
-  ceph_assert(ceph_mutex_is_locked_by_me(lock));
   map<string, token_entry>::iterator iter = tokens.find(token_id);
   if (iter == tokens.end()) {
     if (perfcounter) perfcounter->inc(l_rgw_keystone_token_cache_miss);
@@ -355,17 +394,16 @@ bool TokenCache::find_locked(const std::string& token_id, rgw::keystone::TokenEn
   }
 
   token_entry& entry = iter->second;
-  tokens_lru.erase(entry.lru_iter);
 
   if (entry.token.expired()) {
+    tokens_lru.erase(entry.lru_iter);
     tokens.erase(iter);
     if (perfcounter) perfcounter->inc(l_rgw_keystone_token_cache_hit);
     return false;
   }
   token = entry.token;
 
-  tokens_lru.push_front(token_id);
-  entry.lru_iter = tokens_lru.begin();
+  tokens_lru.splice(tokens_lru.begin(), tokens_lru, entry.lru_iter);
 
   if (perfcounter) perfcounter->inc(l_rgw_keystone_token_cache_hit);
 
@@ -374,36 +412,44 @@ bool TokenCache::find_locked(const std::string& token_id, rgw::keystone::TokenEn
 
 bool TokenCache::find_admin(rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
-
-  return find_locked(admin_token_id, token, tokens, tokens_lru);
+  std::string token_id;
+  {
+    std::lock_guard l{admin_lock};
+    token_id = admin_token_id;
+  }
+  return find(token_id, token);
 }
 
 bool TokenCache::find_barbican(rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
-
-  return find_locked(barbican_token_id, token, tokens, tokens_lru);
+  std::string token_id;
+  {
+    std::lock_guard l{admin_lock};
+    token_id = barbican_token_id;
+  }
+  return find(token_id, token);
 }
 
 void TokenCache::add(const std::string& token_id,
                      const rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
-  add_locked(token_id, token, tokens, tokens_lru);
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  add_locked(token_id, token, shard.tokens, shard.tokens_lru);
 }
 
 void TokenCache::add_service(const std::string& token_id,
                              const rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
-  add_locked(token_id, token, service_tokens, service_tokens_lru);
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  add_locked(token_id, token, shard.service_tokens, shard.service_tokens_lru);
 }
 
 void TokenCache::add_locked(const std::string& token_id, const rgw::keystone::TokenEnvelope& token,
-                            std::map<std::string, token_entry>& tokens, std::list<std::string>& tokens_lru)
+                            std::map<std::string, token_entry>& tokens,
+                            std::list<std::string>& tokens_lru)
 {
-  ceph_assert(ceph_mutex_is_locked_by_me(lock));
   map<string, token_entry>::iterator iter = tokens.find(token_id);
   if (iter != tokens.end()) {
     token_entry& e = iter->second;
@@ -426,36 +472,46 @@ void TokenCache::add_locked(const std::string& token_id, const rgw::keystone::To
 
 void TokenCache::add_admin(const rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
+  std::string token_id;
+  rgw_get_token_id(token.token.id, token_id);
+  add(token_id, token);
 
-  rgw_get_token_id(token.token.id, admin_token_id);
-  add_locked(admin_token_id, token, tokens, tokens_lru);
+  std::lock_guard l{admin_lock};
+  admin_token_id = std::move(token_id);
 }
 
 void TokenCache::add_barbican(const rgw::keystone::TokenEnvelope& token)
 {
-  std::lock_guard l{lock};
+  std::string token_id;
+  rgw_get_token_id(token.token.id, token_id);
+  add(token_id, token);
 
-  rgw_get_token_id(token.token.id, barbican_token_id);
-  add_locked(barbican_token_id, token, tokens, tokens_lru);
+  std::lock_guard l{admin_lock};
+  barbican_token_id = std::move(token_id);
 }
 
 void TokenCache::invalidate(const DoutPrefixProvider *dpp, const std::string& token_id)
 {
-  std::lock_guard l{lock};
-  map<string, token_entry>::iterator iter = tokens.find(token_id);
-  if (iter == tokens.end())
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  map<string, token_entry>::iterator iter = shard.tokens.find(token_id);
+  if (iter == shard.tokens.end())
     return;
 
   ldpp_dout(dpp, 20) << "invalidating revoked token id=" << token_id << dendl;
   token_entry& e = iter->second;
-  tokens_lru.erase(e.lru_iter);
-  tokens.erase(iter);
+  shard.tokens_lru.erase(e.lru_iter);
+  shard.tokens.erase(iter);
 }
 
 void TokenCache::invalidate_admin(const DoutPrefixProvider *dpp)
 {
-  invalidate(dpp, admin_token_id);
+  std::string token_id;
+  {
+    std::lock_guard l{admin_lock};
+    token_id = admin_token_id;
+  }
+  invalidate(dpp, token_id);
 }
 
 bool TokenCache::going_down() const
@@ -463,6 +519,119 @@ bool TokenCache::going_down() const
   return down_flag;
 }
 
+void TokenCache::add_rejected(const std::string& token_id)
+{
+  const auto ttl = cct->_conf->rgw_keystone_token_cache_negative_ttl;
+  if (ttl <= 0) {
+    return;
+  }
+  const auto now = ceph::coarse_mono_clock::now();
+
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  auto [iter, inserted] = shard.rejected.try_emplace(token_id);
+  if (!inserted) {
+    shard.rejected_lru.erase(iter->second.lru_iter);
+  }
+  shard.rejected_lru.push_front(token_id);
+  iter->second.lru_iter = shard.rejected_lru.begin();
+  iter->second.expires = now + std::chrono::seconds(ttl);
+
+  /* drop what expired first, then the least recently refused */
+  while (!shard.rejected_lru.empty()) {
+    auto oldest = shard.rejected.find(shard.rejected_lru.back());
+    if (shard.rejected_lru.size() <= max && oldest->second.expires > now) {
+      break;
+    }
+    shard.rejected.erase(oldest);
+    shard.rejected_lru.pop_back();
+  }
+}
+
+bool TokenCache::is_rejected(const std::string& token_id)
+{
+  auto& shard = get_shard(token_id);
+  std::lock_guard l{shard.lock};
+  auto iter = shard.rejected.find(token_id);
+  if (iter == shard.rejected.end()) {
+    return false;
+  }
+  if (iter->second.expires <= ceph::coarse_mono_clock::now()) {
+    shard.rejected_lru.erase(iter->second.lru_iter);
+    shard.rejected.erase(iter);
+    return false;
+  }
+  return true;
+}
+
+bool TokenCache::begin_validation(const std::string& token_id,
+                                  optional_yield y)
+{
+  auto& shard = get_shard(token_id);
+  std::unique_lock l{shard.lock};
+  if (shard.validating.try_emplace(token_id).second) {
+    return true;
+  }
+
+  if (y) {
+    l.unlock();
+    auto& yield = y.get_yield_context();
+    ceph::async::yield_waiter<void> waiter;
+    // register only once the coroutine is suspended, so that
+    // end_validation() never completes the waiter before it waits
+    boost::asio::defer(yield.get_executor(), [&shard, &token_id, &waiter] {
+      std::unique_lock l{shard.lock};
+      auto iter = shard.validating.find(token_id);
+      if (iter == shard.validating.end()) {
+        l.unlock();
+        waiter.complete(boost::system::error_code{});
+      } else {
+        iter->second.push_back(&waiter);
+      }
+    });
+    waiter.async_wait(yield);
+  } else {
+    shard.cond.wait(l, [&shard, &token_id] {
+      return !shard.validating.contains(token_id);
+    });
+  }
+  return false;
+}
+
+void TokenCache::end_validation(const std::string& token_id)
+{
+  auto& shard = get_shard(token_id);
+  std::vector<ceph::async::yield_waiter<void>*> waiters;
+  {
+    std::lock_guard l{shard.lock};
+    auto iter = shard.validating.find(token_id);
+    if (iter == shard.validating.end()) {
+      return;
+    }
+    waiters = std::move(iter->second);
+    shard.validating.erase(iter);
+  }
+  for (auto waiter : waiters) {
+    waiter->complete(boost::system::error_code{});
+  }
+  shard.cond.notify_all();
+}
+
+bool TokenCache::begin_admin_refresh(const TokenEnvelope& token)
+{
+  const auto window = cct->_conf->rgw_keystone_token_cache_refresh_window;
+  const int64_t now = ceph_clock_now().sec();
+  if (window <= 0 || token.get_expires() - now > window) {
+    return false;
+  }
+  return !admin_refreshing.exchange(true);
+}
+
+void TokenCache::end_admin_refresh()
+{
+  admin_refreshing = false;
+}
+
 }; /* namespace keystone */
 }; /* namespace rgw */
 
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <string_view>
 #include <type_traits>
@@ -12,7 +13,10 @@
 
 #include "rgw_common.h"
 #include "rgw_http_client.h"
+#include "common/async/yield_context.h"
+#include "common/async/yield_waiter.h"
 #include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
 #include "common/Clock.h" // for ceph_clock_now()
 #include "global/global_init.h"
 
@@ -122,6 +126,10 @@ public:
                                        const Config& config,
                                        optional_yield y,
                                        TokenEnvelope& token);
+  static void refresh_admin_token(const DoutPrefixProvider *dpp,
+                                  TokenCache& token_cache,
+                                  const Config& config,
+                                  optional_yield y);
   static int get_keystone_barbican_token(const DoutPrefixProvider *dpp,
                                          optional_yield y,
                                          std::string& token);
@@ -214,29 +222,59 @@ class TokenCache {
     std::list<std::string>::iterator lru_iter;
   };
 
+  /* A token Keystone refused, remembered until `expires`. These live apart
+   * from the valid tokens, so a flood of bad tokens can only evict other
+   * bad tokens. */
+  struct rejected_entry {
+    ceph::coarse_mono_time expires;
+    std::list<std::string>::iterator lru_iter;
+  };
+
+  /* Tokens are spread over shards by their id so that requests carrying
+   * different tokens don't serialize on a single lock. Each shard has its own
+   * LRU, bounded by its share of rgw_keystone_token_cache_size. */
+  struct Shard {
+    ceph::mutex lock = ceph::make_mutex("rgw::keystone::TokenCache::Shard");
+    ceph::condition_variable cond;
+    std::map<std::string, token_entry> tokens;
+    std::map<std::string, token_entry> service_tokens;
+    std::list<std::string> tokens_lru;
+    std::list<std::string> service_tokens_lru;
+    std::map<std::string, rejected_entry> rejected;
+    std::list<std::string> rejected_lru;
+    /* Token ids being validated against Keystone, with the coroutines
+     * waiting for the outcome. Threads wait on cond instead. */
+    std::map<std::string,
+             std::vector<ceph::async::yield_waiter<void>*>> validating;
+  };
+  static constexpr size_t num_shards = 16;
+
   std::atomic<bool> down_flag = { false };
   const boost::intrusive_ptr<CephContext> cct;
 
+  ceph::mutex admin_lock = ceph::make_mutex("rgw::keystone::TokenCache::admin");
   std::string admin_token_id;
   std::string barbican_token_id;
-  std::map<std::string, token_entry> tokens;
-  std::map<std::string, token_entry> service_tokens;
-  std::list<std::string> tokens_lru;
-  std::list<std::string> service_tokens_lru;
+  std::atomic<bool> admin_refreshing = { false };
 
-  ceph::mutex lock = ceph::make_mutex("rgw::keystone::TokenCache");
+  std::array<Shard, num_shards> shards;
 
   const size_t max;
 
   explicit TokenCache(const rgw::keystone::Config& config)
     : cct(g_ceph_context),
-      max(cct->_conf->rgw_keystone_token_cache_size) {
+      max(std::max<size_t>(1, (cct->_conf->rgw_keystone_token_cache_size +
+                               num_shards - 1) / num_shards)) {
   }
 
   ~TokenCache() {
     down_flag = true;
   }
 
+  Shard& get_shard(const std::string& token_id) {
+    return shards[std::hash<std::string>{}(token_id) % num_shards];
+  }
+
 public:
   TokenCache(const TokenCache&) = delete;
   void operator=(const TokenCache&) = delete;
@@ -276,9 +314,32 @@ public:
   void invalidate(const DoutPrefixProvider *dpp, const std::string& token_id);
   void invalidate_admin(const DoutPrefixProvider *dpp);
   bool going_down() const;
+
+  /* Negative caching: remember for rgw_keystone_token_cache_negative_ttl
+   * seconds that Keystone refused a token, so a client retrying with a bad
+   * token doesn't cost a Keystone round trip per request. Only for tokens
+   * Keystone itself reported as invalid or expired, never for errors
+   * reaching it. */
+  void add_rejected(const std::string& token_id);
+  bool is_rejected(const std::string& token_id);
+
+  /* Coalesce concurrent validations of the same token. The first caller gets
+   * true and must call end_validation() once the outcome is in the cache (or
+   * known not to be cacheable). The others wait for it and get false; they
+   * should look the token up again before going to Keystone themselves. */
+  bool begin_validation(const std::string& token_id, optional_yield y);
+  void end_validation(const std::string& token_id);
+
+  /* Returns true to exactly one caller once the cached admin token gets
+   * within rgw_keystone_token_cache_refresh_window seconds of its expiry.
+   * That caller renews it while everyone else keeps using the cached one,
+   * and calls end_admin_refresh() when done. */
+  bool begin_admin_refresh(const TokenEnvelope& token);
+  void end_admin_refresh();
 private:
   void add_locked(const std::string& token_id, const TokenEnvelope& token,
-                  std::map<std::string, token_entry>& tokens, std::list<std::string>& tokens_lru);
+                  std::map<std::string, token_entry>& tokens,
+                  std::list<std::string>& tokens_lru);
   bool find_locked(const std::string& token_id, TokenEnvelope& token,
                    std::map<std::string, token_entry>& tokens, std::list<std::string>& tokens_lru);
 };
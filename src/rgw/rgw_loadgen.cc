@@ -2,11 +2,13 @@
 // vim: ts=8 sw=2 sts=2 expandtab ft=cpp
 
 #include <algorithm>
+#include <limits>
 #include <sstream>
 #include <string.h>
 
 #include "rgw_loadgen.h"
 #include "rgw_auth_s3.h"
+#include "common/Formatter.h"
 
 
 #define dout_subsys ceph_subsys_rgw
@@ -55,6 +57,7 @@ int RGWLoadGenRequestEnv::sign(const DoutPrefixProvider *dpp, RGWAccessKey& acce
 size_t RGWLoadGenIO::write_data(const char* const buf,
                                 const size_t len)
 {
+  bytes_sent += len;
   return len;
 }
 
@@ -129,3 +132,91 @@ size_t RGWLoadGenIO::send_content_length(const uint64_t len)
 {
   return 0;
 }
+
+const char* RGWLoadGenStats::op_name(int op)
+{
+  switch (op) {
+  case GET: return "get";
+  case PUT: return "put";
+  case DELETE: return "delete";
+  case LIST: return "list";
+  default: return "unknown";
+  }
+}
+
+void RGWLoadGenStats::add(int op, ceph::timespan latency, uint64_t bytes,
+                          bool error)
+{
+  const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  std::lock_guard l{lock};
+  auto& s = ops[op];
+  s.count++;
+  if (error) {
+    s.errors++;
+  }
+  s.bytes += bytes;
+  s.total += latency;
+  s.max = std::max(s.max, latency);
+  s.latency_us.add(std::min<int64_t>(us, std::numeric_limits<int32_t>::max()));
+}
+
+void RGWLoadGenStats::dump(ceph::Formatter* f, ceph::timespan elapsed) const
+{
+  const double secs = std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+  std::lock_guard l{lock};
+  uint64_t total = 0;
+  for (const auto& s : ops) {
+    total += s.count;
+  }
+  f->dump_float("elapsed_sec", secs);
+  f->dump_unsigned("total_ops", total);
+  f->dump_float("ops_per_sec", total / secs);
+
+  f->open_array_section("ops");
+  for (int op = 0; op < NUM_OPS; op++) {
+    const auto& s = ops[op];
+    if (!s.count) {
+      continue;
+    }
+    f->open_object_section("op");
+    f->dump_string("op", op_name(op));
+    f->dump_unsigned("count", s.count);
+    f->dump_unsigned("errors", s.errors);
+    f->dump_unsigned("bytes", s.bytes);
+    f->dump_float("ops_per_sec", s.count / secs);
+    f->dump_float("mean_us", std::chrono::duration<double, std::micro>(s.total).count() / s.count);
+    f->dump_float("max_us", std::chrono::duration<double, std::micro>(s.max).count());
+
+    // percentiles are reported as the upper bound of the bin they fall in
+    const auto& h = s.latency_us.h;
+    static constexpr std::pair<const char*, double> pcts[] = {
+      {"p50_us", 0.5}, {"p90_us", 0.9}, {"p99_us", 0.99}, {"p999_us", 0.999},
+    };
+    for (const auto& [name, pct] : pcts) {
+      const auto target = static_cast<uint64_t>(pct * s.count);
+      uint64_t seen = 0;
+      unsigned bin = 0;
+      for (; bin < h.size(); bin++) {
+        seen += h[bin];
+        if (seen > target) {
+          break;
+        }
+      }
+      f->dump_unsigned(name, uint64_t(1) << std::min<unsigned>(bin, h.size() - 1));
+    }
+
+    f->open_array_section("latency_histogram_us");
+    for (unsigned bin = 0; bin < h.size(); bin++) {
+      if (!h[bin]) {
+        continue;
+      }
+      f->open_object_section("bin");
+      f->dump_unsigned("le", uint64_t(1) << bin);
+      f->dump_int("count", h[bin]);
+      f->close_section();
+    }
+    f->close_section();
+    f->close_section();
+  }
+  f->close_section();
+}
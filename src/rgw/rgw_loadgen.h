@@ -3,11 +3,19 @@
 
 #pragma once
 
+#include <array>
 #include <map>
+#include <mutex>
 #include <string>
 
+#include "common/ceph_time.h"
+#include "common/histogram.h"
 #include "rgw_client_io.h"
 
+namespace ceph {
+  class Formatter;
+}
+
 
 struct RGWLoadGenRequestEnv {
   int port;
@@ -29,11 +37,36 @@ struct RGWLoadGenRequestEnv {
   int sign(const DoutPrefixProvider *dpp, RGWAccessKey& access_key);
 };
 
+/* Per-op results of a loadgen benchmark run: request and error counts,
+ * bytes transferred and a power-of-2 latency histogram in microseconds.
+ * Requests complete on the process thread pool, so updates are locked. */
+class RGWLoadGenStats {
+public:
+  enum Op { GET, PUT, DELETE, LIST, NUM_OPS };
+  static const char* op_name(int op);
+
+  void add(int op, ceph::timespan latency, uint64_t bytes, bool error);
+  void dump(ceph::Formatter* f, ceph::timespan elapsed) const;
+
+private:
+  struct OpStats {
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    ceph::timespan total = ceph::timespan::zero();
+    ceph::timespan max = ceph::timespan::zero();
+    pow2_hist_t latency_us;
+  };
+  mutable std::mutex lock;
+  std::array<OpStats, NUM_OPS> ops;
+};
+
 /* XXX does RGWLoadGenIO actually want to perform stream/HTTP I/O,
  * or (e.g) are these NOOPs? */
 class RGWLoadGenIO : public rgw::io::RestfulClient
 {
   uint64_t left_to_read;
+  uint64_t bytes_sent = 0;
   RGWLoadGenRequestEnv* req;
   RGWEnv env;
 
@@ -69,4 +102,8 @@ public:
   }
 
   size_t complete_request() override;
+
+  uint64_t get_bytes_sent() const {
+    return bytes_sent;
+  }
 };
@@ -4,6 +4,8 @@
 #include "common/errno.h"
 #include "common/Throttle.h"
 #include "common/WorkQueue.h"
+#include "common/JSONFormatter.h"
+#include "include/str_list.h"
 
 #include "rgw_rest.h"
 #include "rgw_frontend.h"
@@ -13,12 +15,76 @@
 #include "rgw_client_io.h"
 #include "rgw_signal.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <random>
 
 #define dout_subsys ceph_subsys_rgw
 
 using namespace std;
 
+namespace {
+
+/* Parses a "name:weight,name:weight,..." list, calling f(name, weight) for
+ * each entry. A missing weight counts as 1. */
+template <typename Func>
+bool parse_weights(std::string_view str, Func&& f)
+{
+  bool ok = true;
+  ceph::for_each_substr(str, ",", [&] (std::string_view entry) {
+      std::string_view name = entry;
+      double weight = 1;
+      if (auto pos = entry.find(':'); pos != entry.npos) {
+        name = entry.substr(0, pos);
+        const std::string w{entry.substr(pos + 1)};
+        char *end = nullptr;
+        weight = strtod(w.c_str(), &end);
+        if (w.empty() || *end || weight < 0) {
+          ok = false;
+          return;
+        }
+      }
+      ok = ok && f(name, weight);
+    });
+  return ok;
+}
+
+/* Picks keys from [0, n) following a zipf distribution with the given
+ * exponent, so that low indexes are hot. An exponent of 0 is uniform. */
+class KeyChooser {
+  std::vector<double> cdf;
+  std::uniform_int_distribution<size_t> uniform;
+public:
+  KeyChooser(size_t n, double skew) : uniform(0, n - 1) {
+    if (skew > 0) {
+      cdf.reserve(n);
+      double sum = 0;
+      for (size_t i = 0; i < n; i++) {
+        sum += 1.0 / std::pow(i + 1, skew);
+        cdf.push_back(sum);
+      }
+      for (auto& c : cdf) {
+        c /= sum;
+      }
+    }
+  }
+
+  template <typename Rng>
+  size_t operator()(Rng& rng) {
+    if (cdf.empty()) {
+      return uniform(rng);
+    }
+    const double u = std::uniform_real_distribution<double>{}(rng);
+    const size_t i = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    return std::min(i, cdf.size() - 1);
+  }
+};
+
+} // anonymous namespace
+
 void RGWLoadGenProcess::checkpoint()
 {
   m_tp.drain(&req_wq);
@@ -37,6 +103,9 @@ void RGWLoadGenProcess::run()
   int num_buckets;
   conf->get_val("num_buckets", 1, &num_buckets);
 
+  int bench_ops;
+  conf->get_val("ops", 0, &bench_ops);
+
   vector<string> buckets(num_buckets);
 
   std::atomic<bool> failed = { false };
@@ -65,6 +134,11 @@ void RGWLoadGenProcess::run()
     objs[i] = buckets[i % num_buckets] + "/" + buf;
   }
 
+  if (bench_ops > 0) {
+    run_benchmark(objs, num_objs, buckets, bench_ops, &failed);
+    goto cleanup;
+  }
+
   for (i = 0; i < num_objs; i++) {
     gen_request("PUT", objs[i], 4096, &failed);
   }
@@ -82,6 +156,7 @@ void RGWLoadGenProcess::run()
 
   checkpoint();
 
+cleanup:
   for (i = 0; i < num_objs; i++) {
     gen_request("DELETE", objs[i], 0, NULL);
   }
@@ -102,13 +177,157 @@ done:
   rgw::signal::signal_shutdown();
 } /* RGWLoadGenProcess::run() */
 
+/* Benchmark mode, enabled with ops=<n>. Writes the key space with sizes
+ * drawn from obj_sizes, then issues n requests drawn from op_mix against
+ * keys chosen with the given zipf skew, and reports per-op latency
+ * histograms as JSON. Frontend options:
+ *   ops=<n>                 number of requests in the measured phase
+ *   op_mix=get:70,put:20,delete:5,list:5
+ *   obj_sizes=4096:90,1048576:10
+ *   skew=<exponent>         zipf exponent of key popularity, 0 is uniform
+ *   concurrency=<n>         requests in flight, default 2 * num_threads
+ *   seed=<n>                seed for the op, size and key choices
+ *   report=<path>           write the JSON report there instead of the log
+ */
+int RGWLoadGenProcess::run_benchmark(const string* objs, int num_objs,
+				     const vector<string>& buckets, int num_ops,
+				     std::atomic<bool>* fail_flag)
+{
+  int concurrency;
+  conf->get_val("concurrency", 0, &concurrency);
+  if (concurrency > 0) {
+    req_throttle.reset_max(concurrency);
+  }
+  int seed;
+  conf->get_val("seed", 0, &seed);
+  const string skew_str = conf->get_val("skew", "0");
+  const string op_mix_str = conf->get_val("op_mix", "get:70,put:20,delete:5,list:5");
+  const string obj_sizes_str = conf->get_val("obj_sizes", "4096");
+  const string report = conf->get_val("report", "");
+
+  char *end = nullptr;
+  const double skew = strtod(skew_str.c_str(), &end);
+  if (*end || skew < 0) {
+    derr << "ERROR: loadgen: invalid skew=" << skew_str << dendl;
+    return -EINVAL;
+  }
+
+  vector<double> op_weights(RGWLoadGenStats::NUM_OPS, 0);
+  bool ok = parse_weights(op_mix_str, [&] (std::string_view name, double weight) {
+      for (int op = 0; op < RGWLoadGenStats::NUM_OPS; op++) {
+        if (name == RGWLoadGenStats::op_name(op)) {
+          op_weights[op] = weight;
+          return true;
+        }
+      }
+      return false;
+    });
+  if (!ok || std::all_of(op_weights.begin(), op_weights.end(),
+                         [] (double w) { return w == 0; })) {
+    derr << "ERROR: loadgen: invalid op_mix=" << op_mix_str << dendl;
+    return -EINVAL;
+  }
+
+  vector<int> sizes;
+  vector<double> size_weights;
+  ok = parse_weights(obj_sizes_str, [&] (std::string_view name, double weight) {
+      const string size_str{name};
+      char *end = nullptr;
+      const long size = strtol(size_str.c_str(), &end, 10);
+      if (size_str.empty() || *end || size < 0 || size > std::numeric_limits<int>::max()) {
+        return false;
+      }
+      sizes.push_back(size);
+      size_weights.push_back(weight);
+      return true;
+    });
+  if (!ok || sizes.empty()) {
+    derr << "ERROR: loadgen: invalid obj_sizes=" << obj_sizes_str << dendl;
+    return -EINVAL;
+  }
+
+  std::mt19937_64 rng(seed);
+  std::discrete_distribution<int> choose_op(op_weights.begin(), op_weights.end());
+  std::discrete_distribution<size_t> choose_size(size_weights.begin(), size_weights.end());
+  KeyChooser choose_key(num_objs, skew);
+
+  for (int i = 0; i < num_objs; i++) {
+    gen_request("PUT", objs[i], sizes[choose_size(rng)], fail_flag);
+  }
+  checkpoint();
+  if (*fail_flag) {
+    derr << "ERROR: loadgen: writing the key space failed" << dendl;
+    return -EIO;
+  }
+
+  RGWLoadGenStats stats;
+  const auto start = ceph::mono_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    const int op = choose_op(rng);
+    switch (op) {
+    case RGWLoadGenStats::GET:
+      gen_request("GET", objs[choose_key(rng)], 0, nullptr, &stats, op);
+      break;
+    case RGWLoadGenStats::PUT:
+      gen_request("PUT", objs[choose_key(rng)], sizes[choose_size(rng)],
+                  nullptr, &stats, op);
+      break;
+    case RGWLoadGenStats::DELETE:
+      gen_request("DELETE", objs[choose_key(rng)], 0, nullptr, &stats, op);
+      break;
+    case RGWLoadGenStats::LIST:
+      gen_request("GET", buckets[rng() % buckets.size()], 0, nullptr,
+                  &stats, op, "max-keys=100");
+      break;
+    }
+  }
+  checkpoint();
+  const auto elapsed = ceph::mono_clock::now() - start;
+
+  JSONFormatter f(true);
+  f.open_object_section("loadgen");
+  f.open_object_section("config");
+  f.dump_int("num_objs", num_objs);
+  f.dump_unsigned("num_buckets", buckets.size());
+  f.dump_int("ops", num_ops);
+  f.dump_int("concurrency", req_throttle.get_max());
+  f.dump_int("seed", seed);
+  f.dump_float("skew", skew);
+  f.dump_string("op_mix", op_mix_str);
+  f.dump_string("obj_sizes", obj_sizes_str);
+  f.close_section();
+  stats.dump(&f, elapsed);
+  f.close_section();
+
+  if (report.empty()) {
+    std::ostringstream os;
+    f.flush(os);
+    dout(0) << "loadgen report: " << os.str() << dendl;
+  } else {
+    std::ofstream of(report);
+    f.flush(of);
+    of << std::endl;
+    if (!of) {
+      derr << "ERROR: loadgen: failed to write report to " << report << dendl;
+      return -EIO;
+    }
+    dout(0) << "loadgen report written to " << report << dendl;
+  }
+  return 0;
+} /* RGWLoadGenProcess::run_benchmark */
+
 void RGWLoadGenProcess::gen_request(const string& method,
 				    const string& resource,
-				    int content_length, std::atomic<bool>* fail_flag)
+				    int content_length, std::atomic<bool>* fail_flag,
+				    RGWLoadGenStats* stats, int stats_op,
+				    const string& query_string)
 {
   RGWLoadGenRequest* req =
     new RGWLoadGenRequest(env.driver->get_new_req_id(), method, resource,
 			  content_length, fail_flag);
+  req->query_string = query_string;
+  req->stats = stats;
+  req->stats_op = stats_op;
   dout(10) << "allocated request req=" << hex << req << dec << dendl;
   req_throttle.get(1);
   req_wq.queue(req);
@@ -127,21 +346,31 @@ void RGWLoadGenProcess::handle_request(const DoutPrefixProvider *dpp, RGWRequest
   renv.content_type = "binary/octet-stream";
   renv.request_method = req->method;
   renv.uri = req->resource;
+  renv.query_string = req->query_string;
   renv.set_date(tm);
   renv.sign(dpp, access_key);
 
   RGWLoadGenIO real_client_io(&renv);
   RGWRestfulIO client_io(cct, &real_client_io);
+  int http_ret = 0;
+  const auto start = ceph::mono_clock::now();
   int ret = process_request(env, req, uri_prefix, &client_io,
-                            null_yield, nullptr, nullptr, nullptr);
+                            null_yield, nullptr, nullptr, nullptr, &http_ret);
+  const auto latency = ceph::mono_clock::now() - start;
   if (ret < 0) {
     /* we don't really care about return code */
     dout(20) << "process_request() returned " << ret << dendl;
 
     if (req->fail_flag) {
-      req->fail_flag++;
+      *req->fail_flag = true;
     }
   }
 
+  if (req->stats) {
+    req->stats->add(req->stats_op, latency,
+                    req->content_length + real_client_io.get_bytes_sent(),
+                    ret < 0 || http_ret >= 400);
+  }
+
   delete req;
 } /* RGWLoadGenProcess::handle_request */
@@ -63,6 +63,11 @@ void add_rgw_frontend_counters(PerfCountersBuilder *pcb) {
   pcb->add_u64_counter(l_rgw_d4n_cache_hits, "d4n_cache_hits", "D4N cache hits");
   pcb->add_u64_counter(l_rgw_d4n_cache_misses, "d4n_cache_misses", "D4N cache misses");
   pcb->add_u64_counter(l_rgw_d4n_cache_evictions, "d4n_cache_evictions", "D4N cache evictions");
+  pcb->add_u64_counter(l_rgw_d4n_writeback_objects, "d4n_writeback_objects", "D4N dirty objects written back");
+  pcb->add_u64_counter(l_rgw_d4n_writeback_bytes, "d4n_writeback_bytes", "D4N dirty bytes written back");
+  pcb->add_time_avg(l_rgw_d4n_writeback_stall_lat, "d4n_writeback_stall_lat", "D4N time writes were stalled on write cache occupancy");
+
+  pcb->add_u64_counter(l_rgw_asio_blocking, "asio_blocking", "Blocking waits on frontend threads");
 }
 
 void add_rgw_op_counters(PerfCountersBuilder *lpcb) {
@@ -52,6 +52,11 @@ enum {
   l_rgw_d4n_cache_hits,
   l_rgw_d4n_cache_misses,
   l_rgw_d4n_cache_evictions,
+  l_rgw_d4n_writeback_objects,
+  l_rgw_d4n_writeback_bytes,
+  l_rgw_d4n_writeback_stall_lat,
+
+  l_rgw_asio_blocking,
 
   l_rgw_last,
 };
@@ -24,6 +24,7 @@ namespace rgw::dmclock {
 struct RGWProcessEnv;
 class RGWFrontendConfig;
 class RGWRequest;
+class RGWLoadGenStats;
 
 class RGWProcess {
   std::deque<RGWRequest*> m_req_queue;
@@ -133,7 +134,12 @@ public:
   void checkpoint();
   void handle_request(const DoutPrefixProvider *dpp, RGWRequest* req) override;
   void gen_request(const std::string& method, const std::string& resource,
-		  int content_length, std::atomic<bool>* fail_flag);
+		  int content_length, std::atomic<bool>* fail_flag,
+		  RGWLoadGenStats* stats = nullptr, int stats_op = -1,
+		  const std::string& query_string = "");
+  int run_benchmark(const std::string* objs, int num_objs,
+		    const std::vector<std::string>& buckets, int num_ops,
+		    std::atomic<bool>* fail_flag);
 
   void set_access_key(RGWAccessKey& key) { access_key = key; }
 };
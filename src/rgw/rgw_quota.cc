@@ -42,8 +42,35 @@ struct RGWQuotaCacheStats {
   RGWStorageStats stats;
   utime_t expiration;
   utime_t async_refresh_time;
+  /* changes made through this gateway since the async refresh in flight (if
+   * any) was issued; they are folded into the stats it returns */
+  int64_t pending_objs = 0;
+  int64_t pending_size = 0;
+  int64_t pending_size_rounded = 0;
 };
 
+static void apply_stats_delta(RGWStorageStats& stats, int64_t objs,
+                              int64_t size, int64_t size_rounded)
+{
+  if ((int64_t)stats.size + size >= 0) {
+    stats.size += size;
+  } else {
+    stats.size = 0;
+  }
+
+  if ((int64_t)stats.size_rounded + size_rounded >= 0) {
+    stats.size_rounded += size_rounded;
+  } else {
+    stats.size_rounded = 0;
+  }
+
+  if ((int64_t)stats.num_objects + objs >= 0) {
+    stats.num_objects += objs;
+  } else {
+    stats.num_objects = 0;
+  }
+}
+
 template<class T>
 class RGWQuotaCache {
 protected:
@@ -89,8 +116,8 @@ public:
 
   void set_stats(const rgw_owner& owner, const rgw_bucket& bucket, RGWQuotaCacheStats& qs, const RGWStorageStats& stats);
   int async_refresh(const rgw_owner& owner, const rgw_bucket& bucket, RGWQuotaCacheStats& qs);
-  void async_refresh_response(const rgw_owner& owner, rgw_bucket& bucket, const RGWStorageStats& stats);
-  void async_refresh_fail(const rgw_owner& owner, rgw_bucket& bucket);
+  void async_refresh_response(const rgw_owner& owner, const rgw_bucket& bucket, const RGWStorageStats& stats);
+  void async_refresh_fail(const rgw_owner& owner, const rgw_bucket& bucket);
 
   /// start an async refresh that will eventually call async_refresh_response or
   /// async_refresh_fail. hold a reference to the waiter until completion
@@ -108,25 +135,74 @@ int RGWQuotaCache<T>::async_refresh(const rgw_owner& owner, const rgw_bucket& bu
     return 0;
   }
 
-  return init_refresh(owner, bucket, async_refcount);
+  int r = init_refresh(owner, bucket, async_refcount);
+  if (r < 0) {
+    async_refresh_fail(owner, bucket);
+  }
+  return r;
 }
 
+/* Installs the stats read by an async refresh, plus whatever this gateway
+ * changed while the read was in flight, in a single update of the entry so
+ * that no concurrent adjust_stats() is lost. */
+template<class T>
+class RGWQuotaStatsRefresh : public lru_map<T, RGWQuotaCacheStats>::UpdateContext {
+  const RGWStorageStats& stats;
+  const int ttl;
+public:
+  RGWQuotaStatsRefresh(const RGWStorageStats& stats, int ttl)
+    : stats(stats), ttl(ttl) {}
+
+  bool update(RGWQuotaCacheStats * const entry) override {
+    entry->stats = stats;
+    apply_stats_delta(entry->stats, entry->pending_objs, entry->pending_size,
+                      entry->pending_size_rounded);
+    entry->pending_objs = 0;
+    entry->pending_size = 0;
+    entry->pending_size_rounded = 0;
+
+    entry->expiration = ceph_clock_now();
+    entry->async_refresh_time = entry->expiration;
+    entry->expiration += ttl;
+    entry->async_refresh_time += ttl / 2;
+    return true;
+  }
+};
+
+/* Lets the next lookup retry a refresh that failed. The cached stats are
+ * kept, they already account for the pending changes. */
+template<class T>
+class RGWQuotaStatsRefreshFail : public lru_map<T, RGWQuotaCacheStats>::UpdateContext {
+public:
+  bool update(RGWQuotaCacheStats * const entry) override {
+    entry->pending_objs = 0;
+    entry->pending_size = 0;
+    entry->pending_size_rounded = 0;
+    entry->async_refresh_time = ceph_clock_now();
+    return true;
+  }
+};
+
 template<class T>
-void RGWQuotaCache<T>::async_refresh_fail(const rgw_owner& owner, rgw_bucket& bucket)
+void RGWQuotaCache<T>::async_refresh_fail(const rgw_owner& owner, const rgw_bucket& bucket)
 {
-  ldout(driver->ctx(), 20) << "async stats refresh response for bucket=" << bucket << dendl;
+  ldout(driver->ctx(), 20) << "async stats refresh failed for bucket=" << bucket << dendl;
+
+  RGWQuotaStatsRefreshFail<T> fail;
+  map_find_and_update(owner, bucket, &fail);
 }
 
 template<class T>
-void RGWQuotaCache<T>::async_refresh_response(const rgw_owner& owner, rgw_bucket& bucket, const RGWStorageStats& stats)
+void RGWQuotaCache<T>::async_refresh_response(const rgw_owner& owner, const rgw_bucket& bucket, const RGWStorageStats& stats)
 {
   ldout(driver->ctx(), 20) << "async stats refresh response for bucket=" << bucket << dendl;
 
-  RGWQuotaCacheStats qs;
-
-  map_find(owner, bucket, qs);
-
-  set_stats(owner, bucket, qs, stats);
+  RGWQuotaStatsRefresh<T> refresh(stats, driver->ctx()->_conf->rgw_bucket_quota_ttl);
+  if (!map_find_and_update(owner, bucket, &refresh)) {
+    /* evicted meanwhile */
+    RGWQuotaCacheStats qs;
+    set_stats(owner, bucket, qs, stats);
+  }
 }
 
 template<class T>
@@ -137,6 +213,9 @@ void RGWQuotaCache<T>::set_stats(const rgw_owner& owner, const rgw_bucket& bucke
   qs.async_refresh_time = qs.expiration;
   qs.expiration += driver->ctx()->_conf->rgw_bucket_quota_ttl;
   qs.async_refresh_time += driver->ctx()->_conf->rgw_bucket_quota_ttl / 2;
+  qs.pending_objs = 0;
+  qs.pending_size = 0;
+  qs.pending_size_rounded = 0;
 
   map_add(owner, bucket, qs);
 }
@@ -155,7 +234,13 @@ int RGWQuotaCache<T>::get_stats(const rgw_owner& owner, const rgw_bucket& bucket
       }
     }
 
-    if (qs.expiration > ceph_clock_now()) {
+    /* Past its expiration, an entry that has been kept up to date with the
+     * changes made through this gateway is still served for a while, as a
+     * refresh is on its way: only a cold or a very stale entry makes the
+     * request wait for the stats to be read. */
+    utime_t valid_until = qs.expiration;
+    valid_until += driver->ctx()->_conf->rgw_quota_cache_max_staleness;
+    if (valid_until > now) {
       stats = qs.stats;
       return 0;
     }
@@ -186,25 +271,17 @@ public:
   }
 
   bool update(RGWQuotaCacheStats * const entry) override {
-    const uint64_t rounded_added = rgw_rounded_objsize(added_bytes);
-    const uint64_t rounded_removed = rgw_rounded_objsize(removed_bytes);
-
-    if (((int64_t)(entry->stats.size + added_bytes - removed_bytes)) >= 0) {
-      entry->stats.size += added_bytes - removed_bytes;
-    } else {
-      entry->stats.size = 0;
-    }
+    const int64_t size = (int64_t)added_bytes - (int64_t)removed_bytes;
+    const int64_t size_rounded = (int64_t)rgw_rounded_objsize(added_bytes) -
+                                 (int64_t)rgw_rounded_objsize(removed_bytes);
 
-    if (((int64_t)(entry->stats.size_rounded + rounded_added - rounded_removed)) >= 0) {
-      entry->stats.size_rounded += rounded_added - rounded_removed;
-    } else {
-      entry->stats.size_rounded = 0;
-    }
+    apply_stats_delta(entry->stats, objs_delta, size, size_rounded);
 
-    if (((int64_t)(entry->stats.num_objects + objs_delta)) >= 0) {
-      entry->stats.num_objects += objs_delta;
-    } else {
-      entry->stats.num_objects = 0;
+    /* an async refresh is in flight, its result may predate this change */
+    if (entry->async_refresh_time.sec() == 0) {
+      entry->pending_objs += objs_delta;
+      entry->pending_size += size;
+      entry->pending_size_rounded += size_rounded;
     }
 
     return true;
@@ -27,11 +27,17 @@ struct RGWRequest
   }
 }; /* RGWRequest */
 
+class RGWLoadGenStats;
+
 struct RGWLoadGenRequest : public RGWRequest {
 	std::string method;
 	std::string resource;
+	std::string query_string;
 	int content_length;
 	std::atomic<bool>* fail_flag = nullptr;
+	/* set for benchmark requests, whose results are accounted there */
+	RGWLoadGenStats* stats = nullptr;
+	int stats_op = -1;
 
 RGWLoadGenRequest(uint64_t req_id, const std::string& _m, const std::string& _r, int _cl,
 		std::atomic<bool> *ff)
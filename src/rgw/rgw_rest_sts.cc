@@ -13,6 +13,7 @@
 #include <string_view>
 #include <sstream>
 #include <memory>
+#include <mutex>
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/format.hpp>
@@ -26,6 +27,7 @@
 #include "common/Formatter.h"
 #include "common/utf8.h"
 #include "common/ceph_json.h"
+#include "common/ceph_time.h"
 
 #include "rgw_rest.h"
 #include "rgw_account.h"
@@ -607,158 +609,225 @@ bool WebTokenEngine::verify_oidc_thumbprint(const DoutPrefixProvider* dpp, const
   return true;
 }
 
-void
-WebTokenEngine::validate_signature(const DoutPrefixProvider* dpp, const jwt::decoded_jwt& decoded, const string& algorithm, const string& iss, const vector<string>& thumbprints, optional_yield y) const
-{
-  if (algorithm != "HS256" && algorithm != "HS384" && algorithm != "HS512") {
-    const auto cert_url = get_cert_url(iss, dpp, y);
-    if (cert_url.empty() || !verify_oidc_thumbprint(dpp, cert_url, thumbprints)) {
-      ldpp_dout(dpp, 5) << "Not able to validate JWKS url with registered thumbprints" << dendl;
-      throw std::system_error(EINVAL, std::system_category());
+namespace {
+
+/* JWKS documents of the OpenID Connect providers, by issuer. A document is
+ * only handed out for the thumbprints it was verified against. */
+class JwksCache {
+  struct Entry {
+    std::vector<std::string> thumbprints;
+    std::string jwks;
+    ceph::coarse_mono_time fetched;
+  };
+  std::mutex mutex;
+  std::map<std::string, Entry> entries;
+
+ public:
+  bool find(const std::string& iss, const std::vector<std::string>& thumbprints,
+            std::chrono::seconds ttl, std::string& jwks) {
+    std::lock_guard lock{mutex};
+    auto i = entries.find(iss);
+    if (i == entries.end() || i->second.thumbprints != thumbprints ||
+        ceph::coarse_mono_clock::now() - i->second.fetched > ttl) {
+      return false;
     }
+    jwks = i->second.jwks;
+    return true;
+  }
 
-    // Get certificate
-    bufferlist cert_resp;
-    RGWHTTPTransceiver cert_req(cct, "GET", cert_url, &cert_resp);
-    //Headers
-    cert_req.append_header("Content-Type", "application/x-www-form-urlencoded");
+  void add(const std::string& iss, const std::vector<std::string>& thumbprints,
+           std::string jwks) {
+    std::lock_guard lock{mutex};
+    entries[iss] = Entry{thumbprints, std::move(jwks),
+                         ceph::coarse_mono_clock::now()};
+  }
+};
 
-    int res = cert_req.process(dpp, y);
-    if (res < 0) {
-      ldpp_dout(dpp, 10) << "HTTP request res: " << res << dendl;
-      throw std::system_error(EINVAL, std::system_category());
-    }
-    //Debug only
-    ldpp_dout(dpp, 20) << "HTTP status: " << cert_req.get_http_status() << dendl;
-    ldpp_dout(dpp, 20) << "JSON Response is: " << cert_resp.c_str() << dendl;
-
-    JSONParser parser;
-    if (parser.parse(cert_resp.c_str(), cert_resp.length())) {
-      JSONObj* val = parser.find_obj("keys");
-      if (val && val->is_array()) {
-        vector<string> keys = val->get_array_elements();
-        for (auto &key : keys) {
-          JSONParser k_parser;
-          vector<string> x5c;
-          std::string use, kid;
-          if (k_parser.parse(key.c_str(), key.size())) {
-            if (JSONDecoder::decode_json("kid", kid, &k_parser)) {
-              ldpp_dout(dpp, 20) << "Checking key id: " << kid << dendl;
-            }
-            if (JSONDecoder::decode_json("use", use, &k_parser) && use != "sig") {
-                continue;
-            }
+JwksCache jwks_cache;
+
+} // anonymous namespace
+
+std::string
+WebTokenEngine::get_jwks(const DoutPrefixProvider* dpp, const string& iss, const vector<string>& thumbprints, optional_yield y) const
+{
+  const auto cert_url = get_cert_url(iss, dpp, y);
+  if (cert_url.empty() || !verify_oidc_thumbprint(dpp, cert_url, thumbprints)) {
+    ldpp_dout(dpp, 5) << "Not able to validate JWKS url with registered thumbprints" << dendl;
+    throw std::system_error(EINVAL, std::system_category());
+  }
+
+  // Get certificate
+  bufferlist cert_resp;
+  RGWHTTPTransceiver cert_req(cct, "GET", cert_url, &cert_resp);
+  //Headers
+  cert_req.append_header("Content-Type", "application/x-www-form-urlencoded");
+
+  int res = cert_req.process(dpp, y);
+  if (res < 0) {
+    ldpp_dout(dpp, 10) << "HTTP request res: " << res << dendl;
+    throw std::system_error(EINVAL, std::system_category());
+  }
+  //Debug only
+  ldpp_dout(dpp, 20) << "HTTP status: " << cert_req.get_http_status() << dendl;
+  ldpp_dout(dpp, 20) << "JSON Response is: " << cert_resp.c_str() << dendl;
+
+  return cert_resp.to_str();
+}
+
+bool
+WebTokenEngine::validate_signature_using_jwks(const DoutPrefixProvider* dpp, const jwt::decoded_jwt& decoded, const string& algorithm, const vector<string>& thumbprints, const std::string& jwks) const
+{
+  JSONParser parser;
+  if (! parser.parse(jwks.c_str(), jwks.size())) {
+    ldpp_dout(dpp, 0) << "Malformed json returned while fetching cert" << dendl;
+    return false;
+  }
+  JSONObj* val = parser.find_obj("keys");
+  if (! val || ! val->is_array()) {
+    ldpp_dout(dpp, 0) << "keys not present in JSON" << dendl;
+    return false;
+  }
+  vector<string> keys = val->get_array_elements();
+  for (auto &key : keys) {
+    JSONParser k_parser;
+    vector<string> x5c;
+    std::string use, kid;
+    if (k_parser.parse(key.c_str(), key.size())) {
+      if (JSONDecoder::decode_json("kid", kid, &k_parser)) {
+        ldpp_dout(dpp, 20) << "Checking key id: " << kid << dendl;
+      }
+      if (JSONDecoder::decode_json("use", use, &k_parser) && use != "sig") {
+          continue;
+      }
 
-            if (JSONDecoder::decode_json("x5c", x5c, &k_parser)) {
-              string cert;
-              bool found_valid_cert = false;
-              bool skip_thumbprint_verification = cct->_conf.get_val<bool>("rgw_enable_jwks_url_verification");
-              for (auto& it : x5c) {
-                cert = "-----BEGIN CERTIFICATE-----\n" + it + "\n-----END CERTIFICATE-----";
-                ldpp_dout(dpp, 20) << "Certificate is: " << cert.c_str() << dendl;
-                if (skip_thumbprint_verification || is_cert_valid(thumbprints, cert)) {
-                  found_valid_cert = true;
-                  break;
-                }
-              }
-              if (!found_valid_cert) {
-                ldpp_dout(dpp, 10) << "Cert doesn't match that with the thumbprints registered with oidc provider: " << cert.c_str() << dendl;
-                continue;
-              }
-              try {
-                //verify method takes care of expired tokens also
-                if (algorithm == "RS256") {
-                  auto verifier = jwt::verify()
-                              .allow_algorithm(jwt::algorithm::rs256{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "RS384") {
-                  auto verifier = jwt::verify()
-                              .allow_algorithm(jwt::algorithm::rs384{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "RS512") {
-                  auto verifier = jwt::verify()
-                              .allow_algorithm(jwt::algorithm::rs512{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "ES256") {
-                  auto verifier = jwt::verify()
-                              .allow_algorithm(jwt::algorithm::es256{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "ES384") {
-                  auto verifier = jwt::verify()
-                              .allow_algorithm(jwt::algorithm::es384{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "ES512") {
-                  auto verifier = jwt::verify()
-                                .allow_algorithm(jwt::algorithm::es512{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "PS256") {
-                  auto verifier = jwt::verify()
-                                .allow_algorithm(jwt::algorithm::ps256{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "PS384") {
-                  auto verifier = jwt::verify()
-                                .allow_algorithm(jwt::algorithm::ps384{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else if (algorithm == "PS512") {
-                  auto verifier = jwt::verify()
-                                .allow_algorithm(jwt::algorithm::ps512{cert});
-
-                  verifier.verify(decoded);
-                  return;
-                } else {
-                  ldpp_dout(dpp, 5) << "Unsupported algorithm: " << algorithm << dendl;
-                }
-              }
-              catch (const std::exception& e) {
-                ldpp_dout(dpp, 10) << "Signature validation using x5c failed" << e.what() << dendl;
-              }
-            } else {
-              // Try bare key validation
-              ldpp_dout(dpp, 20) << "Trying bare key validation" << dendl;
-              std::string kty;
-              if (JSONDecoder::decode_json("kty", kty, &k_parser) && kty != "RSA") {
-                ldpp_dout(dpp, 10) << "Only RSA bare key validation is currently supported" << dendl;
-                continue;
-              }
-
-              if (algorithm == "RS256" || algorithm == "RS384" || algorithm == "RS512") {
-                std::string n, e; //modulus and exponent
-                if (JSONDecoder::decode_json("n", n, &k_parser) && JSONDecoder::decode_json("e", e, &k_parser)) {
-                  if (validate_signature_using_n_e(dpp, decoded, algorithm, n, e)) {
-                    return;
-                  }
-                }
-                ldpp_dout(dpp, 10) << "Bare key parameters (n&e) are not present for key" << dendl;
-              }
+      if (JSONDecoder::decode_json("x5c", x5c, &k_parser)) {
+        string cert;
+        bool found_valid_cert = false;
+        bool skip_thumbprint_verification = cct->_conf.get_val<bool>("rgw_enable_jwks_url_verification");
+        for (auto& it : x5c) {
+          cert = "-----BEGIN CERTIFICATE-----\n" + it + "\n-----END CERTIFICATE-----";
+          ldpp_dout(dpp, 20) << "Certificate is: " << cert.c_str() << dendl;
+          if (skip_thumbprint_verification || is_cert_valid(thumbprints, cert)) {
+            found_valid_cert = true;
+            break;
+          }
+        }
+        if (!found_valid_cert) {
+          ldpp_dout(dpp, 10) << "Cert doesn't match that with the thumbprints registered with oidc provider: " << cert.c_str() << dendl;
+          continue;
+        }
+        try {
+          //verify method takes care of expired tokens also
+          if (algorithm == "RS256") {
+            auto verifier = jwt::verify()
+                        .allow_algorithm(jwt::algorithm::rs256{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "RS384") {
+            auto verifier = jwt::verify()
+                        .allow_algorithm(jwt::algorithm::rs384{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "RS512") {
+            auto verifier = jwt::verify()
+                        .allow_algorithm(jwt::algorithm::rs512{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "ES256") {
+            auto verifier = jwt::verify()
+                        .allow_algorithm(jwt::algorithm::es256{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "ES384") {
+            auto verifier = jwt::verify()
+                        .allow_algorithm(jwt::algorithm::es384{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "ES512") {
+            auto verifier = jwt::verify()
+                          .allow_algorithm(jwt::algorithm::es512{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "PS256") {
+            auto verifier = jwt::verify()
+                          .allow_algorithm(jwt::algorithm::ps256{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "PS384") {
+            auto verifier = jwt::verify()
+                          .allow_algorithm(jwt::algorithm::ps384{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else if (algorithm == "PS512") {
+            auto verifier = jwt::verify()
+                          .allow_algorithm(jwt::algorithm::ps512{cert});
+
+            verifier.verify(decoded);
+            return true;
+          } else {
+            ldpp_dout(dpp, 5) << "Unsupported algorithm: " << algorithm << dendl;
+          }
+        }
+        catch (const std::exception& e) {
+          ldpp_dout(dpp, 10) << "Signature validation using x5c failed" << e.what() << dendl;
+        }
+      } else {
+        // Try bare key validation
+        ldpp_dout(dpp, 20) << "Trying bare key validation" << dendl;
+        std::string kty;
+        if (JSONDecoder::decode_json("kty", kty, &k_parser) && kty != "RSA") {
+          ldpp_dout(dpp, 10) << "Only RSA bare key validation is currently supported" << dendl;
+          continue;
+        }
+
+        if (algorithm == "RS256" || algorithm == "RS384" || algorithm == "RS512") {
+          std::string n, e; //modulus and exponent
+          if (JSONDecoder::decode_json("n", n, &k_parser) && JSONDecoder::decode_json("e", e, &k_parser)) {
+            if (validate_signature_using_n_e(dpp, decoded, algorithm, n, e)) {
+              return true;
             }
-          } //end k_parser.parse
-        } //end for iterate through keys
-        ldpp_dout(dpp, 0) << "Signature can not be validated with the JWKS present." << dendl;
-        throw std::system_error(EINVAL, std::system_category());
-      } else { //end val->is_array
-        ldpp_dout(dpp, 0) << "keys not present in JSON" << dendl;
-        throw std::system_error(EINVAL, std::system_category());
+          }
+          ldpp_dout(dpp, 10) << "Bare key parameters (n&e) are not present for key" << dendl;
+        }
       }
-    } else {
-      ldpp_dout(dpp, 0) << "Malformed json returned while fetching cert" << dendl;
-      throw std::system_error(EINVAL, std::system_category());
-    } //if-else get-data
+    } //end k_parser.parse
+  } //end for iterate through keys
+  ldpp_dout(dpp, 0) << "Signature can not be validated with the JWKS present." << dendl;
+  return false;
+}
+
+void
+WebTokenEngine::validate_signature(const DoutPrefixProvider* dpp, const jwt::decoded_jwt& decoded, const string& algorithm, const string& iss, const vector<string>& thumbprints, optional_yield y) const
+{
+  if (algorithm != "HS256" && algorithm != "HS384" && algorithm != "HS512") {
+    /* Fetching the JWKS costs two HTTPS requests and a TLS handshake to
+     * verify the thumbprint, so the document is reused for a while. A token
+     * it can't validate may have been signed with a key the provider added
+     * since, so that one gets a fresh copy. */
+    const std::chrono::seconds ttl{cct->_conf.get_val<uint64_t>("rgw_sts_jwks_cache_ttl")};
+    std::string jwks;
+    if (ttl.count() > 0 && jwks_cache.find(iss, thumbprints, ttl, jwks)) {
+      if (validate_signature_using_jwks(dpp, decoded, algorithm, thumbprints, jwks)) {
+        return;
+      }
+      ldpp_dout(dpp, 10) << "Cached JWKS doesn't validate the token, fetching it again" << dendl;
+    }
+    jwks = get_jwks(dpp, iss, thumbprints, y);
+    if (validate_signature_using_jwks(dpp, decoded, algorithm, thumbprints, jwks)) {
+      if (ttl.count() > 0) {
+        jwks_cache.add(iss, thumbprints, std::move(jwks));
+      }
+      return;
+    }
+    throw std::system_error(EINVAL, std::system_category());
   } else {
     ldpp_dout(dpp, 0) << "JWT signed by HMAC algos are currently not supported" << dendl;
     throw std::system_error(EINVAL, std::system_category());
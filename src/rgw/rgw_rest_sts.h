@@ -55,6 +55,10 @@ class WebTokenEngine : public rgw::auth::Engine {
 
  bool validate_signature_using_n_e(const DoutPrefixProvider* dpp, const jwt::decoded_jwt& decoded, const std::string &algorithm, const std::string& n, const std::string& e) const;
 
+  std::string get_jwks(const DoutPrefixProvider* dpp, const std::string& iss, const std::vector<std::string>& thumbprints, optional_yield y) const;
+
+  bool validate_signature_using_jwks(const DoutPrefixProvider* dpp, const jwt::decoded_jwt& decoded, const std::string& algorithm, const std::vector<std::string>& thumbprints, const std::string& jwks) const;
+
   void validate_signature (const DoutPrefixProvider* dpp, const jwt::decoded_jwt& decoded, const std::string& algorithm, const std::string& iss, const std::vector<std::string>& thumbprints, optional_yield y) const;
 
   result_t authenticate(const DoutPrefixProvider* dpp,
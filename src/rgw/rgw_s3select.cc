@@ -3,6 +3,17 @@
 
 #include "rgw_s3select_private.h"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <boost/asio/defer.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include "common/async/yield_waiter.h"
+#include "include/scope_guard.h"
+
 #define dout_subsys ceph_subsys_rgw
 
 namespace rgw::s3select {
@@ -385,13 +396,8 @@ int RGWSelectObj_ObjStore_S3::get_params(optional_yield y)
   return RGWGetObj_ObjStore_S3::get_params(y);
 }
 
-int RGWSelectObj_ObjStore_S3::run_s3select_on_csv(const char* query, const char* input, size_t input_length)
+void RGWSelectObj_ObjStore_S3::get_csv_definitions(csv_object::csv_defintions& csv)
 {
-  int status = 0;
-  uint32_t length_before_processing, length_post_processing;
-  csv_object::csv_defintions csv;
-
-  s3select_syntax.parse_query(query);
   if (m_row_delimiter.size()) {
     csv.row_delimiter = *m_row_delimiter.c_str();
   }
@@ -426,6 +432,16 @@ int RGWSelectObj_ObjStore_S3::run_s3select_on_csv(const char* query, const char*
   } else if (m_header_info.compare("USE")==0) {
     csv.use_header_info=true;
   }
+}
+
+int RGWSelectObj_ObjStore_S3::run_s3select_on_csv(const char* query, const char* input, size_t input_length)
+{
+  int status = 0;
+  uint32_t length_before_processing, length_post_processing;
+  csv_object::csv_defintions csv;
+
+  s3select_syntax.parse_query(query);
+  get_csv_definitions(csv);
 
   m_s3_csv_object.set_csv_query(&s3select_syntax, csv);
 
@@ -638,6 +654,7 @@ int RGWSelectObj_ObjStore_S3::handle_aws_cli_parameters(std::string& sql_query)
     m_row_delimiter='\n';
   }
   extract_by_tag(m_s3select_input, "QuoteEscapeCharacter", m_escape_char);
+  extract_by_tag(m_s3select_input, "AllowQuotedRecordDelimiter", m_allow_quoted_record_delimiter);
   extract_by_tag(m_s3select_input, "CompressionType", m_compression_type);
   size_t _qo = m_s3select_query.find("<" + output_tag + ">", 0);
   size_t _qs = m_s3select_query.find("</" + output_tag + ">", _qi);
@@ -719,6 +736,399 @@ int RGWSelectObj_ObjStore_S3::range_request(int64_t ofs, int64_t len, void* buff
   return len;
 }
 
+namespace {
+
+// threads shared by all parallel scans, so their number doesn't grow with
+// the number of requests
+boost::asio::thread_pool& scan_pool(CephContext* cct)
+{
+  static boost::asio::thread_pool pool(
+      cct->_conf.get_val<uint64_t>("rgw_s3select_parallel_workers"));
+  return pool;
+}
+
+// Scans row-aligned ranges of a CSV object on the shared pool, each with
+// its own s3select engine and its own RADOS reads. The request emits the
+// results of the ranges in object order; at most `workers` ranges of a
+// request are scanned at once, and no more than `window` ahead of it, which
+// bounds the memory held by pending results. The scan is shared with its
+// tasks, so a request that ends early just stops it instead of waiting.
+class ParallelCsvScan : public std::enable_shared_from_this<ParallelCsvScan> {
+public:
+  struct Params {
+    std::string query;
+    csv_object::csv_defintions csv;
+    std::string header; // first row, prepended to all ranges but the first
+    uint64_t obj_size;
+    uint64_t range_size;
+    unsigned workers;
+  };
+
+  struct Range {
+    bool done = false;
+    int status = 0;
+    std::string error;
+    std::vector<std::string> results;
+    uint64_t scanned = 0;
+  };
+
+private:
+  // tasks may outlive the request, so keep copies of what they use
+  const std::string prefix;
+  const DoutPrefix dp;
+  const DoutPrefixProvider* const dpp = &dp;
+  const std::unique_ptr<rgw::sal::Bucket> bucket;
+  const rgw_obj_key key;
+  const Params params;
+  const size_t nranges;
+  const size_t window;
+
+  std::mutex mtx;
+  std::condition_variable cond;
+  std::vector<Range> ranges;
+  size_t next_claim = 0;
+  size_t next_emit = 0;
+  size_t running = 0;
+  std::optional<size_t> waiting_for; // set while the coroutine is suspended
+  bool stopping = false;
+  ceph::async::yield_waiter<void> waiter;
+
+  // blocking read of [ofs, ofs + len), a single ReadOp::read() does not
+  // cross a stripe
+  int read(rgw::sal::Object::ReadOp* op, uint64_t ofs, uint64_t len,
+           std::string& out) {
+    const uint64_t end = std::min(ofs + len, params.obj_size);
+    while (ofs < end) {
+      bufferlist bl;
+      int r = op->read(ofs, end - 1, bl, null_yield, dpp);
+      if (r < 0) {
+        return r;
+      } else if (r == 0) {
+        break;
+      }
+      for (const auto& p : bl.buffers()) {
+        out.append(p.c_str(), p.length());
+      }
+      ofs += bl.length();
+    }
+    return 0;
+  }
+
+  // a range owns the rows that start within it
+  int scan(size_t i, Range& range) {
+    auto obj = bucket->get_object(key);
+    auto op = obj->get_read_op();
+    int r = op->prepare(null_yield, dpp);
+    if (r < 0) {
+      return r;
+    }
+
+    const char delim = params.csv.row_delimiter;
+    const uint64_t begin = i * params.range_size;
+    const uint64_t end = std::min(begin + params.range_size, params.obj_size);
+
+    // read one byte before the range, so a row starting exactly at begin is
+    // recognized
+    const uint64_t read_from = begin ? begin - 1 : 0;
+    std::string data;
+    r = read(op.get(), read_from, end - read_from, data);
+    if (r < 0) {
+      return r;
+    }
+    size_t start = 0;
+    if (begin) {
+      start = data.find(delim);
+      if (start == std::string::npos) {
+        return 0; // no row starts here
+      }
+      ++start;
+    }
+    // complete the last row from the following bytes
+    static constexpr uint64_t tail_chunk = 64 * 1024;
+    if (!data.empty() && data.back() != delim) {
+      for (uint64_t ofs = end; ofs < params.obj_size; ofs += tail_chunk) {
+        const size_t old_size = data.size();
+        r = read(op.get(), ofs, tail_chunk, data);
+        if (r < 0) {
+          return r;
+        }
+        const auto pos = data.find(delim, old_size);
+        if (pos != std::string::npos) {
+          data.resize(pos + 1);
+          break;
+        }
+      }
+    }
+    range.scanned = data.size() - start;
+    if (range.scanned == 0) {
+      return 0;
+    }
+
+    std::string input;
+    const char* input_data = data.data() + start;
+    size_t input_len = range.scanned;
+    if (begin && !params.header.empty()) {
+      input.reserve(params.header.size() + input_len);
+      input.append(params.header).append(input_data, input_len);
+      input_data = input.data();
+      input_len = input.size();
+    }
+
+    // the engine hands over full result buffers through result_format, and
+    // expects a fresh one afterwards
+    std::string result;
+    std::function<int(std::string&)> fp_continue = [] (std::string&) {
+      return 0;
+    };
+    std::function<int(std::string&)> fp_result_format = [&range] (std::string& res) {
+      range.results.push_back(std::move(res));
+      res.clear();
+      return 0;
+    };
+    std::function<int(std::string&)> fp_header_format = [] (std::string&) {
+      return 0;
+    };
+    std::function<void(const char*)> fp_debug = [this] (const char* mesg) {
+      ldpp_dout(dpp, 20) << mesg << dendl;
+    };
+
+    s3select syntax;
+    syntax.parse_query(params.query.c_str());
+    csv_object engine;
+    engine.set_csv_query(&syntax, params.csv);
+    engine.set_external_system_functions(fp_continue, fp_result_format,
+                                         fp_header_format, fp_debug);
+    r = engine.run_s3select_on_stream(result, input_data, input_len, input_len);
+    if (r < 0) {
+      range.error = engine.get_error_description();
+      return r;
+    }
+    if (!result.empty()) {
+      range.results.push_back(std::move(result));
+    }
+    return 0;
+  }
+
+  // queue the ranges that may be scanned now. called with mtx held
+  void schedule() {
+    while (!stopping && running < params.workers && next_claim < nranges &&
+           next_claim < next_emit + window) {
+      ++running;
+      boost::asio::post(scan_pool(dpp->get_cct()),
+                        [self = shared_from_this(), i = next_claim++] {
+                          self->run(i);
+                        });
+    }
+  }
+
+  void run(size_t i) {
+    Range range;
+    {
+      std::lock_guard lock(mtx);
+      if (stopping) {
+        --running;
+        return;
+      }
+    }
+    range.status = scan(i, range);
+    range.done = true;
+
+    bool wake = false;
+    {
+      std::lock_guard lock(mtx);
+      --running;
+      if (stopping) {
+        return;
+      }
+      ranges[i] = std::move(range);
+      if (waiting_for == i) {
+        waiting_for.reset();
+        wake = true;
+      }
+      schedule();
+    }
+    cond.notify_all();
+    if (wake) {
+      waiter.complete(boost::system::error_code{});
+    }
+  }
+
+  static std::string make_prefix(const DoutPrefixProvider* dpp) {
+    std::ostringstream out;
+    dpp->gen_prefix(out);
+    return out.str();
+  }
+
+public:
+  ParallelCsvScan(const DoutPrefixProvider* dpp, rgw::sal::Bucket* bucket,
+                  const rgw_obj_key& key, Params&& p)
+    : prefix(make_prefix(dpp)),
+      dp(dpp->get_cct(), dout_subsys, prefix.c_str()),
+      bucket(bucket->clone()), key(key), params(std::move(p)),
+      nranges((params.obj_size + params.range_size - 1) / params.range_size),
+      window(2 * params.workers),
+      ranges(nranges)
+  {}
+
+  size_t size() const { return nranges; }
+
+  void start() {
+    std::lock_guard lock(mtx);
+    schedule();
+  }
+
+  // drop the results and let the ranges in progress finish on their own
+  void stop() {
+    std::lock_guard lock(mtx);
+    stopping = true;
+    waiting_for.reset();
+    ranges.clear();
+  }
+
+  // wait for range i, which must be the next one to emit, and take its
+  // results
+  Range take(size_t i, optional_yield y) {
+    if (y) {
+      auto& yield = y.get_yield_context();
+      // register only once the coroutine is suspended, so that a worker
+      // never completes the waiter before it waits
+      boost::asio::defer(yield.get_executor(), [this, i] {
+        std::unique_lock lock(mtx);
+        if (ranges[i].done) {
+          lock.unlock();
+          waiter.complete(boost::system::error_code{});
+        } else {
+          waiting_for = i;
+        }
+      });
+      waiter.async_wait(yield);
+    } else {
+      std::unique_lock lock(mtx);
+      cond.wait(lock, [this, i] { return ranges[i].done; });
+    }
+
+    Range range;
+    {
+      std::lock_guard lock(mtx);
+      range = std::move(ranges[i]);
+      next_emit = i + 1;
+      schedule();
+    }
+    cond.notify_all();
+    return range;
+  }
+};
+
+} // anonymous namespace
+
+int RGWSelectObj_ObjStore_S3::run_s3select_on_csv_parallel(optional_yield y)
+{
+  // -EOPNOTSUPP means the request should take the sequential path
+  const auto workers = s->cct->_conf.get_val<uint64_t>("rgw_s3select_parallel_workers");
+  const uint64_t range_size = s->cct->_conf.get_val<Option::size_t>("rgw_s3select_parallel_range_size");
+  if (workers < 2 || m_scan_range_ind || m_is_trino_request) {
+    return -EOPNOTSUPP;
+  }
+  // ranges are split on the row delimiter, which is only safe if the client
+  // states that no quoted field contains one
+  if (!boost::algorithm::iequals(m_allow_quoted_record_delimiter, "FALSE")) {
+    return -EOPNOTSUPP;
+  }
+
+  // results of aggregates and limits can't be merged from partial scans
+  s3select syntax;
+  syntax.parse_query(m_sql_query.c_str());
+  if (!syntax.get_error_description().empty() ||
+      syntax.is_aggregate_query() || syntax.is_limit()) {
+    return -EOPNOTSUPP;
+  }
+
+  // workers read the stored data directly, which is only the object's
+  // content when it is neither compressed nor encrypted
+  auto obj = s->bucket->get_object(s->object->get_key());
+  auto op = obj->get_read_op();
+  int r = op->prepare(y, this);
+  if (r < 0) {
+    return -EOPNOTSUPP;
+  }
+  const auto& attrs = obj->get_attrs();
+  if (attrs.count(RGW_ATTR_COMPRESSION) || attrs.count(RGW_ATTR_CRYPT_MODE)) {
+    return -EOPNOTSUPP;
+  }
+  const uint64_t obj_size = obj->get_size();
+  if (obj_size < 2 * range_size) {
+    return -EOPNOTSUPP;
+  }
+
+  ParallelCsvScan::Params params;
+  params.query = m_sql_query;
+  get_csv_definitions(params.csv);
+  params.obj_size = obj_size;
+  params.range_size = range_size;
+  params.workers = workers;
+  if (params.csv.use_header_info || params.csv.ignore_header_info) {
+    // the first row, up to and including its delimiter
+    static constexpr uint64_t header_chunk = 64 * 1024;
+    uint64_t ofs = 0;
+    while (ofs < obj_size) {
+      bufferlist bl;
+      r = op->read(ofs, std::min(ofs + header_chunk, obj_size) - 1, bl, y, this);
+      if (r <= 0) {
+        return -EOPNOTSUPP;
+      }
+      ofs += bl.length();
+      params.header.append(bl.to_str());
+      const auto pos = params.header.find(params.csv.row_delimiter);
+      if (pos != std::string::npos) {
+        params.header.resize(pos + 1);
+        break;
+      }
+    }
+  }
+
+  ldpp_dout(this, 10) << "s3select: parallel scan of " << obj_size << " bytes with "
+                      << workers << " workers, range size " << range_size << dendl;
+
+  m_object_size_for_processing = obj_size;
+  auto scan = std::make_shared<ParallelCsvScan>(this, s->bucket.get(),
+                                                s->object->get_key(),
+                                                std::move(params));
+  scan->start();
+  auto stop_scan = make_scope_guard([&scan] { scan->stop(); });
+
+  uint64_t returned = 0;
+  for (size_t i = 0; i < scan->size(); ++i) {
+    auto range = scan->take(i, y);
+    if (range.status < 0) {
+      if (range.error.empty()) {
+        range.error = cpp_strerror(range.status);
+      }
+      ldpp_dout(this, 10) << "s3select: failed to process range " << i << "; {"
+                          << range.error << "}" << dendl;
+      m_aws_response_handler.send_error_response(s3select_processTime_error,
+                                                 range.error.c_str());
+      return -EINVAL;
+    }
+    m_aws_response_handler.update_processed_size(range.scanned);
+    for (auto& result : range.results) {
+      returned += result.size();
+      fp_result_header_format(m_aws_response_handler.get_sql_result());
+      m_aws_response_handler.get_sql_result().append(result);
+      fp_s3select_result_format(m_aws_response_handler.get_sql_result());
+    }
+    if (enable_progress) {
+      m_aws_response_handler.init_progress_response();
+      m_aws_response_handler.send_progress_response();
+    }
+  }
+
+  m_aws_response_handler.update_total_bytes_returned(returned);
+  m_aws_response_handler.init_stats_response();
+  m_aws_response_handler.send_stats_response();
+  m_aws_response_handler.init_end_response();
+  return 0;
+}
+
 void RGWSelectObj_ObjStore_S3::execute(optional_yield y)
 {
   int status = 0;
@@ -790,7 +1200,12 @@ void RGWSelectObj_ObjStore_S3::execute(optional_yield y)
 	  }
 
 	} else {
-	  RGWGetObj::execute(y);
+	  status = m_json_type ? -EOPNOTSUPP : run_s3select_on_csv_parallel(y);
+	  if (status == -EOPNOTSUPP) {
+	    RGWGetObj::execute(y);
+	  } else if (status < 0) {
+	    op_ret = status;
+	  }
 	}
   }//if (m_parquet_type)
 }
@@ -205,6 +205,7 @@ private:
   std::string m_row_delimiter;
   std::string m_compression_type;
   std::string m_escape_char;
+  std::string m_allow_quoted_record_delimiter;
   std::string m_header_info;
   std::string m_sql_query;
   std::string m_enable_progress;
@@ -269,8 +270,12 @@ private:
 
   int json_processing(bufferlist& bl, off_t ofs, off_t len);
 
+  void get_csv_definitions(s3selectEngine::csv_object::csv_defintions& csv);
+
   int run_s3select_on_csv(const char* query, const char* input, size_t input_length);
 
+  int run_s3select_on_csv_parallel(optional_yield y);
+
   int run_s3select_on_parquet(const char* query);
 
   int run_s3select_on_json(const char* query, const char* input, size_t input_length);
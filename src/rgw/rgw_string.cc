@@ -3,6 +3,17 @@
 
 #include "rgw_string.h"
 #include <fnmatch.h>
+#include <cstring>
+#include <strings.h>
+
+static bool match_literal(const char* pattern, const char* input, size_t len,
+                          bool case_insensitive)
+{
+  if (case_insensitive) {
+    return strncasecmp(pattern, input, len) == 0;
+  }
+  return memcmp(pattern, input, len) == 0;
+}
 
 bool match_wildcards(const std::string& pattern, const std::string& input,
                      uint32_t flags)
@@ -14,6 +25,18 @@ bool match_wildcards(const std::string& pattern, const std::string& input,
     flag = FNM_CASEFOLD;
   }
 
+  // policy patterns are mostly "*", a literal, or a literal prefix followed
+  // by a single "*" (e.g. "bucket/*"); these are matched without fnmatch()
+  const auto meta = pattern.find_first_of("*?[\\");
+  if (meta == std::string::npos) {
+    return pattern.size() == input.size() &&
+      match_literal(pattern.data(), input.data(), input.size(), case_insensive);
+  }
+  if (meta == pattern.size() - 1 && pattern[meta] == '*') {
+    return input.size() >= meta &&
+      match_literal(pattern.data(), input.data(), meta, case_insensive);
+  }
+
   if (fnmatch(pattern.data(), input.data(), flag) == 0) {
     return true;
   } else {
@@ -0,0 +1,184 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab
+
+// Fills a cls_queue object and drains it the way the queue consumers do,
+// then reports the entries drained per second. Entries are listed plainly,
+// in bulk, or in bulk with the removal of each batch sent along with the
+// listing of the next one.
+
+#include "include/types.h"
+
+#include "cls/queue/cls_queue_client.h"
+#include "test/librados/test_cxx.h"
+
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+
+int main(int argc, char **argv)
+{
+  int ops = 100;
+  int elements = 1000;
+  size_t element_size = 32;
+  uint64_t batch = 1024;
+  std::string mode = "pipelined";
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("ops", po::value<int>(&ops)->default_value(ops),
+     "number of enqueue ops")
+    ("elements", po::value<int>(&elements)->default_value(elements),
+     "number of entries enqueued per op")
+    ("element-size", po::value<size_t>(&element_size)->default_value(element_size),
+     "size of each entry in bytes")
+    ("batch", po::value<uint64_t>(&batch)->default_value(batch),
+     "max entries listed per round trip")
+    ("mode", po::value<std::string>(&mode)->default_value(mode),
+     "plain, bulk or pipelined");
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+  if (mode != "plain" && mode != "bulk" && mode != "pipelined") {
+    std::cerr << "unknown mode: " << mode << std::endl;
+    return 1;
+  }
+  const bool bulk = mode != "plain";
+  const bool pipelined = mode == "pipelined";
+
+  librados::Rados rados;
+  librados::IoCtx ioctx;
+  const std::string pool_name = get_temp_pool_name();
+  const std::string err = create_one_pool_pp(pool_name, rados);
+  if (!err.empty()) {
+    std::cerr << err << std::endl;
+    return 1;
+  }
+  int r = rados.ioctx_create(pool_name.c_str(), ioctx);
+  if (r < 0) {
+    std::cerr << "failed to open pool " << pool_name << ": r=" << r << std::endl;
+    destroy_one_pool_pp(pool_name, rados);
+    return 1;
+  }
+
+  const std::string queue_name = "drain-queue";
+  {
+    // room for everything, with the per-entry overhead
+    const uint64_t queue_size = uint64_t(ops) * elements * (element_size + 64);
+    librados::ObjectWriteOperation op;
+    op.create(true);
+    cls_queue_init(op, queue_name, queue_size);
+    r = ioctx.operate(queue_name, &op);
+  }
+  for (int i = 0; r == 0 && i < ops; ++i) {
+    std::vector<bufferlist> data(elements);
+    for (auto& bl : data) {
+      bl.append(std::string(element_size, 'x'));
+    }
+    librados::ObjectWriteOperation op;
+    cls_queue_enqueue(op, 0, data);
+    r = ioctx.operate(queue_name, &op);
+  }
+  if (r < 0) {
+    std::cerr << "failed to fill the queue: r=" << r << std::endl;
+    ioctx.close();
+    destroy_one_pool_pp(pool_name, rados);
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t total = 0;
+  uint64_t bytes = 0;
+  // end of the last listing, up to where the queue is removed next
+  std::string marker;
+  bool truncated = true;
+  while (truncated) {
+    std::unique_ptr<librados::AioCompletion> removal;
+    if (pipelined && !marker.empty()) {
+      librados::ObjectWriteOperation op;
+      cls_queue_remove_entries(op, marker);
+      removal.reset(librados::Rados::aio_create_completion());
+      r = ioctx.aio_operate(queue_name, removal.get(), &op);
+      if (r < 0) {
+        break;
+      }
+    }
+    std::string next_marker;
+    if (bulk) {
+      librados::ObjectReadOperation op;
+      bufferlist obl;
+      int rval = 0;
+      cls_queue_list_entries_bulk(op, marker, batch, &obl, &rval);
+      r = ioctx.operate(queue_name, &op, nullptr);
+      cls_queue_list_ret ret;
+      if (r == 0) {
+        r = cls_queue_list_entries_result(obl, ret);
+      }
+      if (r == 0) {
+        cls_queue_list_iterator it(ret);
+        cls_queue_entry entry;
+        while ((r = it.next(entry)) > 0) {
+          ++total;
+          bytes += entry.data.length();
+        }
+        truncated = ret.is_truncated;
+        next_marker = std::move(ret.next_marker);
+      }
+    } else {
+      std::vector<cls_queue_entry> entries;
+      r = cls_queue_list_entries(ioctx, queue_name, marker, batch, entries,
+                                 &truncated, next_marker);
+      for (const auto& entry : entries) {
+        bytes += entry.data.length();
+      }
+      total += entries.size();
+    }
+    if (removal) {
+      removal->wait_for_complete();
+      if (r == 0) {
+        r = removal->get_return_value();
+      }
+    }
+    if (r < 0) {
+      break;
+    }
+    marker = std::move(next_marker);
+    if (!pipelined || !truncated) {
+      librados::ObjectWriteOperation op;
+      cls_queue_remove_entries(op, marker);
+      r = ioctx.operate(queue_name, &op);
+      if (r < 0) {
+        break;
+      }
+    }
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  ioctx.close();
+  destroy_one_pool_pp(pool_name, rados);
+  if (r < 0) {
+    std::cerr << "failed to drain the queue: r=" << r << std::endl;
+    return 1;
+  }
+  std::cout << mode << ": drained " << total << " entries (" << bytes
+            << " bytes) in " << elapsed.count()
+            << "s, " << static_cast<uint64_t>(total / elapsed.count())
+            << " entries/s" << std::endl;
+  return 0;
+}
@@ -650,3 +650,105 @@ TEST_F(TestClsQueue, WrapAround)
   }
 }
 
+
+TEST_F(TestClsQueue, BulkListWrapAround)
+{
+  const std::string queue_name = "my-queue";
+  const auto number_of_entries = 10U;
+  const auto max_entry_size = 2000;
+  const auto min_entry_size = 1000;
+  const uint64_t queue_size = number_of_entries*max_entry_size;
+  const auto entry_overhead = 10;
+  librados::ObjectWriteOperation op;
+  op.create(true);
+  cls_queue_init(op, queue_name, queue_size);
+  ASSERT_EQ(0, ioctx.operate(queue_name, &op));
+
+  auto fill = [&] (unsigned entries) {
+    for (auto i = 0U; i < entries; ++i) {
+      const auto entry_size = rand()%(max_entry_size - min_entry_size + 1) + min_entry_size;
+      std::string entry_str(entry_size-entry_overhead, 0);
+      std::generate_n(entry_str.begin(), entry_str.size(), [](){return (char)(rand());});
+      bufferlist entry_bl;
+      entry_bl.append(entry_str);
+      std::vector<bufferlist> data{{entry_bl}};
+      cls_queue_enqueue(op, 0, data);
+      ASSERT_EQ(0, ioctx.operate(queue_name, &op));
+    }
+  };
+  fill(number_of_entries);
+
+  std::string marker;
+  for (auto j = 0; j < 10; ++j) {
+    // bulk and plain listings of half+1 of the queue agree, across the wrap around
+    const auto max_elements = number_of_entries/2 + 1;
+    bool truncated;
+    std::string end_marker;
+    std::vector<cls_queue_entry> entries;
+    auto ret = cls_queue_list_entries(ioctx, queue_name, marker, max_elements, entries, &truncated, end_marker);
+    ASSERT_EQ(0, ret);
+
+    cls_queue_list_ret bulk_ret;
+    ret = cls_queue_list_entries_bulk(ioctx, queue_name, marker, max_elements, bulk_ret);
+    ASSERT_EQ(0, ret);
+    ASSERT_TRUE(bulk_ret.bulk);
+    ASSERT_TRUE(bulk_ret.entries.empty());
+    ASSERT_EQ(entries.size(), bulk_ret.num_entries);
+    ASSERT_EQ(truncated, bulk_ret.is_truncated);
+    ASSERT_EQ(end_marker, bulk_ret.next_marker);
+
+    cls_queue_list_iterator it(bulk_ret);
+    ASSERT_EQ(entries.size(), it.size());
+    for (const auto& entry : entries) {
+      ASSERT_EQ(entry.marker, it.marker());
+      cls_queue_entry bulk_entry;
+      ASSERT_EQ(1, it.next(bulk_entry));
+      ASSERT_EQ(entry.marker, bulk_entry.marker);
+      ASSERT_EQ(entry.data, bulk_entry.data);
+    }
+    cls_queue_entry bulk_entry;
+    ASSERT_EQ(0, it.next(bulk_entry));
+    ASSERT_EQ(end_marker, it.marker());
+
+    marker = end_marker;
+    cls_queue_remove_entries(op, end_marker);
+    ASSERT_EQ(0, ioctx.operate(queue_name, &op));
+    fill(number_of_entries/2 + 1);
+  }
+
+  // a bulk listing without a limit stops at about one large chunk of data,
+  // and the next listing continues from there
+  const std::string big_queue_name = "my-big-queue";
+  const auto big_entry_size = 64*1024;
+  const auto big_entries = 128U;
+  op.create(true);
+  cls_queue_init(op, big_queue_name, big_entries*(big_entry_size + entry_overhead));
+  ASSERT_EQ(0, ioctx.operate(big_queue_name, &op));
+  for (auto i = 0U; i < big_entries; ++i) {
+    bufferlist entry_bl;
+    entry_bl.append(std::string(big_entry_size, 'a' + i%26));
+    std::vector<bufferlist> data{{entry_bl}};
+    cls_queue_enqueue(op, 0, data);
+    ASSERT_EQ(0, ioctx.operate(big_queue_name, &op));
+  }
+  marker.clear();
+  auto total_elements = 0U;
+  auto listings = 0U;
+  cls_queue_list_ret bulk_ret;
+  do {
+    bulk_ret = cls_queue_list_ret();
+    ASSERT_EQ(0, cls_queue_list_entries_bulk(ioctx, big_queue_name, marker, big_entries, bulk_ret));
+    cls_queue_list_iterator it(bulk_ret);
+    cls_queue_entry entry;
+    int ret;
+    while ((ret = it.next(entry)) > 0) {
+      ASSERT_EQ(std::string(big_entry_size, 'a' + total_elements%26), entry.data.to_str());
+      ++total_elements;
+    }
+    ASSERT_EQ(0, ret);
+    marker = bulk_ret.next_marker;
+    ++listings;
+  } while (bulk_ret.is_truncated);
+  ASSERT_EQ(big_entries, total_elements);
+  ASSERT_GT(listings, 1U);
+}
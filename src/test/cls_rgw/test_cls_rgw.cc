@@ -1193,6 +1193,106 @@ TEST_F(cls_rgw, usage_basic)
   ASSERT_EQ(0, cls_rgw_usage_log_trim(ioctx, oid, "", bucket2, start_epoch, end_epoch));
 }
 
+TEST_F(cls_rgw, usage_rollup)
+{
+  string oid="usage.2";
+  string user="user1";
+  uint64_t an_hour{3600}, a_day{86400};
+  uint64_t day{1755820800};
+  int total_usage_entries = 10;
+  uint64_t max_entries = 2000;
+  string payer;
+
+  for (uint64_t hour = 0; hour < 3; ++hour) {
+    auto info = populate_usage_log_info(user, payer, total_usage_entries, day + hour * an_hour);
+    for (auto& entry : info.entries) {
+      entry.add_usage("get_obj", rgw_usage_data(100, 10));
+    }
+    ObjectWriteOperation op;
+    cls_rgw_usage_log_add(op, info);
+    ASSERT_EQ(0, ioctx.operate(oid, &op));
+  }
+
+  // everything but the first record of the day gets merged into it
+  ObjectWriteOperation op;
+  cls_rgw_usage_log_rollup(op, day + 1, day + a_day, a_day);
+  ASSERT_EQ(0, ioctx.operate(oid, &op));
+  ObjectWriteOperation op2;
+  cls_rgw_usage_log_rollup(op2, day + 1, day + a_day, a_day);
+  ASSERT_EQ(-ENODATA, ioctx.operate(oid, &op2));
+
+  string read_iter;
+  map <rgw_user_bucket, rgw_usage_log_entry> usage;
+  bool truncated;
+  int ret = cls_rgw_usage_log_read(ioctx, oid, user, "", day + 1, day + a_day,
+                                   max_entries, read_iter, usage, &truncated);
+  ASSERT_EQ(0, ret);
+  ASSERT_EQ(0u, usage.size());
+
+  ret = cls_rgw_usage_log_read(ioctx, oid, user, "", day, day + 1,
+                               max_entries, read_iter, usage, &truncated);
+  ASSERT_EQ(0, ret);
+  ASSERT_EQ(static_cast<uint64_t>(total_usage_entries), usage.size());
+  for (const auto& [ub, entry] : usage) {
+    ASSERT_EQ(day, entry.epoch);
+    ASSERT_EQ(300u, entry.total_usage.bytes_sent);
+    ASSERT_EQ(30u, entry.total_usage.bytes_received);
+  }
+
+  ASSERT_EQ(0, cls_rgw_usage_log_trim(ioctx, oid, "", "", 0, day + a_day));
+}
+
+TEST_F(cls_rgw, usage_rollup_skipped_page)
+{
+  string oid="usage.3";
+  string user="user1";
+  uint64_t an_hour{3600}, a_day{86400};
+  uint64_t day{1755820800};
+  string payer;
+
+  // more records than a call lists that are rolled up already, followed by
+  // some that aren't
+  {
+    auto info = populate_usage_log_info(user, payer, 1100, day);
+    ObjectWriteOperation op;
+    cls_rgw_usage_log_add(op, info);
+    ASSERT_EQ(0, ioctx.operate(oid, &op));
+  }
+  {
+    auto info = populate_usage_log_info(user, payer, 10, day + an_hour);
+    ObjectWriteOperation op;
+    cls_rgw_usage_log_add(op, info);
+    ASSERT_EQ(0, ioctx.operate(oid, &op));
+  }
+
+  uint64_t start_epoch = day;
+  int calls = 0;
+  int ret = 0;
+  do {
+    ASSERT_LT(++calls, 5);
+    ObjectWriteOperation op;
+    bufferlist reply;
+    cls_rgw_usage_log_rollup(op, start_epoch, day + a_day, a_day, &reply);
+    ret = ioctx.operate(oid, &op, librados::OPERATION_RETURNVEC);
+    if (ret == 0) {
+      rgw_cls_usage_log_rollup_ret r;
+      ASSERT_EQ(0, cls_rgw_usage_log_rollup_result(reply, r));
+      start_epoch = r.next_epoch;
+    }
+  } while (ret == 0);
+  ASSERT_EQ(-ENODATA, ret);
+
+  string read_iter;
+  map <rgw_user_bucket, rgw_usage_log_entry> usage;
+  bool truncated;
+  ret = cls_rgw_usage_log_read(ioctx, oid, user, "", day + 1, day + a_day,
+                               2000, read_iter, usage, &truncated);
+  ASSERT_EQ(0, ret);
+  ASSERT_EQ(0u, usage.size());
+
+  ASSERT_EQ(0, cls_rgw_usage_log_trim(ioctx, oid, "", "", 0, day + a_day));
+}
+
 TEST_F(cls_rgw, usage_clear_no_obj)
 {
   string user="user1";
@@ -1638,3 +1738,52 @@ TEST_F(cls_rgw, bi_put_entries)
     test_stats(ioctx, dst_bucket, RGWObjCategory::Main, 3, 24576);
   }
 }
+
+TEST_F(cls_rgw, link_olh_reply)
+{
+  const string bucket_oid = __func__;
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  bufferlist olh_tag;
+  olh_tag.append("olhtag");
+  rgw_bucket_dir_entry_meta meta;
+  rgw_zone_set zones_trace;
+
+  auto link = [&] (const cls_rgw_obj_key& key, const string& op_tag,
+                   rgw_cls_link_olh_ret& ret) {
+    ObjectWriteOperation op;
+    bufferlist reply;
+    cls_rgw_bucket_link_olh(op, key, olh_tag, false, op_tag, &meta, 0,
+                            ceph::real_time{}, true, false, zones_trace, &reply);
+    int r = ioctx.operate(bucket_oid, &op, librados::OPERATION_RETURNVEC);
+    if (r < 0) {
+      return r;
+    }
+    return cls_rgw_bucket_link_olh_result(reply, ret);
+  };
+
+  // the first link is the only entry in the olh log
+  rgw_cls_link_olh_ret ret1;
+  ASSERT_EQ(0, link(cls_rgw_obj_key("obj", "v1"), "tag1", ret1));
+  EXPECT_TRUE(ret1.own_log);
+  EXPECT_FALSE(ret1.removing);
+  EXPECT_LT(0u, ret1.olh_epoch);
+
+  // without a trim, the second link finds the first one's entry
+  rgw_cls_link_olh_ret ret2;
+  ASSERT_EQ(0, link(cls_rgw_obj_key("obj", "v2"), "tag2", ret2));
+  EXPECT_FALSE(ret2.own_log);
+  EXPECT_LT(ret1.olh_epoch, ret2.olh_epoch);
+
+  // once the log is trimmed, the next link owns it again
+  {
+    ObjectWriteOperation op;
+    cls_rgw_trim_olh_log(op, cls_rgw_obj_key("obj"), ret2.olh_epoch, "olhtag");
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  rgw_cls_link_olh_ret ret3;
+  ASSERT_EQ(0, link(cls_rgw_obj_key("obj", "v3"), "tag3", ret3));
+  EXPECT_TRUE(ret3.own_log);
+}
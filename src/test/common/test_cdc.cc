@@ -111,6 +111,24 @@ TEST_P(CDCTest, specific_result)
   ASSERT_EQ(chunks, expected[GetParam()]);
 }
 
+TEST_P(CDCTest, contiguous_matches_fragmented)
+{
+  // a single-buffer bufferlist takes a separate (possibly vectorized)
+  // path; it must cut at the same points
+  for (int seed = 0; seed < 4; ++seed) {
+    bufferlist fragmented;
+    generate_buffer(4*1024*1024 + seed * 12345, &fragmented, seed);
+    ASSERT_GT(fragmented.get_num_buffers(), 1u);
+    bufferlist contiguous = fragmented;
+    contiguous.rebuild();
+    ASSERT_EQ(contiguous.get_num_buffers(), 1u);
+
+    vector<pair<uint64_t, uint64_t>> chunks1, chunks2;
+    cdc->calc_chunks(fragmented, &chunks1);
+    cdc->calc_chunks(contiguous, &chunks2);
+    ASSERT_EQ(chunks1, chunks2);
+  }
+}
 
 void do_size_histogram(CDC& cdc, bufferlist& bl,
 		       map<int,int> *h)
@@ -0,0 +1,181 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+// Builds a synthetic versioned-backup corpus, where each version of an image
+// is the previous one with a few regions overwritten, inserted or deleted,
+// and splits every version the way dedup with rgw_dedup_cdc does: FastCDC
+// chunks named by their BLAKE3 hash. Reports the dedup ratio against
+// whole-object dedup and fixed-size stripes, and the chunking and hashing
+// throughput.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "BLAKE3/c/blake3.h"
+#include "common/CDC.h"
+#include "include/buffer.h"
+
+namespace po = boost::program_options;
+
+namespace {
+
+std::string chunk_hash(const ceph::bufferlist& bl, uint64_t ofs, uint64_t len)
+{
+  ceph::bufferlist chunk;
+  chunk.substr_of(bl, ofs, len);
+  blake3_hasher hasher;
+  blake3_hasher_init(&hasher);
+  for (const auto& bptr : chunk.buffers()) {
+    blake3_hasher_update(&hasher, (const unsigned char *)bptr.c_str(), bptr.length());
+  }
+  std::string hash(BLAKE3_OUT_LEN, '\0');
+  blake3_hasher_finalize(&hasher, (uint8_t*)hash.data(), BLAKE3_OUT_LEN);
+  return hash;
+}
+
+void random_fill(std::mt19937_64& rng, std::string& s, size_t pos, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    s[pos + i] = static_cast<char>(rng());
+  }
+}
+
+// the chunks a dedup store keeps once, and the bytes they take
+struct chunk_store {
+  std::unordered_set<std::string> hashes;
+  uint64_t stored = 0;
+
+  void add(const ceph::bufferlist& bl, uint64_t ofs, uint64_t len) {
+    if (hashes.insert(chunk_hash(bl, ofs, len)).second) {
+      stored += len;
+    }
+  }
+};
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  uint64_t image_size = 256 << 20;
+  unsigned versions = 10;
+  unsigned changes = 8;
+  uint64_t change_size = 512 << 10;
+  int chunk_bits = 20;
+  uint64_t stripe_size = 4 << 20;
+  uint64_t seed = 1;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("image-size", po::value<uint64_t>(&image_size)->default_value(image_size),
+     "size of the first version of the image, in bytes")
+    ("versions", po::value<unsigned>(&versions)->default_value(versions),
+     "number of versions of the image")
+    ("changes", po::value<unsigned>(&changes)->default_value(changes),
+     "number of changed regions from one version to the next")
+    ("change-size", po::value<uint64_t>(&change_size)->default_value(change_size),
+     "size of each changed region, in bytes")
+    ("chunk-bits", po::value<int>(&chunk_bits)->default_value(chunk_bits),
+     "target chunk size as a power of 2, as rgw_dedup_cdc_chunk_bits")
+    ("stripe-size", po::value<uint64_t>(&stripe_size)->default_value(stripe_size),
+     "size of the fixed stripes compared against, in bytes")
+    ("seed", po::value<uint64_t>(&seed)->default_value(seed),
+     "seed of the corpus");
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+  if (image_size == 0 || versions == 0 || change_size == 0 || stripe_size == 0 ||
+      image_size < 2 * change_size) {
+    std::cerr << "invalid sizes or counts" << std::endl;
+    return 1;
+  }
+
+  auto cdc = CDC::create("fastcdc", chunk_bits);
+  std::mt19937_64 rng{seed};
+  std::string image(image_size, '\0');
+  random_fill(rng, image, 0, image.size());
+
+  chunk_store cdc_store;
+  chunk_store stripe_store;
+  uint64_t logical = 0;
+  uint64_t num_chunks = 0;
+  std::chrono::duration<double> cdc_time{0};
+
+  for (unsigned v = 0; v < versions; v++) {
+    if (v > 0) {
+      // an overwrite, an insert or a delete of change_size bytes per region
+      for (unsigned c = 0; c < changes; c++) {
+        const size_t pos = rng() % (image.size() - change_size);
+        switch (rng() % 3) {
+        case 0:
+          random_fill(rng, image, pos, change_size);
+          break;
+        case 1: {
+          std::string inserted(change_size, '\0');
+          random_fill(rng, inserted, 0, inserted.size());
+          image.insert(pos, inserted);
+          break;
+        }
+        default:
+          if (image.size() > 2 * change_size) {
+            image.erase(pos, change_size);
+          }
+          break;
+        }
+      }
+    }
+
+    // one contiguous buffer, as dedup reads an object to chunk it
+    ceph::bufferlist bl;
+    bl.append(image);
+    bl.rebuild();
+    logical += bl.length();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::pair<uint64_t, uint64_t>> chunks;
+    cdc->calc_chunks(bl, &chunks);
+    for (const auto& [ofs, len] : chunks) {
+      cdc_store.add(bl, ofs, len);
+    }
+    cdc_time += std::chrono::steady_clock::now() - start;
+    num_chunks += chunks.size();
+
+    for (uint64_t ofs = 0; ofs < bl.length(); ofs += stripe_size) {
+      stripe_store.add(bl, ofs, std::min<uint64_t>(stripe_size, bl.length() - ofs));
+    }
+  }
+
+  // versions always differ, so whole-object dedup keeps every byte
+  std::cout << "corpus: " << versions << " versions, " << logical
+            << " bytes" << std::endl;
+  std::cout << "whole-object dedup: stored " << logical
+            << " bytes, ratio 1.00" << std::endl;
+  std::cout << "fixed " << stripe_size << " byte stripes: stored "
+            << stripe_store.stored << " bytes, ratio "
+            << double(logical) / stripe_store.stored << std::endl;
+  std::cout << "fastcdc chunks: " << num_chunks << " chunks of "
+            << logical / std::max<uint64_t>(num_chunks, 1)
+            << " bytes on average, " << cdc_store.hashes.size()
+            << " unique, stored " << cdc_store.stored << " bytes, ratio "
+            << double(logical) / cdc_store.stored << std::endl;
+  std::cout << "fastcdc chunking and hashing: " << cdc_time.count() << "s, "
+            << logical / cdc_time.count() / (1 << 20) << " MiB/s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,136 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright contributors to the Ceph project
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+// Measures rgw::IAM::Policy::eval() throughput on a bucket policy shaped
+// like those of multi-team tenants: one statement per prefix, each granting
+// a few actions, some with conditions, and a trailing deny.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+#include <fmt/format.h>
+
+#include "common/ceph_context.h"
+#include "rgw_iam_policy.h"
+
+using rgw::ARN;
+using rgw::Partition;
+using rgw::Service;
+using rgw::IAM::Effect;
+using rgw::IAM::Environment;
+using rgw::IAM::Policy;
+
+static std::string make_policy(int nstatements)
+{
+  static const char* const actions[] = {
+    R"("s3:GetObject", "s3:GetObjectVersion")",
+    R"("s3:PutObject", "s3:AbortMultipartUpload")",
+    R"("s3:DeleteObject")",
+    R"("s3:GetObject*", "s3:ListMultipartUploadParts")",
+  };
+
+  std::string text = R"({"Version": "2012-10-17", "Statement": [)";
+  for (int i = 0; i < nstatements; ++i) {
+    text += fmt::format(
+      R"({{"Sid": "team{0}", "Effect": "Allow", "Action": [{1}], )"
+      R"("Resource": ["arn:aws:s3:::bucket/team{0}/*", "arn:aws:s3:::bucket/shared/team{0}-*"])",
+      i, actions[i % std::size(actions)]);
+    if (i % 3 == 0) {
+      text += fmt::format(
+        R"(, "Condition": {{"StringLike": {{"s3:prefix": ["team{}/*"]}}}})", i);
+    }
+    text += "},";
+  }
+  text += R"({"Sid": "fence", "Effect": "Deny", "Action": "s3:*", )"
+    R"("NotResource": ["arn:aws:s3:::bucket", "arn:aws:s3:::bucket/*"]}]})";
+  return text;
+}
+
+int main(int argc, char** argv)
+{
+  int nstatements = 50;
+  int64_t iterations = 1000000;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("statements", po::value<int>(&nstatements)->default_value(nstatements),
+     "number of allow statements in the policy")
+    ("iterations", po::value<int64_t>(&iterations)->default_value(iterations),
+     "number of evaluations");
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  boost::intrusive_ptr<CephContext> cct(new CephContext(CEPH_ENTITY_TYPE_CLIENT), false);
+  const std::string tenant;
+  const Policy p(cct.get(), &tenant, make_policy(nstatements), false);
+
+  Environment e;
+  e.emplace("aws:SourceIp", "10.1.2.3");
+  e.emplace("s3:prefix", fmt::format("team{}/reports/", nstatements / 2));
+
+  struct Request {
+    uint64_t action;
+    ARN resource;
+  };
+  const int mid = nstatements / 2;
+  const std::vector<Request> requests = {
+    {rgw::IAM::s3GetObject,
+     ARN(Partition::aws, Service::s3, "", "", fmt::format("bucket/team{}/reports/q3.csv", mid))},
+    {rgw::IAM::s3PutObject,
+     ARN(Partition::aws, Service::s3, "", "", fmt::format("bucket/team{}/upload.bin", mid + 1))},
+    {rgw::IAM::s3DeleteObject,
+     ARN(Partition::aws, Service::s3, "", "", "bucket/shared/team2-notes.txt")},
+    {rgw::IAM::s3ListBucket,
+     ARN(Partition::aws, Service::s3, "", "", "bucket")},
+    {rgw::IAM::s3GetObject,
+     ARN(Partition::aws, Service::s3, "", "", "other/object")},
+  };
+
+  int64_t allowed = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < iterations; ++i) {
+    const auto& r = requests[i % requests.size()];
+    if (p.eval(e, boost::none, r.action, r.resource) == Effect::Allow) {
+      ++allowed;
+    }
+  }
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  std::cout << "statements: " << p.statements.size()
+            << " evaluations: " << iterations
+            << " allowed: " << allowed << std::endl;
+  std::cout << "elapsed: " << elapsed.count() << "s, "
+            << static_cast<int64_t>(iterations / elapsed.count())
+            << " evaluations/s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,144 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+// Issues random reads or writes against one file from many coroutines, the
+// way the POSIX driver does for object data, with rgw_posix_io_uring on or
+// off, and reports the operations and bytes per second.
+
+#include "rgw_posix_uring.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/program_options.hpp>
+
+#include "common/ceph_argparse.h"
+#include "common/common_init.h"
+#include "common/dout.h"
+#include "common/errno.h"
+#include "global/global_init.h"
+
+namespace po = boost::program_options;
+using namespace rgw::sal;
+
+int main(int argc, char **argv)
+{
+  std::string path = "bench_rgw_posix_io.dat";
+  uint64_t file_size = 1 << 30;
+  size_t block_size = 4 << 10;
+  uint64_t ops = 100000;
+  unsigned concurrency = 64;
+  unsigned threads = 4;
+  bool use_uring = true;
+  bool write = false;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("file", po::value<std::string>(&path)->default_value(path),
+     "file to read or write, created if missing")
+    ("file-size", po::value<uint64_t>(&file_size)->default_value(file_size),
+     "size of the region accessed, in bytes")
+    ("block-size", po::value<size_t>(&block_size)->default_value(block_size),
+     "size of each read or write, in bytes")
+    ("ops", po::value<uint64_t>(&ops)->default_value(ops),
+     "total number of reads or writes")
+    ("concurrency", po::value<unsigned>(&concurrency)->default_value(concurrency),
+     "number of coroutines issuing I/O")
+    ("threads", po::value<unsigned>(&threads)->default_value(threads),
+     "number of threads running the coroutines")
+    ("uring", po::value<bool>(&use_uring)->default_value(use_uring),
+     "use io_uring rather than blocking system calls")
+    ("write", po::bool_switch(&write), "write instead of read");
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+  if (block_size == 0 || file_size < block_size || concurrency == 0 || threads == 0) {
+    std::cerr << "invalid sizes or counts" << std::endl;
+    return 1;
+  }
+
+  std::vector<const char*> args;
+  const std::string uring_arg = std::string("--rgw_posix_io_uring=") +
+                                (use_uring ? "true" : "false");
+  args.push_back(uring_arg.c_str());
+  auto cct = global_init(nullptr, args, CEPH_ENTITY_TYPE_CLIENT,
+                         CODE_ENVIRONMENT_UTILITY,
+                         CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(cct.get());
+  NoDoutPrefix dpp{cct.get(), ceph_subsys_rgw};
+
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    std::cerr << "failed to open " << path << ": " << cpp_strerror(errno) << std::endl;
+    return 1;
+  }
+  if (::ftruncate(fd, file_size) < 0) {
+    std::cerr << "failed to size " << path << ": " << cpp_strerror(errno) << std::endl;
+    ::close(fd);
+    return 1;
+  }
+
+  boost::asio::io_context context;
+  std::atomic<uint64_t> issued{0};
+  std::atomic<uint64_t> failed{0};
+  const uint64_t num_blocks = file_size / block_size;
+  auto rethrow = [] (std::exception_ptr eptr) {
+    if (eptr) std::rethrow_exception(eptr);
+  };
+
+  for (unsigned c = 0; c < concurrency; c++) {
+    boost::asio::spawn(context, [&, c] (boost::asio::yield_context yield) {
+      std::minstd_rand rng{c};
+      std::uniform_int_distribution<uint64_t> dist(0, num_blocks - 1);
+      std::string buf(block_size, 'x');
+      while (issued++ < ops) {
+        const off_t ofs = dist(rng) * block_size;
+        ssize_t r = write ?
+          posix_io::pwrite(&dpp, fd, buf.data(), buf.size(), ofs, yield) :
+          posix_io::pread(&dpp, fd, buf.data(), buf.size(), ofs, yield);
+        if (r < 0) {
+          failed++;
+        }
+      }
+    }, rethrow);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; t++) {
+    workers.emplace_back([&context] { context.run(); });
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  ::close(fd);
+
+  std::cout << (use_uring ? "io_uring" : "blocking") << " "
+            << (write ? "writes" : "reads") << ": " << ops << " ops of "
+            << block_size << " bytes in " << elapsed.count() << "s, "
+            << ops / elapsed.count() << " ops/s, "
+            << ops * block_size / elapsed.count() / (1 << 20) << " MiB/s, "
+            << failed << " failed" << std::endl;
+  return failed ? 1 : 0;
+}
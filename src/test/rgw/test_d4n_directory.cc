@@ -595,6 +595,80 @@ TEST_F(BlockDirectoryFixture, RemoveHostYield)
   io.run();
 }
 
+TEST_F(BlockDirectoryFixture, PipelinedUpdateFieldYield)
+{
+  boost::asio::spawn(io, [this] (boost::asio::yield_context yield) {
+    std::vector<rgw::d4n::CacheBlock> blocks;
+    for (uint64_t i = 0; i < 3; i++) {
+      rgw::d4n::CacheBlock b = *block;
+      b.blockID = i;
+      blocks.push_back(b);
+    }
+    ASSERT_EQ(0, dir->set(env->dpp, &blocks[0], optional_yield{yield}));
+    ASSERT_EQ(0, dir->set(env->dpp, &blocks[1], optional_yield{yield}));
+
+    std::string dirty = "true";
+    std::string host = "127.0.0.1:5000";
+    ASSERT_EQ(0, dir->update_field(env->dpp, blocks, "dirty", dirty, optional_yield{yield}));
+    ASSERT_EQ(0, dir->update_field(env->dpp, blocks, "hosts", host, optional_yield{yield}));
+
+    boost::system::error_code ec;
+    request req;
+    req.push("HMGET", "testBucket_testName_0_0", "dirty", "hosts");
+    req.push("HMGET", "testBucket_testName_1_0", "dirty", "hosts");
+    req.push("EXISTS", "testBucket_testName_2_0");
+    req.push("FLUSHALL");
+    response< std::vector<std::string>,
+	      std::vector<std::string>,
+	      int,
+	      boost::redis::ignore_t> resp;
+
+    conn->async_exec(req, resp, yield[ec]);
+
+    ASSERT_EQ((bool)ec, false);
+    EXPECT_EQ(std::get<0>(resp).value()[0], "1");
+    EXPECT_EQ(std::get<0>(resp).value()[1], "127.0.0.1:6379_127.0.0.1:5000");
+    EXPECT_EQ(std::get<1>(resp).value()[0], "1");
+    EXPECT_EQ(std::get<1>(resp).value()[1], "127.0.0.1:6379_127.0.0.1:5000");
+    EXPECT_EQ(std::get<2>(resp).value(), 0); // update_field does not create missing blocks
+
+    conn->cancel();
+  }, rethrow);
+
+  io.run();
+}
+
+TEST_F(BlockDirectoryFixture, PipelinedDelYield)
+{
+  boost::asio::spawn(io, [this] (boost::asio::yield_context yield) {
+    std::vector<rgw::d4n::CacheBlock> blocks;
+    for (uint64_t i = 0; i < 3; i++) {
+      rgw::d4n::CacheBlock b = *block;
+      b.blockID = i;
+      blocks.push_back(b);
+    }
+    ASSERT_EQ(0, dir->set(env->dpp, &blocks[0], optional_yield{yield}));
+    ASSERT_EQ(0, dir->set(env->dpp, &blocks[2], optional_yield{yield}));
+
+    ASSERT_EQ(0, dir->del(env->dpp, blocks, optional_yield{yield}));
+
+    boost::system::error_code ec;
+    request req;
+    req.push("EXISTS", "testBucket_testName_0_0", "testBucket_testName_1_0", "testBucket_testName_2_0");
+    req.push("FLUSHALL");
+    response<int, boost::redis::ignore_t> resp;
+
+    conn->async_exec(req, resp, yield[ec]);
+
+    ASSERT_EQ((bool)ec, false);
+    EXPECT_EQ(std::get<0>(resp).value(), 0);
+
+    conn->cancel();
+  }, rethrow);
+
+  io.run();
+}
+
 TEST_F(BlockDirectoryFixture, WatchExecuteYield)
 {
   boost::asio::spawn(io, [this] (boost::asio::yield_context yield) {
@@ -1,3 +1,6 @@
+#include <set>
+#include <thread>
+
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/redis/connection.hpp>
@@ -149,6 +152,47 @@ class LFUDAPolicyFixture : public ::testing::Test {
       }
     }
 
+    rgw::d4n::LFUDAPolicy* lfuda_policy() {
+      return dynamic_cast<rgw::d4n::LFUDAPolicy*>(policyDriver->get_cache_policy());
+    }
+
+    /* Enables writer backpressure without starting the cleaning threads, so dirty
+       objects stay until the test removes them */
+    void enable_writeback_throttle(uint64_t max_dirty_bytes) {
+      auto p = lfuda_policy();
+      p->quit = false;
+      p->max_dirty_bytes = max_dirty_bytes;
+      p->dirty_cond.emplace(io.get_executor());
+    }
+
+    void add_dirty_object(const std::string& key, uint64_t size) {
+      policyDriver->get_cache_policy()->update_dirty_object(env->dpp, key, "version", false, size, time(nullptr),
+                                                            rgw_user{"testUser"}, "etag", "testBucket", "testBucketID",
+                                                            rgw_obj_key{key}, rgw::d4n::RefCount::NOOP, null_yield);
+    }
+
+    /* Picks up the next dirty object the way a cleaning thread does */
+    std::optional<std::string> claim_dirty_object() {
+      auto p = lfuda_policy();
+      const std::lock_guard l(p->lfuda_cleaning_lock);
+      auto e = p->next_dirty_object();
+      if (!e) {
+        return std::nullopt;
+      }
+      p->claim_dirty_object(e);
+      return e->key;
+    }
+
+    void release_dirty_object(const std::string& key) {
+      lfuda_policy()->release_dirty_object(key);
+    }
+
+    size_t throttled_writers() {
+      auto p = lfuda_policy();
+      const std::lock_guard l(p->lfuda_cleaning_lock);
+      return p->throttled_writers;
+    }
+
     rgw::d4n::CacheBlock* block;
     rgw::d4n::BlockDirectory* dir;
     rgw::d4n::PolicyDriver* policyDriver;
@@ -361,6 +405,116 @@ TEST_F(LFUDAPolicyFixture, RedisSyncTest)
   io.run();
 }
 
+TEST_F(LFUDAPolicyFixture, DirtyObjectClaimThreads)
+{
+  constexpr size_t num_objects = 64;
+  constexpr size_t num_threads = 4;
+  for (size_t i = 0; i < num_objects; i++) {
+    add_dirty_object("dirty" + std::to_string(i), 1);
+  }
+
+  // each object is handed to exactly one thread
+  auto claim_all = [this] {
+    std::mutex m;
+    std::multiset<std::string> claimed;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([this, &m, &claimed] {
+        while (auto key = claim_dirty_object()) {
+          const std::lock_guard l(m);
+          claimed.insert(*key);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    return claimed;
+  };
+
+  auto claimed = claim_all();
+  ASSERT_EQ(num_objects, claimed.size());
+  EXPECT_EQ(num_objects, std::set<std::string>(claimed.begin(), claimed.end()).size());
+  EXPECT_FALSE(claim_dirty_object());
+
+  // a written back object stays gone when its cleaning thread releases it
+  ASSERT_TRUE(policyDriver->get_cache_policy()->erase_dirty_object(env->dpp, "dirty0", null_yield));
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([this, t] {
+      for (size_t i = t; i < num_objects; i += num_threads) {
+        release_dirty_object("dirty" + std::to_string(i));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  claimed = claim_all();
+  EXPECT_EQ(num_objects - 1, claimed.size());
+  EXPECT_EQ(num_objects - 1, std::set<std::string>(claimed.begin(), claimed.end()).size());
+  EXPECT_EQ(0, claimed.count("dirty0"));
+}
+
+TEST_F(LFUDAPolicyFixture, WritebackThrottle)
+{
+  enable_writeback_throttle(100);
+  add_dirty_object("dirty", 80);
+
+  auto policy = policyDriver->get_cache_policy();
+  EXPECT_EQ(0, policy->writeback_throttle(env->dpp, 20, null_yield));
+  EXPECT_EQ(-EBUSY, policy->writeback_throttle(env->dpp, 40, null_yield));
+
+  bool resumed = false;
+  boost::asio::spawn(io, [this, policy, &resumed] (boost::asio::yield_context yield) {
+    EXPECT_EQ(0, policy->writeback_throttle(env->dpp, 40, optional_yield{yield}));
+    resumed = true;
+
+    cacheDriver->shutdown();
+    conn->cancel();
+  }, rethrow);
+
+  boost::asio::spawn(io, [this, policy, &resumed] (boost::asio::yield_context yield) {
+    EXPECT_EQ(1, throttled_writers());
+    EXPECT_FALSE(resumed);
+    // writing back the dirty object releases the writer
+    EXPECT_TRUE(policy->erase_dirty_object(env->dpp, "dirty", optional_yield{yield}));
+  }, rethrow);
+
+  io.run();
+
+  EXPECT_TRUE(resumed);
+  EXPECT_EQ(0, throttled_writers());
+}
+
+TEST_F(LFUDAPolicyFixture, WritebackThrottleDestroy)
+{
+  enable_writeback_throttle(100);
+  add_dirty_object("dirty", 80);
+
+  int ret = 0;
+  boost::asio::spawn(io, [this, &ret] (boost::asio::yield_context yield) {
+    ret = policyDriver->get_cache_policy()->writeback_throttle(env->dpp, 40, optional_yield{yield});
+
+    cacheDriver->shutdown();
+    conn->cancel();
+  }, rethrow);
+
+  std::thread io_thread([this] { io.run(); });
+  while (throttled_writers() == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // the waiting writer is canceled before the policy goes away
+  delete policyDriver;
+  policyDriver = nullptr;
+
+  io_thread.join();
+  EXPECT_EQ(-ECANCELED, ret);
+}
+
 int main(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -9,6 +9,7 @@
 #include <string_view>
 #include <random>
 #include <ranges>
+#include <atomic>
 #include <thread>
 #include <stdint.h>
 
@@ -77,8 +78,14 @@ protected:
     }
 
     using fill_cache_cb_t = file::listing::fill_cache_cb_t;
+    using fill_cache_check_t = file::listing::fill_cache_check_t;
+
+    /* number of fills, and of entries materialized by them */
+    static inline std::atomic<uint32_t> nfill{0};
+    static inline std::atomic<uint32_t> nmaterialized{0};
 
     int fill_cache(const DoutPrefixProvider* dpp, optional_yield y, fill_cache_cb_t cb) {
+      ++nfill;
       sf::path rp{bucket_root};
       sf::path bp{rp / name};
       if (! (sf::exists(rp) && sf::is_directory(rp))) {
@@ -90,11 +97,30 @@ protected:
 	rgw_bucket_dir_entry bde{};
 	auto fname = dir_entry.path().filename().string();
 	bde.key.name = fname;
+	bde.meta.size = dir_entry.is_regular_file() ? dir_entry.file_size() : 0;
+	++nmaterialized;
 	cb(dpp, bde);
       }
       return 0;
     } /* fill_cache */
 
+    int fill_cache(const DoutPrefixProvider* dpp, optional_yield y, fill_cache_cb_t& cb,
+		   fill_cache_check_t& check) {
+      ++nfill;
+      sf::path bp{sf::path{bucket_root} / name};
+      for (const auto& dir_entry : sf::directory_iterator{bp}) {
+	rgw_bucket_dir_entry bde{};
+	bde.key.name = dir_entry.path().filename().string();
+	bde.meta.size = dir_entry.is_regular_file() ? dir_entry.file_size() : 0;
+	if (check(dpp, bde.key, bde.meta.mtime, bde.meta.size)) {
+	  continue;
+	}
+	++nmaterialized;
+	cb(dpp, bde);
+      }
+      return 0;
+    } /* fill_cache (incremental) */
+
   }; /* MockSalBucket */
 
   using BucketCache = file::listing::BucketCache<MockSalDriver, MockSalBucket>;
@@ -477,6 +503,80 @@ TEST_F(BucketCacheFixtureInotify1, List2Inotify1)
 } /* List2Inotify1 */
 #endif
 
+class BucketCacheFixturePersist1 : public testing::Test, protected BucketCacheFixtureBase {
+protected:
+  static inline const std::string bucket{"persist1"};
+
+  void SetUp() override {
+    sf::path tp{sf::path{bucket_root} / bucket};
+    sf::remove_all(tp);
+    sf::create_directory(tp);
+    create_files("file_", 20);
+    MockSalBucket::nfill = 0;
+    MockSalBucket::nmaterialized = 0;
+  }
+
+  void TearDown() override {
+    sf::path tp{sf::path{bucket_root} / bucket};
+    sf::remove_all(tp);
+  }
+
+  static void create_files(std::string fbase, int nfiles) {
+    sf::path tp{sf::path{bucket_root} / bucket};
+    for (int ix = 0; ix < nfiles; ++ix) {
+      sf::path ttp{tp / fmt::format("{}{}", fbase, ix)};
+      std::ofstream ofs(ttp);
+      ofs << "data for " << ttp << std::endl;
+      ofs.close();
+    }
+  }
+
+  /* list the bucket from a freshly started cache */
+  static std::vector<std::string> list_restarted() {
+    std::vector<std::string> names;
+    BucketCache bc{&sal_driver, bucket_root, database_root, 100, 3, 3, 3,
+		   true /* persistent */};
+    MockSalBucket sb{bucket};
+    (void) bc.list_bucket(nullptr, null_yield, &sb, "",
+      [&](const rgw_bucket_dir_entry& bde) -> bool {
+	names.push_back(bde.key.name);
+	return true;
+      });
+    return names;
+  }
+};
+
+TEST_F(BucketCacheFixturePersist1, ListPersist1)
+{
+  ASSERT_EQ(list_restarted().size(), 20);
+  ASSERT_EQ(MockSalBucket::nfill, 1);
+  ASSERT_EQ(MockSalBucket::nmaterialized, 20);
+
+  /* unchanged since the last fill, every entry checks out */
+  ASSERT_EQ(list_restarted().size(), 20);
+  ASSERT_EQ(MockSalBucket::nfill, 2);
+  ASSERT_EQ(MockSalBucket::nmaterialized, 20);
+
+  /* overwritten in place, which leaves the directory untouched */
+  {
+    std::ofstream ofs(sf::path{bucket_root} / bucket / "file_5");
+    ofs << "different data" << std::endl;
+  }
+  ASSERT_EQ(list_restarted().size(), 20);
+  ASSERT_EQ(MockSalBucket::nfill, 3);
+  ASSERT_EQ(MockSalBucket::nmaterialized, 21);
+
+  /* changed while down, only new entries are materialized */
+  create_files("upfile_", 5);
+  sf::remove(sf::path{bucket_root} / bucket / "file_0");
+  sf::remove(sf::path{bucket_root} / bucket / "file_1");
+  auto names = list_restarted();
+  ASSERT_EQ(names.size(), 23);
+  ASSERT_EQ(MockSalBucket::nfill, 4);
+  ASSERT_EQ(MockSalBucket::nmaterialized, 26);
+  ASSERT_EQ(*names.begin(), "file_10");
+} /* ListPersist1 */
+
 int main (int argc, char *argv[])
 {
 
@@ -4,6 +4,7 @@
 #include "rgw_xml.h"
 #include "rgw_lc.h"
 #include "rgw_lc_s3.h"
+#include "rgw_lc_tier.h"
 #include <gtest/gtest.h>
 #include <string>
 #include <vector>
@@ -419,3 +420,95 @@ TEST_F(LCWorkTimeTests, ScheduleNextStartTime)
 
    run_schedule_next_start_time_test(test_values_to_expectations);
 }
+
+TEST(TestLCCloudTier, InitParts)
+{
+  rgw_lc_multipart_upload_info status;
+  const uint64_t mb = 1024 * 1024;
+
+  // the configured part size is raised to the smallest one S3 accepts
+  rgw_cloud_tier_init_parts(status, 12 * mb, mb);
+  ASSERT_EQ(3u, status.parts.size());
+  EXPECT_EQ(0u, status.parts[1].ofs);
+  EXPECT_EQ(5 * mb, status.parts[1].size);
+  EXPECT_EQ(5 * mb, status.parts[2].ofs);
+  EXPECT_EQ(10 * mb, status.parts[3].ofs);
+  EXPECT_EQ(2 * mb, status.parts[3].size);
+
+  // no more than 10000 parts
+  rgw_cloud_tier_init_parts(status, 100000 * mb, 5 * mb);
+  EXPECT_LE(status.parts.size(), 10000u);
+  uint64_t total = 0;
+  for (const auto& [num, part] : status.parts) {
+    EXPECT_EQ(num, part.part_num);
+    EXPECT_EQ(total, part.ofs);
+    total += part.size;
+  }
+  EXPECT_EQ(100000 * mb, total);
+}
+
+TEST(TestLCCloudTier, ResumeSavedParts)
+{
+  const uint64_t mb = 1024 * 1024;
+  const auto mtime = ceph::real_clock::now();
+  rgw_lc_multipart_upload_info status;
+  status.upload_id = "upload";
+  status.obj_size = 20 * mb;
+  status.mtime = mtime;
+  status.etag = "etag";
+  rgw_cloud_tier_init_parts(status, status.obj_size, 5 * mb);
+  ASSERT_EQ(4u, status.parts.size());
+  status.parts[1].etag = "etag1";
+  status.parts[3].etag = "etag3";
+
+  // what a later attempt reads back from the status object
+  bufferlist bl;
+  encode(status, bl);
+  rgw_lc_multipart_upload_info saved;
+  auto p = bl.cbegin();
+  decode(saved, p);
+
+  ASSERT_TRUE(rgw_cloud_tier_can_resume(saved, mtime, 20 * mb, "etag"));
+  EXPECT_EQ(std::vector<int>({2, 4}), rgw_cloud_tier_pending_parts(saved));
+  EXPECT_EQ("etag1", saved.parts[1].etag);
+  EXPECT_EQ("etag3", saved.parts[3].etag);
+  EXPECT_EQ(status.parts[4].ofs, saved.parts[4].ofs);
+  EXPECT_EQ(status.parts[4].size, saved.parts[4].size);
+
+  // the object changed since
+  EXPECT_FALSE(rgw_cloud_tier_can_resume(saved, mtime + std::chrono::seconds(1), 20 * mb, "etag"));
+  EXPECT_FALSE(rgw_cloud_tier_can_resume(saved, mtime, 21 * mb, "etag"));
+  EXPECT_FALSE(rgw_cloud_tier_can_resume(saved, mtime, 20 * mb, "etag2"));
+
+  // all parts sent, only the completion is left
+  for (auto& [num, part] : saved.parts) {
+    part.etag = "etag" + std::to_string(num);
+  }
+  EXPECT_TRUE(rgw_cloud_tier_pending_parts(saved).empty());
+}
+
+TEST(TestLCCloudTier, ResumeWithoutParts)
+{
+  // a status written before the part layout was recorded can't be resumed
+  rgw_lc_multipart_upload_info status;
+  const auto mtime = ceph::real_clock::now();
+  status.upload_id = "upload";
+  status.obj_size = 20 * 1024 * 1024;
+  status.mtime = mtime;
+  status.etag = "etag";
+
+  bufferlist bl;
+  ENCODE_START(1, 1, bl);
+  encode(status.upload_id, bl);
+  encode(status.obj_size, bl);
+  encode(status.mtime, bl);
+  encode(status.etag, bl);
+  ENCODE_FINISH(bl);
+
+  rgw_lc_multipart_upload_info saved;
+  auto p = bl.cbegin();
+  decode(saved, p);
+  EXPECT_EQ("upload", saved.upload_id);
+  EXPECT_TRUE(saved.parts.empty());
+  EXPECT_FALSE(rgw_cloud_tier_can_resume(saved, mtime, status.obj_size, "etag"));
+}
@@ -241,6 +241,53 @@ TEST(TestRGWManifest, head_only_obj) {
   ASSERT_EQ((int)iter.get_stripe_size(), obj_size);
 }
 
+TEST(TestRGWManifest, inlined_small_obj) {
+  test_rgw_env env;
+  RGWObjManifest manifest;
+  rgw_bucket bucket;
+  rgw_obj head;
+  RGWObjManifest::generator gen;
+
+  const uint64_t obj_size = 1000;
+  const uint64_t stripe_size = 4 * 1024 * 1024;
+
+  /* a placement without a head (inline_data=false), restarted with a head
+   * that holds the whole object as AtomicObjectProcessor does */
+  test_rgw_init_bucket(&bucket, "buck");
+  head = rgw_obj(bucket, "oid");
+  manifest.set_trivial_rule(0, stripe_size);
+  ASSERT_EQ(0, gen.create_begin(g_ceph_context, &manifest, env.zonegroup.default_placement,
+                                nullptr, bucket, head));
+  manifest.set_trivial_rule(obj_size, stripe_size);
+  ASSERT_EQ(0, gen.create_begin(g_ceph_context, &manifest, env.zonegroup.default_placement,
+                                nullptr, bucket, head));
+  ASSERT_TRUE(gen.get_cur_obj(env.zonegroup, env.zone_params) == env.get_raw(head));
+  ASSERT_EQ(0, gen.create_next(obj_size));
+
+  ASSERT_EQ(manifest.get_obj_size(), obj_size);
+  ASSERT_EQ(manifest.get_head_size(), obj_size);
+  ASSERT_EQ(manifest.get_max_head_size(), obj_size);
+  ASSERT_FALSE(manifest.has_tail());
+  ASSERT_TRUE(manifest.get_tail_placement().placement_rule == env.zonegroup.default_placement);
+
+  /* the head is the only object */
+  RGWObjManifest::obj_iterator iter = manifest.obj_begin(&dp);
+  ASSERT_TRUE(iter != manifest.obj_end(&dp));
+  ASSERT_TRUE(env.get_raw(iter.get_location()) == env.get_raw(head));
+  ++iter;
+  ASSERT_TRUE(iter == manifest.obj_end(&dp));
+
+  /* a manifest round trip keeps it */
+  bufferlist bl;
+  encode(manifest, bl);
+  RGWObjManifest decoded;
+  auto p = bl.cbegin();
+  decode(decoded, p);
+  ASSERT_EQ(decoded.get_obj_size(), obj_size);
+  ASSERT_EQ(decoded.get_head_size(), obj_size);
+  ASSERT_FALSE(decoded.has_tail());
+}
+
 TEST(TestRGWManifest, obj_with_head_and_tail) {
   test_rgw_env env;
   RGWObjManifest manifest;
@@ -13,9 +13,13 @@
  */
 
 #include "rgw_sal_posix.h"
+#include "rgw_posix_uring.h"
 #include <gtest/gtest.h>
+#include <fcntl.h>
 #include <iostream>
 #include <filesystem>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/spawn.hpp>
 #include "common/common_init.h"
 #include "common/errno.h"
 #include "global/global_init.h"
@@ -49,6 +53,8 @@ public:
     args.push_back("--rgw_multipart_min_part_size=32");
     args.push_back("--debug-rgw=20");
     args.push_back("--debug-ms=1");
+    // small enough for the PosixIO tests to fill the ring
+    args.push_back("--rgw_posix_io_uring_depth=4");
 
     /* Proceed with environment setup */
     cct = global_init(nullptr, args, CEPH_ENTITY_TYPE_CLIENT,
@@ -2541,6 +2547,104 @@ TEST_F(POSIXVerMPObjectTest, MPUploadComplete)
 }
 
 
+class PosixIOTest : public ::testing::Test {
+protected:
+  static constexpr size_t block_size = 4096;
+  NoDoutPrefix dpp{env->cct.get(), ceph_subsys_rgw};
+  sf::path path{base_path / "posix_io"};
+  int fd{-1};
+
+  void SetUp() override {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+  }
+
+  void TearDown() override {
+    ::close(fd);
+    sf::remove(path);
+  }
+
+  static std::string block(size_t i) {
+    return std::string(block_size, static_cast<char>('a' + i % 26));
+  }
+};
+
+TEST_F(PosixIOTest, ReadWriteBlocking)
+{
+  const std::string data = block(0);
+  EXPECT_EQ(posix_io::pwrite(&dpp, fd, data.data(), data.size(), block_size, null_yield),
+            static_cast<ssize_t>(data.size()));
+
+  std::string out(block_size, '\0');
+  EXPECT_EQ(posix_io::pread(&dpp, fd, out.data(), out.size(), block_size, null_yield),
+            static_cast<ssize_t>(out.size()));
+  EXPECT_EQ(out, data);
+
+  // short read at the end of the file
+  EXPECT_EQ(posix_io::pread(&dpp, fd, out.data(), out.size(), block_size + 1, null_yield),
+            static_cast<ssize_t>(block_size - 1));
+  EXPECT_EQ(posix_io::pread(&dpp, fd, out.data(), out.size(), 2 * block_size, null_yield), 0);
+
+  EXPECT_EQ(posix_io::pread(&dpp, -1, out.data(), out.size(), 0, null_yield), -EBADF);
+  EXPECT_EQ(posix_io::pwrite(&dpp, -1, data.data(), data.size(), 0, null_yield), -EBADF);
+}
+
+TEST_F(PosixIOTest, ReadWriteCoroutine)
+{
+  boost::asio::io_context context;
+  boost::asio::spawn(context, [&] (boost::asio::yield_context yield) {
+    const std::string data = block(1);
+    EXPECT_EQ(posix_io::pwrite(&dpp, fd, data.data(), data.size(), 0, yield),
+              static_cast<ssize_t>(data.size()));
+    std::string out(block_size, '\0');
+    EXPECT_EQ(posix_io::pread(&dpp, fd, out.data(), out.size(), 0, yield),
+              static_cast<ssize_t>(out.size()));
+    EXPECT_EQ(out, data);
+
+    EXPECT_EQ(posix_io::pread(&dpp, -1, out.data(), out.size(), 0, yield), -EBADF);
+  }, [] (std::exception_ptr eptr) {
+    if (eptr) std::rethrow_exception(eptr);
+  });
+  context.run();
+}
+
+/* Many more requests than the ring has entries: some find the submission queue
+ * full and are flushed out or done synchronously. All of them must complete. */
+TEST_F(PosixIOTest, ReadWriteFullRing)
+{
+  constexpr size_t num_blocks = 64;
+  boost::asio::io_context context;
+  auto rethrow = [] (std::exception_ptr eptr) {
+    if (eptr) std::rethrow_exception(eptr);
+  };
+
+  size_t written = 0;
+  for (size_t i = 0; i < num_blocks; i++) {
+    boost::asio::spawn(context, [&, i] (boost::asio::yield_context yield) {
+      const std::string data = block(i);
+      EXPECT_EQ(posix_io::pwrite(&dpp, fd, data.data(), data.size(), i * block_size, yield),
+                static_cast<ssize_t>(data.size()));
+      written++;
+    }, rethrow);
+  }
+  context.run();
+  ASSERT_EQ(written, num_blocks);
+
+  context.restart();
+  size_t verified = 0;
+  for (size_t i = 0; i < num_blocks; i++) {
+    boost::asio::spawn(context, [&, i] (boost::asio::yield_context yield) {
+      std::string out(block_size, '\0');
+      EXPECT_EQ(posix_io::pread(&dpp, fd, out.data(), out.size(), i * block_size, yield),
+                static_cast<ssize_t>(out.size()));
+      EXPECT_EQ(out, block(i));
+      verified++;
+    }, rethrow);
+  }
+  context.run();
+  EXPECT_EQ(verified, num_blocks);
+}
+
 int main(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
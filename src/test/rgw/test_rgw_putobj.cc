@@ -14,6 +14,7 @@
  */
 
 #include "rgw_putobj.h"
+#include "rgw_putobj_processor.h"
 #include <gtest/gtest.h>
 
 inline bufferlist string_buf(const char* buf) {
@@ -195,3 +196,17 @@ TEST(PutObj_Stripe, SkipFirstChunk)
   ASSERT_EQ(4u, mock.ops.size());
   EXPECT_EQ(Op({"", 4}), mock.ops[3]); // flush
 }
+
+TEST(PutObj_Atomic, InlineSmallObjectSize)
+{
+  using rgw::putobj::inline_small_object_size;
+  // disabled
+  EXPECT_EQ(0u, inline_small_object_size(0, true, 0, 4096));
+  // inline_data=false, tail in the head pool
+  EXPECT_EQ(1024u, inline_small_object_size(1024, true, 0, 4096));
+  EXPECT_EQ(4096u, inline_small_object_size(8192, true, 0, 4096));
+  // the placement already inlines a head
+  EXPECT_EQ(0u, inline_small_object_size(1024, true, 4096, 4096));
+  // a storage class with its own data pool keeps its data there
+  EXPECT_EQ(0u, inline_small_object_size(1024, false, 0, 4096));
+}
@@ -0,0 +1,229 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * Copyright contributors to the Ceph project
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw_readahead.h"
+
+#include <boost/intrusive_ptr.hpp>
+#include "common/ceph_context.h"
+#include "common/config.h"
+
+#include <gtest/gtest.h>
+
+using rgw::rados::ReadAhead;
+
+static rgw_raw_obj make_obj(const std::string& oid)
+{
+  return {{"testpool"}, oid};
+}
+
+static ceph::buffer::list make_data(char c, size_t len)
+{
+  ceph::buffer::list bl;
+  bl.append(std::string(len, c));
+  return bl;
+}
+
+class ReadAheadTest : public ::testing::Test {
+ protected:
+  boost::intrusive_ptr<CephContext> cct{
+    new CephContext(CEPH_ENTITY_TYPE_CLIENT), false};
+
+  void SetUp() override {
+    cct->_conf.set_val_or_die("rgw_get_obj_readahead_size", "1024");
+    cct->_conf.set_val_or_die("rgw_get_obj_readahead_cache_size", "4096");
+  }
+};
+
+TEST_F(ReadAheadTest, Disabled)
+{
+  cct->_conf.set_val_or_die("rgw_get_obj_readahead_size", "0");
+  ReadAhead ra{cct.get()};
+  const auto head = make_obj("head");
+  EXPECT_FALSE(ra.note_read(head, 0, 99, 10000));
+  EXPECT_FALSE(ra.note_read(head, 100, 199, 10000));
+}
+
+TEST_F(ReadAheadTest, Sequential)
+{
+  ReadAhead ra{cct.get()};
+  const auto head = make_obj("head");
+
+  // the first read only starts the stream
+  EXPECT_FALSE(ra.note_read(head, 0, 99, 10000));
+
+  // the next one continues it, so prefetch a range of the same size
+  auto range = ra.note_read(head, 100, 199, 10000);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(200u, range->first);
+  EXPECT_EQ(299u, range->second);
+
+  // the following read was prefetched, so stay one range ahead
+  range = ra.note_read(head, 200, 299, 10000);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(300u, range->first);
+  EXPECT_EQ(399u, range->second);
+
+  // a seek restarts the stream
+  EXPECT_FALSE(ra.note_read(head, 5000, 5099, 10000));
+  range = ra.note_read(head, 5100, 5199, 10000);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(5200u, range->first);
+}
+
+TEST_F(ReadAheadTest, Limits)
+{
+  ReadAhead ra{cct.get()};
+  const auto head = make_obj("head");
+
+  // prefetch is capped at rgw_get_obj_readahead_size
+  EXPECT_FALSE(ra.note_read(head, 0, 4999, 100000));
+  auto range = ra.note_read(head, 5000, 9999, 100000);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(10000u, range->first);
+  EXPECT_EQ(11023u, range->second);
+
+  // data that was already prefetched isn't fetched again
+  EXPECT_FALSE(ra.note_read(head, 10000, 10499, 100000));
+
+  // prefetch stops at the end of the object
+  const auto head2 = make_obj("head2");
+  EXPECT_FALSE(ra.note_read(head2, 0, 499, 800));
+  range = ra.note_read(head2, 500, 699, 800);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(700u, range->first);
+  EXPECT_EQ(799u, range->second);
+  EXPECT_FALSE(ra.note_read(head2, 700, 799, 800));
+}
+
+static void insert(ReadAhead& ra, const rgw_raw_obj& obj, uint64_t ofs,
+                   ceph::buffer::list&& bl)
+{
+  ASSERT_TRUE(ra.start_fetch(obj, ofs, bl.length()));
+  ra.finish_fetch(obj, ofs, 0, std::move(bl));
+}
+
+static ReadAhead::Lookup lookup(ReadAhead& ra, const rgw_raw_obj& obj,
+                                uint64_t ofs, uint64_t len)
+{
+  ceph::buffer::list bl;
+  auto result = ra.lookup(obj, ofs, len, bl, [] (int, ceph::buffer::list&&) {});
+  if (result == ReadAhead::Lookup::hit) {
+    EXPECT_EQ(len, bl.length());
+  }
+  return result;
+}
+
+TEST_F(ReadAheadTest, LookupCovering)
+{
+  ReadAhead ra{cct.get()};
+  const auto tail = make_obj("tail");
+  insert(ra, tail, 1000, make_data('a', 1000));
+
+  EXPECT_EQ(ReadAhead::Lookup::hit, lookup(ra, tail, 1000, 1000));
+  EXPECT_EQ(ReadAhead::Lookup::hit, lookup(ra, tail, 1500, 200));
+  EXPECT_EQ(ReadAhead::Lookup::miss, lookup(ra, tail, 900, 200));
+  EXPECT_EQ(ReadAhead::Lookup::miss, lookup(ra, tail, 1900, 200));
+  EXPECT_EQ(ReadAhead::Lookup::miss, lookup(ra, make_obj("other"), 1000, 100));
+
+  // the range is cached already
+  EXPECT_FALSE(ra.start_fetch(tail, 1000, 1000));
+}
+
+TEST_F(ReadAheadTest, Pending)
+{
+  ReadAhead ra{cct.get()};
+  const auto tail = make_obj("tail");
+  ASSERT_TRUE(ra.start_fetch(tail, 0, 1000));
+  // the range is in flight, so it isn't fetched twice
+  EXPECT_FALSE(ra.start_fetch(tail, 0, 1000));
+
+  int result = 1;
+  ceph::buffer::list data;
+  ceph::buffer::list bl;
+  ASSERT_EQ(ReadAhead::Lookup::pending,
+            ra.lookup(tail, 100, 200, bl, [&] (int r, ceph::buffer::list&& d) {
+                        result = r;
+                        data = std::move(d);
+                      }));
+  EXPECT_EQ(1, result);
+
+  ra.finish_fetch(tail, 0, 0, make_data('a', 1000));
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(200u, data.length());
+  EXPECT_EQ(ReadAhead::Lookup::hit, lookup(ra, tail, 0, 1000));
+}
+
+TEST_F(ReadAheadTest, PendingFailed)
+{
+  ReadAhead ra{cct.get()};
+  const auto tail = make_obj("tail");
+  ASSERT_TRUE(ra.start_fetch(tail, 0, 1000));
+
+  int failed = 0;
+  int short_read = 0;
+  ceph::buffer::list bl;
+  ASSERT_EQ(ReadAhead::Lookup::pending,
+            ra.lookup(tail, 0, 100, bl, [&] (int r, ceph::buffer::list&&) {
+                        failed = r;
+                      }));
+  ra.finish_fetch(tail, 0, -EIO, {});
+  EXPECT_EQ(-EIO, failed);
+  EXPECT_EQ(ReadAhead::Lookup::miss, lookup(ra, tail, 0, 100));
+
+  // waiters past the end of a short read get an error
+  ASSERT_TRUE(ra.start_fetch(tail, 0, 1000));
+  ASSERT_EQ(ReadAhead::Lookup::pending,
+            ra.lookup(tail, 500, 500, bl, [&] (int r, ceph::buffer::list&&) {
+                        short_read = r;
+                      }));
+  ra.finish_fetch(tail, 0, 0, make_data('a', 600));
+  EXPECT_EQ(-ENODATA, short_read);
+}
+
+TEST_F(ReadAheadTest, Eviction)
+{
+  ReadAhead ra{cct.get()};
+  const auto tail = make_obj("tail");
+  insert(ra, tail, 0, make_data('a', 2048));
+  insert(ra, tail, 2048, make_data('b', 2048));
+
+  // touch the first chunk so the second is least recently used
+  EXPECT_EQ(ReadAhead::Lookup::hit, lookup(ra, tail, 0, 10));
+
+  insert(ra, tail, 4096, make_data('c', 2048));
+  EXPECT_EQ(ReadAhead::Lookup::hit, lookup(ra, tail, 0, 10));
+  EXPECT_EQ(ReadAhead::Lookup::miss, lookup(ra, tail, 2048, 10));
+  EXPECT_EQ(ReadAhead::Lookup::hit, lookup(ra, tail, 4096, 10));
+
+  // chunks bigger than the whole cache aren't kept
+  EXPECT_FALSE(ra.start_fetch(tail, 8192, 8192));
+}
+
+TEST_F(ReadAheadTest, InFlightLimit)
+{
+  ReadAhead ra{cct.get()};
+  const auto tail = make_obj("tail");
+  insert(ra, tail, 0, make_data('a', 2048));
+
+  // prefetches in flight count against the cache, evicting complete data
+  ASSERT_TRUE(ra.start_fetch(tail, 2048, 2048));
+  ASSERT_TRUE(ra.start_fetch(tail, 4096, 2048));
+  EXPECT_EQ(ReadAhead::Lookup::miss, lookup(ra, tail, 0, 10));
+
+  // but can't evict each other
+  EXPECT_FALSE(ra.start_fetch(tail, 6144, 1024));
+  ra.finish_fetch(tail, 2048, 0, make_data('b', 2048));
+  EXPECT_TRUE(ra.start_fetch(tail, 6144, 1024));
+}
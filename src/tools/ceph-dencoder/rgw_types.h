@@ -79,6 +79,7 @@ TYPE(cls_rgw_bi_log_list_op)
 TYPE(cls_rgw_bi_log_trim_op)
 TYPE(cls_rgw_bi_log_list_ret)
 TYPE(rgw_cls_link_olh_op)
+TYPE(rgw_cls_link_olh_ret)
 TYPE(rgw_cls_unlink_instance_op)
 TYPE(rgw_cls_read_olh_log_op)
 TYPE(rgw_cls_read_olh_log_ret)
@@ -107,6 +108,8 @@ TYPE(rgw_cls_usage_log_add_op)
 TYPE(rgw_cls_usage_log_read_op)
 TYPE(rgw_cls_usage_log_read_ret)
 TYPE(rgw_cls_usage_log_trim_op)
+TYPE(rgw_cls_usage_log_rollup_op)
+TYPE(rgw_cls_usage_log_rollup_ret)
 TYPE(cls_rgw_guard_bucket_resharding_op)
 TYPE(cls_rgw_lc_set_entry_op)
 